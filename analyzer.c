@@ -0,0 +1,832 @@
+#include "analyzer.h"
+
+#include "input.h"
+#include "job.h"
+#include "level.h"
+#include "lily.h"
+#include "message.h"
+#include "player.h"
+#include "safe.h"
+#include "snapshot.h"
+#include "util.h"
+
+#include <string.h>
+
+// ACTIONS are the inputs the player holds down during a step of the search
+static const Uint32 ACTIONS[] = {
+    INPUT_NONE,
+    INPUT_LEFT,
+    INPUT_RIGHT,
+    INPUT_LEFT | INPUT_SPRINT,
+    INPUT_RIGHT | INPUT_SPRINT,
+    INPUT_JUMP,
+    INPUT_LEFT | INPUT_JUMP,
+    INPUT_RIGHT | INPUT_JUMP,
+    INPUT_LEFT | INPUT_SPRINT | INPUT_JUMP,
+    INPUT_RIGHT | INPUT_SPRINT | INPUT_JUMP,
+    INPUT_LEFT | INPUT_SHORT_JUMP,
+    INPUT_RIGHT | INPUT_SHORT_JUMP,
+    INPUT_UP,
+    INPUT_DOWN,
+};
+
+enum {
+  ACTION_COUNT = sizeof(ACTIONS) / sizeof(ACTIONS[0]),
+  // MAX_BLOCKED_FRAMES is the maximum number of frames spent dismissing
+  // blocking messages after an action (10 seconds)
+  MAX_BLOCKED_FRAMES = 10 * FRAME_RATE,
+  // the visited set is split into SHARD_COUNT shards, each with its own lock
+  SHARD_BITS = 6,
+  SHARD_COUNT = 1 << SHARD_BITS,
+};
+
+// NO_PARENT is the parent of the start of the level in the trace
+static const Uint32 NO_PARENT = 0xFFFFFFFF;
+
+// outcome is the outcome of playing an action from a state
+enum outcome {
+  OUTCOME_ALIVE, // the player is somewhere in the level
+  OUTCOME_DEAD,  // the player lost a life or fell out of the level
+  OUTCOME_GOAL,  // the player completed the level
+  OUTCOME_ERROR, // stepping the world failed
+};
+
+// node is a state in the frontier of the search
+struct node {
+  Uint32 trace;  // the index of the state in the trace
+  Uint8 action;  // the action that led to the state from its parent
+  Uint32 parent; // the index of the parent of the state in the trace
+  Uint32 score;  // the distance of the player to the nearest door, in pixels
+  Uint64 key;    // the quantized state of the player
+  Uint8 *snap;   // the snapshot of the world, see snapshot.h
+  size_t len;    // the size of snap
+};
+
+// trace records how every state was reached: from the state with index
+// `parent` in the trace, with the action ACTIONS[action]
+struct trace {
+  Uint32 parent;
+  Uint8 action;
+};
+
+// visited is the set of the quantized states visited by the search, shared by
+// every thread. It is split into shards, each an open addressing hash table of
+// keys (which are never 0) with its own spin lock, so threads rarely wait for
+// each other.
+struct visited {
+  Uint64 *keys;      // the shards, one after the other
+  size_t shard_cap;  // the capacity of each shard, a power of two
+  size_t limit;      // the maximum number of keys in each shard
+  size_t counts[SHARD_COUNT];
+  SDL_SpinLock locks[SHARD_COUNT];
+};
+
+struct search;
+
+// worker expands the frontier nodes in [begin, end) of a depth of the search,
+// as a job of the batch of the depth (see expand_depth)
+struct worker {
+  struct search *s;
+  size_t begin;
+  size_t end;
+  struct lily_world *w;
+  bool *reached; // the tiles reached by the worker, see analyzer_result
+
+  // out holds the new states found by the worker
+  struct node *out;
+  size_t out_len;
+  size_t out_cap;
+
+  // goal is the first frontier node (and goal_action the action) from which
+  // the worker completed the level, if found is true
+  bool found;
+  size_t goal;
+  Uint8 goal_action;
+
+  bool full;   // true if the visited set was full
+  bool failed; // true if an error occurred
+};
+
+struct search {
+  struct level_template *t;
+  size_t hold;
+  size_t rows;
+  size_t cols;
+  unsigned int lives; // the lives of the player at the start of the level
+
+  // doors holds the door_count doors of the level, as tile indices
+  size_t *doors;
+  size_t door_count;
+
+  struct visited v;
+  struct node *frontier;
+  size_t frontier_len;
+  struct trace *trace;
+  size_t trace_len;
+  size_t trace_cap;
+
+  // workers contains a worker per thread, each expanding a range of the
+  // frontier as a job run by jobs
+  struct worker *workers;
+  size_t threads;
+  struct job_pool *jobs;
+};
+
+// mix is the finalizer of splitmix64 (see util_rand), used to spread keys
+static Uint64 mix(Uint64 z) {
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+  return z ^ (z >> 31);
+}
+
+static int visited_create(struct visited *v, const size_t max_states) {
+  v->limit = max_states / SHARD_COUNT + 1;
+  // keep the load factor of each shard below one half
+  v->shard_cap = 1;
+  while (v->shard_cap < 2 * v->limit) {
+    v->shard_cap <<= 1;
+  }
+
+  v->keys = calloc(SHARD_COUNT * v->shard_cap, sizeof(Uint64));
+  if (v->keys == NULL) {
+    LOG_ERROR("could not allocate the visited states");
+    return -1;
+  }
+
+  return 0;
+}
+
+// visited_insert adds key to the set. Returns 1 if it was added, 0 if it was
+// already in the set, and -1 if the set is full.
+static int visited_insert(struct visited *v, const Uint64 key) {
+  const Uint64 h = mix(key);
+  const size_t shard = h >> (64 - SHARD_BITS);
+  Uint64 *keys = v->keys + shard * v->shard_cap;
+  const size_t mask = v->shard_cap - 1;
+  int ret = -1;
+
+  SDL_AtomicLock(&v->locks[shard]);
+
+  size_t i = h & mask;
+  while (keys[i] != 0 && keys[i] != key) {
+    i = (i + 1) & mask;
+  }
+
+  if (keys[i] == key) {
+    ret = 0;
+  } else if (v->counts[shard] < v->limit) {
+    keys[i] = key;
+    v->counts[shard]++;
+    ret = 1;
+  }
+
+  SDL_AtomicUnlock(&v->locks[shard]);
+  return ret;
+}
+
+static size_t visited_count(const struct visited *v) {
+  size_t n = 0;
+  register size_t i;
+  for (i = 0; i < SHARD_COUNT; i++) {
+    n += v->counts[i];
+  }
+  return n;
+}
+
+// state_key quantizes the state of the player of the world w into a key. Bit
+// 63 is always set, so a key is never 0.
+static Uint64 state_key(const struct lily_world *w) {
+  const struct player *p = w->player;
+  const struct sprite *s = p->s;
+
+  const Sint64 x = SDL_floor(s->x / ANALYZER_POSITION_STEP);
+  const Sint64 y = SDL_floor(s->y / ANALYZER_POSITION_STEP);
+  const Sint64 vx = SDL_floor(s->vx / ANALYZER_VELOCITY_STEP);
+  const Sint64 vy = SDL_floor(s->vy / ANALYZER_VELOCITY_STEP);
+
+  return ((Uint64)1 << 63) | ((Uint64)(x & 0xFFFFF) << 40) |
+         ((Uint64)(y & 0xFFFFF) << 20) | ((Uint64)(vx & 0xFF) << 12) |
+         ((Uint64)(vy & 0x1FF) << 3) | ((Uint64)p->air << 2) |
+         ((Uint64)p->ladder << 1) | (Uint64)p->jump;
+}
+
+// score returns the distance, in pixels, between the player of the world w
+// and the nearest door
+static Uint32 score(const struct search *s, const struct lily_world *w) {
+  const struct sprite *ps = w->player->s;
+  Uint32 best = 0xFFFFFFFF;
+
+  register size_t i;
+  for (i = 0; i < s->door_count; i++) {
+    const double x = (double)(s->doors[i] % s->cols) * SPRITE_SIZE;
+    const double y = (double)(s->doors[i] / s->cols) * SPRITE_SIZE;
+    const Uint32 d = SDL_fabs(ps->x - x) + SDL_fabs(ps->y - y);
+    best = SDL_min(best, d);
+  }
+
+  return best;
+}
+
+// frame_input returns the input of the player of the world w for the next
+// frame, while holding down `action`
+static Uint32 frame_input(const struct lily_world *w, const Uint32 action) {
+  if (message_block(w->message)) {
+    return INPUT_INTERACT;
+  }
+
+  int r, c;
+  util_nearest(w->player->s, &r, &c);
+  if (util_door(w, r, c)) {
+    return action | INPUT_INTERACT;
+  }
+
+  return action;
+}
+
+// step steps the world w with the input `in`, appending it to inputs (if not
+// NULL), and marks the tile of the player in reached (if not NULL)
+static enum outcome step(const struct search *s, struct lily_world *w,
+                         const Uint32 in, bool *reached, Uint32 *inputs,
+                         size_t *input_count) {
+  if (lily_world_step(w, in, FRAME_TIME) != 0) {
+    return OUTCOME_ERROR;
+  }
+
+  if (inputs != NULL) {
+    inputs[(*input_count)++] = in;
+  }
+
+  if (w->state == PROG_GAME_LEVEL_COMPLETE) {
+    return OUTCOME_GOAL;
+  }
+
+  if (w->state == PROG_GAME_OVER || w->player->lives < s->lives) {
+    return OUTCOME_DEAD;
+  }
+
+  int r, c;
+  util_nearest(w->player->s, &r, &c);
+  if (r < 0 || c < 0 || (size_t)r >= s->rows || (size_t)c >= s->cols) {
+    return OUTCOME_DEAD;
+  }
+
+  if (reached != NULL) {
+    reached[r * s->cols + c] = true;
+  }
+
+  return OUTCOME_ALIVE;
+}
+
+// play holds the action ACTIONS[a] for s->hold frames in the world w, then
+// dismisses any blocking message. If inputs is not NULL, it must hold
+// s->hold + MAX_BLOCKED_FRAMES more values.
+static enum outcome play(const struct search *s, struct lily_world *w,
+                         const Uint8 a, bool *reached, Uint32 *inputs,
+                         size_t *input_count) {
+  enum outcome o = OUTCOME_ALIVE;
+
+  register size_t i;
+  for (i = 0; i < s->hold && o == OUTCOME_ALIVE; i++) {
+    o = step(s, w, frame_input(w, ACTIONS[a]), reached, inputs, input_count);
+  }
+
+  // a blocking message pauses the game, so the state would not change until it
+  // is dismissed
+  for (i = 0; i < MAX_BLOCKED_FRAMES && o == OUTCOME_ALIVE &&
+              message_block(w->message);
+       i++) {
+    o = step(s, w, INPUT_INTERACT, reached, inputs, input_count);
+  }
+
+  return o;
+}
+
+// create_world creates a world playing the level of the search. Returns NULL
+// on failure.
+static struct lily_world *create_world(const struct search *s,
+                                       const Uint64 seed) {
+  struct lily_world *w = lily_world_create();
+  if (w == NULL) {
+    return NULL;
+  }
+
+  lily_world_seed(w, seed);
+  if (lily_world_load_level_template(w, s->t) != 0) {
+    lily_world_destroy(&w);
+    return NULL;
+  }
+
+  return w;
+}
+
+// add_node appends a new state of the world w to the output of the worker k
+static int add_node(struct worker *k, const struct lily_world *w,
+                    const Uint64 key, const Uint32 parent, const Uint8 a) {
+  if (k->out_len == k->out_cap) {
+    const size_t cap = k->out_cap == 0 ? 64 : 2 * k->out_cap;
+    struct node *out = realloc(k->out, cap * sizeof(struct node));
+    if (out == NULL) {
+      LOG_ERROR("could not allocate search nodes");
+      return -1;
+    }
+    k->out = out;
+    k->out_cap = cap;
+  }
+
+  const size_t len = snapshot_save(w, NULL, 0);
+  Uint8 *snap = malloc(len);
+  if (snap == NULL) {
+    LOG_ERROR("could not allocate snapshot");
+    return -1;
+  }
+  snapshot_save(w, snap, len);
+
+  k->out[k->out_len++] = (struct node){.action = a,
+                                       .parent = parent,
+                                       .score = score(k->s, w),
+                                       .key = key,
+                                       .snap = snap,
+                                       .len = len};
+  return 0;
+}
+
+// expand plays every action from the frontier node i
+static void expand(struct worker *k, const size_t i) {
+  struct search *s = k->s;
+  const struct node *n = &s->frontier[i];
+
+  register Uint8 a;
+  for (a = 0; a < ACTION_COUNT; a++) {
+    if (snapshot_load(k->w, n->snap, n->len) != 0) {
+      k->failed = true;
+      return;
+    }
+
+    const enum outcome o = play(s, k->w, a, k->reached, NULL, NULL);
+    if (o == OUTCOME_ERROR) {
+      k->failed = true;
+      return;
+    }
+
+    if (o == OUTCOME_GOAL) {
+      k->found = true;
+      k->goal = i;
+      k->goal_action = a;
+      return;
+    }
+
+    if (o == OUTCOME_DEAD) {
+      continue;
+    }
+
+    const Uint64 key = state_key(k->w);
+    const int ret = visited_insert(&s->v, key);
+    if (ret < 0) {
+      k->full = true;
+    } else if (ret > 0 && add_node(k, k->w, key, n->trace, a) != 0) {
+      k->failed = true;
+      return;
+    }
+  }
+}
+
+// expand_range expands the range of frontier nodes of the worker i of the
+// search `data`, as the job i of a batch (see job_func), stopping at the first
+// node from which the level can be completed. Returns 0 on success, -1 on
+// failure.
+static int expand_range(void *data, const size_t thread, const size_t i) {
+  SAFE_UNUSED(thread);
+  struct search *s = data;
+  struct worker *k = &s->workers[i];
+
+  register size_t j;
+  for (j = k->begin; j < k->end && !k->found && !k->failed; j++) {
+    expand(k, j);
+  }
+
+  return k->failed ? -1 : 0;
+}
+
+// expand_depth expands the whole frontier, using every thread. Returns 0 on
+// success, -1 on failure.
+static int expand_depth(struct search *s) {
+  register size_t i;
+  for (i = 0; i < s->threads; i++) {
+    struct worker *k = &s->workers[i];
+    k->begin = s->frontier_len * i / s->threads;
+    k->end = s->frontier_len * (i + 1) / s->threads;
+    k->out_len = 0;
+    k->found = false;
+  }
+
+  return job_pool_run(s->jobs, s->threads, expand_range, s);
+}
+
+// trace_append appends a state to the trace and returns its index, or
+// NO_PARENT on failure
+static Uint32 trace_append(struct search *s, const Uint32 parent,
+                           const Uint8 action) {
+  if (s->trace_len == NO_PARENT) {
+    LOG_ERROR("too many states");
+    return NO_PARENT;
+  }
+
+  if (s->trace_len == s->trace_cap) {
+    const size_t cap = s->trace_cap == 0 ? 1024 : 2 * s->trace_cap;
+    struct trace *trace = realloc(s->trace, cap * sizeof(struct trace));
+    if (trace == NULL) {
+      LOG_ERROR("could not allocate search trace");
+      return NO_PARENT;
+    }
+    s->trace = trace;
+    s->trace_cap = cap;
+  }
+
+  s->trace[s->trace_len] = (struct trace){parent, action};
+  return s->trace_len++;
+}
+
+static void free_frontier(struct search *s) {
+  register size_t i;
+  for (i = 0; i < s->frontier_len; i++) {
+    free(s->frontier[i].snap);
+  }
+  free(s->frontier);
+  s->frontier = NULL;
+  s->frontier_len = 0;
+}
+
+// compare_nodes orders nodes by distance to the nearest door, then by key so
+// the order does not depend on how the states were found
+static int compare_nodes(const void *a, const void *b) {
+  const struct node *x = a, *y = b;
+  if (x->score != y->score) {
+    return x->score < y->score ? -1 : 1;
+  }
+  return x->key < y->key ? -1 : x->key > y->key;
+}
+
+// next_depth replaces the frontier with the states found by the workers,
+// keeping at most `beam` of them (if not 0). Sets *pruned to true if some
+// states were dropped. Returns 0 on success, -1 on failure.
+static int next_depth(struct search *s, const size_t beam, bool *pruned) {
+  size_t n = 0;
+  register size_t i, j;
+  for (i = 0; i < s->threads; i++) {
+    n += s->workers[i].out_len;
+  }
+
+  struct node *next = malloc(SDL_max(n, 1) * sizeof(struct node));
+  if (next == NULL) {
+    LOG_ERROR("could not allocate search nodes");
+    return -1;
+  }
+
+  size_t len = 0;
+  for (i = 0; i < s->threads; i++) {
+    struct worker *k = &s->workers[i];
+    memcpy(next + len, k->out, k->out_len * sizeof(struct node));
+    len += k->out_len;
+    k->out_len = 0;
+  }
+
+  if (beam != 0 && n > beam) {
+    qsort(next, n, sizeof(struct node), compare_nodes);
+    for (i = beam; i < n; i++) {
+      free(next[i].snap);
+    }
+    n = beam;
+    *pruned = true;
+  }
+
+  free_frontier(s);
+  s->frontier = next;
+  s->frontier_len = n;
+
+  for (j = 0; j < n; j++) {
+    next[j].trace = trace_append(s, next[j].parent, next[j].action);
+    if (next[j].trace == NO_PARENT) {
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+// replay plays the path to the state `last` of the trace followed by the
+// action a from the start of the level, recording the inputs of every frame
+// in res. Returns 0 on success, -1 on failure.
+static int replay(struct search *s, const Uint64 seed, const Uint32 last,
+                  const Uint8 a, struct analyzer_result *res) {
+  size_t depth = 1;
+  Uint32 i;
+  for (i = last; s->trace[i].parent != NO_PARENT; i = s->trace[i].parent) {
+    depth++;
+  }
+
+  Uint8 *actions = malloc(depth);
+  res->inputs =
+      calloc(depth, (s->hold + MAX_BLOCKED_FRAMES) * sizeof(Uint32));
+  if (actions == NULL || res->inputs == NULL) {
+    LOG_ERROR("could not allocate the path");
+    free(actions);
+    return -1;
+  }
+
+  size_t j = depth;
+  actions[--j] = a;
+  for (i = last; s->trace[i].parent != NO_PARENT; i = s->trace[i].parent) {
+    actions[--j] = s->trace[i].action;
+  }
+
+  struct lily_world *w = create_world(s, seed);
+  if (w == NULL) {
+    free(actions);
+    return -1;
+  }
+
+  enum outcome o = OUTCOME_ALIVE;
+  for (j = 0; j < depth && o == OUTCOME_ALIVE; j++) {
+    o = play(s, w, actions[j], NULL, res->inputs, &res->input_count);
+  }
+
+  lily_world_destroy(&w);
+  free(actions);
+
+  if (o != OUTCOME_GOAL || j != depth) {
+    LOG_ERROR("could not replay the path to the door");
+    return -1;
+  }
+
+  return 0;
+}
+
+// find_regions lists the regions of open tiles never reached in res, using the
+// sprite types of the world w. Returns 0 on success, -1 on failure.
+static int find_regions(const struct search *s, const struct lily_world *w,
+                        struct analyzer_result *res) {
+  const size_t n = s->rows * s->cols;
+  const enum sprite_id *tiles = s->t->passive_sprites;
+
+  bool *seen = calloc(n, sizeof(bool));
+  size_t *stack = malloc(n * sizeof(size_t));
+  if (seen == NULL || stack == NULL) {
+    LOG_ERROR("could not allocate regions");
+    free(seen);
+    free(stack);
+    return -1;
+  }
+
+  size_t cap = 0;
+  register size_t i;
+  for (i = 0; i < n; i++) {
+    seen[i] = res->reached[i] ||
+              w->sprite_types[tiles[i]].solid_type != SOLID_NONE;
+  }
+
+  for (i = 0; i < n; i++) {
+    if (seen[i]) {
+      continue;
+    }
+
+    if (res->region_count == cap) {
+      cap = cap == 0 ? 16 : 2 * cap;
+      struct analyzer_region *regions =
+          realloc(res->regions, cap * sizeof(struct analyzer_region));
+      if (regions == NULL) {
+        LOG_ERROR("could not allocate regions");
+        free(seen);
+        free(stack);
+        return -1;
+      }
+      res->regions = regions;
+    }
+
+    // flood fill the region, with the 4 neighbors of every tile
+    size_t top = i / s->cols, bottom = top;
+    size_t left = i % s->cols, right = left;
+    size_t size = 0, len = 0;
+
+    stack[len++] = i;
+    seen[i] = true;
+    while (len > 0) {
+      const size_t t = stack[--len];
+      const size_t r = t / s->cols, c = t % s->cols;
+      size++;
+      bottom = SDL_max(bottom, r);
+      left = SDL_min(left, c);
+      right = SDL_max(right, c);
+
+      const size_t next[4] = {r > 0 ? t - s->cols : t,
+                              r + 1 < s->rows ? t + s->cols : t,
+                              c > 0 ? t - 1 : t, c + 1 < s->cols ? t + 1 : t};
+      register size_t j;
+      for (j = 0; j < 4; j++) {
+        if (!seen[next[j]]) {
+          seen[next[j]] = true;
+          stack[len++] = next[j];
+        }
+      }
+    }
+
+    res->regions[res->region_count++] = (struct analyzer_region){
+        top, left, bottom - top + 1, right - left + 1, size};
+  }
+
+  free(seen);
+  free(stack);
+  return 0;
+}
+
+// start initializes the search and its first frontier: the start of the
+// level. Returns 0 on success, -1 on failure.
+static int start(struct search *s, const struct analyzer_options *o,
+                 const size_t max_states) {
+  const size_t n = s->rows * s->cols;
+
+  s->workers = calloc(s->threads, sizeof(struct worker));
+  s->frontier = calloc(1, sizeof(struct node));
+  s->doors = malloc(n * sizeof(size_t));
+  if (s->workers == NULL || s->frontier == NULL || s->doors == NULL) {
+    LOG_ERROR("could not allocate the search");
+    return -1;
+  }
+
+  s->jobs = job_pool_create(s->threads);
+  if (s->jobs == NULL) {
+    return -1;
+  }
+
+  register size_t i;
+  for (i = 0; i < s->threads; i++) {
+    struct worker *k = &s->workers[i];
+    k->s = s;
+    k->w = create_world(s, o->seed);
+    k->reached = calloc(n, sizeof(bool));
+    if (k->w == NULL || k->reached == NULL) {
+      return -1;
+    }
+  }
+
+  const struct lily_world *w = s->workers[0].w;
+  s->lives = w->player->lives;
+
+  for (i = 0; i < n; i++) {
+    if (w->sprite_types[s->t->passive_sprites[i]].parent_id == SPRITE_DOOR) {
+      s->doors[s->door_count++] = i;
+    }
+  }
+
+  if (visited_create(&s->v, max_states) != 0) {
+    return -1;
+  }
+
+  struct node *root = &s->frontier[0];
+  root->key = state_key(w);
+  root->len = snapshot_save(w, NULL, 0);
+  root->snap = malloc(root->len);
+  if (root->snap == NULL) {
+    LOG_ERROR("could not allocate snapshot");
+    return -1;
+  }
+
+  snapshot_save(w, root->snap, root->len);
+  s->frontier_len = 1;
+  visited_insert(&s->v, root->key);
+  root->trace = trace_append(s, NO_PARENT, 0);
+  if (root->trace == NO_PARENT) {
+    return -1;
+  }
+
+  int r, c;
+  util_nearest(w->player->s, &r, &c);
+  if (r >= 0 && c >= 0 && (size_t)r < s->rows && (size_t)c < s->cols) {
+    s->workers[0].reached[r * s->cols + c] = true;
+  }
+
+  return 0;
+}
+
+static void finish(struct search *s) {
+  if (s->jobs != NULL) {
+    job_pool_destroy(&s->jobs);
+  }
+
+  if (s->workers != NULL) {
+    register size_t i;
+    for (i = 0; i < s->threads; i++) {
+      struct worker *k = &s->workers[i];
+      if (k->w != NULL) {
+        lily_world_destroy(&k->w);
+      }
+
+      register size_t j;
+      for (j = 0; j < k->out_len; j++) {
+        free(k->out[j].snap);
+      }
+      free(k->out);
+      free(k->reached);
+    }
+  }
+
+  free_frontier(s);
+  free(s->workers);
+  free(s->doors);
+  free(s->trace);
+  free(s->v.keys);
+}
+
+int analyzer_run(struct level_template *t, const struct analyzer_options *o,
+                 struct analyzer_result *res) {
+  assert_not_null(3, t, o, res);
+  memset(res, 0, sizeof(struct analyzer_result));
+
+  const int cpus = SDL_GetCPUCount();
+  const size_t max_depth =
+      o->max_depth != 0 ? o->max_depth : ANALYZER_MAX_DEPTH;
+  const size_t max_states =
+      o->max_states != 0 ? o->max_states : ANALYZER_MAX_STATES;
+
+  struct search s = {0};
+  s.t = t;
+  s.hold = o->hold != 0 ? o->hold : ANALYZER_HOLD;
+  s.rows = ROW_COUNT * t->h;
+  s.cols = COLUMN_COUNT * t->w;
+  s.threads = o->threads != 0 ? o->threads : (size_t)SDL_max(cpus, 1);
+
+  res->rows = s.rows;
+  res->cols = s.cols;
+  res->reached = calloc(s.rows * s.cols, sizeof(bool));
+  if (res->reached == NULL || start(&s, o, max_states) != 0) {
+    goto error_out;
+  }
+
+  bool pruned = false, full = false;
+  while (s.frontier_len > 0 && res->depth < max_depth) {
+    if (expand_depth(&s) != 0) {
+      goto error_out;
+    }
+    res->depth++;
+
+    register size_t i;
+    for (i = 0; i < s.threads; i++) {
+      full = full || s.workers[i].full;
+    }
+
+    // the workers expand ranges of the frontier in order, so the first one
+    // that found the door found it from the earliest node
+    for (i = 0; i < s.threads; i++) {
+      const struct worker *k = &s.workers[i];
+      if (k->found) {
+        const Uint32 last = s.frontier[k->goal].trace;
+        if (replay(&s, o->seed, last, k->goal_action, res) != 0) {
+          goto error_out;
+        }
+        res->reachable = true;
+        break;
+      }
+    }
+
+    if (res->reachable) {
+      break;
+    }
+
+    if (next_depth(&s, o->beam, &pruned) != 0) {
+      goto error_out;
+    }
+  }
+
+  if (!res->reachable && s.frontier_len > 0) {
+    pruned = true; // max_depth was reached
+  }
+
+  register size_t i, j;
+  for (i = 0; i < s.threads; i++) {
+    for (j = 0; j < s.rows * s.cols; j++) {
+      res->reached[j] = res->reached[j] || s.workers[i].reached[j];
+    }
+  }
+
+  res->exhaustive = !pruned && !full;
+  res->states = visited_count(&s.v);
+
+  if (find_regions(&s, s.workers[0].w, res) != 0) {
+    goto error_out;
+  }
+
+  finish(&s);
+  return 0;
+
+error_out:
+  finish(&s);
+  analyzer_result_free(res);
+  return -1;
+}
+
+void analyzer_result_free(struct analyzer_result *res) {
+  assert_not_null(1, res);
+  free(res->inputs);
+  free(res->reached);
+  free(res->regions);
+  memset(res, 0, sizeof(struct analyzer_result));
+}
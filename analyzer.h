@@ -0,0 +1,108 @@
+#ifndef ANALYZER_H
+#define ANALYZER_H
+
+#include "base.h"
+
+#include "level_template.h"
+#include <stdbool.h>
+
+// analyzer proves that the door of a level can be reached, by searching the
+// inputs of the player with the real game logic. Starting from the start of
+// the level, every state is expanded by holding each of a small set of actions
+// (walk, sprint, jump, climb...) for a few frames, stepping a world with
+// lily_world_step (see lily.h) and restoring it with snapshots (see
+// snapshot.h) between actions. So moving platforms, springs, ladders and
+// enemies behave exactly like in the game.
+//
+// The search is a breadth-first search over quantized player states: the
+// position (to ANALYZER_POSITION_STEP pixels), the velocity (to
+// ANALYZER_VELOCITY_STEP pixels per second), and whether the player is
+// mid-air, on a ladder or can jump. Two worlds whose players are in the same
+// quantized state are considered the same, regardless of the other sprites, so
+// solutions that depend on the timing of enemies or moving platforms may be
+// missed. Each depth of the search is expanded in parallel, the threads sharing
+// a single set of visited states. Optionally, only the `beam` states closest
+// to a door are kept at each depth (a beam search), which is much faster on
+// large levels but no longer exhaustive.
+//
+// The player may interact with the door (or dismiss a blocking message) at any
+// frame: when the player is on a door, or a message blocks the game, the
+// analyzer presses the interact key for it. States in which the player loses a
+// life or falls out of the level are dead ends.
+
+enum {
+  ANALYZER_POSITION_STEP = 2,  // pixels
+  ANALYZER_VELOCITY_STEP = 32, // pixels per second
+  // the defaults of analyzer_options
+  ANALYZER_HOLD = 4,
+  ANALYZER_MAX_DEPTH = 2000,
+  ANALYZER_MAX_STATES = 1 << 21,
+};
+
+// analyzer_options configures the search. Zeroed options give an exhaustive
+// search with the defaults.
+struct analyzer_options {
+  // threads is the number of threads to search with, or 0 for one per CPU
+  size_t threads;
+  // beam is the maximum number of states expanded at each depth, or 0 for no
+  // limit
+  size_t beam;
+  // hold is the number of frames each action is held for, or 0 for
+  // ANALYZER_HOLD. Shorter holds find more precise paths, but take longer.
+  size_t hold;
+  // max_depth is the maximum number of actions in a path, or 0 for
+  // ANALYZER_MAX_DEPTH
+  size_t max_depth;
+  // max_states is the maximum number of states visited, or 0 for
+  // ANALYZER_MAX_STATES
+  size_t max_states;
+  // seed seeds the pseudo-random number generator of the worlds, see
+  // lily_world_seed
+  Uint64 seed;
+};
+
+// analyzer_region is a connected region of open tiles that the player never
+// reached
+struct analyzer_region {
+  size_t r, c; // the top left corner of the bounding box of the region
+  size_t h, w; // the size of the bounding box of the region
+  size_t size; // the number of tiles in the region
+};
+
+// analyzer_result is the outcome of a search, see analyzer_run
+struct analyzer_result {
+  // reachable is true if the player can complete the level through a door
+  bool reachable;
+  // exhaustive is true if the search was not cut short by the beam or by the
+  // limits of the options. If it is true and the door is not reachable, no
+  // sequence of actions reaches it (up to the quantization of the states).
+  bool exhaustive;
+  // inputs is the shortest sequence of inputs found that completes the level,
+  // one per frame (see input.h), from the start of the level. It holds
+  // input_count values, and is NULL if the door is not reachable.
+  Uint32 *inputs;
+  size_t input_count;
+  size_t depth;  // the number of actions of the deepest states searched
+  size_t states; // the number of distinct states visited
+
+  // reached has one value per tile of the level (rows * cols, row by row),
+  // true if the player was on the tile in any searched frame
+  bool *reached;
+  size_t rows;
+  size_t cols;
+  // regions lists the region_count regions of open tiles (i.e tiles that are
+  // not solid) that the player never reached, from the top left of the level
+  struct analyzer_region *regions;
+  size_t region_count;
+};
+
+// analyzer_run searches the level instantiated from the template t. Populates
+// res, which must be freed with analyzer_result_free. Returns 0 on success
+// (whether or not the door is reachable), -1 on failure.
+int analyzer_run(struct level_template *t, const struct analyzer_options *o,
+                 struct analyzer_result *res);
+
+// analyzer_result_free frees the memory held by res
+void analyzer_result_free(struct analyzer_result *res);
+
+#endif // ANALYZER_H
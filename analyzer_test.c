@@ -0,0 +1,166 @@
+#include "analyzer.h"
+
+#include "lily.h"
+#include "test.h"
+#include "util.h"
+#include <stdlib.h>
+
+static const struct token_entry TOKENS[] = {
+    {'=', SPRITE_WALL_TOP, token_passive_sprite},
+    {'*', SPRITE_WALL, token_passive_sprite},
+    {'L', SPRITE_LADDER, token_passive_sprite},
+    {'D', SPRITE_DOOR, token_passive_sprite},
+    {'P', SPRITE_PLAYER, token_player},
+    {' ', SPRITE_NONE, NULL}};
+
+static const size_t TOKEN_SIZE = 6;
+
+// the door is on a ledge, which can only be reached by climbing the ladder
+static const char LEVEL[] = "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "                 D  \n"
+                            "           L========\n"
+                            "           L        \n"
+                            "           L        \n"
+                            "           L        \n"
+                            "  P        L        \n"
+                            "====================\n"
+                            "********************";
+
+// the door is walled in
+static const char WALLED_LEVEL[] = "                    \n"
+                                   "                    \n"
+                                   "                    \n"
+                                   "                    \n"
+                                   "                    \n"
+                                   "                    \n"
+                                   "                    \n"
+                                   "              ******\n"
+                                   "              *    *\n"
+                                   "              *    *\n"
+                                   "              *    *\n"
+                                   "  P           *  D *\n"
+                                   "              ******\n"
+                                   "====================\n"
+                                   "********************";
+
+static struct level_template *template(const char *level, const size_t len) {
+  char *str;
+  size_t w, h;
+  assert(util_level_from_buffer(level, len, &str, &w, &h) > 0);
+
+  struct level_template *t =
+      level_template_from_string(str, w, h, TOKENS, TOKEN_SIZE);
+  assert(t != NULL);
+  free(str);
+  return t;
+}
+
+// the inputs found by the analyzer complete the level in a new world
+static void test_reachable(void) {
+  struct level_template *t = template(LEVEL, sizeof(LEVEL) - 1);
+  const struct analyzer_options o = {.threads = 1};
+  struct analyzer_result res;
+
+  assert(analyzer_run(t, &o, &res) == 0);
+  assert(res.reachable);
+  assert(res.input_count > 0);
+  assert(res.states > 0);
+
+  struct lily_world *w = lily_world_create();
+  assert(w != NULL);
+  assert(lily_world_load_level_template(w, t) == 0);
+
+  register size_t i;
+  for (i = 0; i < res.input_count; i++) {
+    struct lily_status st;
+    lily_world_status(w, &st);
+    assert(st.state == PROG_GAME_IN);
+    assert(lily_world_step(w, res.inputs[i], FRAME_TIME) == 0);
+  }
+
+  struct lily_status st;
+  lily_world_status(w, &st);
+  assert(st.state == PROG_GAME_LEVEL_COMPLETE);
+
+  lily_world_destroy(&w);
+  analyzer_result_free(&res);
+  level_template_release(&t);
+}
+
+// an exhaustive search proves that a walled in door cannot be reached, and
+// finds the unreachable room around it
+static void test_unreachable(void) {
+  struct level_template *t = template(WALLED_LEVEL, sizeof(WALLED_LEVEL) - 1);
+  const struct analyzer_options o = {.threads = 2};
+  struct analyzer_result res;
+
+  assert(analyzer_run(t, &o, &res) == 0);
+  assert(!res.reachable);
+  assert(res.exhaustive);
+  assert(res.inputs == NULL);
+  assert(res.rows == 15 && res.cols == 20);
+
+  // the player walks on the ground
+  assert(res.reached[12 * res.cols + 2]);
+  assert(res.reached[12 * res.cols + 10]);
+
+  // the inside of the room is one of the unreachable regions
+  bool room = false;
+  register size_t i;
+  for (i = 0; i < res.region_count; i++) {
+    const struct analyzer_region *r = &res.regions[i];
+    if (r->r == 8 && r->c == 15 && r->h == 4 && r->w == 4) {
+      assert(r->size == 16);
+      room = true;
+    }
+  }
+  assert(room);
+
+  analyzer_result_free(&res);
+  level_template_release(&t);
+}
+
+// the path found does not depend on the number of threads, and a beam search
+// finds the door too
+static void test_options(void) {
+  struct level_template *t = template(LEVEL, sizeof(LEVEL) - 1);
+  struct analyzer_options o = {.threads = 1};
+  struct analyzer_result one, many, beam;
+
+  assert(analyzer_run(t, &o, &one) == 0);
+  o.threads = 4;
+  assert(analyzer_run(t, &o, &many) == 0);
+  assert(many.reachable);
+  assert(many.depth == one.depth);
+
+  o.beam = 8;
+  assert(analyzer_run(t, &o, &beam) == 0);
+  assert(beam.reachable);
+  assert(beam.states < one.states);
+
+  // a search that is too short finds nothing, and says so
+  o.beam = 0;
+  o.max_depth = 2;
+  analyzer_result_free(&beam);
+  assert(analyzer_run(t, &o, &beam) == 0);
+  assert(!beam.reachable);
+  assert(!beam.exhaustive);
+
+  analyzer_result_free(&beam);
+  analyzer_result_free(&many);
+  analyzer_result_free(&one);
+  level_template_release(&t);
+}
+
+int main(void) {
+  RUN_TEST(test_reachable);
+  RUN_TEST(test_unreachable);
+  RUN_TEST(test_options);
+  return 0;
+}
@@ -15,6 +15,7 @@ struct array *array_new(void) {
   a->l = 0;
   a->free_on_clean = true;
   a->destroy_on_clean = true;
+  a->placed = 0;
 
   // Some implementation of calloc, especially older ones such as the 4.4 BSD
   // implementation [1] do *not* check for multiplication overflow. So we do it
@@ -38,7 +39,7 @@ struct array *array_new(void) {
   return a;
 }
 
-void array_free(struct array **pa) {
+void array_free(struct lily_world *w, struct array **pa) {
   assert_not_null(2, pa, *pa);
   struct array *a = *pa;
 
@@ -49,17 +50,45 @@ void array_free(struct array **pa) {
     s->removed = true;
   }
 
-  array_clean(a);
+  array_clean(w, a);
 
   free(a->a);
   free(a);
   *pa = NULL;
 }
 
-void array_clean(struct array *a) {
+// place moves the first sprite after the placed sprites of the array a to the
+// end of its depth bucket. ends[id] is one past the index of the last sprite
+// of the bucket of id: the buckets are laid out from the last sprite_id to the
+// first, so ends[0] is the number of placed sprites. Every bucket after the
+// bucket of the sprite moves by one, by moving its first sprite after its last.
+static void place(struct array *a, size_t *ends) {
+  struct sprite *s = a->a[ends[0]];
+  const size_t id = s->type->id;
+  assert(id < SPRITE_TYPE_COUNT);
+
+  // hole is the index to move a sprite to, right after the bucket k
+  size_t hole = ends[0];
+  register size_t k;
+  for (k = 0; k < id; k++) {
+    if (ends[k + 1] < ends[k]) {
+      a->a[hole] = a->a[ends[k + 1]];
+      hole = ends[k + 1];
+    }
+    ends[k]++;
+  }
+
+  a->a[hole] = s;
+  ends[id]++;
+}
+
+void array_clean(struct lily_world *w, struct array *a) {
   assert_not_null(1, a);
 
   size_t r = 0;
+  // ends is the number of placed sprites of each sprite_id that are kept, until
+  // it is turned into the ends of the buckets (see place)
+  size_t ends[SPRITE_TYPE_COUNT] = {0};
 
   register size_t i;
   for (i = 0; i < a->l; i++) {
@@ -69,7 +98,7 @@ void array_clean(struct array *a) {
         // call the destroy handler of the sprite. It is okay to make this a
         // compile time assertion as deallocation is usually a fail-safe
         // operation (e.g the free function).
-        assert(s->type->destroy_handler(s) == 0);
+        assert(s->type->destroy_handler(w, s) == 0);
       }
 
       if (a->free_on_clean) {
@@ -77,13 +106,31 @@ void array_clean(struct array *a) {
       }
 
       r += 1;
-    } else if (r) {
+      continue;
+    }
+
+    if (i < a->placed) {
+      ends[s->type->id]++;
+    }
+
+    if (r) {
       a->a[i - r] = s;
       a->a[i] = NULL;
     }
   }
 
   a->l -= r;
+
+  // the kept sprites were moved without changing their order, so the placed
+  // ones are still in their bucket
+  for (i = SPRITE_TYPE_COUNT - 1; i > 0; i--) {
+    ends[i - 1] += ends[i];
+  }
+
+  while (ends[0] < a->l) {
+    place(a, ends);
+  }
+  a->placed = a->l;
 }
 
 int array_append(struct array *a, struct sprite *s) {
@@ -129,16 +176,18 @@ int array_append(struct array *a, struct sprite *s) {
   return 0;
 }
 
-// sprite_compare is used for qsort in array_sort
-static int sprite_compare(const void *a, const void *b) {
-  assert_not_null(2, a, b);
-  const struct sprite *sa = *(const struct sprite **)a;
-  const struct sprite *sb = *(const struct sprite **)b;
-
-  return (sb->type->id - sa->type->id);
-}
-
 void array_sort(struct array *a) {
   assert_not_null(1, a);
-  qsort(a->a, a->l, sizeof(struct sprite *), sprite_compare);
+
+  // an insertion sort keeps the order of the sprites of a same sprite_id
+  register size_t i, j;
+  for (i = 1; i < a->l; i++) {
+    struct sprite *s = a->a[i];
+    for (j = i; j > 0 && a->a[j - 1]->type->id < s->type->id; j--) {
+      a->a[j] = a->a[j - 1];
+    }
+    a->a[j] = s;
+  }
+
+  a->placed = a->l;
 }
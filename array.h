@@ -6,6 +6,8 @@
 
 #include <stdbool.h>
 
+struct lily_world;
+
 #define ARRAY_INIT_CAPACITY 32
 
 // array is a dynamically allocated, automatically resized array for sprites
@@ -24,24 +26,40 @@ struct array {
   // If this is true, the destroy handler for a removed sprite is called when
   // array_clean is called. By default, this is set to true.
   bool destroy_on_clean;
+  // The sprites are kept in descending order of depth (see enum sprite_id), in
+  // one bucket per sprite_id. placed is the number of sprites at the start of
+  // the array that are in their bucket. The sprites after them were appended
+  // since the last call to array_clean, which moves them to their bucket, so
+  // sprites can be appended while iterating over the array.
+  size_t placed;
 };
 
 // array_new creates a new sprite array with capacity ARRAY_INIT_CAPACITY
 struct array *array_new(void);
 
-// array_free frees the memory taken up by a sprite array and sets it to NULL
-void array_free(struct array **pa);
+// array_free frees the memory taken up by a sprite array and sets it to NULL.
+// w is the world the sprites belong to, see array_clean.
+void array_free(struct lily_world *w, struct array **pa);
 
-// array_clean removes and frees all sprites with sprite->remove set to true
-void array_clean(struct array *a);
+// array_clean removes and frees all sprites with sprite->remove set to true.
+// w is the world the sprites belong to, it is passed to their destroy handler
+// and may be NULL if destroy_on_clean is false. The sprites appended since the
+// last call are then moved to the end of their depth bucket, which moves at
+// most one sprite per bucket: the order of the sprites within a bucket is not
+// kept.
+void array_clean(struct lily_world *w, struct array *a);
 
-// array_append appends a sprite to the array.
-// Returns 0 on success and -1 on failure.
+// array_append appends a sprite to the end of the array, until array_clean
+// moves it to its depth bucket. Returns 0 on success and -1 on failure.
 int array_append(struct array *a, struct sprite *s);
 
 // array_sort sorts the array by the depth of each sprite_id (stored in
-// sprite.type->id). sprite_id is an enum defined in descending order of depth.
-// Take a look at enum sprite_id in base.h for more information on this.
+// sprite.type->id), keeping the order of the sprites of a same sprite_id.
+// sprite_id is an enum defined in descending order of depth. Take a look at
+// enum sprite_id in sprite_type.h for more information on this. There is no
+// need to sort an array that is only changed with array_append and
+// array_clean: this is for arrays whose sprites were overwritten, and takes a
+// single pass over an array that is sorted already.
 void array_sort(struct array *a);
 
 #endif // ARRAY_H
@@ -7,7 +7,7 @@ static void test_array_allocation(void) {
   assert(a != NULL);
   assert(a->l == 0);
 
-  array_free(&a);
+  array_free(NULL, &a);
   assert(a == NULL);
 }
 
@@ -41,7 +41,7 @@ static void test_array_append(void) {
   assert(a->l == ARRAY_INIT_CAPACITY + 2);
   assert(a->c > ARRAY_INIT_CAPACITY + 2);
 
-  array_free(&a);
+  array_free(NULL, &a);
 }
 
 static void test_array_clean(void) {
@@ -53,16 +53,19 @@ static void test_array_clean(void) {
   a->destroy_on_clean = false;
 
   struct sprite s1, s2, s3;
+  struct sprite_type t;
+  t.id = SPRITE_TEST_LO_DEPTH;
 
   s1.removed = false;
   s2.removed = true;
   s3.removed = false;
+  s1.type = s2.type = s3.type = &t;
 
   array_append(a, &s1);
   array_append(a, &s2);
   array_append(a, &s3);
 
-  array_clean(a);
+  array_clean(NULL, a);
 
   assert(a->l == 2);
   assert(a->a[0] == &s1);
@@ -71,15 +74,13 @@ static void test_array_clean(void) {
   s1.removed = true;
   s3.removed = true;
 
-  array_clean(a);
+  array_clean(NULL, a);
   assert(a->l == 0);
 
-  array_free(&a);
+  array_free(NULL, &a);
 }
 
 static void test_array_sort(void) {
-  // we trust qsort here. Just checking if our comparison function does what we
-  // think it does.
   struct array *a = array_new();
   assert(a != NULL);
 
@@ -106,7 +107,63 @@ static void test_array_sort(void) {
   assert(a->a[0]->type->id == SPRITE_TEST_HI_DEPTH);
   assert(a->a[1]->type->id == SPRITE_TEST_LO_DEPTH);
 
-  array_free(&a);
+  array_free(NULL, &a);
+}
+
+// sprites appended to an array are moved to their depth bucket by array_clean
+static void test_array_depth(void) {
+  struct array *a = array_new();
+  assert(a != NULL);
+
+  a->free_on_clean = false;
+  a->destroy_on_clean = false;
+
+  struct sprite_type lo, hi;
+  lo.id = SPRITE_TEST_LO_DEPTH;
+  hi.id = SPRITE_TEST_HI_DEPTH;
+
+  struct sprite s[5];
+  register size_t i;
+  for (i = 0; i < 5; i++) {
+    s[i].removed = false;
+    s[i].type = i % 2 == 0 ? &hi : &lo;
+  }
+
+  array_append(a, &s[0]);
+  array_append(a, &s[1]);
+  array_clean(NULL, a);
+  assert(a->placed == 2);
+
+  // a sprite spawned later is appended, and then rendered at its depth
+  array_append(a, &s[2]);
+  assert(a->a[2] == &s[2]);
+  array_clean(NULL, a);
+  assert(a->l == 3 && a->placed == 3);
+  assert(a->a[0] == &s[0]);
+  assert(a->a[1] == &s[2]);
+  assert(a->a[2] == &s[1]);
+
+  array_append(a, &s[3]);
+  array_append(a, &s[4]);
+  s[2].removed = true;
+  array_clean(NULL, a);
+  assert(a->l == 4 && a->placed == 4);
+  assert(a->a[0]->type == &hi && a->a[1]->type == &hi);
+  assert(a->a[2]->type == &lo && a->a[3]->type == &lo);
+  assert(a->a[0] == &s[0] || a->a[1] == &s[0]);
+  assert(a->a[0] == &s[4] || a->a[1] == &s[4]);
+
+  // an array that is already sorted is left unchanged
+  struct sprite *sorted[4];
+  for (i = 0; i < 4; i++) {
+    sorted[i] = a->a[i];
+  }
+  array_sort(a);
+  for (i = 0; i < 4; i++) {
+    assert(a->a[i] == sorted[i]);
+  }
+
+  array_free(NULL, &a);
 }
 
 int main(int argc, char *argv[]) {
@@ -117,6 +174,7 @@ int main(int argc, char *argv[]) {
   RUN_TEST(test_array_append);
   RUN_TEST(test_array_clean);
   RUN_TEST(test_array_sort);
+  RUN_TEST(test_array_depth);
 
   return EXIT_SUCCESS;
 }
@@ -17,13 +17,15 @@
 // the maximum velocity at which the player or other sprites can move
 extern const double MAX_VELOCITY;
 
-// SIZE_FACTOR is what every tile will be multiplied by prior to rendering it.
+// SIZE_FACTOR is the default scale of the window. The text and the menus are
+// laid out in the pixels of a window of that scale, and scaled along with the
+// game world to the actual scale of the window (see scene_state_clear).
 #define SIZE_FACTOR 2
-// LEVEL_WIDTH is the width of the screen in terms of *logical* pixels. To
-// translate this into *real* pixels, multiply by SIZE_FACTOR.
+// LEVEL_WIDTH is the width of the screen in terms of *logical* pixels. The
+// game world is rendered at this size, and then scaled up to the window (see
+// scene_world_begin).
 #define LEVEL_WIDTH 320
-// LEVEL_HEIGHT is the height of the screen in terms of *logical* pixels. To
-// translate this into *real* pixels, multiply by SIZE_FACTOR.
+// LEVEL_HEIGHT is the height of the screen in terms of *logical* pixels.
 #define LEVEL_HEIGHT 240
 // SPRITE_SIZE is the size (width and height, in pixels) of each sprite in the
 // sprite sheet.
@@ -0,0 +1,167 @@
+#include "batch.h"
+
+#include "safe.h"
+
+// A sprite is a quad of 4 vertices (top left, top right, bottom left and
+// bottom right) drawn as 2 triangles, hence 6 indices. The indices only depend
+// on the position of the quad in the batch, so they are written once, when the
+// buffers grow.
+
+enum {
+  QUAD_VERTICES = 4,
+  QUAD_INDICES = 6,
+  // MIN_QUADS is the initial capacity of a batch, in sprites. A screen of
+  // tiles fits in it.
+  MIN_QUADS = 512,
+};
+
+struct batch {
+  SDL_Texture *texture;
+  // inv_w and inv_h map pixels of the texture to texture coordinates
+  float inv_w;
+  float inv_h;
+
+  SDL_Vertex *vertices;
+  int *indices;
+  size_t len; // the number of sprites in the batch
+  size_t cap; // the number of sprites the buffers can hold
+};
+
+// reserve makes sure the buffers of the batch hold at least n sprites. Returns
+// 0 on success, -1 on failure.
+static int reserve(struct batch *b, const size_t n) {
+  if (n <= b->cap) {
+    return 0;
+  }
+
+  size_t cap = b->cap > 0 ? b->cap : MIN_QUADS;
+  while (cap < n) {
+    cap *= 2;
+  }
+
+  SDL_Vertex *vertices =
+      realloc(b->vertices, cap * QUAD_VERTICES * sizeof(SDL_Vertex));
+  if (vertices == NULL) {
+    goto error_out;
+  }
+  b->vertices = vertices;
+
+  int *indices = realloc(b->indices, cap * QUAD_INDICES * sizeof(int));
+  if (indices == NULL) {
+    goto error_out;
+  }
+  b->indices = indices;
+
+  register size_t i;
+  for (i = b->cap; i < cap; i++) {
+    const int v = (int)(i * QUAD_VERTICES);
+    int *idx = &indices[i * QUAD_INDICES];
+    idx[0] = v;
+    idx[1] = v + 1;
+    idx[2] = v + 2;
+    idx[3] = v + 2;
+    idx[4] = v + 1;
+    idx[5] = v + 3;
+  }
+
+  b->cap = cap;
+  return 0;
+
+error_out:
+  LOG_ERROR("could not allocate memory for the sprite batch");
+  return -1;
+}
+
+struct batch *batch_create(SDL_Texture *t) {
+  assert_not_null(1, t);
+
+  int w, h;
+  if (SDL_QueryTexture(t, NULL, NULL, &w, &h) != 0) {
+    LOG_ERROR("%s", SDL_GetError());
+    return NULL;
+  }
+
+  struct batch *b = calloc(1, sizeof(struct batch));
+  if (b == NULL) {
+    LOG_ERROR("could not allocate memory for the sprite batch");
+    return NULL;
+  }
+
+  b->texture = t;
+  b->inv_w = 1.0f / w;
+  b->inv_h = 1.0f / h;
+
+  if (reserve(b, MIN_QUADS) != 0) {
+    batch_destroy(&b);
+    return NULL;
+  }
+
+  return b;
+}
+
+void batch_destroy(struct batch **pb) {
+  struct batch *b = *pb;
+  free(b->vertices);
+  free(b->indices);
+  free(b);
+  *pb = NULL;
+}
+
+int batch_add(struct batch *b, const SDL_Rect *src, const SDL_Rect *dst,
+              const Uint8 alpha, const SDL_RendererFlip flip) {
+  assert_not_null(3, b, src, dst);
+
+  if (src->w <= 0 || src->h <= 0 || alpha == 0) {
+    return 0;
+  }
+
+  if (reserve(b, b->len + 1) != 0) {
+    return -1;
+  }
+
+  float u0 = src->x * b->inv_w, u1 = (src->x + src->w) * b->inv_w;
+  float v0 = src->y * b->inv_h, v1 = (src->y + src->h) * b->inv_h;
+  if (flip & SDL_FLIP_HORIZONTAL) {
+    const float u = u0;
+    u0 = u1;
+    u1 = u;
+  }
+  if (flip & SDL_FLIP_VERTICAL) {
+    const float v = v0;
+    v0 = v1;
+    v1 = v;
+  }
+
+  const float x0 = (float)dst->x, x1 = (float)(dst->x + dst->w);
+  const float y0 = (float)dst->y, y1 = (float)(dst->y + dst->h);
+  const SDL_Color color = {255, 255, 255, alpha};
+
+  SDL_Vertex *v = &b->vertices[b->len * QUAD_VERTICES];
+  v[0] = (SDL_Vertex){{x0, y0}, color, {u0, v0}};
+  v[1] = (SDL_Vertex){{x1, y0}, color, {u1, v0}};
+  v[2] = (SDL_Vertex){{x0, y1}, color, {u0, v1}};
+  v[3] = (SDL_Vertex){{x1, y1}, color, {u1, v1}};
+
+  b->len++;
+  return 0;
+}
+
+int batch_flush(struct batch *b, SDL_Renderer *r) {
+  assert_not_null(2, b, r);
+
+  if (b->len == 0) {
+    return 0;
+  }
+
+  const int ret = SDL_RenderGeometry(
+      r, b->texture, b->vertices, (int)(b->len * QUAD_VERTICES), b->indices,
+      (int)(b->len * QUAD_INDICES));
+  b->len = 0;
+
+  if (ret != 0) {
+    LOG_ERROR("%s", SDL_GetError());
+    return -1;
+  }
+
+  return 0;
+}
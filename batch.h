@@ -0,0 +1,36 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "base.h"
+
+#include <SDL2/SDL.h>
+
+// batch draws many sprites of a texture (the sprite sheet) with a single draw
+// call. Each sprite added to the batch becomes a textured quad in a vertex
+// buffer: the alpha of the sprite is the color of its vertices, and flipping
+// the sprite swaps the texture coordinates of its corners. Flushing the batch
+// renders every quad at once with SDL_RenderGeometry, in the order they were
+// added, instead of one SDL_RenderCopy per sprite.
+
+// batch is a batch of sprites to draw
+struct batch;
+
+// batch_create creates an empty batch of sprites of the texture t. Returns NULL
+// on failure.
+struct batch *batch_create(SDL_Texture *t);
+
+// batch_destroy frees the memory of the batch and sets *pb to NULL. It does
+// not destroy the texture.
+void batch_destroy(struct batch **pb);
+
+// batch_add adds the sprite at src in the texture, rendered at dst with the
+// given alpha and flip, to the batch. Empty sprites are skipped. Returns 0 on
+// success, -1 on failure.
+int batch_add(struct batch *b, const SDL_Rect *src, const SDL_Rect *dst,
+              const Uint8 alpha, const SDL_RendererFlip flip);
+
+// batch_flush renders the sprites of the batch with the renderer r, and empties
+// the batch. Returns 0 on success, -1 on failure.
+int batch_flush(struct batch *b, SDL_Renderer *r);
+
+#endif // BATCH_H
@@ -26,7 +26,7 @@ enum {
 };
 
 const struct token_entry CUSTOM_LEVEL_TOKENS[CUSTOM_LEVEL_TOKEN_COUNT] = {
-    {'~', SPRITE_WATER_TOP, token_active_sprite},
+    {'~', SPRITE_WATER_TOP, token_passive_sprite},
     {'`', SPRITE_WATER, token_passive_sprite},
     {'L', SPRITE_LADDER, token_passive_sprite},
     {'p', SPRITE_PLATFORM, token_active_sprite},
@@ -36,12 +36,12 @@ const struct token_entry CUSTOM_LEVEL_TOKENS[CUSTOM_LEVEL_TOKEN_COUNT] = {
     {'g', SPRITE_GRASS, token_passive_sprite},
     {'_', SPRITE_GROUND, token_passive_sprite},
     {'s', SPRITE_SPIDER, token_active_sprite},
-    {'O', SPRITE_COIN, token_active_sprite},
+    {'O', SPRITE_COIN, token_item},
     {'D', SPRITE_DOOR, token_passive_sprite},
     {'P', SPRITE_PLAYER, token_player},
     {'S', SPRITE_SPRINTING_SPIDER, token_active_sprite},
     {'G', SPRITE_GHOST, token_active_sprite},
-    {'E', SPRITE_EXTRA_LIFE, token_active_sprite},
+    {'E', SPRITE_EXTRA_LIFE, token_item},
     {'p', SPRITE_PLATFORM, token_active_sprite},
     {'X', SPRITE_SPRING, token_active_sprite},
     {'k', SPRITE_SKELETON, token_active_sprite},
@@ -51,7 +51,7 @@ const struct token_entry CUSTOM_LEVEL_TOKENS[CUSTOM_LEVEL_TOKEN_COUNT] = {
     {' ', SPRITE_NONE, NULL}};
 
 const struct token_entry LEVEL_0_TOKENS[LEVEL_0_COUNT] = {
-    {'~', SPRITE_WATER_TOP, token_active_sprite},
+    {'~', SPRITE_WATER_TOP, token_passive_sprite},
     {'h', SPRITE_CAT_HELPER, token_active_sprite},
     {'H', SPRITE_HELPER, token_active_sprite},
     {'=', SPRITE_WALL_TOP, token_passive_sprite},
@@ -60,26 +60,26 @@ const struct token_entry LEVEL_0_TOKENS[LEVEL_0_COUNT] = {
     {'g', SPRITE_GRASS, token_passive_sprite},
     {'_', SPRITE_GROUND, token_passive_sprite},
     {'s', SPRITE_SPIDER, token_active_sprite},
-    {'O', SPRITE_COIN, token_active_sprite},
+    {'O', SPRITE_COIN, token_item},
     {'D', SPRITE_DOOR, token_passive_sprite},
     {'P', SPRITE_PLAYER, token_player},
     {' ', SPRITE_NONE, NULL}};
 
 const struct token_entry LEVEL_1_TOKENS[LEVEL_1_COUNT] = {
     {'H', SPRITE_LADDER_HELPER, token_active_sprite},
-    {'~', SPRITE_WATER_TOP, token_active_sprite},
+    {'~', SPRITE_WATER_TOP, token_passive_sprite},
     {'`', SPRITE_WATER, token_passive_sprite},
     {'=', SPRITE_WALL_TOP, token_passive_sprite},
     {'*', SPRITE_WALL, token_passive_sprite},
     {'L', SPRITE_LADDER, token_passive_sprite},
     {'s', SPRITE_SPIDER, token_active_sprite},
-    {'O', SPRITE_COIN, token_active_sprite},
+    {'O', SPRITE_COIN, token_item},
     {'D', SPRITE_DOOR, token_passive_sprite},
     {'P', SPRITE_PLAYER, token_player},
     {' ', SPRITE_NONE, NULL}};
 
 const struct token_entry LEVEL_2_TOKENS[LEVEL_2_COUNT] = {
-    {'~', SPRITE_WATER_TOP, token_active_sprite},
+    {'~', SPRITE_WATER_TOP, token_passive_sprite},
     {'`', SPRITE_WATER, token_passive_sprite},
     {'=', SPRITE_WALL_TOP, token_passive_sprite},
     {'*', SPRITE_WALL, token_passive_sprite},
@@ -87,8 +87,8 @@ const struct token_entry LEVEL_2_TOKENS[LEVEL_2_COUNT] = {
     {'g', SPRITE_GRASS, token_passive_sprite},
     {'_', SPRITE_GROUND, token_passive_sprite},
     {'s', SPRITE_SPRINTING_SPIDER, token_active_sprite},
-    {'O', SPRITE_COIN, token_active_sprite},
-    {'E', SPRITE_EXTRA_LIFE, token_active_sprite},
+    {'O', SPRITE_COIN, token_item},
+    {'E', SPRITE_EXTRA_LIFE, token_item},
     {'D', SPRITE_DOOR, token_passive_sprite},
     {'P', SPRITE_PLAYER, token_player},
     {'L', SPRITE_LADDER, token_passive_sprite},
@@ -97,7 +97,7 @@ const struct token_entry LEVEL_2_TOKENS[LEVEL_2_COUNT] = {
 const struct token_entry LEVEL_3_TOKENS[LEVEL_3_COUNT] = {
     {'a', SPRITE_LEFT_ARROW, token_passive_sprite},
     {'H', SPRITE_GHOST_HELPER, token_active_sprite},
-    {'~', SPRITE_WATER_TOP, token_active_sprite},
+    {'~', SPRITE_WATER_TOP, token_passive_sprite},
     {'`', SPRITE_WATER, token_passive_sprite},
     {'=', SPRITE_RED_WALL_TOP, token_passive_sprite},
     {'*', SPRITE_RED_WALL, token_passive_sprite},
@@ -106,8 +106,8 @@ const struct token_entry LEVEL_3_TOKENS[LEVEL_3_COUNT] = {
     {'_', SPRITE_GROUND, token_passive_sprite},
     {'s', SPRITE_SPRINTING_SPIDER, token_active_sprite},
     {'G', SPRITE_GHOST, token_active_sprite},
-    {'O', SPRITE_COIN, token_active_sprite},
-    {'E', SPRITE_EXTRA_LIFE, token_active_sprite},
+    {'O', SPRITE_COIN, token_item},
+    {'E', SPRITE_EXTRA_LIFE, token_item},
     {'D', SPRITE_DOOR, token_passive_sprite},
     {'P', SPRITE_PLAYER, token_player},
     {'L', SPRITE_LADDER, token_passive_sprite},
@@ -115,39 +115,39 @@ const struct token_entry LEVEL_3_TOKENS[LEVEL_3_COUNT] = {
 
 const struct token_entry LEVEL_4_TOKENS[LEVEL_4_COUNT] = {
     {'p', SPRITE_PLATFORM, token_active_sprite},
-    {'~', SPRITE_WATER_TOP, token_active_sprite},
+    {'~', SPRITE_WATER_TOP, token_passive_sprite},
     {'`', SPRITE_WATER, token_passive_sprite},
     {'=', SPRITE_RUST_WALL_TOP, token_passive_sprite},
     {'*', SPRITE_RUST_WALL, token_passive_sprite},
     {'L', SPRITE_LADDER, token_passive_sprite},
     {'s', SPRITE_SPIDER, token_active_sprite},
-    {'O', SPRITE_COIN, token_active_sprite},
+    {'O', SPRITE_COIN, token_item},
     {'D', SPRITE_DOOR, token_passive_sprite},
     {'P', SPRITE_PLAYER, token_player},
     {'S', SPRITE_SPRINTING_SPIDER, token_active_sprite},
-    {'E', SPRITE_EXTRA_LIFE, token_active_sprite},
+    {'E', SPRITE_EXTRA_LIFE, token_item},
     {'G', SPRITE_GHOST, token_active_sprite},
     {' ', SPRITE_NONE, NULL}};
 
 const struct token_entry LEVEL_5_TOKENS[LEVEL_5_COUNT] = {
     {'p', SPRITE_PLATFORM, token_active_sprite},
-    {'~', SPRITE_WATER_TOP, token_active_sprite},
+    {'~', SPRITE_WATER_TOP, token_passive_sprite},
     {'=', SPRITE_CAVE_TOP, token_passive_sprite},
     {'*', SPRITE_CAVE, token_passive_sprite},
     {'L', SPRITE_LADDER, token_passive_sprite},
     {'s', SPRITE_SPIDER, token_active_sprite},
     {'b', SPRITE_BAT, token_active_sprite},
-    {'O', SPRITE_COIN, token_active_sprite},
+    {'O', SPRITE_COIN, token_item},
     {'D', SPRITE_DOOR, token_passive_sprite},
     {'P', SPRITE_PLAYER, token_player},
     {'S', SPRITE_SPRINTING_SPIDER, token_active_sprite},
-    {'E', SPRITE_EXTRA_LIFE, token_active_sprite},
+    {'E', SPRITE_EXTRA_LIFE, token_item},
     {'G', SPRITE_GHOST, token_active_sprite},
     {' ', SPRITE_NONE, NULL}};
 
 const struct token_entry LEVEL_6_TOKENS[LEVEL_6_COUNT] = {
     {'X', SPRITE_SPRING, token_active_sprite},
-    {'~', SPRITE_WATER_TOP, token_active_sprite},
+    {'~', SPRITE_WATER_TOP, token_passive_sprite},
     {'`', SPRITE_WATER, token_passive_sprite},
     {'h', SPRITE_CAT_HELPER, token_active_sprite},
     {'H', SPRITE_HELPER, token_active_sprite},
@@ -157,7 +157,7 @@ const struct token_entry LEVEL_6_TOKENS[LEVEL_6_COUNT] = {
     {'g', SPRITE_GRASS, token_passive_sprite},
     {'_', SPRITE_GROUND, token_passive_sprite},
     {'s', SPRITE_SKELETON, token_active_sprite},
-    {'O', SPRITE_COIN, token_active_sprite},
+    {'O', SPRITE_COIN, token_item},
     {'D', SPRITE_DOOR, token_passive_sprite},
     {'P', SPRITE_PLAYER, token_player},
     {'S', SPRITE_SPRINTING_SPIDER, token_active_sprite},
@@ -165,11 +165,11 @@ const struct token_entry LEVEL_6_TOKENS[LEVEL_6_COUNT] = {
     {'b', SPRITE_BAT, token_active_sprite},
     {'p', SPRITE_PLATFORM, token_active_sprite},
     {'L', SPRITE_LADDER, token_passive_sprite},
-    {'E', SPRITE_EXTRA_LIFE, token_active_sprite},
+    {'E', SPRITE_EXTRA_LIFE, token_item},
     {' ', SPRITE_NONE, NULL}};
 
 const struct token_entry LEVEL_9_TOKENS[LEVEL_9_COUNT] = {
-    {'~', SPRITE_WATER_TOP, token_active_sprite},
+    {'~', SPRITE_WATER_TOP, token_passive_sprite},
     {'`', SPRITE_WATER, token_passive_sprite},
     {'L', SPRITE_LADDER, token_passive_sprite},
     {'p', SPRITE_PLATFORM, token_active_sprite},
@@ -179,12 +179,12 @@ const struct token_entry LEVEL_9_TOKENS[LEVEL_9_COUNT] = {
     {'g', SPRITE_GRASS, token_passive_sprite},
     {'_', SPRITE_GROUND, token_passive_sprite},
     {'s', SPRITE_SPIDER, token_active_sprite},
-    {'O', SPRITE_COIN, token_active_sprite},
+    {'O', SPRITE_COIN, token_item},
     {'D', SPRITE_DOOR, token_passive_sprite},
     {'P', SPRITE_PLAYER, token_player},
     {'S', SPRITE_SPRINTING_SPIDER, token_active_sprite},
     {'G', SPRITE_GHOST, token_active_sprite},
-    {'E', SPRITE_EXTRA_LIFE, token_active_sprite},
+    {'E', SPRITE_EXTRA_LIFE, token_item},
     {'p', SPRITE_PLATFORM, token_active_sprite},
     {'X', SPRITE_SPRING, token_active_sprite},
     {'k', SPRITE_SKELETON, token_active_sprite},
@@ -0,0 +1,87 @@
+#include "delta.h"
+
+size_t delta_put_varint(Uint8 *out, Uint64 v) {
+  size_t n = 0;
+  while (v >= 0x80) {
+    out[n++] = (Uint8)(v | 0x80);
+    v >>= 7;
+  }
+  out[n++] = (Uint8)v;
+  return n;
+}
+
+size_t delta_get_varint(const Uint8 *in, const size_t n, Uint64 *v) {
+  size_t i = 0, shift = 0;
+  *v = 0;
+  do {
+    if (i == n || i == DELTA_MAX_VARINT) {
+      return 0;
+    }
+    *v |= (Uint64)(in[i] & 0x7F) << shift;
+    shift += 7;
+  } while (in[i++] & 0x80);
+  return i;
+}
+
+size_t delta_bound(const size_t len) {
+  // the worst case is a changed byte every other byte: each one takes a run
+  // of two one-byte varints
+  return 3 * len + 2 * DELTA_MAX_VARINT;
+}
+
+size_t delta_encode(const Uint8 *a, const Uint8 *b, const size_t len,
+                    Uint8 *out) {
+  size_t n = 0, i = 0, zeroes = 0;
+  while (i < len) {
+    if (a[i] == b[i]) {
+      zeroes++;
+      i++;
+      continue;
+    }
+
+    size_t j = i;
+    while (j < len && a[j] != b[j]) {
+      j++;
+    }
+
+    n += delta_put_varint(out + n, zeroes);
+    n += delta_put_varint(out + n, j - i);
+    for (; i < j; i++) {
+      out[n++] = a[i] ^ b[i];
+    }
+    zeroes = 0;
+  }
+
+  return n;
+}
+
+int delta_decode(const Uint8 *in, const size_t n, Uint8 *buf,
+                 const size_t len) {
+  size_t i = 0, off = 0;
+  while (i < n) {
+    Uint64 zeroes, count;
+    size_t k = delta_get_varint(in + i, n - i, &zeroes);
+    if (k == 0) {
+      return -1;
+    }
+    i += k;
+
+    k = delta_get_varint(in + i, n - i, &count);
+    if (k == 0) {
+      return -1;
+    }
+    i += k;
+
+    if (zeroes > len - off || count > len - off - zeroes || count > n - i) {
+      return -1;
+    }
+    off += zeroes;
+
+    register size_t j;
+    for (j = 0; j < count; j++) {
+      buf[off++] ^= in[i++];
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,48 @@
+#ifndef DELTA_H
+#define DELTA_H
+
+#include "base.h"
+
+#include <SDL2/SDL.h>
+
+// delta encodes the difference between two buffers of the same size, e.g two
+// snapshots of a world (see history.h) or two frames of a spectator stream
+// (see stream.h). The buffers are XOR-ed, and the result, which is mostly
+// zeroes when little changed, is encoded as a sequence of (zeroes, count,
+// bytes...) runs: zeroes is the number of unchanged bytes to skip, count is the
+// number of bytes that follow, and both are stored as LEB128 variable length
+// integers (varints). Unchanged bytes at the end are not stored at all.
+//
+// Encoding the difference to a buffer of zeroes run-length encodes a buffer on
+// its own.
+
+enum {
+  // DELTA_MAX_VARINT is the maximum size of a varint, in bytes
+  DELTA_MAX_VARINT = 10,
+};
+
+// delta_put_varint stores v as a varint into out, which must hold at least
+// DELTA_MAX_VARINT bytes. Returns the size of the varint.
+size_t delta_put_varint(Uint8 *out, Uint64 v);
+
+// delta_get_varint reads a varint from the n bytes of in into *v. Returns the
+// size of the varint, or 0 if it is truncated or too large.
+size_t delta_get_varint(const Uint8 *in, const size_t n, Uint64 *v);
+
+// delta_bound returns the maximum size of the encoded difference between two
+// buffers of len bytes
+size_t delta_bound(const size_t len);
+
+// delta_encode encodes the difference between a and b, both of size len, into
+// out, which must hold at least delta_bound(len) bytes. Returns the size of the
+// encoded difference.
+size_t delta_encode(const Uint8 *a, const Uint8 *b, const size_t len,
+                    Uint8 *out);
+
+// delta_decode applies the encoded difference in in (of size n) to buf, of size
+// len, turning a into b. Returns 0 on success, and -1 if the encoded difference
+// is invalid or does not fit buf, in which case buf may be partially modified.
+int delta_decode(const Uint8 *in, const size_t n, Uint8 *buf,
+                 const size_t len);
+
+#endif // DELTA_H
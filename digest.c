@@ -0,0 +1,218 @@
+#include "digest.h"
+
+#include "default_levels.h"
+#include "fixed.h"
+#include "level.h"
+#include "lily.h"
+#include "message.h"
+#include "player.h"
+#include "safe.h"
+#include "state.h"
+
+const Uint64 DIGEST_SEED = 0xCBF29CE484222325;
+
+// mix returns the hash h with the 64 bits of v folded into it
+static Uint64 mix(Uint64 h, const Uint64 v) {
+  h = (h ^ v) * 0x9E3779B97F4A7C15;
+  return h ^ (h >> 32);
+}
+
+// fix returns the position or velocity v in fixed units (see fixed.h). Unlike
+// fixed_from_double, v is not limited to the range of a fixed, so sprites
+// falling out of the level can be hashed too.
+static Uint64 fix(const double v) {
+  return (Uint64)(Sint64)(v * FIXED_ONE);
+}
+
+// mix_timer returns the hash h with the timer t folded into it
+static Uint64 mix_timer(Uint64 h, const struct fps_timer *t) {
+  h = mix(h, t->delay);
+  return mix(h, t->time_left);
+}
+
+// mix_enemy returns the hash h with the enemy data e folded into it
+static Uint64 mix_enemy(Uint64 h, const struct data_enemy *e) {
+  h = mix(h, e->dir);
+  h = mix(h, e->alive);
+  h = mix(h, e->rand);
+  h = mix_timer(h, &e->remove_timer);
+  return mix_timer(h, &e->shoot_timer);
+}
+
+// mix_data returns the hash h with the sprite data of s folded into it. The
+// data is a union, so only the member the type of s uses is hashed.
+static Uint64 mix_data(Uint64 h, const struct sprite *s) {
+  const union sprite_data *d = &s->data;
+
+  // the custom sprite types are enemies, with the state of their definition
+  if (s->type->id >= SPRITE_CUSTOM) {
+    h = mix(h, d->enemy.state);
+    h = mix(h, d->enemy.state_time);
+    return mix_enemy(h, &d->enemy);
+  }
+
+  switch (s->type->id) {
+  case SPRITE_COIN:
+  case SPRITE_EXTRA_LIFE:
+    return mix(h, d->item.collected);
+  case SPRITE_SPIDER:
+  case SPRITE_SPRINTING_SPIDER:
+  case SPRITE_SKELETON:
+  case SPRITE_GHOST:
+  case SPRITE_BAT:
+    return mix_enemy(h, &d->enemy);
+  case SPRITE_HELPER:
+  case SPRITE_CAT_HELPER:
+  case SPRITE_LADDER_HELPER:
+  case SPRITE_GHOST_HELPER:
+  case SPRITE_HELPER_LAST_LEVEL:
+  case SPRITE_CAT_HELPER_LAST_LEVEL:
+  case SPRITE_LADDER_HELPER_LAST_LEVEL:
+  case SPRITE_GHOST_HELPER_LAST_LEVEL:
+  case SPRITE_SPRING:
+    return mix_timer(h, &d->helper.interaction_timer);
+  default:
+    return h;
+  }
+}
+
+// mix_sprite returns the hash h with the sprite s folded into it
+static Uint64 mix_sprite(Uint64 h, const struct sprite *s) {
+  const struct animation *a = &s->animation;
+
+  h = mix(h, s->type->id);
+  h = mix(h, s->removed);
+  h = mix(h, fix(s->x));
+  h = mix(h, fix(s->y));
+  h = mix(h, fix(s->vx));
+  h = mix(h, fix(s->vy));
+  h = mix(h, (Uint64)a->frame);
+  h = mix(h, (Uint64)a->frame_delay_counter);
+  h = mix(h, a->flip);
+  h = mix(h, (Uint64)a->alpha);
+  return mix_data(h, s);
+}
+
+Uint64 digest_world(const struct lily_world *w, const Uint64 h) {
+  assert_not_null(4, w, w->level, w->player, w->message);
+  const struct level *l = w->level;
+  const struct player *p = w->player;
+
+  Uint64 d = mix(h, w->state);
+  d = mix(d, w->level_index);
+  d = mix(d, w->ticks);
+  d = mix(d, w->rand);
+  d = mix(d, w->tile_clock);
+
+  d = mix(d, p->air | p->ladder << 1 | p->sprint << 2 | p->jump << 3);
+  d = mix(d, p->lives);
+  d = mix(d, p->coins);
+  d = mix(d, p->index);
+  d = mix(d, p->respawn_x);
+  d = mix(d, p->respawn_y);
+  d = mix_timer(d, &p->blink_timer);
+  d = mix_timer(d, &p->character_timer);
+  d = mix(d, w->message->blocking);
+
+  // the collected items, 8 bytes at a time
+  const size_t n = level_collected_size(l);
+  register size_t i;
+  Uint64 v = 0;
+  for (i = 0; i < n; i++) {
+    v = v << 8 | l->collected[i];
+    if (i % 8 == 7 || i == n - 1) {
+      d = mix(d, v);
+      v = 0;
+    }
+  }
+
+  d = mix(d, l->active_sprites->l);
+  for (i = 0; i < l->active_sprites->l; i++) {
+    d = mix_sprite(d, l->active_sprites->a[i]);
+  }
+
+  d = mix(d, l->projectiles->count);
+  for (i = 0; i < l->projectiles->count; i++) {
+    d = mix_sprite(d, projectile_get(l->projectiles, i));
+  }
+
+  return d;
+}
+
+int digest_log_level(FILE *f, const struct lily_world *w, const Uint64 rand) {
+  assert_not_null(2, f, w);
+
+  if (fprintf(f, "level %llu %016llX\n", (unsigned long long)w->level_index,
+              (unsigned long long)rand) < 0) {
+    LOG_ERROR("could not write hash log");
+    return -1;
+  }
+
+  return 0;
+}
+
+int digest_log_step(FILE *f, const struct lily_world *w) {
+  assert_not_null(2, f, w);
+
+  if (fprintf(f, "%llu %lu %llu %016llX\n", (unsigned long long)w->ticks,
+              (unsigned long)w->input, (unsigned long long)w->dt,
+              (unsigned long long)lily_world_hash(w)) < 0) {
+    LOG_ERROR("could not write hash log");
+    return -1;
+  }
+
+  return 0;
+}
+
+int digest_log_line(struct lily_world *w, const char *line) {
+  assert_not_null(2, w, line);
+  unsigned long long index, rand, tick, dt, hash;
+  unsigned long input;
+
+  if (sscanf(line, "level %llu %llX", &index, &rand) == 2) {
+    w->rand = rand;
+    if (index >= LEVEL_COUNT || lily_world_load_default_level(w, index) != 0) {
+      LOG_ERROR("could not load level %llu of hash log", index);
+      return -1;
+    }
+
+    return 0;
+  }
+
+  if (sscanf(line, "%llu %lu %llu %llX", &tick, &input, &dt, &hash) != 4 ||
+      w->level == NULL) {
+    LOG_ERROR("invalid hash log line: %s", line);
+    return -1;
+  }
+
+  if (lily_world_step(w, input, dt) != 0) {
+    return -1;
+  }
+
+  return w->ticks == tick && lily_world_hash(w) == hash ? 0 : 1;
+}
+
+int digest_log_replay(FILE *f, Uint64 *tick) {
+  assert_not_null(2, f, tick);
+
+  struct lily_world *w = lily_world_create();
+  if (w == NULL) {
+    return -1;
+  }
+  lily_world_set_hashing(w, true);
+
+  int ret = 0;
+  char line[DIGEST_LINE_SIZE];
+  while (ret == 0 && fgets(line, sizeof(line), f) != NULL) {
+    ret = digest_log_line(w, line);
+  }
+
+  if (ret == 0 && ferror(f)) {
+    LOG_ERROR("could not read hash log");
+    ret = -1;
+  }
+
+  *tick = w->ticks;
+  lily_world_destroy(&w);
+  return ret;
+}
@@ -0,0 +1,90 @@
+#ifndef DIGEST_H
+#define DIGEST_H
+
+#include "base.h"
+
+#include <SDL2/SDL.h>
+#include <stdio.h>
+
+// digest hashes the state of a world that the game logic depends on, to prove
+// that two runs of the game played out the same way, e.g before and after an
+// optimization, in two builds, headless and in the game's window, or on
+// different threads.
+//
+// Every time a world that hashes its state (see lily_world_set_hashing) is
+// stepped, the hash of its state is folded into the world's 64 bit hash (see
+// lily_world_hash), so the hash at a tick sums up every tick before it. Two
+// runs that diverge have different hashes from the first tick they differ at
+// onwards.
+//
+// The hash is not a running hash kept up to date as the state changes: every
+// tick, digest_world hashes the whole state again, which costs a pass over
+// every active sprite and projectile. That is about 40 nanoseconds per sprite,
+// or under a microsecond per tick on the levels of the game, against the 1 to
+// 4 microseconds of the tick itself (see digest_bench). So hashing is opt-in: a
+// world hashes its state while it has a hash log, or when it was asked to, e.g
+// to verify a replay.
+//
+// The state hashed is the state of the world (its state, level, tick count,
+// pseudo-random number generator and tile clock), the player (lives, coins,
+// air, ladder, sprint, jump, character and timers), whether the message blocks
+// the game, the collected items, and every active sprite and projectile: its
+// type, position, velocity, whether it was removed, its animation frame, delay,
+// flip and alpha, and the timers and flags of its sprite data. Positions and
+// velocities are hashed in fixed-point (see fixed.h), so the hash is the same
+// on every platform.
+
+// forward declaration, see state.h
+struct lily_world;
+
+// DIGEST_SEED is the hash of a world that was never stepped
+extern const Uint64 DIGEST_SEED;
+
+// digest_world returns the hash h, with the state of the world w folded into
+// it. w must have a level.
+Uint64 digest_world(const struct lily_world *w, const Uint64 h);
+
+// The hash log of a world (see lily_world_set_hash_log) is a text file with a
+// line per event:
+//
+//   level INDEX RAND          a level was loaded
+//   TICK INPUT DT HASH        the world was stepped
+//
+// where INDEX is the world's level_index, RAND the state of its pseudo-random
+// number generator before the level was loaded, TICK the world's tick count,
+// INPUT and DT the arguments of lily_world_step, and HASH the world's hash
+// after the step. RAND and HASH are in hexadecimal. As a log has the inputs of
+// every tick, a game of the game's levels can be played again from its log,
+// see digest_log_replay, and two logs can be compared with diff(1) to find the
+// first tick they diverge at.
+
+// DIGEST_LINE_SIZE is the size of the longest line of a hash log, plus some
+// room
+enum { DIGEST_LINE_SIZE = 128 };
+
+// digest_log_level writes the level line of the world w to the log f, rand
+// being the state of its pseudo-random number generator before the level was
+// loaded. Returns 0 on success, -1 on failure.
+int digest_log_level(FILE *f, const struct lily_world *w, const Uint64 rand);
+
+// digest_log_step writes the step line of the world w to the log f. Returns 0
+// on success, -1 on failure.
+int digest_log_step(FILE *f, const struct lily_world *w);
+
+// digest_log_line plays the line `line` of a log again in the world w, which
+// must hash its state from its first step: a level line loads the level, and
+// a step line steps w. Returns 0 if the hash
+// of w matched the hash of the line, or if it is a level line, 1 if it did not
+// match, and -1 on failure.
+int digest_log_line(struct lily_world *w, const char *line);
+
+// digest_log_replay plays the log f again in a new world, loading the game's
+// levels (see default_levels.h) at its level lines and stepping the world with
+// the inputs of its step lines, and compares the hashes of the world to the
+// ones of the log. Returns 0 if every hash matched, 1 if a hash did not, in
+// which case *tick is set to the first tick it did not match at, and -1 on
+// failure, e.g if the log is not a valid log. Logs of custom levels, or of
+// games that were rewound (see history.h), cannot be played again.
+int digest_log_replay(FILE *f, Uint64 *tick);
+
+#endif // DIGEST_H
@@ -0,0 +1,123 @@
+#include "digest.h"
+
+#include "default_levels.h"
+#include "input.h"
+#include "level.h"
+#include "lily.h"
+#include "player.h"
+#include "safe.h"
+#include "state.h"
+#include "test.h"
+#include <stdio.h>
+
+// digest_bench measures what hashing the state of a world at every tick costs
+// (see lily_world_set_hashing), as digest_world hashes the whole state at every
+// tick: on the levels of the game, and on a synthetic level of 8 by 8 screens
+// whose floors are covered in a thousand to a hundred thousand enemies. Run it
+// with `make bench`.
+
+enum {
+  BENCH_TICKS = FRAME_RATE,
+  // the levels of the game are stepped for longer, as their ticks are short
+  LEVEL_TICKS = 20 * FRAME_RATE,
+};
+
+// MIX is the types of the sprites spawned, in turn
+static const enum sprite_id MIX[] = {SPRITE_SPIDER, SPRITE_SPRINTING_SPIDER,
+                                     SPRITE_SKELETON, SPRITE_GHOST,
+                                     SPRITE_PLATFORM, SPRITE_BAT};
+
+// crowd creates a world playing the synthetic level of test_crowd (see test.h)
+// with n sprites of the types of MIX
+static struct lily_world *crowd(const size_t n) {
+  return test_crowd(NULL, MIX, sizeof(MIX) / sizeof(MIX[0]), n);
+}
+
+// level creates a world playing the game's level number `index`. Returns NULL
+// on failure.
+static struct lily_world *level(const size_t index) {
+  struct lily_world *w = lily_world_create();
+  if (w != NULL && lily_world_load_default_level(w, index) != 0) {
+    lily_world_destroy(&w);
+  }
+
+  return w;
+}
+
+// run steps the world w for `ticks` ticks, hashing its state if `hashing` is
+// true, and destroys it. Returns the time per tick in microseconds, or a
+// negative value on failure.
+static double run(struct lily_world *w, const size_t ticks,
+                  const bool hashing) {
+  if (w == NULL) {
+    return -1;
+  }
+
+  lily_world_set_hashing(w, hashing);
+  double ret = -1;
+  const Uint64 start = SDL_GetPerformanceCounter();
+  register size_t t;
+  for (t = 0; t < ticks; t++) {
+    if (lily_world_step(w, t % 2 ? INPUT_RIGHT : INPUT_NONE, FRAME_TIME) !=
+        0) {
+      goto out;
+    }
+  }
+
+  const double elapsed = (double)(SDL_GetPerformanceCounter() - start) /
+                         SDL_GetPerformanceFrequency();
+  ret = elapsed * 1e6 / ticks;
+
+out:
+  lily_world_destroy(&w);
+  return ret;
+}
+
+// print prints the time per tick of a world without and with hashing, and the
+// time hashing takes per sprite
+static void print(const char *name, const size_t sprites, const double off,
+                  const double on) {
+  printf("  %-22s: %10.1f | %10.1f (+%5.1f%%, %5.1f ns per sprite)\n", name,
+         off, on, (on - off) * 100 / off, (on - off) * 1e3 / sprites);
+}
+
+int main(int argc, char *argv[]) {
+  SAFE_UNUSED(argc);
+  SAFE_UNUSED(argv);
+
+  printf("us per tick, without / with hashing\n");
+
+  // a first run warms the caches and the level template cache up
+  if (run(level(0), LEVEL_TICKS, true) < 0) {
+    return 1;
+  }
+
+  register size_t i;
+  for (i = 0; i < LEVEL_COUNT; i++) {
+    struct lily_world *w = level(i);
+    const size_t sprites = w != NULL ? w->level->active_sprites->l : 0;
+    const double off = run(w, LEVEL_TICKS, false);
+    const double on = run(level(i), LEVEL_TICKS, true);
+    if (off < 0 || on < 0) {
+      return 1;
+    }
+
+    print(LEVELS[i], sprites, off, on);
+  }
+
+  static const size_t COUNTS[] = {1000, 10000, 100000};
+  for (i = 0; i < sizeof(COUNTS) / sizeof(COUNTS[0]); i++) {
+    const double off = run(crowd(COUNTS[i]), BENCH_TICKS, false);
+    const double on = run(crowd(COUNTS[i]), BENCH_TICKS, true);
+    if (off < 0 || on < 0) {
+      return 1;
+    }
+
+    char name[32];
+    snprintf(name, sizeof(name), "%lu sprites", (unsigned long)COUNTS[i]);
+    print(name, COUNTS[i], off, on);
+  }
+
+  level_template_cache_clear();
+  return 0;
+}
@@ -0,0 +1,274 @@
+#include "digest.h"
+
+#include "default_levels.h"
+#include "level.h"
+#include "lily.h"
+#include "player.h"
+#include "snapshot.h"
+#include "state.h"
+#include "test.h"
+#include "util.h"
+#include <string.h>
+
+// the inputs the levels are played with
+static const Uint32 INPUTS[] = {INPUT_NONE,
+                                INPUT_RIGHT | INPUT_SPRINT,
+                                INPUT_RIGHT | INPUT_JUMP,
+                                INPUT_LEFT | INPUT_SHORT_JUMP,
+                                INPUT_UP,
+                                INPUT_INTERACT};
+
+enum { TICKS = 10 * FRAME_RATE, HOLD = FRAME_RATE / 4, DIVERGE = 100 };
+
+// input returns the input of the tick t of a game seeded with `seed`
+static Uint32 input(const Uint64 seed, const size_t t) {
+  Uint64 z = seed * 0x9E3779B97F4A7C15 + t / HOLD;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+  return INPUTS[(z >> 32) % (sizeof(INPUTS) / sizeof(INPUTS[0]))];
+}
+
+// play plays the game's level number `index` for TICKS ticks, and stores the
+// hash of every tick in hashes
+static void play(const size_t index, Uint64 *hashes) {
+  struct lily_world *w = lily_world_create();
+  assert(w != NULL);
+  lily_world_set_hashing(w, true);
+  lily_world_seed(w, index);
+  assert(lily_world_load_default_level(w, index) == 0);
+
+  register size_t t;
+  for (t = 0; t < TICKS; t++) {
+    assert(lily_world_step(w, input(index, t), FRAME_TIME) == 0);
+    hashes[t] = lily_world_hash(w);
+  }
+
+  lily_world_destroy(&w);
+}
+
+// play_thread plays the level of the index pointed to by data, see play
+static int play_thread(void *data) {
+  const size_t index = *(size_t *)data;
+  Uint64 *hashes = malloc(TICKS * sizeof(Uint64));
+  assert(hashes != NULL);
+  play(index, hashes);
+
+  // each thread only returns its last hash, which sums up every tick
+  const int ret = (int)(hashes[TICKS - 1] & 0x7FFFFFFF);
+  free(hashes);
+  return ret;
+}
+
+// two worlds playing the same level with the same inputs have the same hash
+// at every tick, which changes at every tick
+static void test_hash(void) {
+  Uint64 a[TICKS], b[TICKS];
+  register size_t i, t;
+  for (i = 0; i < LEVEL_COUNT; i++) {
+    play(i, a);
+    play(i, b);
+    assert(memcmp(a, b, sizeof(a)) == 0);
+    for (t = 1; t < TICKS; t++) {
+      assert(a[t] != a[t - 1]);
+    }
+  }
+
+  level_template_cache_clear();
+}
+
+// a change to the state of a world changes its hash from the next tick on,
+// even once the state is back to what it was
+static void test_diverge(void) {
+  struct lily_world *w[2];
+  register size_t i, t;
+  for (i = 0; i < 2; i++) {
+    w[i] = lily_world_create();
+    assert(w[i] != NULL);
+    lily_world_set_hashing(w[i], true);
+    assert(lily_world_load_default_level(w[i], 0) == 0);
+  }
+
+  for (t = 0; t < TICKS; t++) {
+    if (t == DIVERGE) {
+      w[1]->player->coins++;
+    } else if (t == DIVERGE + 1) {
+      w[1]->player->coins--;
+    }
+
+    for (i = 0; i < 2; i++) {
+      assert(lily_world_step(w[i], input(0, t), FRAME_TIME) == 0);
+    }
+
+    const bool same = lily_world_hash(w[0]) == lily_world_hash(w[1]);
+    assert(same == (t < DIVERGE));
+  }
+
+  for (i = 0; i < 2; i++) {
+    lily_world_destroy(&w[i]);
+  }
+  level_template_cache_clear();
+}
+
+// every level played on its own thread, all at the same time, has the same
+// hash as when it is played on the main thread
+static void test_threads(void) {
+  SDL_Thread *threads[LEVEL_COUNT];
+  size_t indices[LEVEL_COUNT];
+  Uint64 hashes[TICKS];
+
+  register size_t i;
+  for (i = 0; i < LEVEL_COUNT; i++) {
+    indices[i] = i;
+    threads[i] = SDL_CreateThread(play_thread, "digest", &indices[i]);
+    assert(threads[i] != NULL);
+  }
+
+  for (i = 0; i < LEVEL_COUNT; i++) {
+    int ret;
+    SDL_WaitThread(threads[i], &ret);
+    play(i, hashes);
+    assert(ret == (int)(hashes[TICKS - 1] & 0x7FFFFFFF));
+  }
+
+  level_template_cache_clear();
+}
+
+// a world only hashes its state while hashing is on, or while it has a hash
+// log
+static void test_opt_in(void) {
+  struct lily_world *w = lily_world_create();
+  assert(w != NULL);
+  assert(lily_world_load_default_level(w, 0) == 0);
+
+  register size_t t;
+  for (t = 0; t < FRAME_RATE; t++) {
+    assert(lily_world_step(w, input(0, t), FRAME_TIME) == 0);
+  }
+  assert(lily_world_hash(w) == DIGEST_SEED);
+
+  lily_world_set_hashing(w, true);
+  assert(lily_world_step(w, INPUT_NONE, FRAME_TIME) == 0);
+  const Uint64 h = lily_world_hash(w);
+  assert(h != DIGEST_SEED);
+
+  lily_world_set_hashing(w, false);
+  assert(lily_world_step(w, INPUT_NONE, FRAME_TIME) == 0);
+  assert(lily_world_hash(w) == h);
+
+  FILE *f = tmpfile();
+  assert(f != NULL);
+  lily_world_set_hash_log(w, f);
+  assert(lily_world_step(w, INPUT_NONE, FRAME_TIME) == 0);
+  assert(lily_world_hash(w) != h);
+  lily_world_set_hash_log(w, NULL);
+  fclose(f);
+
+  lily_world_destroy(&w);
+  level_template_cache_clear();
+}
+
+// restoring a snapshot restores the hash of the world, so a game that is
+// rewound and played again has the same hashes
+static void test_snapshot(void) {
+  struct lily_world *w = lily_world_create();
+  assert(w != NULL);
+  lily_world_set_hashing(w, true);
+  assert(lily_world_load_default_level(w, 1) == 0);
+
+  Uint64 hashes[TICKS];
+  Uint8 *buf = NULL;
+  size_t len = 0;
+  register size_t t;
+  for (t = 0; t < TICKS; t++) {
+    if (t == DIVERGE) {
+      len = snapshot_save(w, NULL, 0);
+      buf = malloc(len);
+      assert(buf != NULL);
+      assert(snapshot_save(w, buf, len) == len);
+    }
+
+    assert(lily_world_step(w, input(1, t), FRAME_TIME) == 0);
+    hashes[t] = lily_world_hash(w);
+  }
+
+  assert(snapshot_load(w, buf, len) == 0);
+  assert(lily_world_hash(w) == hashes[DIVERGE - 1]);
+  for (t = DIVERGE; t < TICKS; t++) {
+    assert(lily_world_step(w, input(1, t), FRAME_TIME) == 0);
+    assert(lily_world_hash(w) == hashes[t]);
+  }
+
+  free(buf);
+  lily_world_destroy(&w);
+  level_template_cache_clear();
+}
+
+// a game logged with lily_world_set_hash_log plays again the same way from
+// its log, and a log whose input was changed diverges at that tick
+static void test_log(void) {
+  FILE *f = tmpfile();
+  FILE *g = tmpfile();
+  assert(f != NULL && g != NULL);
+
+  struct lily_world *w = lily_world_create();
+  assert(w != NULL);
+  lily_world_seed(w, 42);
+  lily_world_set_hash_log(w, f);
+
+  // the game goes on to the next level, with frames of varying length
+  register size_t i, t;
+  for (i = 0; i < 2; i++) {
+    assert(lily_world_load_default_level(w, i) == 0);
+    for (t = 0; t < TICKS; t++) {
+      const Uint64 dt = FRAME_TIME / 2 + t % (2 * FRAME_TIME);
+      assert(lily_world_step(w, input(i, t), dt) == 0);
+    }
+  }
+
+  const Uint64 ticks = w->ticks;
+  lily_world_destroy(&w);
+
+  Uint64 tick = 0;
+  rewind(f);
+  assert(digest_log_replay(f, &tick) == 0);
+  assert(tick == ticks);
+
+  // change the input of the tick DIVERGE
+  char line[128];
+  unsigned long long n, dt, hash;
+  unsigned long in;
+  rewind(f);
+  while (fgets(line, sizeof(line), f) != NULL) {
+    if (sscanf(line, "%llu %lu %llu %llX", &n, &in, &dt, &hash) == 4 &&
+        n == DIVERGE) {
+      in = in == INPUT_LEFT ? INPUT_RIGHT : INPUT_LEFT;
+      fprintf(g, "%llu %lu %llu %016llX\n", n, in, dt, hash);
+      continue;
+    }
+
+    fputs(line, g);
+  }
+
+  rewind(g);
+  assert(digest_log_replay(g, &tick) == 1);
+  assert(tick == DIVERGE);
+
+  // logs that are not logs
+  rewind(g);
+  assert(fputs("level 0 X\n", g) >= 0);
+  rewind(g);
+  assert(digest_log_replay(g, &tick) == -1);
+
+  fclose(f);
+  fclose(g);
+  level_template_cache_clear();
+}
+
+int main(void) {
+  RUN_TEST(test_hash);
+  RUN_TEST(test_diverge);
+  RUN_TEST(test_threads);
+  RUN_TEST(test_opt_in);
+  RUN_TEST(test_snapshot);
+  RUN_TEST(test_log);
+  return 0;
+}
@@ -0,0 +1,317 @@
+#include "env.h"
+
+#include "array.h"
+#include "job.h"
+#include "level.h"
+#include "player.h"
+#include "safe.h"
+#include "util.h"
+
+#include <string.h>
+
+struct lily_env {
+  size_t n;                    // the number of worlds
+  struct lily_world **worlds;  // the worlds
+  struct level_template *t;    // the level played by every world
+  Uint64 seed;                 // the seed of the environment
+  Uint64 *episodes;            // the number of episodes started by each world
+  struct lily_status *status;  // the status of each world after its last step
+
+  // the batch currently being processed, set by lily_env_step
+  const Uint32 *actions;
+  struct lily_obs *obs;
+  float *rewards;
+  bool *dones;
+
+  // jobs steps the worlds of a batch, a job per world (see job.h)
+  struct job_pool *jobs;
+};
+
+// seed_of returns the seed of the world i for its episode number `episode`.
+// The pseudo-random number generator of the worlds (see util_rand) mixes its
+// seed, so distinct seeds are enough to give uncorrelated games.
+static Uint64 seed_of(const struct lily_env *e, const size_t i,
+                      const Uint64 episode) {
+  return e->seed + ((Uint64)i << 32) + episode;
+}
+
+// reset_world replaces the world i with a new world at the start of the
+// level. Returns 0 on success, -1 on failure.
+static int reset_world(struct lily_env *e, const size_t i) {
+  struct lily_world *w = lily_world_create();
+  if (w == NULL) {
+    return -1;
+  }
+
+  lily_world_seed(w, seed_of(e, i, e->episodes[i]++));
+  if (lily_world_load_level_template(w, e->t) != 0) {
+    lily_world_destroy(&w);
+    return -1;
+  }
+
+  if (e->worlds[i] != NULL) {
+    lily_world_destroy(&e->worlds[i]);
+  }
+
+  e->worlds[i] = w;
+  lily_world_status(w, &e->status[i]);
+  return 0;
+}
+
+// observe_sprite adds the sprite s to the sprites of the observation o if it
+// is within the tile window starting at row r0 and column c0, keeping the
+// LILY_ENV_SPRITE_COUNT nearest sprites to the player's sprite ps, sorted by
+// distance with an insertion sort as the list is tiny. dist holds the squared
+// distance of each of the sprites of o.
+static void observe_sprite(struct lily_obs *o, Sint64 *dist,
+                           const struct sprite *ps, const int r0,
+                           const int c0, const struct sprite *s) {
+  if (s->removed) {
+    return;
+  }
+
+  int sr, sc;
+  util_nearest(s, &sr, &sc);
+  if (sr < r0 || sr >= r0 + LILY_ENV_VIEW_H || sc < c0 ||
+      sc >= c0 + LILY_ENV_VIEW_W) {
+    return;
+  }
+
+  const Sint64 dx = SDL_floor(s->x - ps->x);
+  const Sint64 dy = SDL_floor(s->y - ps->y);
+  const Sint64 d = dx * dx + dy * dy;
+
+  size_t j = o->sprite_count;
+  if (j == LILY_ENV_SPRITE_COUNT) {
+    if (d >= dist[j - 1]) {
+      return;
+    }
+    j--;
+  } else {
+    o->sprite_count++;
+  }
+
+  for (; j > 0 && dist[j - 1] > d; j--) {
+    dist[j] = dist[j - 1];
+    o->sprites[j] = o->sprites[j - 1];
+  }
+
+  dist[j] = d;
+  o->sprites[j].id = (Uint8)s->type->id;
+  o->sprites[j].dx = (Sint16)dx;
+  o->sprites[j].dy = (Sint16)dy;
+}
+
+// observe populates o with the observation of the world w
+static void observe(const struct lily_world *w, struct lily_obs *o) {
+  const struct level *l = w->level;
+  const struct player *p = w->player;
+
+  // zero the padding too, so observations can be compared with memcmp
+  memset(o, 0, sizeof(struct lily_obs));
+  o->lives = (Uint8)SDL_min(p->lives, 0xFF);
+  o->coins = (Uint16)SDL_min(p->coins, 0xFFFF);
+
+  int pr, pc;
+  util_nearest(p->s, &pr, &pc);
+
+  const int rows = ROW_COUNT * size_t_to_int(l->h);
+  const int cols = COLUMN_COUNT * size_t_to_int(l->w);
+  const int r0 = pr - LILY_ENV_VIEW_H / 2;
+  const int c0 = pc - LILY_ENV_VIEW_W / 2;
+
+  register int r, c;
+  for (r = 0; r < LILY_ENV_VIEW_H; r++) {
+    for (c = 0; c < LILY_ENV_VIEW_W; c++) {
+      const int lr = r0 + r, lc = c0 + c;
+      if (lr < 0 || lr >= rows || lc < 0 || lc >= cols) {
+        o->tiles[r][c] = LILY_ENV_TILE_OUTSIDE;
+      } else {
+        // a tile holds either a passive sprite or an item
+        const enum sprite_id id = l->passive_sprites[lr * cols + lc];
+        o->tiles[r][c] = (Uint8)(id != SPRITE_NONE
+                                     ? id
+                                     : level_item(l, lr * cols + lc));
+      }
+    }
+  }
+
+  // keep the LILY_ENV_SPRITE_COUNT nearest sprites within the window, among
+  // the active sprites and the projectiles
+  Sint64 dist[LILY_ENV_SPRITE_COUNT];
+  const struct array *a = l->active_sprites;
+  const struct projectile_pool *pool = l->projectiles;
+
+  register size_t i;
+  for (i = 0; i < a->l; i++) {
+    if (a->a[i] != p->s) {
+      observe_sprite(o, dist, p->s, r0, c0, a->a[i]);
+    }
+  }
+
+  for (i = 0; i < pool->count; i++) {
+    observe_sprite(o, dist, p->s, r0, c0, projectile_get(pool, i));
+  }
+}
+
+// step_world steps the world i of the environment `data` with its action of
+// the current batch, as the job i of the batch (see job_func). Returns 0 on
+// success, -1 on failure.
+static int step_world(void *data, const size_t thread, const size_t i) {
+  SAFE_UNUSED(thread);
+  struct lily_env *e = data;
+  struct lily_world *w = e->worlds[i];
+  const struct lily_status prev = e->status[i];
+  struct lily_status *st = &e->status[i];
+
+  if (lily_world_step(w, e->actions[i], FRAME_TIME) != 0) {
+    return -1;
+  }
+
+  lily_world_status(w, st);
+
+  float reward = 0;
+  if (st->coins > prev.coins) {
+    reward += LILY_ENV_REWARD_COIN * (st->coins - prev.coins);
+  }
+  if (st->lives < prev.lives) {
+    reward += LILY_ENV_REWARD_KILLED * (prev.lives - st->lives);
+  }
+  if (st->state == PROG_GAME_LEVEL_COMPLETE) {
+    reward += LILY_ENV_REWARD_LEVEL_COMPLETE;
+  }
+
+  const bool done = st->state == PROG_GAME_LEVEL_COMPLETE ||
+                    st->state == PROG_GAME_OVER ||
+                    st->ticks >= LILY_ENV_MAX_TICKS;
+
+  e->rewards[i] = reward;
+  e->dones[i] = done;
+
+  if (done && reset_world(e, i) != 0) {
+    return -1;
+  }
+
+  observe(e->worlds[i], &e->obs[i]);
+  return 0;
+}
+
+// free_env frees the memory of the environment
+static void free_env(struct lily_env *e) {
+  if (e->worlds != NULL) {
+    register size_t i;
+    for (i = 0; i < e->n; i++) {
+      if (e->worlds[i] != NULL) {
+        lily_world_destroy(&e->worlds[i]);
+      }
+    }
+  }
+
+  if (e->jobs != NULL) {
+    job_pool_destroy(&e->jobs);
+  }
+
+  if (e->t != NULL) {
+    level_template_release(&e->t);
+  }
+
+  free(e->status);
+  free(e->episodes);
+  free(e->worlds);
+  free(e);
+}
+
+struct lily_env *lily_env_create(const size_t n, const size_t threads,
+                                 struct level_template *t, const Uint64 seed) {
+  assert_not_null(1, t);
+  assert(n > 0);
+
+  struct lily_env *e = calloc(1, sizeof(struct lily_env));
+  if (e == NULL) {
+    LOG_ERROR("could not allocate environment");
+    return NULL;
+  }
+
+  e->n = n;
+  e->seed = seed;
+  e->t = level_template_retain(t);
+
+  // calloc checks for multiplication overflow of its arguments
+  e->worlds = calloc(n, sizeof(struct lily_world *));
+  e->episodes = calloc(n, sizeof(Uint64));
+  e->status = calloc(n, sizeof(struct lily_status));
+  if (e->worlds == NULL || e->episodes == NULL || e->status == NULL) {
+    LOG_ERROR("could not allocate environment");
+    free_env(e);
+    return NULL;
+  }
+
+  // there is no point in having more threads than worlds
+  const int cpus = SDL_GetCPUCount();
+  const size_t all = threads != 0 ? threads : (size_t)SDL_max(cpus, 1);
+  e->jobs = job_pool_create(SDL_min(all, n));
+  if (e->jobs == NULL) {
+    free_env(e);
+    return NULL;
+  }
+
+  return e;
+}
+
+void lily_env_destroy(struct lily_env **pe) {
+  assert_not_null(2, pe, *pe);
+  struct lily_env *e = *pe;
+
+  free_env(e);
+  *pe = NULL;
+}
+
+int lily_env_reset(struct lily_env *e, struct lily_obs *obs) {
+  assert_not_null(2, e, obs);
+
+  register size_t i;
+  for (i = 0; i < e->n; i++) {
+    if (reset_world(e, i) != 0) {
+      return -1;
+    }
+
+    observe(e->worlds[i], &obs[i]);
+  }
+
+  return 0;
+}
+
+int lily_env_step(struct lily_env *e, const Uint32 *actions,
+                  struct lily_obs *obs, float *rewards, bool *dones) {
+  assert_not_null(5, e, actions, obs, rewards, dones);
+  assert_not_null(1, e->worlds[0]); // lily_env_reset was called
+
+  e->actions = actions;
+  e->obs = obs;
+  e->rewards = rewards;
+  e->dones = dones;
+
+  if (job_pool_run(e->jobs, e->n, step_world, e) != 0) {
+    LOG_ERROR("failed to step the environment");
+    return -1;
+  }
+
+  return 0;
+}
+
+size_t lily_env_size(const struct lily_env *e) {
+  assert_not_null(1, e);
+  return e->n;
+}
+
+size_t lily_env_threads(const struct lily_env *e) {
+  assert_not_null(1, e);
+  return job_pool_threads(e->jobs);
+}
+
+const struct lily_world *lily_env_world(const struct lily_env *e,
+                                        const size_t i) {
+  assert_not_null(1, e);
+  assert(i < e->n);
+  return e->worlds[i];
+}
@@ -0,0 +1,111 @@
+#ifndef ENV_H
+#define ENV_H
+
+#include "base.h"
+
+#include "level_template.h"
+#include "lily.h"
+#include <stdbool.h>
+
+// env.h is a batched environment for training agents (e.g with reinforcement
+// learning) on a lily level. An environment holds n independent worlds playing
+// the same level, which are all stepped together, in lockstep, with one action
+// per world. Stepping is spread across a pool of threads and nothing is ever
+// rendered, so the environment runs as fast as the game logic allows.
+//
+// An action is a bitmask of input_key values (see input.h), i.e the keys the
+// agent holds down during the frame, exactly as read by the player's
+// process_keys. After every step, each world reports an observation, a reward
+// and whether its episode is done.
+
+enum {
+  // LILY_ENV_VIEW_W is the number of columns of tiles in an observation. The
+  // window is centered on the player.
+  LILY_ENV_VIEW_W = 11,
+  // LILY_ENV_VIEW_H is the number of rows of tiles in an observation
+  LILY_ENV_VIEW_H = 9,
+  // LILY_ENV_SPRITE_COUNT is the maximum number of active sprites in an
+  // observation
+  LILY_ENV_SPRITE_COUNT = 8,
+  // LILY_ENV_TILE_OUTSIDE is the tile id of the tiles outside of the level
+  LILY_ENV_TILE_OUTSIDE = SPRITE_TYPE_COUNT,
+  // LILY_ENV_MAX_TICKS is the number of steps after which an episode is cut
+  // short, so an agent that is stuck does not stay stuck forever. This is five
+  // minutes of game time at FRAME_RATE.
+  LILY_ENV_MAX_TICKS = 5 * 60 * FRAME_RATE,
+};
+
+// rewards given to the agent, see lily_env_step
+#define LILY_ENV_REWARD_COIN 1.0f            // collecting a coin
+#define LILY_ENV_REWARD_LEVEL_COMPLETE 10.0f // completing the level
+#define LILY_ENV_REWARD_KILLED -5.0f         // losing a life
+
+// lily_env_sprite is an active sprite in an observation
+struct lily_env_sprite {
+  Uint8 id; // the sprite_id of the sprite (see sprite_type.h)
+  // dx and dy are the position of the sprite relative to the player, in
+  // pixels
+  Sint16 dx;
+  Sint16 dy;
+};
+
+// lily_obs is the observation of a world after a step
+struct lily_obs {
+  // tiles contains the sprite_id of the passive sprite, or of the item that
+  // was not collected yet, on every tile around the player, or
+  // LILY_ENV_TILE_OUTSIDE for the tiles outside of the level.
+  // The player's tile is tiles[LILY_ENV_VIEW_H / 2][LILY_ENV_VIEW_W / 2].
+  Uint8 tiles[LILY_ENV_VIEW_H][LILY_ENV_VIEW_W];
+  // sprites contains the active sprites and projectiles within the tile
+  // window, nearest to the player first, not including the player itself
+  struct lily_env_sprite sprites[LILY_ENV_SPRITE_COUNT];
+  Uint8 sprite_count; // the number of elements in sprites
+  Uint8 lives;        // how many lives the player has
+  Uint16 coins;       // the number of coins the player has collected
+};
+
+// lily_env is a batch of worlds stepped together
+struct lily_env;
+
+// lily_env_create creates an environment of n worlds playing the level
+// template t, stepped by `threads` threads (or one thread per CPU if threads is
+// 0). The environment holds its own reference to t. The world i is seeded with
+// a value derived from `seed` and i, so the same seed always gives the same
+// environment. lily_env_reset must be called before the first step. Returns
+// NULL on failure.
+struct lily_env *lily_env_create(const size_t n, const size_t threads,
+                                 struct level_template *t, const Uint64 seed);
+
+// lily_env_destroy stops the threads of the environment, frees all of its
+// worlds and sets *pe to NULL.
+void lily_env_destroy(struct lily_env **pe);
+
+// lily_env_reset starts a new episode in every world and populates obs, an
+// array of lily_env_size elements, with their observations. Returns 0 on
+// success, -1 on failure.
+int lily_env_reset(struct lily_env *e, struct lily_obs *obs);
+
+// lily_env_step steps every world i by one frame of FRAME_TIME milliseconds
+// with the action actions[i], and populates obs[i], rewards[i] and dones[i].
+// All arrays have lily_env_size elements.
+//
+// The reward is the sum of the LILY_ENV_REWARD_* values of the events of the
+// frame. An episode is done once the level is complete, the game is over or
+// LILY_ENV_MAX_TICKS steps were taken. The world of a done episode is
+// immediately reset, so obs[i] is then the first observation of the next
+// episode. Returns 0 on success, -1 on failure.
+int lily_env_step(struct lily_env *e, const Uint32 *actions,
+                  struct lily_obs *obs, float *rewards, bool *dones);
+
+// lily_env_size returns the number of worlds in the environment
+size_t lily_env_size(const struct lily_env *e);
+
+// lily_env_threads returns the number of threads stepping the environment
+size_t lily_env_threads(const struct lily_env *e);
+
+// lily_env_world returns the world i of the environment, e.g to inspect its
+// status with lily_world_status. The world must not be modified.
+const struct lily_world *lily_env_world(const struct lily_env *e,
+                                        const size_t i);
+
+#endif // ENV_H
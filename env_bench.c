@@ -0,0 +1,82 @@
+#include "env.h"
+
+#include "default_levels.h"
+#include "safe.h"
+#include <stdio.h>
+
+// env_bench measures the throughput of the batched environment (see env.h) on
+// the first level of the game, with random actions, first on a single thread
+// then on one thread per CPU. Run it with `make bench`.
+
+enum {
+  BENCH_ENV_SIZE = 256, // the number of worlds in the environment
+  BENCH_STEPS = 2000,   // the number of batches stepped per run
+};
+
+// run steps an environment of BENCH_ENV_SIZE worlds using `threads` threads
+// and prints its throughput. Returns 0 on success, -1 on failure.
+static int run(struct level_template *t, const size_t threads) {
+  struct lily_env *e = lily_env_create(BENCH_ENV_SIZE, threads, t, 0);
+  if (e == NULL) {
+    return -1;
+  }
+
+  static struct lily_obs obs[BENCH_ENV_SIZE];
+  static Uint32 actions[BENCH_ENV_SIZE];
+  static float rewards[BENCH_ENV_SIZE];
+  static bool dones[BENCH_ENV_SIZE];
+
+  if (lily_env_reset(e, obs) != 0) {
+    lily_env_destroy(&e);
+    return -1;
+  }
+
+  // xorshift32, to pick actions without skewing the timings
+  Uint32 x = 1;
+  const Uint64 start = SDL_GetPerformanceCounter();
+
+  register size_t i, j;
+  for (i = 0; i < BENCH_STEPS; i++) {
+    for (j = 0; j < BENCH_ENV_SIZE; j++) {
+      x ^= x << 13;
+      x ^= x >> 17;
+      x ^= x << 5;
+      actions[j] = x % (1 << INPUT_KEY_COUNT);
+    }
+
+    if (lily_env_step(e, actions, obs, rewards, dones) != 0) {
+      lily_env_destroy(&e);
+      return -1;
+    }
+  }
+
+  const double seconds = (double)(SDL_GetPerformanceCounter() - start) /
+                         SDL_GetPerformanceFrequency();
+  const double steps = (double)BENCH_ENV_SIZE * BENCH_STEPS / seconds;
+  const size_t n = lily_env_threads(e);
+  printf("threads: %2zu | steps/s: %10.0f | steps/s per thread: %10.0f\n", n,
+         steps, steps / n);
+
+  lily_env_destroy(&e);
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  SAFE_UNUSED(argc);
+  SAFE_UNUSED(argv);
+
+  struct level_template *t =
+      level_template_get(LEVELS[0], LEVEL_TOKENS[0], LEVEL_TOKENS_COUNT[0]);
+  if (t == NULL) {
+    return 1;
+  }
+
+  int ret = 0;
+  if (run(t, 1) != 0 || run(t, 0) != 0) {
+    ret = 1;
+  }
+
+  level_template_release(&t);
+  level_template_cache_clear();
+  return ret;
+}
@@ -0,0 +1,164 @@
+#include "env.h"
+
+#include "test.h"
+#include "util.h"
+#include <string.h>
+
+static const struct token_entry TOKENS[] = {
+    {'=', SPRITE_WALL_TOP, token_passive_sprite},
+    {'*', SPRITE_WALL, token_passive_sprite},
+    {'O', SPRITE_COIN, token_active_sprite},
+    {'D', SPRITE_DOOR, token_passive_sprite},
+    {'P', SPRITE_PLAYER, token_player},
+    {' ', SPRITE_NONE, NULL}};
+
+static const size_t TOKEN_SIZE = 6;
+
+// a single screen level with the player standing on the floor, a coin on its
+// right and a door further right
+static const char LEVEL[] = "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "     P O  D         \n"
+                            "====================\n"
+                            "********************";
+
+static struct level_template *template(void) {
+  char *str;
+  size_t w, h;
+  assert(util_level_from_buffer(LEVEL, sizeof(LEVEL) - 1, &str, &w, &h) > 0);
+
+  struct level_template *t =
+      level_template_from_string(str, w, h, TOKENS, TOKEN_SIZE);
+  free(str);
+  assert(t != NULL);
+  return t;
+}
+
+static void test_observation(void) {
+  struct level_template *t = template();
+  struct lily_env *e = lily_env_create(1, 1, t, 0);
+  assert(e != NULL);
+  level_template_release(&t);
+
+  struct lily_obs obs;
+  assert(lily_env_reset(e, &obs) == 0);
+  assert(obs.lives == 3);
+  assert(obs.coins == 0);
+
+  // the player is on row 12, column 5: the floor is right below it, and the
+  // level ends three rows further down
+  const int r = LILY_ENV_VIEW_H / 2, c = LILY_ENV_VIEW_W / 2;
+  assert(obs.tiles[r][c] == SPRITE_NONE);
+  assert(obs.tiles[r][c + 5] == SPRITE_DOOR);
+  assert(obs.tiles[r + 1][c] == SPRITE_WALL_TOP);
+  assert(obs.tiles[r + 2][c] == SPRITE_WALL);
+  assert(obs.tiles[r + 3][c] == LILY_ENV_TILE_OUTSIDE);
+
+  // the coin is the only sprite besides the player
+  assert(obs.sprite_count == 1);
+  assert(obs.sprites[0].id == SPRITE_COIN);
+  assert(obs.sprites[0].dx == 2 * SPRITE_SIZE);
+  assert(obs.sprites[0].dy == 0);
+
+  lily_env_destroy(&e);
+  assert(e == NULL);
+}
+
+// walking right picks up the coin, then interacting with the door completes
+// the level, which ends the episode and starts a new one.
+static void test_step(void) {
+  struct level_template *t = template();
+  struct lily_env *e = lily_env_create(1, 1, t, 0);
+  assert(e != NULL);
+  level_template_release(&t);
+
+  struct lily_obs obs;
+  float reward, total = 0;
+  bool done = false;
+  assert(lily_env_reset(e, &obs) == 0);
+
+  const Uint32 action = INPUT_RIGHT | INPUT_INTERACT;
+  register size_t i;
+  for (i = 0; i < 200 && !done; i++) {
+    assert(lily_env_step(e, &action, &obs, &reward, &done) == 0);
+    total += reward;
+
+    if (reward == LILY_ENV_REWARD_COIN) {
+      assert(obs.coins == 1);
+    }
+  }
+
+  assert(done);
+  assert(total == LILY_ENV_REWARD_COIN + LILY_ENV_REWARD_LEVEL_COMPLETE);
+
+  // the observation is the one of the new episode
+  assert(obs.coins == 0);
+  assert(obs.sprite_count == 1);
+
+  struct lily_status st;
+  lily_world_status(lily_env_world(e, 0), &st);
+  assert(st.state == PROG_GAME_IN);
+  assert(st.ticks == 0);
+
+  lily_env_destroy(&e);
+}
+
+enum { ENV_SIZE = 13, ENV_STEPS = 300 };
+
+// run steps an environment of ENV_SIZE worlds with `threads` threads and a
+// fixed sequence of actions, storing the last observations, rewards and done
+// flags.
+static void run(const size_t threads, struct lily_obs *obs, float *rewards,
+                bool *dones) {
+  struct level_template *t = template();
+  struct lily_env *e = lily_env_create(ENV_SIZE, threads, t, 42);
+  assert(e != NULL);
+  assert(lily_env_threads(e) == threads);
+  level_template_release(&t);
+
+  assert(lily_env_reset(e, obs) == 0);
+
+  Uint32 actions[ENV_SIZE];
+  register size_t i, j;
+  for (i = 0; i < ENV_STEPS; i++) {
+    for (j = 0; j < ENV_SIZE; j++) {
+      // change actions every 10 frames, so the player actually moves
+      actions[j] = ((i / 10 + j) * 2654435761u) % (1 << INPUT_KEY_COUNT);
+    }
+
+    assert(lily_env_step(e, actions, obs, rewards, dones) == 0);
+  }
+
+  lily_env_destroy(&e);
+}
+
+// the result of stepping does not depend on the number of threads
+static void test_threads(void) {
+  struct lily_obs obs[2][ENV_SIZE];
+  float rewards[2][ENV_SIZE];
+  bool dones[2][ENV_SIZE];
+
+  run(1, obs[0], rewards[0], dones[0]);
+  run(4, obs[1], rewards[1], dones[1]);
+
+  assert(memcmp(obs[0], obs[1], sizeof(obs[0])) == 0);
+  assert(memcmp(rewards[0], rewards[1], sizeof(rewards[0])) == 0);
+  assert(memcmp(dones[0], dones[1], sizeof(dones[0])) == 0);
+}
+
+int main(void) {
+  RUN_TEST(test_observation);
+  RUN_TEST(test_step);
+  RUN_TEST(test_threads);
+  return 0;
+}
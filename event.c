@@ -0,0 +1,173 @@
+#include "event.h"
+
+#include "handlers.h"
+#include "level.h"
+#include "player.h"
+#include "projectile.h"
+#include "safe.h"
+#include "state.h"
+#include <string.h>
+
+struct event_queue *event_queue_create(void) {
+  struct event_queue *q = calloc(1, sizeof(struct event_queue));
+  if (q == NULL) {
+    LOG_ERROR("could not allocate event queue");
+    return NULL;
+  }
+
+  q->c = EVENT_QUEUE_SIZE;
+  q->e = calloc(q->c, sizeof(struct event));
+  if (q->e == NULL) {
+    LOG_ERROR("could not allocate event queue");
+    free(q);
+    return NULL;
+  }
+
+  return q;
+}
+
+void event_queue_destroy(struct event_queue **pq) {
+  assert_not_null(2, pq, *pq);
+  free((*pq)->e);
+  free(*pq);
+  *pq = NULL;
+}
+
+// push appends an event of type `type` to the queue q. Returns the event, or
+// NULL on failure.
+static struct event *push(struct event_queue *q, const enum event_type type) {
+  if (q->l == q->c) {
+    struct event *e = realloc(q->e, 2 * q->c * sizeof(struct event));
+    if (e == NULL) {
+      LOG_ERROR("could not allocate event queue");
+      return NULL;
+    }
+
+    q->e = e;
+    q->c *= 2;
+  }
+
+  struct event *e = &q->e[q->l++];
+  memset(e, 0, sizeof(struct event));
+  e->type = type;
+  return e;
+}
+
+int event_emit(struct lily_world *w, const enum event_type type,
+               struct sprite *s) {
+  assert_not_null(2, w, w->level);
+
+  struct event *e = push(w->level->events, type);
+  if (e == NULL) {
+    return -1;
+  }
+
+  e->s = s;
+  return 0;
+}
+
+int event_emit_tile(struct lily_world *w, const enum event_type type,
+                    const enum sprite_id id, const int r, const int c,
+                    const double vx) {
+  assert_not_null(2, w, w->level);
+
+  struct event *e = push(w->level->events, type);
+  if (e == NULL) {
+    return -1;
+  }
+
+  e->id = id;
+  e->r = r;
+  e->c = c;
+  e->vx = vx;
+  return 0;
+}
+
+// collect collects the item of the event e in the level l of the world w.
+// Returns 0 on success, -1 on failure.
+static int collect(struct lily_world *w, struct level *l,
+                   const struct event *e) {
+  const size_t i = (size_t)e->r * COLUMN_COUNT * l->w + (size_t)e->c;
+  if (level_item(l, i) == SPRITE_NONE) {
+    return 0;
+  }
+
+  l->collected[i / 8] |= (Uint8)(1 << (i % 8));
+  if (handler_item_collect(w, l, e->id, e->r, e->c) != 0) {
+    LOG_ERROR("failed to collect item with id: %d", e->id);
+    return -1;
+  }
+
+  return 0;
+}
+
+// spawn spawns the projectile of the event e in the level l of the world w,
+// facing the way it flies. Returns 0 on success, -1 on failure.
+static int spawn(struct lily_world *w, struct level *l,
+                 const struct event *e) {
+  struct projectile *p =
+      projectile_spawn(w, l->projectiles, e->id, e->r, e->c, e->vx);
+  if (p == NULL) {
+    return -1;
+  }
+
+  p->s.animation.flip = e->vx > 0 ? SDL_FLIP_NONE : SDL_FLIP_HORIZONTAL;
+  return 0;
+}
+
+// resolve resolves the event e in the world w. Returns 0 on success, -1 on
+// failure.
+static int resolve(struct lily_world *w, const struct event *e) {
+  struct player *p = w->player;
+
+  switch (e->type) {
+  case EVENT_HIT:
+    if (e->s->type->hit_handler(w, e->s) != 0) {
+      LOG_ERROR("failed to handle [hit handler] sprite with id: %d",
+                e->s->type->id);
+      return -1;
+    }
+    return 0;
+  case EVENT_KILL:
+    if (e->s == NULL) {
+      // override blinking
+      p->blink_timer.time_left = 0;
+    }
+    player_kill(w, p);
+    return 0;
+  case EVENT_COLLECT:
+    return collect(w, w->level, e);
+  case EVENT_SPAWN:
+    return spawn(w, w->level, e);
+  case EVENT_DESPAWN:
+    e->s->removed = true;
+    return 0;
+  }
+
+  return 0;
+}
+
+int event_resolve(struct lily_world *w) {
+  assert_not_null(3, w, w->level, w->player);
+  struct event_queue *q = w->level->events;
+
+  // resolving an event may emit more, which moves q->e, so the events are
+  // copied before they are resolved
+  int ret = 0;
+  register size_t i;
+  for (i = 0; i < q->l && ret == 0; i++) {
+    const struct event e = q->e[i];
+    if (e.type != EVENT_SPAWN) {
+      ret = resolve(w, &e);
+    }
+  }
+
+  for (i = 0; i < q->l && ret == 0; i++) {
+    if (q->e[i].type == EVENT_SPAWN) {
+      ret = resolve(w, &q->e[i]);
+    }
+  }
+
+  q->l = 0;
+  return ret;
+}
@@ -0,0 +1,88 @@
+#ifndef EVENT_H
+#define EVENT_H
+
+#include "base.h"
+
+#include "sprite.h"
+
+// event implements the events of a tick of the game. While the active sprites
+// and projectiles of a level are updated (see level_iterate), their handlers
+// and the collision pass do not change the player or the sprites of the level
+// other than the one being updated: they emit events instead, to the event
+// queue of the level. Once every sprite was updated, the events are resolved
+// in the order they were emitted, so the outcome of a tick does not depend on
+// where the sprites that collide with the player are in the update loop, and
+// nothing is added to or removed from the level while it is iterated.
+//
+// Resolving an event may emit more events (e.g a spider hitting the player
+// kills them), which are resolved in the same tick, after the events emitted
+// before them. Spawn events are resolved last, once every other event was, so
+// that the projectile they spawn does not take the slot of a projectile that
+// another event refers to (see projectile_spawn).
+
+// forward declaration, see state.h
+struct lily_world;
+
+// event_type enumerates the events of a tick
+enum event_type {
+  // the sprite s collided with the player: its hit handler is called
+  EVENT_HIT,
+  // the player is killed by the sprite s, unless they are blinking. If s is
+  // NULL, the player touched a tile that kills (see TILE_KILL), which kills
+  // them even if they are blinking.
+  EVENT_KILL,
+  // the player collects the item id on the tile at row r and column c (see
+  // level_item), unless it was collected already
+  EVENT_COLLECT,
+  // a projectile of type id is spawned on the tile at row r and column c,
+  // flying with the horizontal velocity vx (see projectile_spawn)
+  EVENT_SPAWN,
+  // the sprite s is removed from the level
+  EVENT_DESPAWN,
+};
+
+// event is an event of a tick, see event_type
+struct event {
+  enum event_type type;
+  struct sprite *s;
+  enum sprite_id id;
+  int r, c;
+  double vx;
+};
+
+enum {
+  // EVENT_QUEUE_SIZE is the initial capacity of an event queue
+  EVENT_QUEUE_SIZE = 64,
+};
+
+// event_queue holds the events of a tick, in the order they were emitted
+struct event_queue {
+  struct event *e;
+  size_t l; // the number of events
+  size_t c; // the capacity of e
+};
+
+// event_queue_create creates an empty event queue. Returns NULL on failure.
+struct event_queue *event_queue_create(void);
+
+// event_queue_destroy frees the memory of the queue and sets *pq to NULL
+void event_queue_destroy(struct event_queue **pq);
+
+// event_emit emits an event of type `type` about the sprite s to the event
+// queue of the current level of the world w. Returns 0 on success, -1 on
+// failure.
+int event_emit(struct lily_world *w, const enum event_type type,
+               struct sprite *s);
+
+// event_emit_tile emits an event of type `type` about the sprite id on the
+// tile at row r and column c, with the velocity vx, to the event queue of the
+// current level of the world w. Returns 0 on success, -1 on failure.
+int event_emit_tile(struct lily_world *w, const enum event_type type,
+                    const enum sprite_id id, const int r, const int c,
+                    const double vx);
+
+// event_resolve resolves the events of the current level of the world w, then
+// empties its event queue. Returns 0 on success, -1 on failure.
+int event_resolve(struct lily_world *w);
+
+#endif // EVENT_H
@@ -0,0 +1,106 @@
+#include "event.h"
+
+#include "level.h"
+#include "lily.h"
+#include "player.h"
+#include "state.h"
+#include "test.h"
+#include "util.h"
+
+static const struct token_entry TOKENS[] = {
+    {'=', SPRITE_WALL_TOP, token_passive_sprite},
+    {'*', SPRITE_WALL, token_passive_sprite},
+    {'o', SPRITE_COIN, token_item},
+    {'P', SPRITE_PLAYER, token_player},
+    {' ', SPRITE_NONE, NULL}};
+
+static const size_t TOKEN_SIZE = 5;
+
+// the player on the floor, next to a coin
+static const char LEVEL[] = "Po                  \n"
+                            "====================\n"
+                            "********************";
+
+enum { SPEED = 72 };
+
+// events are only resolved by event_resolve, in order, along with the events
+// they emit, and an item is only collected once
+static void test_resolve(void) {
+  struct lily_world *w = test_world(LEVEL, TOKENS, TOKEN_SIZE);
+  struct level *l = w->level;
+  struct player *p = w->player;
+  const unsigned int lives = p->lives;
+  const size_t sprites = l->active_sprites->l;
+
+  int r, c;
+  util_nearest(p->s, &r, &c);
+  assert(token_active_sprite(w, l, SPRITE_SPIDER, r, c) == 0);
+  struct sprite *spider = l->active_sprites->a[l->active_sprites->l - 1];
+
+  // the spider kills the player on the ground when it hits them
+  assert(event_emit(w, EVENT_HIT, spider) == 0);
+  assert(event_emit_tile(w, EVENT_COLLECT, SPRITE_COIN, r, c + 1, 0) == 0);
+  assert(event_emit_tile(w, EVENT_COLLECT, SPRITE_COIN, r, c + 1, 0) == 0);
+  assert(event_emit(w, EVENT_DESPAWN, spider) == 0);
+  assert(l->events->l == 4);
+  assert(p->lives == lives && p->coins == 0 && !spider->removed);
+
+  assert(event_resolve(w) == 0);
+  assert(l->events->l == 0);
+  assert(p->lives == lives - 1);
+  assert(p->coins == 1);
+  assert(spider->removed);
+  assert(level_item(l, r * COLUMN_COUNT + c + 1) == SPRITE_NONE);
+
+  // the spider and the coin fading out
+  assert(l->active_sprites->l == sprites + 2);
+  lily_world_destroy(&w);
+}
+
+// a projectile spawned while the pool is full does not take the slot of the
+// projectile that an event emitted before it removes
+static void test_spawn(void) {
+  struct lily_world *w = test_world(LEVEL, TOKENS, TOKEN_SIZE);
+  struct projectile_pool *pool = w->level->projectiles;
+
+  register size_t i;
+  for (i = 0; i < pool->cap; i++) {
+    struct projectile *pr = projectile_spawn(w, pool, SPRITE_SHOT, 1, 9, SPEED);
+    assert(pr != NULL);
+    pr->s.vy = i;
+  }
+
+  assert(event_emit_tile(w, EVENT_SPAWN, SPRITE_SHOT, 1, 9, -SPEED) == 0);
+  assert(event_emit(w, EVENT_DESPAWN, projectile_get(pool, 0)) == 0);
+  assert(event_resolve(w) == 0);
+  projectile_clean(pool);
+
+  assert(pool->count == pool->cap);
+  assert(projectile_get(pool, 0)->vy == 1);
+  struct sprite *s = projectile_get(pool, pool->count - 1);
+  assert(s->vx == -SPEED && s->animation.flip == SDL_FLIP_HORIZONTAL);
+  lily_world_destroy(&w);
+}
+
+// a level iterates with an empty event queue, and the player collects the coin
+// next to them by walking to it
+static void test_iterate(void) {
+  struct lily_world *w = test_world(LEVEL, TOKENS, TOKEN_SIZE);
+  struct player *p = w->player;
+
+  register size_t t;
+  for (t = 0; t < FRAME_RATE && p->coins == 0; t++) {
+    assert(lily_world_step(w, INPUT_RIGHT, FRAME_TIME) == 0);
+    assert(w->level->events->l == 0);
+  }
+
+  assert(p->coins == 1);
+  lily_world_destroy(&w);
+}
+
+int main(void) {
+  RUN_TEST(test_resolve);
+  RUN_TEST(test_spawn);
+  RUN_TEST(test_iterate);
+  return 0;
+}
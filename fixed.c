@@ -0,0 +1,20 @@
+#include "fixed.h"
+
+#include "safe.h"
+
+fixed fixed_from_double(const double v) {
+  // scaling by a power of two is exact, and so is SDL_floor
+  const double f = SDL_floor(v * FIXED_ONE + 0.5);
+  assert(f >= SDL_MIN_SINT32 && f <= SDL_MAX_SINT32);
+  return (fixed)f;
+}
+
+double fixed_to_double(const fixed f) {
+  return f / (double)FIXED_ONE;
+}
+
+double fixed_step(const double v, const Uint64 dt) {
+  // integer division rounds towards zero
+  const Sint64 d = (Sint64)fixed_from_double(v) * (Sint64)dt / 1000;
+  return fixed_to_double((fixed)d);
+}
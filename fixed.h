@@ -0,0 +1,44 @@
+#ifndef FIXED_H
+#define FIXED_H
+
+#include <SDL2/SDL.h>
+
+// fixed implements the 16.16 fixed-point grid the steps of the physics of the
+// game are rounded to, so that a game plays out bit for bit the same on every
+// platform and with every compiler, e.g for replays (see history.h) and
+// lockstep games (see netplay.h).
+//
+// A fixed is a number of 1/65536ths of a pixel, in a signed 32 bit integer.
+// This is a rounding quantizer, not a fixed-point physics: positions and
+// velocities are stored as doubles (see struct sprite), and the handlers and
+// util_nearest compute with doubles. Only the operations that may round,
+// multiplying a velocity by the duration of a frame, are quantized by
+// fixed_step, which computes them with integer math. Every position and
+// velocity thus stays a whole number of fixed units, which a double holds
+// exactly, so the additions, comparisons, halvings and floors of the rest of
+// the physics are exact as well. Any new multiplication or division of a
+// position or velocity must go through fixed_step too: fixed_test checks that
+// the game plays out the same whether or not the compiler contracts the
+// floating-point operations of the core (see fixed_trace.c).
+
+typedef Sint32 fixed;
+
+enum {
+  FIXED_SHIFT = 16,
+  FIXED_ONE = 1 << FIXED_SHIFT, // 1.0, in fixed-point
+};
+
+// fixed_from_double returns v in fixed-point, rounded to the nearest fixed
+// unit. v must be within +/- 32768.
+fixed fixed_from_double(const double v);
+
+// fixed_to_double returns f as a double, which is exact
+double fixed_to_double(const fixed f);
+
+// fixed_step returns the distance, in pixels, that a sprite moving at v pixels
+// per second moves in dt milliseconds. It is computed in fixed-point and
+// rounded towards zero, so the result is the same on every platform and moving
+// left is the mirror of moving right.
+double fixed_step(const double v, const Uint64 dt);
+
+#endif // FIXED_H
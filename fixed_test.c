@@ -0,0 +1,98 @@
+#include "fixed.h"
+
+#include "default_levels.h"
+#include "fps.h"
+#include "test.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// the values fixed_step is tested with, in pixels per second, see player.c,
+// handlers_*.c and MAX_VELOCITY
+static const double VELOCITIES[] = {0, 1, 36, 64, 72, 96, 128, 142, 352, 384};
+
+// fixed-point conversions are exact, and steps are symmetric
+static void test_fixed(void) {
+  assert(fixed_from_double(1) == FIXED_ONE);
+  assert(fixed_from_double(-0.5) == -FIXED_ONE / 2);
+  assert(fixed_to_double(FIXED_ONE / 4) == 0.25);
+  assert(fixed_to_double(fixed_from_double(1.0 / 3)) != 1.0 / 3);
+
+  register size_t i;
+  register Uint64 dt;
+  for (i = 0; i < sizeof(VELOCITIES) / sizeof(VELOCITIES[0]); i++) {
+    const double v = VELOCITIES[i];
+    for (dt = 0; dt <= MAX_STEP_TIME; dt++) {
+      const double d = fixed_step(v, dt);
+      assert(fixed_step(-v, dt) == -d);
+      assert(fixed_to_double(fixed_from_double(d)) == d);
+      // within a fixed unit of the exact distance
+      assert(d <= v * dt / 1000.0);
+      assert(v * dt / 1000.0 - d < 1.0 / FIXED_ONE);
+    }
+  }
+}
+
+// TRACE_SIZE is the size of the trace of fixed_trace, plus some room
+enum { TRACE_SIZE = 4096 };
+
+// TRACES are the paths of fixed_trace built against a core whose
+// floating-point operations are contracted, e.g into FMA instructions, and
+// against a core whose are not, see main
+static const char *TRACES[2];
+
+// run_trace runs the fixed_trace program at `path`, and reads its trace into
+// buf, of TRACE_SIZE bytes
+static void run_trace(const char *path, char *buf) {
+  char out[1024], cmd[2 * sizeof(out)];
+  assert(snprintf(out, sizeof(out), "%s.out", path) < (int)sizeof(out));
+  assert(snprintf(cmd, sizeof(cmd), "\"%s\" \"%s\"", path, out) <
+         (int)sizeof(cmd));
+  assert(system(cmd) == 0);
+
+  FILE *f = fopen(out, "r");
+  assert(f != NULL);
+  const size_t len = fread(buf, 1, TRACE_SIZE - 1, f);
+  fclose(f);
+  assert(len > 0 && len < TRACE_SIZE - 1);
+  buf[len] = '\0';
+}
+
+// every level of the game, played with the same pseudo-random inputs, goes
+// through the same states whether or not the compiler contracts the
+// floating-point operations of the physics: the traces of both builds of
+// fixed_trace are the same
+static void test_contract(void) {
+  static char a[TRACE_SIZE], b[TRACE_SIZE];
+  run_trace(TRACES[0], a);
+  run_trace(TRACES[1], b);
+
+  if (strcmp(a, b) != 0) {
+    printf("contracted:\n%s\nnot contracted:\n%s\n", a, b);
+  }
+  assert(strcmp(a, b) == 0);
+
+  // a line per level
+  size_t lines = 0;
+  const char *c;
+  for (c = a; *c != '\0'; c++) {
+    lines += *c == '\n';
+  }
+  assert(lines == LEVEL_COUNT);
+}
+
+// fixed_test is given the paths of the two builds of fixed_trace, see
+// meson.build
+int main(int argc, char *argv[]) {
+  RUN_TEST(test_fixed);
+
+  if (argc == 3) {
+    TRACES[0] = argv[1];
+    TRACES[1] = argv[2];
+    RUN_TEST(test_contract);
+  } else {
+    printf("no fixed_trace given, skipping test_contract\n");
+  }
+
+  return 0;
+}
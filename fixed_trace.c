@@ -0,0 +1,131 @@
+#include "fixed.h"
+
+#include "default_levels.h"
+#include "input.h"
+#include "level.h"
+#include "lily.h"
+#include "player.h"
+#include "safe.h"
+#include "state.h"
+#include "util.h"
+#include <stdio.h>
+
+// fixed_trace plays every level of the game with the same pseudo-random
+// inputs, and writes a hash of the positions and velocities of its sprites at
+// every tick to a file, a line per level. Usage:
+//
+//   fixed_trace OUTPUT
+//
+// It is built against cores compiled with different floating-point options,
+// whose traces fixed_test compares (see fixed.h). It aborts if a position or
+// velocity is not a whole number of fixed units.
+
+// the inputs the levels are played with
+static const Uint32 INPUTS[] = {INPUT_NONE,
+                                INPUT_RIGHT,
+                                INPUT_RIGHT | INPUT_SPRINT,
+                                INPUT_RIGHT | INPUT_JUMP,
+                                INPUT_LEFT,
+                                INPUT_LEFT | INPUT_SHORT_JUMP,
+                                INPUT_UP,
+                                INPUT_DOWN};
+
+enum { TRACE_TICKS = 30 * FRAME_RATE, TRACE_HOLD = FRAME_RATE / 2 };
+
+// on_grid returns true if v is a whole number of fixed units
+static bool on_grid(const double v) {
+  return fixed_to_double(fixed_from_double(v)) == v;
+}
+
+// hash adds the 32 bits of v to the FNV-1a hash h, in little endian
+static Uint64 hash(Uint64 h, const Uint32 v) {
+  register int i;
+  for (i = 0; i < 4; i++) {
+    h ^= (v >> (8 * i)) & 0xFF;
+    h *= 0x100000001B3;
+  }
+
+  return h;
+}
+
+// hash_sprite adds the position and velocity of the sprite s to the hash h,
+// after checking that they are whole numbers of fixed units
+static Uint64 hash_sprite(Uint64 h, const struct sprite *s) {
+  assert(on_grid(s->x) && on_grid(s->y));
+  assert(on_grid(s->vx) && on_grid(s->vy));
+
+  h = hash(h, (Uint32)fixed_from_double(s->x));
+  h = hash(h, (Uint32)fixed_from_double(s->y));
+  h = hash(h, (Uint32)fixed_from_double(s->vx));
+  return hash(h, (Uint32)fixed_from_double(s->vy));
+}
+
+// trace plays the game's level number `index`, and returns the hash of every
+// tick of it. Returns 0 on failure.
+static Uint64 trace(const size_t index) {
+  struct lily_world *w = lily_world_create();
+  if (w == NULL) {
+    return 0;
+  }
+
+  lily_world_seed(w, index);
+  if (lily_world_load_default_level(w, index) != 0) {
+    lily_world_destroy(&w);
+    return 0;
+  }
+
+  // the inputs are drawn with the world's generator before the level is
+  // played, so they do not depend on the game logic
+  Uint32 inputs[TRACE_TICKS / TRACE_HOLD];
+  register size_t t, j;
+  for (t = 0; t < TRACE_TICKS / TRACE_HOLD; t++) {
+    inputs[t] = INPUTS[util_rand(w) % (sizeof(INPUTS) / sizeof(INPUTS[0]))];
+  }
+
+  Uint64 h = 0xCBF29CE484222325;
+  for (t = 0; t < TRACE_TICKS; t++) {
+    if (lily_world_step(w, inputs[t / TRACE_HOLD], FRAME_TIME) != 0) {
+      h = 0;
+      break;
+    }
+
+    const struct level *l = w->level;
+    h = hash(h, (Uint32)w->state);
+    for (j = 0; j < l->active_sprites->l; j++) {
+      h = hash_sprite(h, l->active_sprites->a[j]);
+    }
+    for (j = 0; j < l->projectiles->count; j++) {
+      h = hash_sprite(h, projectile_get(l->projectiles, j));
+    }
+  }
+
+  lily_world_destroy(&w);
+  return h;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc != 2) {
+    fprintf(stderr, "usage: fixed_trace OUTPUT\n");
+    return 2;
+  }
+
+  FILE *f = fopen(argv[1], "w");
+  if (f == NULL) {
+    fprintf(stderr, "could not write %s\n", argv[1]);
+    return 2;
+  }
+
+  int ret = 0;
+  register size_t i;
+  for (i = 0; i < LEVEL_COUNT && ret == 0; i++) {
+    const Uint64 h = trace(i);
+    if (h == 0 || fprintf(f, "%s 0x%016llX\n", LEVELS[i],
+                          (unsigned long long)h) < 0) {
+      ret = 1;
+    }
+  }
+
+  fclose(f);
+  level_template_cache_clear();
+  return ret;
+}
@@ -0,0 +1,213 @@
+#include "flow.h"
+
+#include "level.h"
+#include "player.h"
+#include "safe.h"
+#include "state.h"
+#include "util.h"
+
+// move is a way an enemy can walk out of a tile, see flow_field.moves
+enum move {
+  MOVE_LEFT = 1 << 0,
+  MOVE_RIGHT = 1 << 1,
+  MOVE_UP = 1 << 2,
+  MOVE_DOWN = 1 << 3,
+};
+
+struct flow_field *flow_field_create(const size_t w, const size_t h) {
+  struct flow_field *f = calloc(1, sizeof(struct flow_field));
+  if (f == NULL) {
+    LOG_ERROR("could not allocate flow field");
+    return NULL;
+  }
+
+  f->rows = ROW_COUNT * (int)h;
+  f->cols = COLUMN_COUNT * (int)w;
+  f->r = f->c = -1;
+
+  const size_t n = (size_t)f->rows * f->cols;
+  f->moves = calloc(n, sizeof(Uint8));
+  f->dist = malloc(n * sizeof(Uint16));
+  f->reached = malloc(n * sizeof(Uint32));
+  if (f->moves == NULL || f->dist == NULL || f->reached == NULL) {
+    LOG_ERROR("could not allocate flow field");
+    flow_field_destroy(&f);
+    return NULL;
+  }
+
+  register size_t i;
+  for (i = 0; i < n; i++) {
+    f->dist[i] = FLOW_UNREACHED;
+  }
+
+  return f;
+}
+
+void flow_field_destroy(struct flow_field **pf) {
+  assert_not_null(2, pf, *pf);
+  struct flow_field *f = *pf;
+  free(f->reached);
+  free(f->dist);
+  free(f->moves);
+  free(f);
+  *pf = NULL;
+}
+
+// passable returns true if the tile at row r and column c of the current level
+// of the world w is within the level and not solid from any side
+static bool passable(const struct lily_world *w, const struct flow_field *f,
+                     const int r, const int c) {
+  return r >= 0 && r < f->rows && c >= 0 && c < f->cols &&
+         !util_solid(w, r, c, SOLID_LEFT) &&
+         !util_solid(w, r, c, SOLID_RIGHT) &&
+         !util_solid(w, r, c, SOLID_TOP) &&
+         !util_solid(w, r, c, SOLID_BOTTOM);
+}
+
+// walkable returns true if an enemy can walk on the tile at row r and column
+// c: it is passable, and on top of a solid tile or a ladder, or a ladder itself
+static bool walkable(const struct lily_world *w, const struct flow_field *f,
+                     const int r, const int c) {
+  return passable(w, f, r, c) &&
+         (util_solid(w, r + 1, c, SOLID_TOP) || util_ladder(w, r, c) ||
+          util_ladder(w, r + 1, c));
+}
+
+// build builds the moves of the flow field f from the tiles of the current
+// level of the world w
+static void build(const struct lily_world *w, struct flow_field *f) {
+  register int r, c;
+  for (r = 0; r < f->rows; r++) {
+    for (c = 0; c < f->cols; c++) {
+      if (!walkable(w, f, r, c)) {
+        continue;
+      }
+
+      Uint8 *m = &f->moves[r * f->cols + c];
+      if (walkable(w, f, r, c - 1)) {
+        *m |= MOVE_LEFT;
+      }
+      if (walkable(w, f, r, c + 1)) {
+        *m |= MOVE_RIGHT;
+      }
+      // a ladder is climbed up to the tile above it, and down from it
+      if (util_ladder(w, r, c) && walkable(w, f, r - 1, c)) {
+        *m |= MOVE_UP;
+      }
+      if (util_ladder(w, r + 1, c) && walkable(w, f, r + 1, c)) {
+        *m |= MOVE_DOWN;
+      }
+    }
+  }
+
+  f->built = true;
+}
+
+// source populates r and c with the tile the flow field f of the current level
+// of the world w leads to: the tile of the player, or the walkable tile they
+// will land on if they are in the air. Returns false if there is none.
+static bool source(const struct lily_world *w, const struct flow_field *f,
+                   int *r, int *c) {
+  const struct sprite *s = w->player->s;
+  if (s == NULL) {
+    return false;
+  }
+
+  util_nearest(s, r, c);
+  while (passable(w, f, *r, *c) && !walkable(w, f, *r, *c)) {
+    (*r)++;
+  }
+
+  return walkable(w, f, *r, *c);
+}
+
+// search searches the flow field f from the tile at row r and column c, up to
+// FLOW_RANGE tiles away, after resetting the tiles the previous search reached.
+// If r is negative, the field is only reset.
+static void search(struct flow_field *f, const int r, const int c) {
+  register size_t i;
+  for (i = 0; i < f->reach_count; i++) {
+    f->dist[f->reached[i]] = FLOW_UNREACHED;
+  }
+
+  f->r = r;
+  f->c = c;
+  f->reach_count = 0;
+  f->searches++;
+  if (r < 0) {
+    return;
+  }
+
+  // the tiles reached are the queue of the search
+  const Uint32 start = (Uint32)(r * f->cols + c);
+  f->dist[start] = 0;
+  f->reached[0] = start;
+  f->reach_count = 1;
+
+  const int steps[] = {-1, 1, -f->cols, f->cols};
+  const Uint8 moves[] = {MOVE_LEFT, MOVE_RIGHT, MOVE_UP, MOVE_DOWN};
+  register size_t k;
+  for (i = 0; i < f->reach_count; i++) {
+    const Uint32 t = f->reached[i];
+    const Uint16 d = f->dist[t];
+    if (d == FLOW_RANGE) {
+      continue;
+    }
+
+    // the moves are the same both ways, so a tile is reached from every tile
+    // it can be walked to from
+    for (k = 0; k < sizeof(moves) / sizeof(moves[0]); k++) {
+      const Uint32 n = (Uint32)((int)t + steps[k]);
+      if ((f->moves[t] & moves[k]) && f->dist[n] == FLOW_UNREACHED) {
+        f->dist[n] = d + 1;
+        f->reached[f->reach_count++] = n;
+      }
+    }
+  }
+}
+
+void flow_field_update(const struct lily_world *w, struct flow_field *f) {
+  assert_not_null(4, w, w->level, w->player, f);
+
+  if (!f->built) {
+    build(w, f);
+  }
+
+  int r, c;
+  if (!source(w, f, &r, &c)) {
+    // the field leads nowhere, e.g while the player falls into water
+    r = c = -1;
+  }
+
+  if (r != f->r || c != f->c) {
+    search(f, r, c);
+  }
+}
+
+Uint16 flow_field_dist(const struct flow_field *f, const int r, const int c) {
+  assert_not_null(1, f);
+  if (r < 0 || r >= f->rows || c < 0 || c >= f->cols) {
+    return FLOW_UNREACHED;
+  }
+
+  return f->dist[r * f->cols + c];
+}
+
+enum flow_dir flow_field_dir(const struct flow_field *f, const int r,
+                             const int c) {
+  const Uint16 d = flow_field_dist(f, r, c);
+  if (d == FLOW_UNREACHED) {
+    return FLOW_NONE;
+  }
+
+  const Uint8 m = f->moves[r * f->cols + c];
+  if ((m & MOVE_LEFT) && flow_field_dist(f, r, c - 1) < d) {
+    return FLOW_LEFT;
+  }
+
+  if ((m & MOVE_RIGHT) && flow_field_dist(f, r, c + 1) < d) {
+    return FLOW_RIGHT;
+  }
+
+  return FLOW_WAIT;
+}
@@ -0,0 +1,91 @@
+#ifndef FLOW_H
+#define FLOW_H
+
+#include "base.h"
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+
+// flow implements the flow field of a level, which leads the enemies that
+// chase the player to them. It holds the distance of every tile to the tile of
+// the player, along the paths an enemy could walk, found by a breadth-first
+// search: an enemy turns to whichever of the tiles on its left and on its right
+// is closer to the player, which is a lookup of the field however many enemies
+// chase the player.
+//
+// An enemy walks on the tiles that are not solid (see util_solid) and that are
+// on top of a solid tile or of a ladder, and it climbs up and down ladders. It
+// does not fall off ledges. The field only reaches FLOW_RANGE tiles from the
+// player, so the enemies further away do not chase them.
+//
+// The field is a function of the tile of the player, so it is only searched
+// again when the player moves to another tile, once per tick for every enemy
+// (see level_iterate). Searching again only resets the tiles the previous
+// search reached, so it costs the area within FLOW_RANGE of the player rather
+// than the size of the level.
+
+// forward declaration, see state.h
+struct lily_world;
+
+enum {
+  // FLOW_RANGE is the length of the longest path of the flow field, in tiles
+  FLOW_RANGE = 2 * COLUMN_COUNT,
+  // FLOW_UNREACHED is the distance of the tiles the flow field did not reach
+  FLOW_UNREACHED = 0xFFFF,
+};
+
+// flow_dir is the way the flow field leads an enemy on a tile
+enum flow_dir {
+  // FLOW_NONE means the tile was not reached: the player is out of reach
+  FLOW_NONE,
+  // FLOW_LEFT and FLOW_RIGHT mean the tile on the left, or on the right, is
+  // closer to the player
+  FLOW_LEFT,
+  FLOW_RIGHT,
+  // FLOW_WAIT means the tile was reached, but neither the tile on the left nor
+  // the tile on the right is closer to the player: the player is on the tile,
+  // or the path goes up or down a ladder from it
+  FLOW_WAIT,
+};
+
+// flow_field is the flow field of a level
+struct flow_field {
+  int rows, cols; // the size of the level, in tiles
+  // moves has a bitmask of the ways an enemy can walk out of every tile. It is
+  // built from the tiles of the level the first time the field is updated.
+  Uint8 *moves;
+  bool built;
+  // dist has the distance of every tile to the player, or FLOW_UNREACHED
+  Uint16 *dist;
+  // reached lists the reach_count tiles the last search reached, in the order
+  // it reached them
+  Uint32 *reached;
+  size_t reach_count;
+  // r and c are the tile the field leads to, or -1 if it leads nowhere
+  int r, c;
+  // searches is the number of times the field was searched
+  Uint64 searches;
+};
+
+// flow_field_create creates the empty flow field of a level of w by h
+// screens. Returns NULL on failure.
+struct flow_field *flow_field_create(const size_t w, const size_t h);
+
+// flow_field_destroy frees the memory of the flow field and sets *pf to NULL
+void flow_field_destroy(struct flow_field **pf);
+
+// flow_field_update makes the flow field f, of the current level of the world
+// w, lead to the tile of the player, or to the tile they will land on if they
+// are in the air. It is only searched again if that tile changed.
+void flow_field_update(const struct lily_world *w, struct flow_field *f);
+
+// flow_field_dist returns the distance of the tile at row r and column c to
+// the player, in tiles, or FLOW_UNREACHED
+Uint16 flow_field_dist(const struct flow_field *f, const int r, const int c);
+
+// flow_field_dir returns the way the flow field f leads an enemy on the tile
+// at row r and column c
+enum flow_dir flow_field_dir(const struct flow_field *f, const int r,
+                             const int c);
+
+#endif // FLOW_H
@@ -0,0 +1,164 @@
+#include "flow.h"
+
+#include "input.h"
+#include "level.h"
+#include "lily.h"
+#include "player.h"
+#include "state.h"
+#include "test.h"
+#include "util.h"
+#include <string.h>
+
+static const struct token_entry TOKENS[] = {
+    {'=', SPRITE_WALL_TOP, token_passive_sprite},
+    {'*', SPRITE_WALL, token_passive_sprite},
+    {'L', SPRITE_LADDER, token_passive_sprite},
+    {'P', SPRITE_PLAYER, token_player},
+    {'k', SPRITE_SKELETON, token_active_sprite},
+    {' ', SPRITE_NONE, NULL}};
+
+// the player on an upper floor, and a skeleton X on a lower floor, joined by a
+// ladder
+static const char LEVEL[] = "  P                 \n"
+                            "=====L==============\n"
+                            "     L              \n"
+                            "     L              \n"
+                            "     L      X       \n"
+                            "====================\n"
+                            "********************\n"
+                            "********************\n"
+                            "********************";
+
+// world creates a world playing LEVEL, with the enemy X being the token `token`
+static struct lily_world *world(const char token) {
+  char level[sizeof(LEVEL)];
+  memcpy(level, LEVEL, sizeof(LEVEL));
+  *strchr(level, 'X') = token;
+
+  return test_world(level, TOKENS, sizeof(TOKENS) / sizeof(TOKENS[0]));
+}
+
+// the distances follow the floors and the ladder, and the field leads to the
+// ladder from the lower floor
+static void test_dist(void) {
+  struct lily_world *w = world(' ');
+  struct flow_field *f = w->level->flow;
+  flow_field_update(w, f);
+
+  assert(flow_field_dist(f, 6, 2) == 0);
+  assert(flow_field_dist(f, 6, 0) == 2);
+  assert(flow_field_dist(f, 6, 5) == 3);
+  assert(flow_field_dist(f, 7, 5) == 4);
+  assert(flow_field_dist(f, 10, 5) == 7);
+  assert(flow_field_dist(f, 10, 19) == 21);
+
+  // walls, the air and the tiles outside of the level are not reached
+  assert(flow_field_dist(f, 7, 4) == FLOW_UNREACHED);
+  assert(flow_field_dist(f, 5, 2) == FLOW_UNREACHED);
+  assert(flow_field_dist(f, 8, 6) == FLOW_UNREACHED);
+  assert(flow_field_dist(f, -1, 2) == FLOW_UNREACHED);
+  assert(flow_field_dist(f, 6, COLUMN_COUNT) == FLOW_UNREACHED);
+
+  assert(flow_field_dir(f, 10, 12) == FLOW_LEFT);
+  assert(flow_field_dir(f, 10, 3) == FLOW_RIGHT);
+  assert(flow_field_dir(f, 10, 5) == FLOW_WAIT);
+  assert(flow_field_dir(f, 6, 2) == FLOW_WAIT);
+  assert(flow_field_dir(f, 6, 4) == FLOW_LEFT);
+  assert(flow_field_dir(f, 8, 6) == FLOW_NONE);
+
+  lily_world_destroy(&w);
+}
+
+// the field is only searched again when the player moves to another tile, and
+// is then the same as a field searched from scratch
+static void test_search(void) {
+  struct lily_world *w = world(' ');
+  struct flow_field *f = w->level->flow;
+
+  register size_t t;
+  for (t = 0; t < FRAME_RATE; t++) {
+    assert(lily_world_step(w, INPUT_NONE, FRAME_TIME) == 0);
+  }
+  assert(f->searches == 1);
+
+  w->player->s->x += 10 * SPRITE_SIZE;
+  flow_field_update(w, f);
+  assert(f->searches == 2);
+  assert(flow_field_dist(f, 6, 12) == 0);
+  assert(flow_field_dir(f, 6, 2) == FLOW_RIGHT);
+
+  struct flow_field *g = flow_field_create(w->level->w, w->level->h);
+  assert(g != NULL);
+  flow_field_update(w, g);
+  assert(memcmp(f->dist, g->dist, f->rows * f->cols * sizeof(Uint16)) == 0);
+  flow_field_destroy(&g);
+  assert(g == NULL);
+
+  // a player in the air leads to the tile they land on
+  w->player->s->y -= 4 * SPRITE_SIZE;
+  flow_field_update(w, f);
+  assert(f->searches == 2);
+
+  lily_world_destroy(&w);
+}
+
+// the field does not reach further than FLOW_RANGE tiles from the player
+static void test_range(void) {
+  // a floor of 3 screens, with the player at its left end
+  static char level[4 * (3 * COLUMN_COUNT + 1)];
+  register int r, c;
+  char *b = level;
+  for (r = 0; r < 4; r++) {
+    for (c = 0; c < 3 * COLUMN_COUNT; c++) {
+      *b++ = r > 0 ? '=' : c == 0 ? 'P' : ' ';
+    }
+    *b++ = '\n';
+  }
+  level[sizeof(level) - 1] = '\0';
+
+  struct lily_world *w =
+      test_world(level, TOKENS, sizeof(TOKENS) / sizeof(TOKENS[0]));
+
+  struct flow_field *f = w->level->flow;
+  flow_field_update(w, f);
+  assert(flow_field_dist(f, ROW_COUNT - 4, FLOW_RANGE) == FLOW_RANGE);
+  assert(flow_field_dist(f, ROW_COUNT - 4, FLOW_RANGE + 1) == FLOW_UNREACHED);
+  assert(f->reach_count == FLOW_RANGE + 1);
+
+  lily_world_destroy(&w);
+}
+
+// a skeleton that does not see the player walks to the ladder that leads to
+// them, and waits there
+static void test_skeleton(void) {
+  struct lily_world *w = world('k');
+  const struct array *a = w->level->active_sprites;
+  const struct sprite *s = NULL;
+  register size_t i;
+  for (i = 0; i < a->l; i++) {
+    if (a->a[i]->type->id == SPRITE_SKELETON) {
+      s = a->a[i];
+    }
+  }
+  assert(s != NULL);
+
+  for (i = 0; i < 5 * FRAME_RATE; i++) {
+    assert(lily_world_step(w, INPUT_NONE, FRAME_TIME) == 0);
+  }
+
+  int r, c;
+  util_nearest(s, &r, &c);
+  assert(r == 10 && c == 5);
+  assert(s->vx == 0);
+  assert(s->data.enemy.dir == DIR_LEFT);
+
+  lily_world_destroy(&w);
+}
+
+int main(void) {
+  RUN_TEST(test_dist);
+  RUN_TEST(test_search);
+  RUN_TEST(test_range);
+  RUN_TEST(test_skeleton);
+  return 0;
+}
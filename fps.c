@@ -3,43 +3,49 @@
 #include "assert.h"
 #include "safe.h"
 
-static Uint64 _prev_time = 0;
-static Uint64 _start_time = 0;
-static Uint64 _curr_time = 0;
-static Uint64 _elapsed_time = 0;
-static Uint64 _frame_count = 0;
-
-void fps_init(void) { _start_time = _prev_time = SDL_GetTicks64(); }
+void fps_init(struct fps *f) {
+  assert_not_null(1, f);
+  f->start_time = f->prev_time = SDL_GetTicks64();
+  f->curr_time = f->prev_time;
+  f->elapsed_time = 0;
+  f->frame_count = 0;
+}
 
-void fps_iterate(void) {
-  _curr_time = SDL_GetTicks64();
-  Uint64 elapsed_time = _curr_time - _prev_time;
+void fps_iterate(struct fps *f) {
+  assert_not_null(1, f);
+  f->curr_time = SDL_GetTicks64();
+  Uint64 elapsed_time = f->curr_time - f->prev_time;
 
   if (elapsed_time < FRAME_TIME) {
     // delay until we reach the desired frame rate (per second)
     SDL_Delay(FRAME_TIME - elapsed_time);
-    _curr_time = SDL_GetTicks64();
+    f->curr_time = SDL_GetTicks64();
   }
 
-  assert(_curr_time > _prev_time);
-  _elapsed_time = _curr_time - _prev_time;
-  _prev_time = _curr_time;
-  _frame_count += 1;
+  assert(f->curr_time > f->prev_time);
+  f->elapsed_time = f->curr_time - f->prev_time;
+  f->prev_time = f->curr_time;
+  f->frame_count += 1;
 }
 
-Uint64 fps_frame_time(void) {
-  if (_elapsed_time > MAX_FRAME_TIME) {
+Uint64 fps_frame_time(const struct fps *f) {
+  if (f->elapsed_time > MAX_FRAME_TIME) {
     return MAX_FRAME_TIME;
   }
-  return _elapsed_time;
+  return f->elapsed_time;
 }
 
-Uint64 fps_get(void) {
-  double elapsed_seconds = (_prev_time - _start_time) / 1000.0;
-  Uint64 fps = _frame_count / elapsed_seconds;
+Uint64 fps_get(const struct fps *f) {
+  double elapsed_seconds = (f->prev_time - f->start_time) / 1000.0;
+  Uint64 fps = f->frame_count / elapsed_seconds;
   return fps;
 }
 
+void fps_timer_init(struct fps_timer *t, const Uint64 delay) {
+  t->delay = delay;
+  t->time_left = delay;
+}
+
 struct fps_timer *fps_timer_create(const Uint64 delay) {
   struct fps_timer *t = malloc(sizeof(struct fps_timer));
   if (t == NULL) {
@@ -47,8 +53,7 @@ struct fps_timer *fps_timer_create(const Uint64 delay) {
     return NULL;
   }
 
-  t->delay = delay;
-  t->time_left = delay;
+  fps_timer_init(t, delay);
   return t;
 }
 
@@ -58,8 +63,7 @@ void fps_timer_destroy(struct fps_timer **pt) {
   *pt = NULL;
 }
 
-void fps_timer_iterate(struct fps_timer *t) {
-  const Uint64 dt = fps_frame_time();
+void fps_timer_iterate(struct fps_timer *t, const Uint64 dt) {
   t->time_left = dt > t->time_left ? 0 : t->time_left - dt;
 }
 
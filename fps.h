@@ -17,24 +17,38 @@ enum {
   FRAME_RATE = 48,
   FRAME_TIME = 1000 / FRAME_RATE,
   MIN_FRAME_RATE = 24, // frames per second
-  MAX_FRAME_TIME = 1000 / MIN_FRAME_RATE
+  MAX_FRAME_TIME = 1000 / MIN_FRAME_RATE,
+  // MAX_STEP_TIME is the longest frame a world can be stepped by (see
+  // lily_world_step). The frames of the game loop are at most MAX_FRAME_TIME,
+  // but collisions are swept (see util_sweep_x), so a world that is not
+  // rendered can be stepped coarsely to simulate it faster.
+  MAX_STEP_TIME = 8 * FRAME_TIME
 };
 
-// init_fps_cap initializes the state required to maintain an upper bound on
-// the frames per second (fps) that are rendered.
-void fps_init(void);
+// fps is the frame rate limiter of a game loop
+struct fps {
+  Uint64 prev_time;    // the time at the end of the previous frame
+  Uint64 start_time;   // the time at which the limiter was initialized
+  Uint64 curr_time;    // the time at the end of the current frame
+  Uint64 elapsed_time; // the duration of the current frame
+  Uint64 frame_count;  // the number of frames since initialization
+};
+
+// fps_init initializes the state required to maintain an upper bound on the
+// frames per second (fps) that are rendered.
+void fps_init(struct fps *f);
 
 // fps_iterate should be called at every iteration of the game loop, this
 // delays the game loop to maintain an upper bound on the frames per second
 // (fps) that are rendered.
-void fps_iterate(void);
+void fps_iterate(struct fps *f);
 
 // fps_frame_time returns the elapsed frame time (or MAX_FRAME_TIME if the
 // elapsed frame time is higher than MAX_FRAME_TIME).
-Uint64 fps_frame_time(void);
+Uint64 fps_frame_time(const struct fps *f);
 
 // fps_get returns the current frame rate in frames per second
-Uint64 fps_get(void);
+Uint64 fps_get(const struct fps *f);
 
 // timer is a structure that acts like a mechanical timer going off after a
 // given delay. It is used to process multiple delay based gameplay and ui
@@ -47,6 +61,10 @@ struct fps_timer {
   Uint64 time_left;
 };
 
+// fps_timer_init sets up the fps_timer t, which is typically embedded in
+// another structure, with a delay value.
+void fps_timer_init(struct fps_timer *t, const Uint64 delay);
+
 // fps_timer_create creates a new fps_timer and sets a delay value for it.
 // returns NULL on failure.
 struct fps_timer *fps_timer_create(const Uint64 delay);
@@ -56,8 +74,8 @@ struct fps_timer *fps_timer_create(const Uint64 delay);
 void fps_timer_destroy(struct fps_timer **pt);
 
 // fps_timer_iterate updates the time_left of the fps_timer based on the elapsed
-// fps_frame_time
-void fps_timer_iterate(struct fps_timer *t);
+// frame time dt, in milliseconds
+void fps_timer_iterate(struct fps_timer *t, const Uint64 dt);
 
 // fps_timer_done returns true if there is no time left in the fps_timer, false
 // otherwise
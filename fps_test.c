@@ -12,10 +12,11 @@ static void test_timer_simple(void) {
 static void test_timer_delay(void) {
   struct fps_timer *t = fps_timer_create(10000); // 10 seconds
 
-  fps_init();
+  struct fps f;
+  fps_init(&f);
   SDL_Delay(1); // delay of 1 ms
-  fps_iterate();
-  fps_timer_iterate(t);
+  fps_iterate(&f);
+  fps_timer_iterate(t, fps_frame_time(&f));
 
   assert(t->time_left < t->delay);
   assert(!fps_timer_done(t));
@@ -26,10 +27,11 @@ static void test_timer_delay(void) {
 static void test_timer_done(void) {
   struct fps_timer *t = fps_timer_create(1);
 
-  fps_init();
+  struct fps f;
+  fps_init(&f);
   SDL_Delay(1);
-  fps_iterate();
-  fps_timer_iterate(t);
+  fps_iterate(&f);
+  fps_timer_iterate(t, fps_frame_time(&f));
 
   assert(fps_timer_done(t));
 }
@@ -2,25 +2,45 @@
 
 #include <assert.h>
 #include <string.h>
-#include <time.h>
 
 #include "base.h"
 #include "camera.h"
 #include "level.h"
+#include "level_template.h"
 #include "player.h"
 #include "render.h"
 #include "safe.h"
 #include "scene.h"
-#include "sound.h"
+#include "sound_mixer.h"
 #include "state.h"
+#include "stream.h"
+
+// stream_create opens the stream the games played are streamed to, if any.
+// Returns 0 on success, -1 on failure.
+static int stream_create(void) {
+  if (g_prog.stream_location == NULL) {
+    return 0;
+  }
+
+  SDL_RWops *rw = stream_open(g_prog.stream_location, true);
+  if (rw == NULL) {
+    return -1;
+  }
+
+  g_prog.stream = stream_writer_create(rw, STREAM_KEYFRAME_INTERVAL);
+  if (g_prog.stream == NULL) {
+    return -1;
+  }
+
+  LOG_INFO("streaming to %s", g_prog.stream_location);
+  return 0;
+}
 
 // game_create initializes the game state, the rendering state (including SDL2
 // and its modules), the frame rate regulating system, the level, the camera,
-// and the scene.
+// and the scene. When watching a stream, the game starts with SCENE_VIEW
+// instead of the intro.
 void game_create(void) {
-  // seed the random number generator
-  srand(time(NULL));
-
   assert(render_create() == 0);
   assert(sound_create() == 0);
 
@@ -28,13 +48,25 @@ void game_create(void) {
   // according to SDL2 docs, and we should never free it.
   g_prog.keys = SDL_GetKeyboardState(NULL);
 
-  assert(scene_change(SCENE_INTRO) == 0);
+  const enum scene_id first =
+      g_prog.view_location != NULL ? SCENE_VIEW : SCENE_INTRO;
+  if (stream_create() != 0 || scene_change(first) != 0) {
+    g_prog.state = PROG_ERROR;
+    return;
+  }
+
   g_prog.state = PROG_GAME_IN;
 }
 
 // game_destroy destroys all game and rendering state, and frees up any
 // remaining memory allocated on the heap.
 static void game_destroy(void) {
+  // close the stream, if the games were streamed
+  if (g_prog.stream != NULL) {
+    stream_writer_destroy(&g_prog.stream);
+  }
+  // free any level templates still in the level cache
+  level_template_cache_clear();
   // sound_destroy destroys all the sound state
   sound_destroy();
   // render_destroy destroys all the scene state and quits SDL
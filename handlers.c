@@ -4,13 +4,19 @@
 
 // we don't really do anything for the simplest kind of sprite
 // except rendering the sprite
-int handler_sprite_init(struct sprite *s) {
-  assert_not_null(1, s);
+int handler_sprite_init(struct lily_world *w, struct sprite *s) {
+  assert_not_null(2, w, s);
   return 0;
 }
 
-int handler_sprite_frame(struct sprite *s) { return handler_sprite_init(s); }
+int handler_sprite_frame(struct lily_world *w, struct sprite *s) {
+  return handler_sprite_init(w, s);
+}
 
-int handler_sprite_hit(struct sprite *s) { return handler_sprite_init(s); }
+int handler_sprite_hit(struct lily_world *w, struct sprite *s) {
+  return handler_sprite_init(w, s);
+}
 
-int handler_sprite_destroy(struct sprite *s) { return handler_sprite_init(s); }
+int handler_sprite_destroy(struct lily_world *w, struct sprite *s) {
+  return handler_sprite_init(w, s);
+}
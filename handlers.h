@@ -4,66 +4,155 @@
 // Contains all the sprite handlers for the various sprite types in the game
 #include "sprite.h"
 
+// forward declaration, see level.h
+struct level;
+
 // the handlers for the simplest kind of sprite
-int handler_sprite_init(struct sprite *s);
-int handler_sprite_frame(struct sprite *s);
-int handler_sprite_hit(struct sprite *s);
-int handler_sprite_destroy(struct sprite *s);
+int handler_sprite_init(struct lily_world *w, struct sprite *s);
+int handler_sprite_frame(struct lily_world *w, struct sprite *s);
+int handler_sprite_hit(struct lily_world *w, struct sprite *s);
+int handler_sprite_destroy(struct lily_world *w, struct sprite *s);
 
 // the handlers for item collection
-int handler_item_init(struct sprite *s);
-int handler_item_frame(struct sprite *s);
-int handler_item_hit(struct sprite *s);
+int handler_item_init(struct lily_world *w, struct sprite *s);
+int handler_item_frame(struct lily_world *w, struct sprite *s);
+int handler_item_hit(struct lily_world *w, struct sprite *s);
+// handler_item_collect collects the item `id` on the tile at row r and column
+// c of the level l (see level_item): the player is rewarded, and an active
+// sprite of the item is added to the level to fade it out. Returns 0 on
+// success, -1 on failure.
+int handler_item_collect(struct lily_world *w, struct level *l,
+                         const enum sprite_id id, const size_t r,
+                         const size_t c);
 
 // the handler for spiders and similar enemies
-int handler_spider_init(struct sprite *s);
-int handler_spider_frame(struct sprite *s);
-int handler_spider_hit(struct sprite *s);
+int handler_spider_init(struct lily_world *w, struct sprite *s);
+int handler_spider_frame(struct lily_world *w, struct sprite *s);
+int handler_spider_hit(struct lily_world *w, struct sprite *s);
 
-int handler_sprinting_spider_frame(struct sprite *s);
-int handler_bat_init(struct sprite *s);
+int handler_sprinting_spider_init(struct lily_world *w, struct sprite *s);
+int handler_sprinting_spider_frame(struct lily_world *w, struct sprite *s);
+int handler_bat_init(struct lily_world *w, struct sprite *s);
 
 // the handler for ghosts
-int handler_ghost_init(struct sprite *s);
-int handler_ghost_frame(struct sprite *s);
-
-// the handler for things shot at the player by enemies
-int handler_shot_init(struct sprite *s);
-int handler_shot_frame(struct sprite *s);
-int handler_shot_hit(struct sprite *s);
+int handler_ghost_init(struct lily_world *w, struct sprite *s);
+int handler_ghost_frame(struct lily_world *w, struct sprite *s);
 
-// water uses the same frame handler as the simplest kind of sprite.
-int handler_water_init(struct sprite *s);
-int handler_water_hit(struct sprite *s);
+// the handler for things shot at the player by enemies, which are projectiles
+// (see projectile.h)
+int handler_shot_init(struct lily_world *w, struct sprite *s);
+int handler_shot_hit(struct lily_world *w, struct sprite *s);
 
 // the helper characters
-int handler_helper_init(struct sprite *s);
-int handler_helper_frame(struct sprite *s);
-int handler_helper_hit(struct sprite *s);
-int handler_helper_destroy(struct sprite *s);
+int handler_helper_init(struct lily_world *w, struct sprite *s);
+int handler_helper_frame(struct lily_world *w, struct sprite *s);
+int handler_helper_hit(struct lily_world *w, struct sprite *s);
 
-int handler_cat_helper_hit(struct sprite *s);
-int handler_ladder_helper_hit(struct sprite *s);
-int handler_ghost_helper_hit(struct sprite *s);
+int handler_cat_helper_hit(struct lily_world *w, struct sprite *s);
+int handler_ladder_helper_hit(struct lily_world *w, struct sprite *s);
+int handler_ghost_helper_hit(struct lily_world *w, struct sprite *s);
 
-int handler_helper_last_level_hit(struct sprite *s);
-int handler_cat_helper_last_level_hit(struct sprite *s);
-int handler_ladder_helper_last_level_hit(struct sprite *s);
-int handler_ghost_helper_last_level_hit(struct sprite *s);
+int handler_helper_last_level_hit(struct lily_world *w, struct sprite *s);
+int handler_cat_helper_last_level_hit(struct lily_world *w, struct sprite *s);
+int handler_ladder_helper_last_level_hit(struct lily_world *w,
+                                         struct sprite *s);
+int handler_ghost_helper_last_level_hit(struct lily_world *w, struct sprite *s);
 
 // the platform
-int handler_platform_init(struct sprite *s);
-int handler_platform_frame(struct sprite *s);
-int handler_platform_hit(struct sprite *s);
+int handler_platform_init(struct lily_world *w, struct sprite *s);
+int handler_platform_frame(struct lily_world *w, struct sprite *s);
+int handler_platform_hit(struct lily_world *w, struct sprite *s);
 
 // spring
-int handler_spring_init(struct sprite *s);
-int handler_spring_frame(struct sprite *s);
-int handler_spring_hit(struct sprite *s);
-int handler_spring_destroy(struct sprite *s);
+int handler_spring_init(struct lily_world *w, struct sprite *s);
+int handler_spring_frame(struct lily_world *w, struct sprite *s);
+int handler_spring_hit(struct lily_world *w, struct sprite *s);
 
 // skeleton
-int handler_skeleton_init(struct sprite *s);
-int handler_skeleton_frame(struct sprite *s);
+int handler_skeleton_init(struct lily_world *w, struct sprite *s);
+int handler_skeleton_frame(struct lily_world *w, struct sprite *s);
+
+// the inside of a wall, which can only be stood on from the top of the wall
+#define SOLID_INSIDE (SOLID_RIGHT | SOLID_BOTTOM | SOLID_LEFT)
+
+// SPRITE_TYPE_LIST lists every sprite type of the game, from which both
+// SPRITE_TYPES and the update loops of level_iterate are generated, so that a
+// new sprite type cannot be left without its loop. The tiles, whose handlers
+// do nothing, are TILE(id, solid, row, column, flags, frames, fps) entries:
+// their tile is on row `row` and column `column` of the sprite sheet, and
+// flags, frames and fps are their tile_flags, tile_frames and tile_fps. The
+// other types are TYPE(id, solid, row, column, bx, by, bw, bh, init, frame,
+// hit) entries, whose body is at bx, by with a width bw and height bh within
+// their tile (see sprite_type.c), and which have an update loop calling their
+// frame handler.
+#define SPRITE_TYPE_LIST(TYPE, TILE)                                           \
+  /* a transparent block of the sprite sheet */                                \
+  TILE(SPRITE_NONE, SOLID_NONE, 0, 10, TILE_NONE, 0, 0)                        \
+  /* the walls, their top and their inside */                                  \
+  TILE(SPRITE_WALL_TOP, SOLID_ALL, 4, 2, TILE_NONE, 0, 0)                      \
+  TILE(SPRITE_WALL, SOLID_INSIDE, 5, 2, TILE_NONE, 0, 0)                       \
+  TILE(SPRITE_RUST_WALL_TOP, SOLID_ALL, 4, 3, TILE_NONE, 0, 0)                 \
+  TILE(SPRITE_RUST_WALL, SOLID_INSIDE, 5, 3, TILE_NONE, 0, 0)                  \
+  TILE(SPRITE_RED_WALL_TOP, SOLID_ALL, 4, 5, TILE_NONE, 0, 0)                  \
+  TILE(SPRITE_RED_WALL, SOLID_INSIDE, 5, 5, TILE_NONE, 0, 0)                   \
+  TILE(SPRITE_GROUND_TOP, SOLID_ALL, 6, 1, TILE_NONE, 0, 0)                    \
+  TILE(SPRITE_GROUND, SOLID_INSIDE, 7, 1, TILE_NONE, 0, 0)                     \
+  TILE(SPRITE_CAVE_TOP, SOLID_ALL, 6, 0, TILE_NONE, 0, 0)                      \
+  TILE(SPRITE_CAVE, SOLID_INSIDE, 7, 0, TILE_NONE, 0, 0)                       \
+  TILE(SPRITE_GRASS, SOLID_NONE, 40, 1, TILE_NONE, 0, 0)                       \
+  TILE(SPRITE_LADDER, SOLID_NONE, 12, 2, TILE_NONE, 0, 0)                      \
+  /* drowns the player, animated at 4 frames per second */                     \
+  TILE(SPRITE_WATER_TOP, SOLID_NONE, 54, 0, TILE_KILL, 4, 4)                   \
+  TILE(SPRITE_WATER, SOLID_NONE, 55, 0, TILE_NONE, 0, 0)                       \
+  /* typically leads to the next level */                                      \
+  TILE(SPRITE_DOOR, SOLID_NONE, 10, 0, TILE_NONE, 0, 0)                        \
+  TILE(SPRITE_LEFT_ARROW, SOLID_NONE, 51, 2, TILE_NONE, 0, 0)                  \
+  /* the tile of the player depends on their character (see player.index) */   \
+  TYPE(SPRITE_PLAYER, SOLID_ALL, 1, 38, 6, 0, 4, 16,                           \
+       handler_sprite_init, handler_sprite_frame, handler_sprite_hit)          \
+  TYPE(SPRITE_COIN, SOLID_ALL, 47, 29, 0, 0, 16, 16,                           \
+       handler_item_init, handler_item_frame, handler_item_hit)                \
+  TYPE(SPRITE_EXTRA_LIFE, SOLID_ALL, 55, 27, 0, 0, 16, 16,                     \
+       handler_item_init, handler_item_frame, handler_item_hit)                \
+  TYPE(SPRITE_SPIDER, SOLID_ALL, 11, 38, 0, 6, 15, 10,                         \
+       handler_spider_init, handler_spider_frame, handler_spider_hit)          \
+  TYPE(SPRITE_BAT, SOLID_ALL, 8, 26, 0, 3, 16, 10,                             \
+       handler_bat_init, handler_spider_frame, handler_spider_hit)             \
+  TYPE(SPRITE_SPRINTING_SPIDER, SOLID_ALL, 11, 32, 0, 6, 15, 10,               \
+       handler_sprinting_spider_init, handler_sprinting_spider_frame,          \
+       handler_spider_hit)                                                     \
+  TYPE(SPRITE_SKELETON, SOLID_ALL, 6, 26, 0, 6, 15, 10,                        \
+       handler_skeleton_init, handler_skeleton_frame, handler_spider_hit)      \
+  TYPE(SPRITE_GHOST, SOLID_ALL, 7, 26, 0, 6, 15, 10,                           \
+       handler_ghost_init, handler_ghost_frame, handler_spider_hit)            \
+  /* a projectile (see projectile.h) */                                        \
+  TYPE(SPRITE_SHOT, SOLID_ALL, 52, 0, 0, 4, 16, 7,                             \
+       handler_shot_init, handler_sprite_frame, handler_shot_hit)              \
+  /* the helper characters */                                                  \
+  TYPE(SPRITE_HELPER, SOLID_ALL, 56, 0, 0, 0, 16, 16,                          \
+       handler_helper_init, handler_helper_frame, handler_helper_hit)          \
+  TYPE(SPRITE_CAT_HELPER, SOLID_ALL, 56, 1, 0, 0, 16, 16,                      \
+       handler_helper_init, handler_helper_frame, handler_cat_helper_hit)      \
+  TYPE(SPRITE_LADDER_HELPER, SOLID_ALL, 56, 2, 0, 0, 16, 16,                   \
+       handler_helper_init, handler_helper_frame, handler_ladder_helper_hit)   \
+  TYPE(SPRITE_GHOST_HELPER, SOLID_ALL, 56, 3, 0, 0, 16, 16,                    \
+       handler_helper_init, handler_helper_frame, handler_ghost_helper_hit)    \
+  TYPE(SPRITE_PLATFORM, SOLID_NONE, 23, 3, 0, 0, 16, 16,                       \
+       handler_platform_init, handler_platform_frame, handler_platform_hit)    \
+  TYPE(SPRITE_SPRING, SOLID_NONE, 20, 2, 0, 8, 16, 8,                          \
+       handler_spring_init, handler_spring_frame, handler_spring_hit)          \
+  /* the helper characters of the last level */                                \
+  TYPE(SPRITE_HELPER_LAST_LEVEL, SOLID_ALL, 56, 0, 0, 0, 16, 16,               \
+       handler_helper_init, handler_helper_frame,                              \
+       handler_helper_last_level_hit)                                          \
+  TYPE(SPRITE_CAT_HELPER_LAST_LEVEL, SOLID_ALL, 56, 1, 0, 0, 16, 16,           \
+       handler_helper_init, handler_helper_frame,                              \
+       handler_cat_helper_last_level_hit)                                      \
+  TYPE(SPRITE_LADDER_HELPER_LAST_LEVEL, SOLID_ALL, 56, 2, 0, 0, 16, 16,        \
+       handler_helper_init, handler_helper_frame,                              \
+       handler_ladder_helper_last_level_hit)                                   \
+  TYPE(SPRITE_GHOST_HELPER_LAST_LEVEL, SOLID_ALL, 56, 3, 0, 0, 16, 16,         \
+       handler_helper_init, handler_helper_frame,                              \
+       handler_ghost_helper_last_level_hit)
 
 #endif // HANDLERS_H
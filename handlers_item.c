@@ -1,6 +1,8 @@
 #include "handlers.h"
 
+#include "event.h"
 #include "fps.h"
+#include "level.h"
 #include "player.h"
 #include "safe.h"
 #include "sound.h"
@@ -8,14 +10,14 @@
 
 static const Sint64 DISAPPEAR_DELAY = 150;
 
-int handler_item_init(struct sprite *s) {
-  assert_not_null(1, s);
+int handler_item_init(struct lily_world *w, struct sprite *s) {
+  assert_not_null(2, w, s);
   s->data.item.collected = false;
   return 0;
 }
 
-int handler_item_frame(struct sprite *s) {
-  assert_not_null(1, s);
+int handler_item_frame(struct lily_world *w, struct sprite *s) {
+  assert_not_null(2, w, s);
   bool collected = s->data.item.collected;
 
   if (!collected || s->removed) {
@@ -23,36 +25,30 @@ int handler_item_frame(struct sprite *s) {
   }
 
   // item was collected
-  const double dt = fps_frame_time();
   Sint64 *alpha = &s->animation.alpha;
-  *alpha -= (255 / (double)DISAPPEAR_DELAY) * dt;
+  *alpha -= 255 * (Sint64)w->dt / DISAPPEAR_DELAY;
 
   if (*alpha < 0) {
     *alpha = 0;
-    s->removed = true;
+    return event_emit(w, EVENT_DESPAWN, s);
   }
 
   return 0;
 }
 
-int handler_item_hit(struct sprite *s) {
-  bool *collected = &s->data.item.collected;
-  if ((*collected)) {
-    return 0;
-  }
-
-  *collected = true;
-
-  switch (s->type->id) {
+// reward rewards the player of the world w for collecting an item `id`.
+// Returns 0 on success, -1 on failure.
+static int reward(struct lily_world *w, const enum sprite_id id) {
+  switch (id) {
   case SPRITE_COIN:
-    g_game.player->coins++;
-    if (sound_play(SOUND_COIN, CHANNEL_SPRITE) != 0) {
+    w->player->coins++;
+    if (sound_play(w, SOUND_COIN, CHANNEL_SPRITE) != 0) {
       return -1;
     }
     break;
   case SPRITE_EXTRA_LIFE:
-    g_game.player->lives++;
-    if (sound_play(SOUND_EXTRA_LIFE, CHANNEL_SPRITE) != 0) {
+    w->player->lives++;
+    if (sound_play(w, SOUND_EXTRA_LIFE, CHANNEL_SPRITE) != 0) {
       return -1;
     }
     break;
@@ -63,3 +59,28 @@ int handler_item_hit(struct sprite *s) {
 
   return 0;
 }
+
+int handler_item_hit(struct lily_world *w, struct sprite *s) {
+  bool *collected = &s->data.item.collected;
+  if ((*collected)) {
+    return 0;
+  }
+
+  *collected = true;
+  return reward(w, s->type->id);
+}
+
+int handler_item_collect(struct lily_world *w, struct level *l,
+                         const enum sprite_id id, const size_t r,
+                         const size_t c) {
+  assert_not_null(2, w, l);
+
+  if (reward(w, id) != 0 || token_active_sprite(w, l, id, r, c) != 0) {
+    return -1;
+  }
+
+  // the sprite was appended to the active sprites, and starts fading out
+  struct array *a = l->active_sprites;
+  a->a[a->l - 1]->data.item.collected = true;
+  return 0;
+}
@@ -1,5 +1,6 @@
 #include "handlers.h"
 
+#include "fixed.h"
 #include "fps.h"
 #include "player.h"
 #include "safe.h"
@@ -9,25 +10,25 @@
 // the speed with which the platform moves
 #define SPEED 36
 
-int handler_platform_init(struct sprite *s) {
-  assert_not_null(1, s);
+int handler_platform_init(struct lily_world *w, struct sprite *s) {
+  assert_not_null(2, w, s);
   s->vx = SPEED;
   return 0;
 }
 
-int handler_platform_frame(struct sprite *s) {
-  assert_not_null(1, s);
+int handler_platform_frame(struct lily_world *w, struct sprite *s) {
+  assert_not_null(2, w, s);
 
   // process horizontal movement
-  enum collision c = util_move_x(s);
+  enum collision c = util_move_x(w, s);
   if (c != COLLISION_NONE) {
     s->vx = -s->vx;
   }
 
   return 0;
 }
-int handler_platform_hit(struct sprite *s) {
-  struct player *p = g_game.player;
+int handler_platform_hit(struct lily_world *w, struct sprite *s) {
+  struct player *p = w->player;
 
   assert_not_null(3, p, s, p->s);
 
@@ -35,7 +36,6 @@ int handler_platform_hit(struct sprite *s) {
   // licensed) project "sdl-platformer"
   // (https://github.com/artureganyan/sdl-platformer)
 
-  const double dt = fps_frame_time() / 1000.0;
   struct borders tmp, pa, sa;
   int i_tmp;
 
@@ -63,7 +63,7 @@ int handler_platform_hit(struct sprite *s) {
   if (pa.b > sa.t && pa.b < sa.b && collision_x) {
 
     if (p->s->vx == 0) {
-      p->s->x += s->vx * dt;
+      p->s->x += fixed_step(s->vx, w->dt);
     }
 
     p->s->y = sa.t - dh - p_body.h;
@@ -16,34 +16,56 @@ static const double WALK = 36;
 // pixels per second
 static const double SPRINT = 142;
 
-int handler_skeleton_init(struct sprite *s) {
-  assert_not_null(1, s);
+int handler_skeleton_init(struct lily_world *w, struct sprite *s) {
+  assert_not_null(2, w, s);
 
-  if (handler_spider_init(s) != 0) {
+  if (handler_spider_init(w, s) != 0) {
     return -1;
   }
 
   return 0;
 }
 
-int handler_skeleton_frame(struct sprite *s) {
-  struct player *p = g_game.player;
-  struct level *l = g_game.level;
+// face makes the skeleton s face the direction dir, walking
+static void face(struct sprite *s, const enum direction dir) {
+  s->data.enemy.dir = dir;
+  s->animation.flip = dir == DIR_LEFT ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE;
+  s->vx = dir == DIR_LEFT ? -WALK : WALK;
+}
+
+int handler_skeleton_frame(struct lily_world *w, struct sprite *s) {
+  struct player *p = w->player;
+  struct level *l = w->level;
   assert_not_null(4, l, p, s, p->s);
 
-  if (util_visible(s, p->s)) {
-    s->vx = s->vx < 0 ? -SPRINT : SPRINT;
-  } else {
-    s->vx = s->vx < 0 ? -WALK : WALK;
+  if (!s->data.enemy.alive) {
+    return handler_spider_frame(w, s);
   }
 
-  if (handler_spider_frame(s) != 0) {
-    return -1;
+  const bool left = s->data.enemy.dir == DIR_LEFT;
+  if (util_visible(w, s, p->s)) {
+    s->vx = left ? -SPRINT : SPRINT;
+    return handler_spider_frame(w, s);
   }
 
-  if (!s->data.enemy.alive) {
-    return 0;
+  // out of sight, the skeleton walks to the player along the flow field of the
+  // level, and waits where the path leaves its floor, e.g at a ladder
+  int r, c;
+  util_nearest(s, &r, &c);
+  switch (flow_field_dir(l->flow, r, c)) {
+  case FLOW_LEFT:
+    face(s, DIR_LEFT);
+    break;
+  case FLOW_RIGHT:
+    face(s, DIR_RIGHT);
+    break;
+  case FLOW_WAIT:
+    s->vx = 0;
+    break;
+  case FLOW_NONE:
+    s->vx = left ? -WALK : WALK;
+    break;
   }
 
-  return 0;
+  return handler_spider_frame(w, s);
 }
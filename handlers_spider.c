@@ -1,5 +1,6 @@
 #include "handlers.h"
 
+#include "event.h"
 #include "fps.h"
 #include "player.h"
 #include "safe.h"
@@ -34,46 +35,35 @@ static void right(struct sprite *s) {
   s->vx = WALK;
 }
 
-int handler_spider_init(struct sprite *s) {
-  assert_not_null(1, s);
+int handler_spider_init(struct lily_world *w, struct sprite *s) {
+  assert_not_null(2, w, s);
 
-  if (util_fair_coin_flip()) {
+  if (util_fair_coin_flip(w)) {
     left(s);
   } else {
     right(s);
   }
 
   s->data.enemy.alive = true;
-  struct fps_timer *t = fps_timer_create(REMOVE_DELAY);
-  if (t == NULL) {
-    return -1;
-  }
-
-  s->data.enemy.remove_timer = t;
+  fps_timer_init(&s->data.enemy.remove_timer, REMOVE_DELAY);
 
   sprite_animation_set_frame(s, 1, 2, ANIM_WALK);
   return 0;
 }
 
-int handler_spider_frame(struct sprite *s) {
-  assert_not_null(1, s);
+int handler_spider_frame(struct lily_world *w, struct sprite *s) {
+  assert_not_null(2, w, s);
 
   if (!s->data.enemy.alive) {
-    struct fps_timer *t = s->data.enemy.remove_timer;
+    struct fps_timer *t = &s->data.enemy.remove_timer;
 
-    fps_timer_iterate(t);
+    fps_timer_iterate(t, w->dt);
 
-    if (fps_timer_done(t)) {
-      s->removed = true;
-      fps_timer_destroy(&s->data.enemy.remove_timer);
-      t = NULL;
-    }
-
-    return 0;
+    return fps_timer_done(t) ? event_emit(w, EVENT_DESPAWN, s) : 0;
   }
 
   // process horizontal movement
-  enum collision c = util_move_x(s);
+  enum collision c = util_move_x(w, s);
 
   if (c & COLLISION_LEFT) {
     right(s);
@@ -86,8 +76,8 @@ int handler_spider_frame(struct sprite *s) {
   return 0;
 }
 
-int handler_spider_hit(struct sprite *s) {
-  struct player *p = g_game.player;
+int handler_spider_hit(struct lily_world *w, struct sprite *s) {
+  struct player *p = w->player;
   assert_not_null(3, p, p->s, s);
 
   bool *alive = &s->data.enemy.alive;
@@ -98,7 +88,7 @@ int handler_spider_hit(struct sprite *s) {
 
   if (p->air && p->s->y < s->y && p->s->vy > 0) {
     // play sound effect
-    sound_play(SOUND_HIT, CHANNEL_SPRITE);
+    sound_play(w, SOUND_HIT, CHANNEL_SPRITE);
 
     p->s->vy = -BOUNCE;
     *alive = false;
@@ -106,26 +96,38 @@ int handler_spider_hit(struct sprite *s) {
     return 0;
   }
 
-  player_kill(p);
+  return event_emit(w, EVENT_KILL, s);
+}
+
+int handler_sprinting_spider_init(struct lily_world *w, struct sprite *s) {
+  if (handler_spider_init(w, s) != 0) {
+    return -1;
+  }
+
+  // the spider draws from a generator of its own when it moves, seeded from
+  // the world's, so that its frame handler only changes its own sprite (see
+  // sprite_type.frame_handler)
+  const Uint64 high = util_rand(w);
+  s->data.enemy.rand = high << 32 | util_rand(w);
   return 0;
 }
 
-int handler_sprinting_spider_frame(struct sprite *s) {
-  if (handler_spider_frame(s) != 0) {
+int handler_sprinting_spider_frame(struct lily_world *w, struct sprite *s) {
+  if (handler_spider_frame(w, s) != 0) {
     return -1;
   }
 
-  if (rand() % 100 == 0) {
+  if (util_rand_state(&s->data.enemy.rand) % 100 == 0) {
     s->vx *= 2;
   }
 
   return 0;
 }
 
-int handler_bat_init(struct sprite *s) {
-  assert_not_null(1, s);
+int handler_bat_init(struct lily_world *w, struct sprite *s) {
+  assert_not_null(2, w, s);
 
-  if (handler_spider_init(s) != 0) {
+  if (handler_spider_init(w, s) != 0) {
     return -1;
   }
 
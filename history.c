@@ -0,0 +1,231 @@
+#include "history.h"
+
+#include "delta.h"
+#include "safe.h"
+#include "snapshot.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+// A frame is stored in the ring buffer as a record:
+// - the size of the payload (a Uint32)
+// - the payload: the size of the snapshot of the frame (a Uint32) followed by
+//   the encoded difference between that snapshot and the next one
+// - the size of the payload again, so records can be walked in both
+//   directions: the oldest ones are dropped from the front of the ring buffer
+//   and the newest ones are popped from its back.
+//
+// The difference is encoded with delta_encode, see delta.h.
+
+struct history {
+  Uint8 *ring;       // the ring buffer of records
+  size_t cap;        // the size of ring
+  size_t start;      // the offset of the oldest record in ring
+  size_t used;       // the number of bytes used in ring
+  size_t frames;     // the number of records in ring
+  size_t max_frames; // the maximum number of records
+
+  // curr is the snapshot of the frame recorded last, if any
+  Uint8 *curr;
+  size_t curr_len;
+  size_t curr_cap;
+  bool has_curr;
+
+  // next holds the snapshot of the frame being pushed
+  Uint8 *next;
+  size_t next_cap;
+
+  // delta holds the payload of the record being pushed or popped
+  Uint8 *delta;
+  size_t delta_cap;
+};
+
+// reserve makes sure the buffer *pbuf of capacity *pcap holds at least n
+// bytes. New bytes are zeroed. Returns 0 on success, -1 on failure.
+static int reserve(Uint8 **pbuf, size_t *pcap, const size_t n) {
+  if (n <= *pcap) {
+    return 0;
+  }
+
+  Uint8 *buf = realloc(*pbuf, n);
+  if (buf == NULL) {
+    LOG_ERROR("could not allocate history buffer");
+    return -1;
+  }
+
+  memset(buf + *pcap, 0, n - *pcap);
+  *pbuf = buf;
+  *pcap = n;
+  return 0;
+}
+
+// ring_write copies n bytes from src to the ring buffer at offset off
+static void ring_write(struct history *h, size_t off, const void *src,
+                       const size_t n) {
+  off %= h->cap;
+  const size_t first = SDL_min(n, h->cap - off);
+  memcpy(h->ring + off, src, first);
+  memcpy(h->ring, (const Uint8 *)src + first, n - first);
+}
+
+// ring_read copies n bytes from the ring buffer at offset off to dst
+static void ring_read(const struct history *h, size_t off, void *dst,
+                      const size_t n) {
+  off %= h->cap;
+  const size_t first = SDL_min(n, h->cap - off);
+  memcpy(dst, h->ring + off, first);
+  memcpy((Uint8 *)dst + first, h->ring, n - first);
+}
+
+// drop_oldest drops the oldest record of the ring buffer
+static void drop_oldest(struct history *h) {
+  Uint32 size;
+  ring_read(h, h->start, &size, sizeof(size));
+
+  const size_t n = size + 2 * sizeof(Uint32);
+  h->start = (h->start + n) % h->cap;
+  h->used -= n;
+  h->frames--;
+}
+
+struct history *history_create(const size_t budget, const size_t max_frames) {
+  assert(budget > 0);
+
+  struct history *h = calloc(1, sizeof(struct history));
+  if (h == NULL) {
+    LOG_ERROR("could not allocate history");
+    return NULL;
+  }
+
+  h->ring = malloc(budget);
+  if (h->ring == NULL) {
+    LOG_ERROR("could not allocate history");
+    free(h);
+    return NULL;
+  }
+
+  h->cap = budget;
+  h->max_frames = max_frames;
+  return h;
+}
+
+void history_destroy(struct history **ph) {
+  assert_not_null(2, ph, *ph);
+  struct history *h = *ph;
+
+  free(h->ring);
+  free(h->curr);
+  free(h->next);
+  free(h->delta);
+  free(h);
+  *ph = NULL;
+}
+
+int history_push(struct history *h, const struct lily_world *w) {
+  assert_not_null(2, h, w);
+
+  size_t n = snapshot_save(w, h->next, h->next_cap);
+  if (n > h->next_cap) {
+    if (reserve(&h->next, &h->next_cap, n) != 0) {
+      return -1;
+    }
+    snapshot_save(w, h->next, h->next_cap);
+  }
+
+  if (h->has_curr) {
+    // diff the two snapshots over the size of the larger one, the smaller one
+    // being padded with zeroes
+    const size_t len = SDL_max(n, h->curr_len);
+    if (reserve(&h->curr, &h->curr_cap, len) != 0 ||
+        reserve(&h->next, &h->next_cap, len) != 0 ||
+        reserve(&h->delta, &h->delta_cap, delta_bound(len)) != 0) {
+      return -1;
+    }
+    memset(h->curr + h->curr_len, 0, len - h->curr_len);
+    memset(h->next + n, 0, len - n);
+
+    const Uint32 prev_len = h->curr_len;
+    const Uint32 size =
+        sizeof(prev_len) + delta_encode(h->curr, h->next, len, h->delta);
+    const size_t total = size + 2 * sizeof(Uint32);
+
+    if (total > h->cap) {
+      // this frame alone does not fit, so nothing before it can be rewound to
+      history_clear(h);
+    } else {
+      while (h->frames > 0 &&
+             (h->used + total > h->cap || h->frames >= h->max_frames)) {
+        drop_oldest(h);
+      }
+
+      if (h->max_frames > 0) {
+        const size_t end = h->start + h->used;
+        ring_write(h, end, &size, sizeof(size));
+        ring_write(h, end + sizeof(size), &prev_len, sizeof(prev_len));
+        ring_write(h, end + 2 * sizeof(Uint32), h->delta,
+                   size - sizeof(prev_len));
+        ring_write(h, end + sizeof(size) + size, &size, sizeof(size));
+        h->used += total;
+        h->frames++;
+      }
+    }
+  }
+
+  // the new snapshot becomes the current one
+  Uint8 *tmp = h->curr;
+  const size_t tmp_cap = h->curr_cap;
+  h->curr = h->next;
+  h->curr_cap = h->next_cap;
+  h->curr_len = n;
+  h->next = tmp;
+  h->next_cap = tmp_cap;
+  h->has_curr = true;
+  return 0;
+}
+
+int history_pop(struct history *h, struct lily_world *w) {
+  assert_not_null(2, h, w);
+
+  if (h->frames == 0) {
+    return -1;
+  }
+
+  const size_t end = h->start + h->used;
+  Uint32 size, prev_len;
+  ring_read(h, end - sizeof(size), &size, sizeof(size));
+
+  const size_t payload = end - sizeof(size) - size;
+  ring_read(h, payload, &prev_len, sizeof(prev_len));
+
+  const size_t len = SDL_max(prev_len, h->curr_len);
+  if (reserve(&h->delta, &h->delta_cap, size) != 0 ||
+      reserve(&h->curr, &h->curr_cap, len) != 0) {
+    return -1;
+  }
+
+  ring_read(h, payload + sizeof(prev_len), h->delta, size - sizeof(prev_len));
+  memset(h->curr + h->curr_len, 0, len - h->curr_len);
+  if (delta_decode(h->delta, size - sizeof(prev_len), h->curr, len) != 0) {
+    LOG_ERROR("corrupted history");
+    return -1;
+  }
+
+  h->curr_len = prev_len;
+  h->used -= size + 2 * sizeof(Uint32);
+  h->frames--;
+
+  return snapshot_load(w, h->curr, h->curr_len);
+}
+
+size_t history_frames(const struct history *h) {
+  assert_not_null(1, h);
+  return h->frames;
+}
+
+void history_clear(struct history *h) {
+  assert_not_null(1, h);
+  h->start = 0;
+  h->used = 0;
+  h->frames = 0;
+  h->has_curr = false;
+}
@@ -0,0 +1,48 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include "base.h"
+
+#include <SDL2/SDL.h>
+
+// history records the recent states of a world, one per frame, so the world
+// can be rewound frame by frame (e.g while the player holds down the rewind
+// key). Only the latest state is kept as a full snapshot (see snapshot.h).
+// Every older frame is stored as the difference to the frame after it: the two
+// snapshots are XOR-ed, and the result, which is mostly zeroes as little
+// changes between frames, is run-length encoded. The differences are kept in a
+// ring buffer of a fixed size: once it is full, the oldest frames are dropped.
+
+// forward declaration, see state.h
+struct lily_world;
+
+// history is the recorded history of a world
+struct history;
+
+// history_create creates an empty history that keeps at most max_frames frames
+// that can be rewound, using at most `budget` bytes for them. On top of that,
+// the history holds a few buffers the size of a snapshot. Returns NULL on
+// failure.
+struct history *history_create(const size_t budget, const size_t max_frames);
+
+// history_destroy frees the memory of the history and sets *ph to NULL
+void history_destroy(struct history **ph);
+
+// history_push records the current state of the world w, which is the state
+// following the state recorded last. Returns 0 on success, -1 on failure.
+int history_push(struct history *h, const struct lily_world *w);
+
+// history_pop rewinds the world w by one frame: the state recorded last is
+// dropped, and w is restored to the state recorded before it. Returns 0 on
+// success, -1 on failure or if there is no frame to rewind to.
+int history_pop(struct history *h, struct lily_world *w);
+
+// history_frames returns the number of frames the world can be rewound by
+size_t history_frames(const struct history *h);
+
+// history_clear drops every recorded frame. This must be done whenever the
+// world loads another level, as the frames of different levels cannot be
+// mixed.
+void history_clear(struct history *h);
+
+#endif // HISTORY_H
@@ -0,0 +1,117 @@
+#include "history.h"
+
+#include "lily.h"
+#include "snapshot.h"
+#include "test.h"
+#include <string.h>
+
+static const struct token_entry TOKENS[] = {
+    {'=', SPRITE_WALL_TOP, token_passive_sprite},
+    {'*', SPRITE_WALL, token_passive_sprite},
+    {'s', SPRITE_SPIDER, token_active_sprite},
+    {'G', SPRITE_GHOST, token_active_sprite},
+    {'P', SPRITE_PLAYER, token_player},
+    {' ', SPRITE_NONE, NULL}};
+
+static const size_t TOKEN_SIZE = 6;
+
+static const char LEVEL[] = " s   P     s    G   \n"
+                            "====================\n"
+                            "********************";
+
+enum { FRAMES = 120, BUFFER_SIZE = 1 << 14 };
+
+// snapshots[i] is the snapshot of the world after frame i
+static Uint8 snapshots[FRAMES][BUFFER_SIZE];
+static size_t sizes[FRAMES];
+
+// play plays FRAMES frames, recording each of them in h and in snapshots
+static void play(struct lily_world *w, struct history *h) {
+  register size_t i;
+  for (i = 0; i < FRAMES; i++) {
+    const Uint32 in = (i / 10) % 2 == 0 ? INPUT_RIGHT : INPUT_LEFT | INPUT_JUMP;
+    assert(lily_world_step(w, in, FRAME_TIME) == 0);
+    assert(history_push(h, w) == 0);
+
+    sizes[i] = snapshot_save(w, snapshots[i], BUFFER_SIZE);
+    assert(sizes[i] <= BUFFER_SIZE);
+  }
+}
+
+// same returns true if the world w is in the state of snapshots[i]
+static bool same(const struct lily_world *w, const size_t i) {
+  static Uint8 buf[BUFFER_SIZE];
+  return snapshot_save(w, buf, BUFFER_SIZE) == sizes[i] &&
+         memcmp(buf, snapshots[i], sizes[i]) == 0;
+}
+
+// every frame can be rewound to, in reverse order
+static void test_rewind(void) {
+  struct lily_world *w = test_world(LEVEL, TOKENS, TOKEN_SIZE);
+  struct history *h = history_create(1 << 20, FRAMES);
+  assert(h != NULL);
+
+  play(w, h);
+  assert(history_frames(h) == FRAMES - 1);
+
+  register size_t i;
+  for (i = FRAMES - 1; i > 0; i--) {
+    assert(history_pop(h, w) == 0);
+    assert(same(w, i - 1));
+  }
+
+  assert(history_frames(h) == 0);
+  assert(history_pop(h, w) != 0);
+
+  // the world can be played and recorded again from there
+  assert(lily_world_step(w, INPUT_NONE, FRAME_TIME) == 0);
+  assert(history_push(h, w) == 0);
+  assert(history_frames(h) == 1);
+  assert(history_pop(h, w) == 0);
+  assert(same(w, 0));
+
+  history_destroy(&h);
+  assert(h == NULL);
+  lily_world_destroy(&w);
+}
+
+// the oldest frames are dropped to stay within the limits of the history
+static void test_limits(void) {
+  struct lily_world *w = test_world(LEVEL, TOKENS, TOKEN_SIZE);
+
+  // frame limit
+  struct history *h = history_create(1 << 20, 10);
+  play(w, h);
+  assert(history_frames(h) == 10);
+
+  register size_t i;
+  for (i = 0; i < 10; i++) {
+    assert(history_pop(h, w) == 0);
+    assert(same(w, FRAMES - 2 - i));
+  }
+  assert(history_pop(h, w) != 0);
+  history_destroy(&h);
+
+  // memory budget: the difference between two frames is much smaller than a
+  // snapshot, so more frames than would fit as snapshots are kept
+  const size_t budget = 4 * sizes[0];
+  h = history_create(budget, FRAMES);
+  play(w, h);
+  const size_t frames = history_frames(h);
+  assert(frames > 4);
+  assert(frames < FRAMES - 1);
+
+  for (i = 0; i < frames; i++) {
+    assert(history_pop(h, w) == 0);
+    assert(same(w, FRAMES - 2 - i));
+  }
+  history_destroy(&h);
+
+  lily_world_destroy(&w);
+}
+
+int main(void) {
+  RUN_TEST(test_rewind);
+  RUN_TEST(test_limits);
+  return 0;
+}
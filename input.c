@@ -0,0 +1,24 @@
+#include "input.h"
+
+#include "safe.h"
+
+// _keymap maps every input_key (by bit position) to its keyboard scancode
+static const SDL_Scancode _keymap[INPUT_KEY_COUNT] = {
+    SDL_SCANCODE_LEFT,  SDL_SCANCODE_RIGHT, SDL_SCANCODE_UP,
+    SDL_SCANCODE_DOWN,  SDL_SCANCODE_Z,     SDL_SCANCODE_X,
+    SDL_SCANCODE_SPACE, SDL_SCANCODE_C,     SDL_SCANCODE_Q};
+
+Uint32 input_from_keyboard(const Uint8 *keys) {
+  assert_not_null(1, keys);
+
+  Uint32 input = INPUT_NONE;
+
+  register size_t i;
+  for (i = 0; i < INPUT_KEY_COUNT; i++) {
+    if (keys[_keymap[i]]) {
+      input |= (1u << i);
+    }
+  }
+
+  return input;
+}
@@ -0,0 +1,33 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <SDL2/SDL.h>
+
+// input contains the (platform independent) player inputs used by the game
+// logic. The inputs for one frame are stored as a bitmask of input_key values,
+// which keeps them small enough to record, send over the network or generate in
+// bulk, e.g when running the game without a keyboard.
+
+// input_key contains every input the game logic responds to. The comments
+// show the key each input is mapped to by input_from_keyboard.
+enum input_key {
+  INPUT_NONE = 0,
+  INPUT_LEFT = (1 << 0),       // LEFT arrow: walk left
+  INPUT_RIGHT = (1 << 1),      // RIGHT arrow: walk right
+  INPUT_UP = (1 << 2),         // UP arrow: climb up a ladder
+  INPUT_DOWN = (1 << 3),       // DOWN arrow: climb down a ladder
+  INPUT_JUMP = (1 << 4),       // Z: jump
+  INPUT_SHORT_JUMP = (1 << 5), // X: short jump
+  INPUT_SPRINT = (1 << 6),     // SPACE: sprint
+  INPUT_INTERACT = (1 << 7),   // C: interact, dismiss messages
+  INPUT_CYCLE = (1 << 8),      // Q: toggle the player character
+  // INPUT_KEY_COUNT should always be the final element. It is the number of
+  // input keys, and not a valid input key.
+  INPUT_KEY_COUNT = 9
+};
+
+// input_from_keyboard maps the keyboard state `keys` (as returned by
+// SDL_GetKeyboardState) to a bitmask of input_key values.
+Uint32 input_from_keyboard(const Uint8 *keys);
+
+#endif // INPUT_H
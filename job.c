@@ -0,0 +1,217 @@
+#include "job.h"
+
+#include "safe.h"
+#include <stdbool.h>
+
+// range is the range of jobs of a thread, in a batch. Jobs are taken from it
+// by incrementing next, by the thread or by a thread stealing them. It is
+// padded to a cache line, so that threads taking jobs from their own range do
+// not slow each other down.
+struct range {
+  SDL_atomic_t next;
+  size_t end;
+  Uint8 pad[64 - sizeof(SDL_atomic_t) - sizeof(size_t)];
+};
+
+// worker is a thread of the pool, other than the thread running the batches
+struct worker {
+  struct job_pool *j;
+  SDL_Thread *thread;
+  size_t index; // the number of the thread in the pool
+};
+
+struct job_pool {
+  size_t threads;
+  // workers contains threads - 1 workers, for the threads 1 and up
+  struct worker *workers;
+  // ranges contains the range of every thread in the current batch
+  struct range *ranges;
+
+  // the batch currently being run, set by job_pool_run
+  job_func f;
+  void *data;
+  // failed is set to a non-zero value if a job of the batch failed
+  SDL_atomic_t failed;
+
+  // lock guards generation, pending and quit
+  SDL_mutex *lock;
+  // start is signalled when a new batch is ready (generation was incremented)
+  // or when the workers must quit
+  SDL_cond *start;
+  // done is signalled when the last worker finishes its part of a batch
+  SDL_cond *done;
+  Uint64 generation; // the number of batches started
+  size_t pending;    // the number of workers still running the batch
+  bool quit;
+};
+
+// take takes the next job of the range r. Returns true if there was one, and
+// populates i with it.
+static bool take(struct range *r, size_t *i) {
+  if ((size_t)SDL_AtomicGet(&r->next) >= r->end) {
+    return false;
+  }
+
+  *i = (size_t)SDL_AtomicAdd(&r->next, 1);
+  return *i < r->end;
+}
+
+// run_jobs runs the jobs of the range of the thread t, then the jobs it steals
+// from the other threads, until there are none left or a job failed
+static void run_jobs(struct job_pool *j, const size_t t) {
+  register size_t k;
+  size_t i;
+  for (k = 0; k < j->threads; k++) {
+    struct range *r = &j->ranges[(t + k) % j->threads];
+    while (!SDL_AtomicGet(&j->failed) && take(r, &i)) {
+      if (j->f(j->data, t, i) != 0) {
+        SDL_AtomicSet(&j->failed, 1);
+      }
+    }
+  }
+}
+
+// worker_run is the main function of a worker thread. It waits for a batch,
+// runs jobs, and reports back, until the pool is destroyed.
+static int worker_run(void *data) {
+  struct worker *k = data;
+  struct job_pool *j = k->j;
+  Uint64 seen = 0;
+
+  for (;;) {
+    SDL_LockMutex(j->lock);
+    while (j->generation == seen && !j->quit) {
+      SDL_CondWait(j->start, j->lock);
+    }
+
+    if (j->quit) {
+      SDL_UnlockMutex(j->lock);
+      return 0;
+    }
+
+    seen = j->generation;
+    SDL_UnlockMutex(j->lock);
+
+    run_jobs(j, k->index);
+
+    SDL_LockMutex(j->lock);
+    if (--j->pending == 0) {
+      SDL_CondSignal(j->done);
+    }
+    SDL_UnlockMutex(j->lock);
+  }
+}
+
+// pool_stop makes every started worker quit and waits for them
+static void pool_stop(struct job_pool *j, const size_t started) {
+  SDL_LockMutex(j->lock);
+  j->quit = true;
+  SDL_CondBroadcast(j->start);
+  SDL_UnlockMutex(j->lock);
+
+  register size_t i;
+  for (i = 0; i < started; i++) {
+    SDL_WaitThread(j->workers[i].thread, NULL);
+  }
+}
+
+// free_pool frees the memory of the pool, whose workers must not be running
+static void free_pool(struct job_pool *j) {
+  if (j->done != NULL) {
+    SDL_DestroyCond(j->done);
+  }
+  if (j->start != NULL) {
+    SDL_DestroyCond(j->start);
+  }
+  if (j->lock != NULL) {
+    SDL_DestroyMutex(j->lock);
+  }
+
+  free(j->ranges);
+  free(j->workers);
+  free(j);
+}
+
+struct job_pool *job_pool_create(const size_t threads) {
+  struct job_pool *j = calloc(1, sizeof(struct job_pool));
+  if (j == NULL) {
+    LOG_ERROR("could not allocate job pool");
+    return NULL;
+  }
+
+  const int cpus = SDL_GetCPUCount();
+  j->threads = threads != 0 ? threads : (size_t)SDL_max(cpus, 1);
+  j->ranges = calloc(j->threads, sizeof(struct range));
+  j->workers = calloc(j->threads, sizeof(struct worker));
+  j->lock = SDL_CreateMutex();
+  j->start = SDL_CreateCond();
+  j->done = SDL_CreateCond();
+  if (j->ranges == NULL || j->workers == NULL || j->lock == NULL ||
+      j->start == NULL || j->done == NULL) {
+    LOG_ERROR("could not create the job pool: %s", SDL_GetError());
+    free_pool(j);
+    return NULL;
+  }
+
+  register size_t i;
+  for (i = 0; i < j->threads - 1; i++) {
+    struct worker *k = &j->workers[i];
+    k->j = j;
+    k->index = i + 1;
+    k->thread = SDL_CreateThread(worker_run, "lily_job", k);
+    if (k->thread == NULL) {
+      LOG_ERROR("could not create thread: %s", SDL_GetError());
+      pool_stop(j, i);
+      free_pool(j);
+      return NULL;
+    }
+  }
+
+  return j;
+}
+
+void job_pool_destroy(struct job_pool **pj) {
+  assert_not_null(2, pj, *pj);
+  struct job_pool *j = *pj;
+
+  pool_stop(j, j->threads - 1);
+  free_pool(j);
+  *pj = NULL;
+}
+
+size_t job_pool_threads(const struct job_pool *j) {
+  assert_not_null(1, j);
+  return j->threads;
+}
+
+int job_pool_run(struct job_pool *j, const size_t count, const job_func f,
+                 void *data) {
+  assert_not_null(2, j, f);
+  assert(count <= SDL_MAX_SINT32);
+
+  j->f = f;
+  j->data = data;
+  SDL_AtomicSet(&j->failed, 0);
+
+  register size_t t;
+  for (t = 0; t < j->threads; t++) {
+    SDL_AtomicSet(&j->ranges[t].next, (int)(count * t / j->threads));
+    j->ranges[t].end = count * (t + 1) / j->threads;
+  }
+
+  SDL_LockMutex(j->lock);
+  j->generation++;
+  j->pending = j->threads - 1;
+  SDL_CondBroadcast(j->start);
+  SDL_UnlockMutex(j->lock);
+
+  run_jobs(j, 0);
+
+  SDL_LockMutex(j->lock);
+  while (j->pending != 0) {
+    SDL_CondWait(j->done, j->lock);
+  }
+  SDL_UnlockMutex(j->lock);
+
+  return SDL_AtomicGet(&j->failed) ? -1 : 0;
+}
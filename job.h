@@ -0,0 +1,45 @@
+#ifndef JOB_H
+#define JOB_H
+
+#include "base.h"
+
+#include <SDL2/SDL.h>
+
+// job runs the jobs of a batch on a pool of threads. A batch is `count` jobs,
+// numbered from 0, which may run in any order and on any thread of the pool,
+// so that every job must only write to memory that no other job of the batch
+// reads or writes. The thread calling job_pool_run runs jobs as well, and it
+// returns once every job of the batch ran.
+//
+// The jobs of a batch are split into a range of consecutive jobs per thread.
+// Each thread runs the jobs of its range in order, then steals the next job of
+// the range of another thread until there are none left, so a thread whose
+// jobs were slow does not hold back the whole batch.
+
+// job_func runs the job i of a batch on the thread `thread` of the pool, with
+// the data given to job_pool_run. Returns 0 on success, -1 on failure.
+typedef int (*job_func)(void *data, const size_t thread, const size_t i);
+
+// job_pool is a pool of threads running batches of jobs
+struct job_pool;
+
+// job_pool_create creates a pool of `threads` threads, including the thread
+// running the batches, or one thread per CPU if threads is 0. Returns NULL on
+// failure.
+struct job_pool *job_pool_create(const size_t threads);
+
+// job_pool_destroy stops the threads of the pool, frees its memory, and sets
+// *pj to NULL
+void job_pool_destroy(struct job_pool **pj);
+
+// job_pool_threads returns the number of threads of the pool j, which number
+// them from 0 to job_pool_threads(j) - 1. The thread running the batches is 0.
+size_t job_pool_threads(const struct job_pool *j);
+
+// job_pool_run runs the `count` jobs of a batch with the function f and the
+// data `data` on the pool j. Returns 0 on success, -1 if a job failed, in which
+// case the jobs that were not started yet are not run.
+int job_pool_run(struct job_pool *j, const size_t count, const job_func f,
+                 void *data);
+
+#endif // JOB_H
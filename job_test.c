@@ -0,0 +1,125 @@
+#include "job.h"
+
+#include "test.h"
+
+enum {
+  THREADS = 4,
+  JOBS = 100,
+  // STALL is the longest a job waits for the others, in milliseconds
+  STALL = 10000,
+};
+
+// batch records the jobs of a batch that ran
+struct batch {
+  int runs[JOBS];
+  size_t threads[JOBS];
+  SDL_atomic_t done;
+  size_t fail; // the job that fails, or JOBS if none does
+};
+
+static int count(void *data, const size_t thread, const size_t i) {
+  struct batch *b = data;
+  b->runs[i]++;
+  b->threads[i] = thread;
+  SDL_AtomicAdd(&b->done, 1);
+  return i == b->fail ? -1 : 0;
+}
+
+// stall is like count, but the job 0 only returns once every other job ran
+static int stall(void *data, const size_t thread, const size_t i) {
+  struct batch *b = data;
+  register Uint32 t;
+  for (t = 0; i == 0 && t < STALL; t++) {
+    if (SDL_AtomicGet(&b->done) == JOBS - 1) {
+      break;
+    }
+    SDL_Delay(1);
+  }
+
+  return count(data, thread, i);
+}
+
+// every job of a batch runs once, whatever the number of jobs
+static void test_run(void) {
+  struct job_pool *j = job_pool_create(THREADS);
+  assert(j != NULL);
+  assert(job_pool_threads(j) == THREADS);
+
+  static const size_t COUNTS[] = {0, 1, THREADS - 1, JOBS};
+  register size_t i, k;
+  for (k = 0; k < sizeof(COUNTS) / sizeof(COUNTS[0]); k++) {
+    struct batch b = {.fail = JOBS};
+    assert(job_pool_run(j, COUNTS[k], count, &b) == 0);
+    for (i = 0; i < JOBS; i++) {
+      assert(b.runs[i] == (i < COUNTS[k]));
+    }
+  }
+
+  job_pool_destroy(&j);
+  assert(j == NULL);
+}
+
+// the jobs of a thread held back by a slow job are stolen by the other threads
+static void test_steal(void) {
+  struct job_pool *j = job_pool_create(THREADS);
+  assert(j != NULL);
+
+  struct batch b = {.fail = JOBS};
+  assert(job_pool_run(j, JOBS, stall, &b) == 0);
+  assert(SDL_AtomicGet(&b.done) == JOBS);
+
+  // the jobs 1 and up of the range of the thread running job 0 were all run
+  // while it was waiting, so by other threads
+  register size_t i;
+  for (i = 1; i < JOBS / THREADS; i++) {
+    assert(b.runs[i] == 1);
+    if (b.threads[0] == 0) {
+      assert(b.threads[i] != 0);
+    }
+  }
+
+  job_pool_destroy(&j);
+}
+
+// a batch with a failed job fails, and the pool runs the next batches
+static void test_fail(void) {
+  struct job_pool *j = job_pool_create(THREADS);
+  assert(j != NULL);
+
+  struct batch b = {.fail = JOBS / 2};
+  assert(job_pool_run(j, JOBS, count, &b) == -1);
+  assert(b.runs[JOBS / 2] == 1);
+
+  struct batch c = {.fail = JOBS};
+  assert(job_pool_run(j, JOBS, count, &c) == 0);
+  assert(SDL_AtomicGet(&c.done) == JOBS);
+  job_pool_destroy(&j);
+}
+
+// a pool of a single thread runs the jobs in order on the calling thread
+static void test_serial(void) {
+  struct job_pool *j = job_pool_create(1);
+  assert(j != NULL);
+
+  struct batch b = {.fail = JOBS};
+  assert(job_pool_run(j, JOBS, count, &b) == 0);
+  register size_t i;
+  for (i = 0; i < JOBS; i++) {
+    assert(b.runs[i] == 1 && b.threads[i] == 0);
+  }
+
+  job_pool_destroy(&j);
+
+  j = job_pool_create(0);
+  assert(j != NULL);
+  assert(job_pool_threads(j) == (size_t)SDL_max(SDL_GetCPUCount(), 1));
+  job_pool_destroy(&j);
+}
+
+int main(void) {
+  RUN_TEST(test_run);
+  RUN_TEST(test_steal);
+  RUN_TEST(test_fail);
+  RUN_TEST(test_serial);
+  return 0;
+}
@@ -1,8 +1,9 @@
 #include "level.h"
 
+#include "handlers.h"
 #include "player.h"
-#include "render.h"
 #include "safe.h"
+#include "sprite_def.h"
 #include "state.h"
 #include "util.h"
 #include <assert.h>
@@ -10,170 +11,371 @@
 #include <stddef.h>
 #include <string.h>
 
-int level_iterate(struct level *l) {
-  assert_not_null(2, l, g_game.player);
+// collect emits an event to collect the items of the level l of the world w on
+// the tiles that the body of the sprite s overlaps. Returns 0 on success, -1
+// on failure.
+static int collect(struct lily_world *w, struct level *l,
+                   const struct sprite *s) {
+  const size_t cols = COLUMN_COUNT * l->w;
+  int r0, c0, r1, c1;
+  util_tiles(w, s, &r0, &c0, &r1, &c1);
+
+  register int r, c;
+  for (r = r0; r <= r1; r++) {
+    for (c = c0; c <= c1; c++) {
+      const enum sprite_id id = level_item(l, r * cols + c);
+      if (id != SPRITE_NONE &&
+          event_emit_tile(w, EVENT_COLLECT, id, r, c, 0) != 0) {
+        return -1;
+      }
+    }
+  }
+
+  return 0;
+}
+
+// collide emits a hit event if the sprite s collides with the player of the
+// world w, which will do whatever it is supposed to do upon collision once
+// every sprite was processed. Returns 0 on success, -1 on failure.
+static int collide(struct lily_world *w, struct sprite *s) {
+  if (util_collide(s, w->player->s) && event_emit(w, EVENT_HIT, s) != 0) {
+    return -1;
+  }
+
+  return 0;
+}
+
+// sprite_run is the update loop of the n sprites of a same type from the
+// sprite a[0], skipping the removed ones. Returns 0 on success, -1 on failure.
+typedef int (*sprite_run)(struct lily_world *w, struct sprite **a,
+                          const size_t n);
+
+// RUN defines run_ID, the update loop of the sprites of type id, which calls
+// their frame handler directly. There is one for every TYPE entry of
+// SPRITE_TYPE_LIST.
+#define RUN(id, solid, row, column, bx, by, bw, bh, init, frame_handler, hit)  \
+  static int run_##id(struct lily_world *w, struct sprite **a,                 \
+                      const size_t n) {                                        \
+    register size_t i;                                                         \
+    for (i = 0; i < n; i++) {                                                  \
+      if (a[i]->removed) {                                                     \
+        continue;                                                              \
+      }                                                                        \
+                                                                               \
+      if (frame_handler(w, a[i]) != 0) {                                       \
+        LOG_ERROR("failed to handle [frame handler] sprite with id: %d", id);  \
+        return -1;                                                             \
+      }                                                                        \
+                                                                               \
+      if (collide(w, a[i]) != 0) {                                             \
+        return -1;                                                             \
+      }                                                                        \
+    }                                                                          \
+                                                                               \
+    return 0;                                                                  \
+  }
 
+// NO_RUN skips the tiles, which have no loop of their own (see run_collide)
+#define NO_RUN(...)
+SPRITE_TYPE_LIST(RUN, NO_RUN)
+#undef RUN
+
+// run_collide is the update loop of the tiles, whose frame handler does
+// nothing, and of the types used for testing
+static int run_collide(struct lily_world *w, struct sprite **a,
+                       const size_t n) {
   register size_t i;
-  struct array *s_arr = l->active_sprites;
-  for (i = 0; i < s_arr->l; i++) {
-    struct sprite *s = s_arr->a[i];
-    struct sprite_type *t = s->type;
+  for (i = 0; i < n; i++) {
+    if (!a[i]->removed && collide(w, a[i]) != 0) {
+      return -1;
+    }
+  }
 
-    // skip the player as well as active sprites that are removed
-    if (t->id == SPRITE_PLAYER || s->removed) {
+  return 0;
+}
+
+// run_custom is the update loop of the sprites of the custom sprite types,
+// which calls their frame handler, sprite_def_frame, directly
+static int run_custom(struct lily_world *w, struct sprite **a,
+                      const size_t n) {
+  register size_t i;
+  for (i = 0; i < n; i++) {
+    if (a[i]->removed) {
       continue;
     }
 
-    if (t->frame_handler(s) != 0) {
-      LOG_ERROR("failed to handle [frame handler] sprite with id: %d",
-                s->type->id);
+    if (sprite_def_frame(w, a[i]) != 0 || collide(w, a[i]) != 0) {
       return -1;
     }
+  }
 
-    // if the active sprite collides with the player, do whatever the active
-    // sprite is supposed to do upon collision
-    if (util_collide(s, g_game.player->s)) {
-      if (t->hit_handler(s) != 0) {
-        LOG_ERROR("failed to handle [hit handler] sprite with id: %d",
-                  s->type->id);
-        return -1;
-      }
+  return 0;
+}
+
+// RUNS has the update loop of every sprite type, see SPRITE_TYPE_LIST
+#define RUN(id, ...) [id] = run_##id,
+static const sprite_run RUNS[SPRITE_TYPE_COUNT] = {
+    SPRITE_TYPE_LIST(RUN, NO_RUN)};
+#undef RUN
+#undef NO_RUN
+
+// run_range updates the n active sprites from a[0]. The active sprites are
+// kept in one bucket per type (see array.h), so each run of sprites of a same
+// type is updated by the loop of its type. The sprites appended since the array
+// was last cleaned may be in runs of their own. Returns 0 on success, -1 on
+// failure.
+static int run_range(struct lily_world *w, struct sprite **a, const size_t n) {
+  register size_t i, j;
+  for (i = 0; i < n; i = j) {
+    const enum sprite_id id = a[i]->type->id;
+    j = i + 1;
+    while (j < n && a[j]->type->id == id) {
+      j++;
+    }
+
+    // skip the player
+    if (id == SPRITE_PLAYER) {
+      continue;
+    }
+
+    const sprite_run run = RUNS[id] != NULL     ? RUNS[id]
+                           : id >= SPRITE_CUSTOM ? run_custom
+                                                 : run_collide;
+    if (run(w, &a[i], j - i) != 0) {
+      return -1;
     }
   }
 
-  // clean the sprites in the level that were removed
-  array_clean(s_arr);
+  return 0;
+}
+
+int level_iterate(struct lily_world *w, struct level *l) {
+  assert_not_null(3, w, l, w->player);
+
+  // the flow field is only read while the sprites are updated
+  flow_field_update(w, l->flow);
+
+  struct array *s_arr = l->active_sprites;
+  if (run_range(w, s_arr->a, s_arr->l) != 0) {
+    return -1;
+  }
+
+  if (projectile_iterate(w, l->projectiles) != 0) {
+    return -1;
+  }
+
+  // the tiles that kill on touch, like water, are looked up in the tile grid
+  // instead of being active sprites
+  struct player *p = w->player;
+  if (p->s != NULL && util_touch(w, p->s, TILE_KILL) &&
+      event_emit(w, EVENT_KILL, NULL) != 0) {
+    return -1;
+  }
+
+  // so are the items: only the few tiles the player touches are looked up,
+  // however many items the level has
+  if (p->s != NULL && collect(w, l, p->s) != 0) {
+    return -1;
+  }
+
+  if (event_resolve(w) != 0) {
+    return -1;
+  }
+
+  // clean the projectiles and the sprites in the level that were removed
+  projectile_clean(l->projectiles);
+  array_clean(w, s_arr);
 
   return 0;
 }
 
-// level_new initializes a new level or returns NULL on failure. The user is
-// responsible for deallocating the level using level_free. They are to be
-// handled externally by the functions of the world this level is in.
-static struct level *level_new(const size_t w, const size_t h) {
+void level_animate(struct level *l, const Uint64 dt) {
+  assert_not_null(1, l);
+
+  register size_t i;
+  struct array *s_arr = l->active_sprites;
+  for (i = 0; i < s_arr->l; i++) {
+    struct sprite *s = s_arr->a[i];
+
+    // removed sprites are neither animated nor rendered
+    if (!s->removed) {
+      sprite_animate(s, dt);
+    }
+  }
+
+  projectile_animate(l->projectiles, dt);
+}
+
+enum sprite_id level_item(const struct level *l, const size_t i) {
+  assert_not_null(1, l);
+  if (l->collected[i / 8] & (1 << (i % 8))) {
+    return SPRITE_NONE;
+  }
+
+  return (enum sprite_id)l->items[i];
+}
+
+size_t level_collected_size(const struct level *l) {
+  assert_not_null(1, l);
+  return (SPRITE_COUNT * l->w * l->h + 7) / 8;
+}
+
+// level_new initializes a new, empty level sharing the tile and item grids of
+// template t, or returns NULL on failure. The user is responsible for
+// deallocating the level using level_free. They are to be handled externally
+// by the functions of the world this level is in.
+static struct level *level_new(struct level_template *t) {
   struct level *l = (struct level *)malloc(sizeof(struct level));
   if (l == NULL) {
     // errno = ENOMEM
-    goto error_out;
+    return NULL;
   }
 
   l->player_found = false;
+  l->w = t->w;
+  l->h = t->h;
 
-  l->active_sprites = array_new();
-  if (l->active_sprites == NULL) {
-    goto error_post_l;
+  l->collected = calloc(level_collected_size(l), sizeof(Uint8));
+  if (l->collected == NULL) {
+    free(l);
+    return NULL;
   }
 
-  l->w = w;
-  l->h = h;
-
-  size_t passive_arr_len;
-  if (SDL_size_mul_overflow(SPRITE_COUNT, w, &passive_arr_len) != 0) {
-    errno = EOVERFLOW;
-    goto error_post_active_sprites;
+  l->projectiles = projectile_pool_create(PROJECTILE_POOL_SIZE);
+  if (l->projectiles == NULL) {
+    free(l->collected);
+    free(l);
+    return NULL;
   }
 
-  if (SDL_size_mul_overflow(passive_arr_len, h, &passive_arr_len) != 0) {
-    errno = EOVERFLOW;
-    goto error_post_active_sprites;
+  l->events = event_queue_create();
+  if (l->events == NULL) {
+    projectile_pool_destroy(&l->projectiles);
+    free(l->collected);
+    free(l);
+    return NULL;
   }
 
-  size_t passive_arr_size;
-  if (SDL_size_mul_overflow(passive_arr_len, sizeof(struct sprite_type *),
-                            &passive_arr_size) != 0) {
-    errno = EOVERFLOW;
-    goto error_post_active_sprites;
+  l->active_sprites = array_new();
+  if (l->active_sprites == NULL) {
+    event_queue_destroy(&l->events);
+    projectile_pool_destroy(&l->projectiles);
+    free(l->collected);
+    free(l);
+    return NULL;
   }
 
-  l->passive_sprites = malloc(passive_arr_size);
-  if (l->passive_sprites == NULL) {
-    // errno = ERRNOMEM
-    goto error_post_active_sprites;
+  l->flow = flow_field_create(t->w, t->h);
+  if (l->flow == NULL) {
+    array_free(NULL, &l->active_sprites);
+    event_queue_destroy(&l->events);
+    projectile_pool_destroy(&l->projectiles);
+    free(l->collected);
+    free(l);
+    return NULL;
   }
 
-  // l has been successfully allocated if we reached this point.
-  register size_t r;
-  register size_t c;
-
-  // set all the passive sprites to SPRITE_NONE to start with
-  for (r = 0; r < ROW_COUNT * h; r++) {
-    for (c = 0; c < COLUMN_COUNT * w; c++) {
-      l->passive_sprites[r * COLUMN_COUNT * w + c] =
-          g_sprite_types[SPRITE_NONE];
-    }
-  }
+  l->template = level_template_retain(t);
+  l->passive_sprites = t->passive_sprites;
+  l->items = t->items;
+  l->solids = t->solids;
 
   return l;
-
-error_post_active_sprites:
-  array_free(&l->active_sprites);
-error_post_l:
-  free(l);
-error_out:
-  return NULL;
 }
 
-void level_free(struct level **pl) {
-  struct player *p = g_game.player;
-  assert_not_null(3, p, pl, *pl);
+void level_free(struct lily_world *w, struct level **pl) {
+  assert_not_null(3, w, pl, *pl);
 
   struct level *l = *pl;
-  array_free(&l->active_sprites);
+  array_free(w, &l->active_sprites);
+  projectile_pool_destroy(&l->projectiles);
+  event_queue_destroy(&l->events);
+  flow_field_destroy(&l->flow);
+  level_template_release(&l->template);
+  free(l->collected);
   free(l);
   *pl = NULL;
 
   LOG_INFO_VERBOSE("unloaded level");
 }
 
-struct level *level_load_from_string(const char *s, const size_t w,
-                                     const size_t h,
-                                     const struct token_entry *arr,
-                                     const size_t arr_len) {
-  struct level *l = level_new(w, h);
+struct level *level_instantiate(struct lily_world *w,
+                                struct level_template *t) {
+  assert_not_null(2, w, t);
+
+  struct level *l = level_new(t);
   if (l == NULL) {
+    LOG_ERROR("failed to allocate level");
     return NULL;
   }
 
-  if (token_level_populate(l, s, arr, arr_len) != 0) {
-    level_free(&l);
-    return NULL;
+  // the spawn list is already sorted by depth, so there is no need to sort the
+  // active sprites afterwards.
+  register size_t i;
+  for (i = 0; i < t->spawn_count; i++) {
+    const struct spawn *sp = &t->spawns[i];
+    if (sp->f(w, l, sp->id, sp->r, sp->c) != 0) {
+      level_free(w, &l);
+      return NULL;
+    }
   }
 
   return l;
 }
 
-int level_load(const char *filename, const struct token_entry *arr,
-               const size_t arr_len) {
-  struct level *prev = NULL;
-  if (g_game.level != NULL) {
-    prev = g_game.level;
+struct level *level_load_from_string(struct lily_world *world, const char *s,
+                                     const size_t w, const size_t h,
+                                     const struct token_entry *arr,
+                                     const size_t arr_len) {
+  struct level_template *t = level_template_from_string(s, w, h, arr, arr_len);
+  if (t == NULL) {
+    return NULL;
   }
 
-  char *str;
-  size_t w, h;
-  if (util_level_from_file(filename, &str, &w, &h) < 0) {
-    // logging is done in util_level_from_file
-    return -1;
+  struct level *l = level_instantiate(world, t);
+  level_template_release(&t);
+  return l;
+}
+
+int level_load_template(struct lily_world *w, struct level_template *t) {
+  assert_not_null(3, w, t, w->player);
+
+  struct level *prev = NULL;
+  if (w->level != NULL) {
+    prev = w->level;
   }
 
   // so the new level can add its sprite here. The pointer to this old sprite is
   // still in the active sprites array of the previous level and hence will be
   // freed when we cann level_free on the previous level
-  g_game.player->s = NULL;
+  w->player->s = NULL;
   // Side note: we are hoping here the system has enough memory to load two
   // levels at once. Otherwise, we may have to optimize by free-ing the previous
   // world first.
-  struct level *l = level_load_from_string(str, w, h, arr, arr_len);
+  struct level *l = level_instantiate(w, t);
 
   if (l == NULL) {
     return -1;
   }
 
   if (prev != NULL) {
-    level_free(&prev);
+    level_free(w, &prev);
   }
 
-  g_game.level = l;
+  w->level = l;
 
   return 0;
 }
+
+int level_load(struct lily_world *w, const char *filename,
+               const struct token_entry *arr, const size_t arr_len) {
+  struct level_template *t = level_template_get(filename, arr, arr_len);
+  if (t == NULL) {
+    // logging is done in level_template_get
+    return -1;
+  }
+
+  int ret = level_load_template(w, t);
+  level_template_release(&t);
+  return ret;
+}
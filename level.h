@@ -3,10 +3,17 @@
 
 #include "array.h"
 #include "base.h"
+#include "event.h"
+#include "flow.h"
+#include "level_template.h"
+#include "projectile.h"
 #include "token.h"
 
 #include <stdbool.h>
 
+// forward declaration, see state.h
+struct lily_world;
+
 //  --------------------------------------------
 // | Quick note on the structure of the game    |
 // | A SPRITE is our atomic unit                |
@@ -26,13 +33,41 @@
 // A passive sprite:
 // - is rendered
 // - is rendered *before* any active sprite
+// - may be animated, and may have properties like killing the player on touch,
+//   shared by every passive sprite of its type (see sprite_type.tile_frames)
+// Items, like coins, sit on the tiles without a passive sprite. They are not
+// active sprites either: they are looked up on the tiles the player touches,
+// and only become an active sprite once collected, to fade out.
 struct level {
-  // passive_sprites stores (pointers to) all the passive sprites in the level.
-  // This is a dynamic array of size ROW_COUNT * COLUMN_COUNT * w (or, more
-  // simply, SPRITE_COUNT * w).
-  struct sprite_type **passive_sprites;
+  // passive_sprites stores the sprite ids of all the passive sprites in the
+  // level. This is an array of size ROW_COUNT * COLUMN_COUNT * w * h (or, more
+  // simply, SPRITE_COUNT * w * h). It belongs to the level template this level
+  // was instantiated from, and is shared read-only by every instance of it.
+  const enum sprite_id *passive_sprites;
+  // items stores the sprite ids of the items on the tiles of the level, in the
+  // same order as passive_sprites (see level_template.items). It belongs to the
+  // level template as well.
+  const Uint8 *items;
+  // collected is a bitset of the tiles whose item was collected, a bit per
+  // tile in the order of passive_sprites. Its size is level_collected_size.
+  Uint8 *collected;
+  // solids is the solid geometry of the tiles of the level, in rectangles (see
+  // solid.h). It belongs to the level template as well.
+  const struct solid_map *solids;
+  // template is the level template this level was instantiated from. The level
+  // holds a reference to it for as long as the level exists.
+  struct level_template *template;
   // active_sprites stores all the active sprites in the level
   struct array *active_sprites;
+  // projectiles stores the projectiles in flight in the level, e.g shots. They
+  // are rendered at the depth of their sprite type, among the active sprites.
+  struct projectile_pool *projectiles;
+  // events stores the events of the current tick, which are resolved at the
+  // end of level_iterate (see event.h). It is empty between ticks.
+  struct event_queue *events;
+  // flow leads the enemies that chase the player to them (see flow.h). It is
+  // updated at the start of level_iterate, before the sprites are.
+  struct flow_field *flow;
   // w is the width of the level in units of COLUMN_COUNT i.e "screen". How many
   // screens wide is the level?
   size_t w;
@@ -44,28 +79,56 @@ struct level {
   bool player_found;
 };
 
-// level_load_from_string loads a level directly from its string, given a level
-// width. Primarily used for testing, or internally by level_load. Returns the
-// level, or NULL on failure.
-struct level *level_load_from_string(const char *s, const size_t w,
-                                     const size_t h,
+// level_instantiate creates a new level of the world w from a level template:
+// the active sprites in the template's spawn list are created, and the
+// template's tile grid is shared with the level. Returns the level, or NULL on
+// failure.
+struct level *level_instantiate(struct lily_world *w,
+                                struct level_template *t);
+
+// level_load_from_string loads a level of `world` directly from its string,
+// given a level width. Primarily used for testing. The level is not
+// cached (see level_template_get). Returns the level, or NULL on failure.
+struct level *level_load_from_string(struct lily_world *world, const char *s,
+                                     const size_t w, const size_t h,
                                      const struct token_entry *arr,
                                      const size_t arr_len);
 
-// level_load destroys the current world and loads a new one, the string
-// representation for which is in the file `filename`. Returns 0 on success, -1
-// on failure. If this function is successful, current_level will be set to the
-// loaded level.
-int level_load(const char *filename, const struct token_entry *arr,
-               const size_t arr_len);
+// level_load destroys the current level of the world w and loads a new one,
+// the string representation for which is in the file `filename`. The file is
+// only read and parsed if its level template is not cached already, so
+// restarting a level is cheap. Returns 0 on success, -1 on failure. If this
+// function is successful, w->level will be set to the loaded level.
+int level_load(struct lily_world *w, const char *filename,
+               const struct token_entry *arr, const size_t arr_len);
+
+// level_load_template works like level_load, but instantiates the level
+// template t instead of loading a level file. Returns 0 on success, -1 on
+// failure.
+int level_load_template(struct lily_world *w, struct level_template *t);
+
+// level_free deallocates the memory used for a level of the world w and sets
+// the value pointed to by pl to NULL
+void level_free(struct lily_world *w, struct level **pl);
+
+// level_iterate processes all active sprites, projectiles and other objects of
+// the world w that require processing per frame within the lever *except* for
+// the player, which is handled separately. The events they emit are resolved
+// once they were all processed (see event.h). Returns 0 on success, -1 on
+// failure.
+int level_iterate(struct lily_world *w, struct level *l);
+
+// level_item returns the sprite id of the item on the tile i of the level l, in
+// the order of passive_sprites, or SPRITE_NONE if there is no item on the tile
+// or if it was collected.
+enum sprite_id level_item(const struct level *l, const size_t i);
 
-// level_free deallocates the memory used for a level and sets the value
-// pointed to by pl to NULL
-void level_free(struct level **pl);
+// level_collected_size returns the size in bytes of the collected bitset of the
+// level l
+size_t level_collected_size(const struct level *l);
 
-// level_iterate processes all active sprites and other objects that require
-// processing per frame within the lever *except* for the player, which is
-// handled separately. Returns 0 on success, -1 on failure.
-int level_iterate(struct level *l);
+// level_animate advances the animation of every active sprite and projectile in
+// the level, including the player, by dt milliseconds.
+void level_animate(struct level *l, const Uint64 dt);
 
 #endif // LEVEL_H
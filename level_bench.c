@@ -0,0 +1,187 @@
+#include "level.h"
+
+#include "default_levels.h"
+#include "event.h"
+#include "lily.h"
+#include "player.h"
+#include "safe.h"
+#include "state.h"
+#include "util.h"
+#include <stdio.h>
+
+// level_bench measures the cost of updating an active sprite in level_iterate,
+// which updates the sprites type by type with a loop per type (see
+// SPRITE_TYPE_LIST). It compares it to updating them one by one, calling the
+// frame handler of their type through a pointer like the game did before, in
+// the same order and in the order they were spawned in, which is also the
+// order of their memory. Thousands of sprites of mixed types are spawned at
+// pseudo-random tiles of every level of the game, away from the rows of the
+// player so that none of them is removed during the benchmark. Run it with
+// `make bench`.
+
+enum {
+  BENCH_TICKS = 2 * FRAME_RATE,
+};
+
+// MIX is the types of the sprites spawned, in turn
+static const enum sprite_id MIX[] = {
+    SPRITE_SPIDER, SPRITE_COIN,     SPRITE_SKELETON, SPRITE_BAT,
+    SPRITE_GHOST,  SPRITE_PLATFORM, SPRITE_SPRING,   SPRITE_SPRINTING_SPIDER,
+    SPRITE_HELPER, SPRITE_EXTRA_LIFE};
+
+// world creates a world with the game's level number `index` and n sprites of
+// mixed types, in the order they were spawned in. Returns NULL on failure.
+static struct lily_world *world(const size_t index, const size_t n) {
+  struct lily_world *w = lily_world_create();
+  if (w == NULL || lily_world_load_default_level(w, index) != 0) {
+    return NULL;
+  }
+
+  w->dt = FRAME_TIME;
+  // the player blinks for the whole benchmark, so that the sprites hitting it
+  // do not end the game
+  fps_timer_init(&w->player->blink_timer, (Uint64)-1);
+
+  const struct level *l = w->level;
+  const int rows = ROW_COUNT * l->h, cols = COLUMN_COUNT * l->w;
+  int pr, pc;
+  util_nearest(w->player->s, &pr, &pc);
+
+  Uint64 z = index;
+  register size_t i;
+  for (i = 0; i < n;) {
+    z = z * 6364136223846793005 + 1442695040888963407;
+    const int r = (int)((z >> 33) % rows), c = (int)((z >> 17) % cols);
+    const enum sprite_id tile = l->passive_sprites[r * cols + c];
+    if (SDL_abs(r - pr) <= 2 ||
+        w->sprite_types[tile].solid_type != SOLID_NONE) {
+      continue;
+    }
+
+    const enum sprite_id id = MIX[i % (sizeof(MIX) / sizeof(MIX[0]))];
+    if (token_active_sprite(w, w->level, id, r, c) != 0) {
+      lily_world_destroy(&w);
+      return NULL;
+    }
+    i++;
+  }
+
+  return w;
+}
+
+// sprites returns the number of active sprites of the world w, but for the
+// player
+static size_t sprites(const struct lily_world *w) {
+  return w->level->active_sprites->l - 1;
+}
+
+// typed updates the sprites of the world w with level_iterate for BENCH_TICKS
+// ticks. Returns the time per sprite per tick in nanoseconds, or a negative
+// value on failure.
+static double typed(struct lily_world *w) {
+  array_clean(w, w->level->active_sprites);
+
+  const Uint64 start = SDL_GetPerformanceCounter();
+  register size_t t;
+  for (t = 0; t < BENCH_TICKS; t++) {
+    if (level_iterate(w, w->level) != 0) {
+      return -1;
+    }
+  }
+
+  const double elapsed = (double)(SDL_GetPerformanceCounter() - start) /
+                         SDL_GetPerformanceFrequency();
+  return elapsed * 1e9 / BENCH_TICKS / sprites(w);
+}
+
+// indirect updates the sprites of the world w for BENCH_TICKS ticks like
+// level_iterate, but one by one, calling the frame handler of their type
+// through a pointer. If spawned is true, they are updated in the order they
+// were spawned in, otherwise in the order of the active sprites of the level,
+// by type. Returns the time per sprite per tick in nanoseconds, or a negative
+// value on failure.
+static double indirect(struct lily_world *w, const bool spawned) {
+  struct level *l = w->level;
+  struct array *arr = l->active_sprites;
+  struct sprite **a = malloc(arr->l * sizeof(struct sprite *));
+  if (a == NULL) {
+    return -1;
+  }
+
+  // the spawned sprites are appended to the array until it is cleaned
+  if (!spawned) {
+    array_clean(w, arr);
+  }
+
+  register size_t t, i, n = 0;
+  for (i = 0; i < arr->l; i++) {
+    if (arr->a[i]->type->id != SPRITE_PLAYER) {
+      a[n++] = arr->a[i];
+    }
+  }
+  array_clean(w, arr);
+
+  double ret = -1;
+  const Uint64 start = SDL_GetPerformanceCounter();
+  for (t = 0; t < BENCH_TICKS; t++) {
+    for (i = 0; i < n; i++) {
+      struct sprite *s = a[i];
+      if (s->removed) {
+        continue;
+      }
+
+      if (s->type->frame_handler(w, s) != 0 ||
+          (util_collide(s, w->player->s) && event_emit(w, EVENT_HIT, s) != 0)) {
+        goto out;
+      }
+    }
+
+    if (projectile_iterate(w, l->projectiles) != 0 || event_resolve(w) != 0) {
+      goto out;
+    }
+    projectile_clean(l->projectiles);
+    array_clean(w, arr);
+  }
+
+  const double elapsed = (double)(SDL_GetPerformanceCounter() - start) /
+                         SDL_GetPerformanceFrequency();
+  ret = elapsed * 1e9 / BENCH_TICKS / n;
+
+out:
+  free(a);
+  return ret;
+}
+
+int main(int argc, char *argv[]) {
+  SAFE_UNUSED(argc);
+  SAFE_UNUSED(argv);
+
+  printf("%d ticks, ns per sprite per tick\n", BENCH_TICKS);
+  static const size_t COUNTS[] = {1000, 16000};
+  int ret = 0;
+  register size_t i, j, k;
+  for (i = 0; i < LEVEL_COUNT && ret == 0; i++) {
+    for (j = 0; j < sizeof(COUNTS) / sizeof(COUNTS[0]) && ret == 0; j++) {
+      // the same sprites, updated by type, one by one in the same order, and
+      // one by one in the order they were spawned in
+      double ns[3];
+      for (k = 0; k < 3 && ret == 0; k++) {
+        struct lily_world *w = world(i, COUNTS[j]);
+        ns[k] = w == NULL ? -1 : k == 0 ? typed(w) : indirect(w, k == 2);
+        if (w != NULL) {
+          lily_world_destroy(&w);
+        }
+        ret = ns[k] < 0;
+      }
+
+      if (ret == 0) {
+        printf("  %-22s %6lu sprites: by type %6.1f | one by one %6.1f | "
+               "spawn order %6.1f\n",
+               LEVELS[i], (unsigned long)COUNTS[j], ns[0], ns[1], ns[2]);
+      }
+    }
+  }
+
+  level_template_cache_clear();
+  return ret;
+}
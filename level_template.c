@@ -0,0 +1,282 @@
+#include "level_template.h"
+
+#include "safe.h"
+#include "util.h"
+
+#include <errno.h>
+#include <string.h>
+
+// cache_entry is an entry of the level template cache. Entries are identified
+// by the level filename *and* the token entries used to parse it, as the same
+// file parsed with different tokens gives a different template.
+struct cache_entry {
+  char *filename;
+  const struct token_entry *arr;
+  struct level_template *t;
+  // used is the value of _cache_clock when the entry was last used, the entry
+  // with the smallest value is the least recently used one.
+  Uint64 used;
+};
+
+static struct cache_entry _cache[LEVEL_TEMPLATE_CACHE_SIZE];
+static Uint64 _cache_clock = 0;
+// _cache_lock guards _cache and _cache_clock
+static SDL_SpinLock _cache_lock = 0;
+
+// template_new allocates a template with an empty tile grid of w x h screens.
+// Returns NULL on failure.
+static struct level_template *template_new(const size_t w, const size_t h) {
+  size_t len;
+  if (SDL_size_mul_overflow(SPRITE_COUNT, w, &len) != 0 ||
+      SDL_size_mul_overflow(len, h, &len) != 0) {
+    errno = EOVERFLOW;
+    return NULL;
+  }
+
+  struct level_template *t = calloc(1, sizeof(struct level_template));
+  if (t == NULL) {
+    // errno = ENOMEM
+    return NULL;
+  }
+
+  // calloc checks for multiplication overflow of its arguments
+  t->passive_sprites = calloc(len, sizeof(enum sprite_id));
+  t->items = calloc(len, sizeof(Uint8));
+  if (t->passive_sprites == NULL || t->items == NULL) {
+    // errno = ENOMEM
+    free(t->passive_sprites);
+    free(t->items);
+    free(t);
+    return NULL;
+  }
+
+  t->w = w;
+  t->h = h;
+  SDL_AtomicSet(&t->refs, 1);
+  return t;
+}
+
+// fnv returns the FNV-1a hash h with the n bytes of p folded into it
+static Uint64 fnv(Uint64 h, const void *p, const size_t n) {
+  const Uint8 *b = p;
+  register size_t i;
+  for (i = 0; i < n; i++) {
+    h ^= b[i];
+    h *= 0x100000001B3;
+  }
+
+  return h;
+}
+
+// template_hash returns the hash of the passive sprites, items and spawns of
+// the template t, see level_template.hash
+static Uint64 template_hash(const struct level_template *t) {
+  const size_t n = SPRITE_COUNT * t->w * t->h;
+  Uint64 h = 0xCBF29CE484222325;
+  register size_t i;
+  for (i = 0; i < n; i++) {
+    const Uint32 id = (Uint32)t->passive_sprites[i];
+    h = fnv(h, &id, sizeof(id));
+  }
+
+  h = fnv(h, t->items, n);
+  for (i = 0; i < t->spawn_count; i++) {
+    const Uint32 spawn[] = {(Uint32)t->spawns[i].id, (Uint32)t->spawns[i].r,
+                            (Uint32)t->spawns[i].c};
+    h = fnv(h, spawn, sizeof(spawn));
+  }
+
+  return h;
+}
+
+struct level_template *
+level_template_from_string(const char *s, const size_t w, const size_t h,
+                           const struct token_entry *arr,
+                           const size_t arr_len) {
+  struct level_template *t = template_new(w, h);
+  if (t == NULL) {
+    LOG_ERROR("failed to allocate level template");
+    return NULL;
+  }
+
+  if (token_template_populate(t, s, arr, arr_len) != 0) {
+    level_template_release(&t);
+    return NULL;
+  }
+  t->hash = template_hash(t);
+
+  // sprite types never change, so they give the solid geometry of the level in
+  // every world
+  t->solids = solid_map_create(t->passive_sprites, SPRITE_TYPES,
+                               size_t_to_int(ROW_COUNT * h),
+                               size_t_to_int(COLUMN_COUNT * w));
+  if (t->solids == NULL) {
+    level_template_release(&t);
+    return NULL;
+  }
+
+  return t;
+}
+
+struct level_template *level_template_retain(struct level_template *t) {
+  assert_not_null(1, t);
+  SDL_AtomicIncRef(&t->refs);
+  return t;
+}
+
+void level_template_release(struct level_template **pt) {
+  assert_not_null(2, pt, *pt);
+  struct level_template *t = *pt;
+  *pt = NULL;
+
+  assert(SDL_AtomicGet(&t->refs) > 0);
+  if (!SDL_AtomicDecRef(&t->refs)) {
+    return;
+  }
+
+  if (t->solids != NULL) {
+    solid_map_destroy(&t->solids);
+  }
+  free(t->spawns);
+  free(t->passive_sprites);
+  free(t->items);
+  free(t);
+}
+
+// cache_unlink moves the cache entry e to `out`, and empties e. _cache_lock
+// must be held. The template of out, if any, is to be released with cache_drop
+// once the lock is released, as releasing a template may free it.
+static void cache_unlink(struct cache_entry *e, struct cache_entry *out) {
+  *out = *e;
+  e->filename = NULL;
+  e->arr = NULL;
+  e->t = NULL;
+}
+
+// cache_drop releases the template of the unlinked cache entry e, if any, and
+// frees its key
+static void cache_drop(struct cache_entry *e) {
+  if (e->t != NULL) {
+    level_template_release(&e->t);
+  }
+
+  free(e->filename);
+  e->filename = NULL;
+  e->arr = NULL;
+}
+
+// cache_find returns a new reference to the cached template for the level file
+// `filename` parsed with the token entries arr, or NULL if it is not cached.
+// _cache_lock must be held.
+static struct level_template *cache_find(const char *filename,
+                                         const struct token_entry *arr) {
+  register size_t i;
+  for (i = 0; i < LEVEL_TEMPLATE_CACHE_SIZE; i++) {
+    struct cache_entry *e = &_cache[i];
+
+    if (e->t != NULL && e->arr == arr && strcmp(e->filename, filename) == 0) {
+      e->used = ++_cache_clock;
+      return level_template_retain(e->t);
+    }
+  }
+
+  return NULL;
+}
+
+// cache_insert adds the template t for the level file `filename` to the cache,
+// reusing an empty slot if there is one, otherwise the least recently used
+// slot, which is unlinked to `evicted` (see cache_unlink). The cache takes
+// ownership of key. _cache_lock must be held, and the level must not be cached
+// already.
+static void cache_insert(char *key, const struct token_entry *arr,
+                         struct level_template *t,
+                         struct cache_entry *evicted) {
+  struct cache_entry *victim = &_cache[0];
+  register size_t i;
+  for (i = 0; i < LEVEL_TEMPLATE_CACHE_SIZE; i++) {
+    struct cache_entry *e = &_cache[i];
+
+    if (victim->t != NULL && (e->t == NULL || e->used < victim->used)) {
+      victim = e;
+    }
+  }
+
+  cache_unlink(victim, evicted);
+  victim->filename = key;
+  victim->arr = arr;
+  victim->t = level_template_retain(t);
+  victim->used = ++_cache_clock;
+}
+
+struct level_template *level_template_get(const char *filename,
+                                          const struct token_entry *arr,
+                                          const size_t arr_len) {
+  assert_not_null(2, filename, arr);
+
+  SDL_AtomicLock(&_cache_lock);
+  struct level_template *t = cache_find(filename, arr);
+  SDL_AtomicUnlock(&_cache_lock);
+
+  if (t != NULL) {
+    LOG_INFO_VERBOSE("loaded level %s from the level cache", filename);
+    return t;
+  }
+
+  // the file is parsed without holding the lock, so other threads can keep
+  // using the cache in the meantime. If two threads parse the same file at the
+  // same time, the first template to be inserted is the one both get.
+  char *str;
+  size_t w, h;
+  if (util_level_from_file(filename, &str, &w, &h) < 0) {
+    // logging is done in util_level_from_file
+    return NULL;
+  }
+
+  t = level_template_from_string(str, w, h, arr, arr_len);
+  free(str);
+
+  if (t == NULL) {
+    return NULL;
+  }
+
+  // the template is still usable if we cannot cache it, we will just have to
+  // parse the file again next time.
+  char *key = malloc(strlen(filename) + 1);
+  if (key == NULL) {
+    return t;
+  }
+
+  strcpy(key, filename);
+
+  struct cache_entry evicted = {0};
+  SDL_AtomicLock(&_cache_lock);
+  struct level_template *cached = cache_find(filename, arr);
+  if (cached == NULL) {
+    cache_insert(key, arr, t, &evicted);
+  }
+  SDL_AtomicUnlock(&_cache_lock);
+
+  cache_drop(&evicted);
+  if (cached != NULL) {
+    free(key);
+    level_template_release(&t);
+    return cached;
+  }
+
+  return t;
+}
+
+void level_template_cache_clear(void) {
+  struct cache_entry evicted[LEVEL_TEMPLATE_CACHE_SIZE];
+
+  SDL_AtomicLock(&_cache_lock);
+  register size_t i;
+  for (i = 0; i < LEVEL_TEMPLATE_CACHE_SIZE; i++) {
+    cache_unlink(&_cache[i], &evicted[i]);
+  }
+  SDL_AtomicUnlock(&_cache_lock);
+
+  for (i = 0; i < LEVEL_TEMPLATE_CACHE_SIZE; i++) {
+    cache_drop(&evicted[i]);
+  }
+}
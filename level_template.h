@@ -0,0 +1,93 @@
+#ifndef LEVEL_TEMPLATE_H
+#define LEVEL_TEMPLATE_H
+
+#include "base.h"
+#include "solid.h"
+#include "token.h"
+
+#include <stdbool.h>
+
+// A level template is the parsed, immutable form of a level file. Parsing a
+// level (reading the file and mapping every token to a sprite) only has to
+// happen once per template. Every time the level is (re)started afterwards, a
+// level instance is created from the template by replaying its spawn list and
+// sharing its tile grid read-only. See level_instantiate in level.h.
+
+// LEVEL_TEMPLATE_CACHE_SIZE is the maximum number of templates kept in memory
+// by level_template_get. When the cache is full, the least recently used
+// template is evicted. The cache is shared by every world and is safe to use
+// from multiple threads.
+enum { LEVEL_TEMPLATE_CACHE_SIZE = 4 };
+
+// spawn records an active sprite (or the player) that is to be created when a
+// level is instantiated from a template.
+struct spawn {
+  // the function to use for sprite creation, see token_entry.f
+  int (*f)(struct lily_world *, struct level *, const enum sprite_id,
+           const size_t, const size_t);
+  enum sprite_id id; // the sprite id to create
+  size_t r;          // the row of the sprite in the level
+  size_t c;          // the column of the sprite in the level
+};
+
+struct level_template {
+  // passive_sprites stores the sprite id of every passive sprite in the level.
+  // This is an array of size SPRITE_COUNT * w * h. It is never modified after
+  // the template is parsed, so every level instance shares it.
+  enum sprite_id *passive_sprites;
+  // items stores the sprite id of the item (e.g a coin) on every tile of the
+  // level, or SPRITE_NONE, in a byte per tile and in the same order as
+  // passive_sprites. Items are not active sprites: the player collects them by
+  // touching their tile (see level_item). It is never modified either.
+  Uint8 *items;
+  // solids is the solid geometry of the tiles of the level, see solid.h
+  struct solid_map *solids;
+  // spawns stores every active sprite to create when instantiating the level,
+  // already sorted in descending order of depth (see array_sort).
+  struct spawn *spawns;
+  // spawn_count is the number of elements in spawns
+  size_t spawn_count;
+  // w is the width of the level in units of COLUMN_COUNT
+  size_t w;
+  // h is the height of the level in units of ROW_COUNT
+  size_t h;
+  // hash is a hash of the passive sprites, items and spawns of the level,
+  // which identifies it, e.g in snapshots (see snapshot.h)
+  Uint64 hash;
+  // refs is the number of owners of this template: the cache (if the template
+  // is cached) plus every level instantiated from it. The template is freed
+  // when refs drops to zero. Levels of worlds running on different threads may
+  // share a template, so refs is atomic.
+  SDL_atomic_t refs;
+};
+
+// level_template_from_string parses a level from its string, given a level
+// width and height (in screens) and the token entries used to map characters
+// to sprites. The returned template has a single reference, owned by the
+// caller. Returns NULL on failure and sets errno.
+struct level_template *
+level_template_from_string(const char *s, const size_t w, const size_t h,
+                           const struct token_entry *arr, const size_t arr_len);
+
+// level_template_get returns the template for the level file `filename`,
+// parsing the file only if the template is not already cached. The caller owns
+// one reference to the returned template and must release it with
+// level_template_release. Returns NULL on failure.
+struct level_template *level_template_get(const char *filename,
+                                          const struct token_entry *arr,
+                                          const size_t arr_len);
+
+// level_template_retain adds a reference to the template and returns it
+struct level_template *level_template_retain(struct level_template *t);
+
+// level_template_release drops a reference to the template pointed to by pt,
+// freeing it if it was the last one, and sets *pt to NULL.
+void level_template_release(struct level_template **pt);
+
+// level_template_cache_clear drops every template held by the cache. Templates
+// still referenced by a level are only freed once that level is freed. This
+// should be called whenever level files may have changed on disk (e.g when the
+// user loads a custom level) and before the program exits.
+void level_template_cache_clear(void);
+
+#endif // LEVEL_TEMPLATE_H
@@ -1,5 +1,8 @@
 #include "level.h"
 
+#include "default_levels.h"
+#include "handlers.h"
+#include "lily.h"
 #include "player.h"
 #include "state.h"
 #include "test.h"
@@ -13,6 +16,8 @@ static const struct token_entry TOKENS[] = {
 
 static const size_t TOKEN_SIZE = 4;
 
+static struct lily_world *world = NULL;
+
 // Based on our current settings of the screen size being 320 x 240, and the
 // sprite size being 16, each level should be 20 x 15 characters long. If we
 // decide to modify these settings in the future, we will probably need to
@@ -22,7 +27,8 @@ static void test_invalid_levels(void) {
   const char *too_short = "     "
                           "     ";
 
-  struct level *l = level_load_from_string(too_short, 1, 1, TOKENS, TOKEN_SIZE);
+  struct level *l = level_load_from_string(world, too_short, 1, 1, TOKENS,
+                                           TOKEN_SIZE);
   assert(l == NULL);
   assert(errno == EINVAL);
 
@@ -43,7 +49,7 @@ static void test_invalid_levels(void) {
                          "                     "
                          "                     "
                          "                     ";
-  l = level_load_from_string(too_long, 1, 1, TOKENS, TOKEN_SIZE);
+  l = level_load_from_string(world, too_long, 1, 1, TOKENS, TOKEN_SIZE);
   assert(l == NULL);
   assert(errno == EINVAL);
 }
@@ -68,7 +74,8 @@ static void test_empty_level(void) {
   // reset errno
   errno = 0;
 
-  struct level *l = level_load_from_string(empty, 1, 1, TOKENS, TOKEN_SIZE);
+  struct level *l = level_load_from_string(world, empty, 1, 1, TOKENS,
+                                           TOKEN_SIZE);
 
   // this should be NULL as the world has no player
   assert(l == NULL);
@@ -78,7 +85,7 @@ static void test_empty_level(void) {
   empty[0] = 'P';
 
   errno = 0; // reset errno
-  l = level_load_from_string(empty, 1, 1, TOKENS, TOKEN_SIZE);
+  l = level_load_from_string(world, empty, 1, 1, TOKENS, TOKEN_SIZE);
 
   LOG_ERROR("%d", errno);
 
@@ -88,8 +95,8 @@ static void test_empty_level(void) {
   l->active_sprites->free_on_clean = false;
   l->active_sprites->destroy_on_clean = false;
 
-  level_free(&l);
-  g_game.player->s = NULL;
+  level_free(world, &l);
+  world->player->s = NULL;
 }
 
 static void test_wall_level(void) {
@@ -112,7 +119,8 @@ static void test_wall_level(void) {
   // reset errno
   errno = 0;
 
-  struct level *l = level_load_from_string(wall, 1, 1, TOKENS, TOKEN_SIZE);
+  struct level *l = level_load_from_string(world, wall, 1, 1, TOKENS,
+                                           TOKEN_SIZE);
 
   assert(l != NULL);
   assert(errno == 0);
@@ -121,15 +129,15 @@ static void test_wall_level(void) {
   // on the 14th row, each column should be SPRITE_WALL_TOP
   // on the 15th row, each column should be SPRITE_WALL
   for (c = 0; c < 20; c++) {
-    assert(l->passive_sprites[13 * 20 + c]->id == SPRITE_WALL_TOP);
-    assert(l->passive_sprites[14 * 20 + c]->id == SPRITE_WALL);
+    assert(l->passive_sprites[13 * 20 + c] == SPRITE_WALL_TOP);
+    assert(l->passive_sprites[14 * 20 + c] == SPRITE_WALL);
   }
 
   l->active_sprites->free_on_clean = false;
   l->active_sprites->destroy_on_clean = false;
 
-  level_free(&l);
-  g_game.player->s = NULL;
+  level_free(world, &l);
+  world->player->s = NULL;
 }
 
 // level larger than the screen
@@ -155,7 +163,8 @@ static void test_wide_level(void) {
 
   // otherwise completely valid level, but not the right width (2 *
   // COLUMN_COUNT)
-  struct level *l = level_load_from_string(wall, 2, 1, TOKENS, TOKEN_SIZE);
+  struct level *l = level_load_from_string(world, wall, 2, 1, TOKENS,
+                                           TOKEN_SIZE);
 
   assert(l == NULL);
   assert(errno == EINVAL);
@@ -176,21 +185,21 @@ static void test_wide_level(void) {
                      "========================================"
                      "****************************************"; // 15 lines
 
-  l = level_load_from_string(wide_wall, 2, 1, TOKENS, TOKEN_SIZE);
+  l = level_load_from_string(world, wide_wall, 2, 1, TOKENS, TOKEN_SIZE);
 
   register size_t c;
   // on the 14th row, each column should be SPRITE_WALL_TOP
   // on the 15th row, each column should be SPRITE_WALL
   for (c = 0; c < 40; c++) {
-    assert(l->passive_sprites[13 * 40 + c]->id == SPRITE_WALL_TOP);
-    assert(l->passive_sprites[14 * 40 + c]->id == SPRITE_WALL);
+    assert(l->passive_sprites[13 * 40 + c] == SPRITE_WALL_TOP);
+    assert(l->passive_sprites[14 * 40 + c] == SPRITE_WALL);
   }
 
   l->active_sprites->free_on_clean = false;
   l->active_sprites->destroy_on_clean = false;
 
-  level_free(&l);
-  g_game.player->s = NULL;
+  level_free(world, &l);
+  world->player->s = NULL;
 }
 
 static void test_high_level(void) {
@@ -228,7 +237,8 @@ static void test_high_level(void) {
   // reset errno
   errno = 0;
 
-  struct level *l = level_load_from_string(wall, 1, 2, TOKENS, TOKEN_SIZE);
+  struct level *l = level_load_from_string(world, wall, 1, 2, TOKENS,
+                                           TOKEN_SIZE);
 
   assert(l != NULL);
   assert(errno == 0);
@@ -237,40 +247,161 @@ static void test_high_level(void) {
   // on the 14th and 29th row, each column should be SPRITE_WALL_TOP
   // on the 15th and 30th row, each column should be SPRITE_WALL
   for (c = 0; c < 20; c++) {
-    assert(l->passive_sprites[13 * 20 + c]->id == SPRITE_WALL_TOP);
-    assert(l->passive_sprites[28 * 20 + c]->id == SPRITE_WALL_TOP);
-    assert(l->passive_sprites[14 * 20 + c]->id == SPRITE_WALL);
-    assert(l->passive_sprites[29 * 20 + c]->id == SPRITE_WALL);
+    assert(l->passive_sprites[13 * 20 + c] == SPRITE_WALL_TOP);
+    assert(l->passive_sprites[28 * 20 + c] == SPRITE_WALL_TOP);
+    assert(l->passive_sprites[14 * 20 + c] == SPRITE_WALL);
+    assert(l->passive_sprites[29 * 20 + c] == SPRITE_WALL);
   }
 
   l->active_sprites->free_on_clean = false;
   l->active_sprites->destroy_on_clean = false;
 
-  level_free(&l);
-  g_game.player->s = NULL;
+  level_free(world, &l);
+  world->player->s = NULL;
+}
+
+// levels instantiated from the same template share its tile grid and get their
+// own active sprites
+static void test_template_instantiate(void) {
+  char wall[] = "                    " // 20 characters
+                "                    "
+                "                    "
+                "                    "
+                "                    "
+                "                    "
+                "                    "
+                "                    "
+                "                    "
+                "                    "
+                "                    "
+                "                    "
+                "P                   "
+                "===================="
+                "********************"; // 15 lines
+
+  errno = 0;
+  struct level_template *t =
+      level_template_from_string(wall, 1, 1, TOKENS, TOKEN_SIZE);
+
+  assert(t != NULL);
+  assert(errno == 0);
+  assert(SDL_AtomicGet(&t->refs) == 1);
+  assert(t->spawn_count == 1);
+  assert(t->spawns[0].id == SPRITE_PLAYER);
+  assert(t->spawns[0].r == 12 && t->spawns[0].c == 0);
+
+  struct level *l = level_instantiate(world, t);
+  assert(l != NULL);
+  assert(SDL_AtomicGet(&t->refs) == 2);
+  assert(l->passive_sprites == t->passive_sprites);
+  assert(l->active_sprites->l == 1);
+  assert(l->active_sprites->a[0] == world->player->s);
+  assert(world->player->s->y == 12 * SPRITE_SIZE);
+
+  level_free(world, &l);
+  assert(SDL_AtomicGet(&t->refs) == 1);
+  world->player->s = NULL;
+
+  // restart the level from the same template
+  l = level_instantiate(world, t);
+  assert(l != NULL);
+  assert(l->passive_sprites == t->passive_sprites);
+  assert(l->active_sprites->l == 1);
+
+  // the level keeps the template alive after the caller releases it
+  level_template_release(&t);
+  assert(t == NULL);
+  assert(l->passive_sprites[13 * 20] == SPRITE_WALL_TOP);
+
+  level_free(world, &l);
+  world->player->s = NULL;
+}
+
+enum { CACHE_THREADS = 8 };
+
+// get_thread gets the template of the first level of the game into the
+// template pointed to by data
+static int get_thread(void *data) {
+  struct level_template **t = data;
+  *t = level_template_get(LEVELS[0], LEVEL_TOKENS[0], LEVEL_TOKENS_COUNT[0]);
+  return 0;
+}
+
+// threads getting the template of a same level at the same time all get the
+// template the cache keeps, however many of them parsed the level
+static void test_template_cache(void) {
+  level_template_cache_clear();
+
+  SDL_Thread *threads[CACHE_THREADS];
+  struct level_template *t[CACHE_THREADS];
+  register size_t i;
+  for (i = 0; i < CACHE_THREADS; i++) {
+    threads[i] = SDL_CreateThread(get_thread, "level", &t[i]);
+    assert(threads[i] != NULL);
+  }
+
+  for (i = 0; i < CACHE_THREADS; i++) {
+    SDL_WaitThread(threads[i], NULL);
+  }
+
+  struct level_template *cached =
+      level_template_get(LEVELS[0], LEVEL_TOKENS[0], LEVEL_TOKENS_COUNT[0]);
+  assert(cached != NULL);
+  assert(SDL_AtomicGet(&cached->refs) == CACHE_THREADS + 2);
+  for (i = 0; i < CACHE_THREADS; i++) {
+    assert(t[i] == cached);
+    level_template_release(&t[i]);
+  }
+
+  level_template_cache_clear();
+  assert(SDL_AtomicGet(&cached->refs) == 1);
+  level_template_release(&cached);
+}
+
+// SPRITE_TYPE_LIST, from which the update loops of level_iterate are
+// generated, lists every sprite type of the game, with its frame handler
+static void test_frame_handlers(void) {
+  bool listed[SPRITE_TYPE_COUNT] = {false};
+
+#define CHECK_TYPE(id, solid, row, column, bx, by, bw, bh, init, frame, hit)  \
+  assert(world->sprite_types[id].frame_handler == frame);                      \
+  listed[id] = true;
+#define CHECK_TILE(id, ...)                                                    \
+  assert(world->sprite_types[id].frame_handler == handler_sprite_frame);       \
+  listed[id] = true;
+
+  SPRITE_TYPE_LIST(CHECK_TYPE, CHECK_TILE)
+#undef CHECK_TYPE
+#undef CHECK_TILE
+
+  register size_t i;
+  for (i = 0; i < SPRITE_CUSTOM; i++) {
+    // the types used for testing have no handlers
+    if (!listed[i]) {
+      assert(i == SPRITE_TEST_LO_DEPTH || i == SPRITE_TEST_HI_DEPTH);
+      assert(world->sprite_types[i].frame_handler == NULL);
+    }
+  }
 }
 
 int main(int argc, char *argv[]) {
   SAFE_UNUSED(argc);
   SAFE_UNUSED(argv);
 
-  // load all sprite types prior to testing, otherwise the assert_not_nulls will
-  // fail
-  assert(g_sprite_types_create() == 0);
-
-  struct player *p = malloc(sizeof(struct player));
-  assert(p != NULL);
-  g_game.player = p; // we don't want to fail because the player is NULL
-  assert(player_create(p) == 0);
+  // create a world prior to testing, otherwise the assert_not_nulls will fail
+  world = lily_world_create();
+  assert(world != NULL);
 
   RUN_TEST(test_invalid_levels);
   RUN_TEST(test_empty_level);
   RUN_TEST(test_wall_level);
   RUN_TEST(test_wide_level);
   RUN_TEST(test_high_level);
+  RUN_TEST(test_template_instantiate);
+  RUN_TEST(test_template_cache);
+  RUN_TEST(test_frame_handlers);
 
-  player_destroy(&p);
-  g_sprite_types_destroy();
+  lily_world_destroy(&world);
 
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,255 @@
+#include "lily.h"
+
+#include "default_levels.h"
+#include "digest.h"
+#include "fps.h"
+#include "level.h"
+#include "message.h"
+#include "player.h"
+#include "safe.h"
+#include "sprite_def.h"
+#include "util.h"
+
+struct lily_world *lily_world_create(void) {
+  struct lily_world *w = calloc(1, sizeof(struct lily_world));
+  if (w == NULL) {
+    LOG_ERROR("could not allocate world");
+    return NULL;
+  }
+
+  w->sprite_types = SPRITE_TYPES;
+
+  w->player = malloc(sizeof(struct player));
+  if (w->player == NULL) {
+    // errno = ENOMEM;
+    goto error_out;
+  }
+
+  // initialize the player
+  if (player_create(w->player) != 0) {
+    goto player_error_out;
+  }
+
+  // start with an empty, null-terminated message
+  w->message = message_create();
+  if (w->message == NULL) {
+    player_destroy(&w->player);
+    goto error_out;
+  }
+
+  w->level = NULL;
+  w->input = INPUT_NONE;
+  w->hash = DIGEST_SEED;
+  w->hashing = false;
+  w->state = PROG_GAME_IN; // we are officially in the game
+  return w;
+
+player_error_out:
+  free(w->player);
+error_out:
+  free(w);
+  return NULL;
+}
+
+void lily_world_destroy(struct lily_world **pw) {
+  assert_not_null(2, pw, *pw);
+  struct lily_world *w = *pw;
+
+  // If we currently have a level, free that level
+  if (w->level != NULL) {
+    level_free(w, &w->level); // this should also free player->sprite
+  }
+
+  message_destroy(&w->message);
+  player_destroy(&w->player);
+
+  free(w);
+  *pw = NULL;
+}
+
+void lily_world_seed(struct lily_world *w, const Uint64 seed) {
+  util_seed(w, seed);
+}
+
+void lily_world_set_hash_log(struct lily_world *w, FILE *f) {
+  assert_not_null(1, w);
+  w->hash_log = f;
+}
+
+void lily_world_set_hashing(struct lily_world *w, const bool on) {
+  assert_not_null(1, w);
+  w->hashing = on;
+}
+
+int lily_world_set_sprite_defs(struct lily_world *w,
+                               const struct sprite_defs *d) {
+  assert_not_null(1, w);
+  if (w->level != NULL) {
+    LOG_ERROR("cannot change the sprite types of a world with a level");
+    return -1;
+  }
+
+  w->sprite_defs = d;
+  w->sprite_types = d != NULL ? d->types : SPRITE_TYPES;
+  return 0;
+}
+
+void lily_world_set_sound_handler(struct lily_world *w, const sound_handler h) {
+  assert_not_null(1, w);
+  w->sound = h;
+}
+
+int lily_world_load_level(struct lily_world *w, const char *buf,
+                          const size_t len, const struct token_entry *arr,
+                          const size_t arr_len) {
+  assert_not_null(3, w, buf, arr);
+
+  char *str;
+  size_t lw, lh;
+  if (util_level_from_buffer(buf, len, &str, &lw, &lh) < 0) {
+    // logging is done in util_level_from_buffer
+    return -1;
+  }
+
+  struct level_template *t =
+      level_template_from_string(str, lw, lh, arr, arr_len);
+  free(str);
+
+  if (t == NULL) {
+    return -1;
+  }
+
+  int ret = lily_world_load_level_template(w, t);
+  level_template_release(&t);
+  return ret;
+}
+
+// log_level logs the level the world w just loaded to its hash log, if it has
+// one, rand being the state of its pseudo-random number generator before the
+// level was loaded. Returns 0 on success, -1 on failure.
+static int log_level(const struct lily_world *w, const Uint64 rand) {
+  return w->hash_log == NULL ? 0 : digest_log_level(w->hash_log, w, rand);
+}
+
+int lily_world_load_level_template(struct lily_world *w,
+                                   struct level_template *t) {
+  assert_not_null(2, w, t);
+  const Uint64 rand = w->rand;
+
+  if (level_load_template(w, t) != 0) {
+    return -1;
+  }
+
+  w->state = PROG_GAME_IN;
+  return log_level(w, rand);
+}
+
+// load_file loads the level file `filename` into the world w, see
+// lily_world_load_level_file, without logging it. Returns 0 on success, -1 on
+// failure.
+static int load_file(struct lily_world *w, const char *filename,
+                     const struct token_entry *arr, const size_t arr_len) {
+  if (level_load(w, filename, arr, arr_len) != 0) {
+    return -1;
+  }
+
+  w->state = PROG_GAME_IN;
+  return 0;
+}
+
+int lily_world_load_level_file(struct lily_world *w, const char *filename,
+                               const struct token_entry *arr,
+                               const size_t arr_len) {
+  assert_not_null(3, w, filename, arr);
+  const Uint64 rand = w->rand;
+
+  if (load_file(w, filename, arr, arr_len) != 0) {
+    return -1;
+  }
+
+  return log_level(w, rand);
+}
+
+int lily_world_load_default_level(struct lily_world *w, const size_t index) {
+  assert_not_null(1, w);
+  assert(index < LEVEL_COUNT);
+  const Uint64 rand = w->rand;
+
+  if (load_file(w, LEVELS[index], LEVEL_TOKENS[index],
+                LEVEL_TOKENS_COUNT[index]) != 0) {
+    return -1;
+  }
+
+  w->level_index = index;
+  return log_level(w, rand);
+}
+
+int lily_world_step(struct lily_world *w, const Uint32 input,
+                    const Uint64 dt) {
+  assert_not_null(2, w, w->level);
+
+  w->dt = SDL_min(dt, MAX_STEP_TIME);
+  w->input = input;
+  w->ticks++;
+
+  // the game logic only runs while the level is being played. Once the game is
+  // over or the level is complete, it is up to the caller to decide what to do
+  // next.
+  if (w->state == PROG_GAME_IN || w->state == PROG_GAME_KILLED) {
+    message_iterate(w, input & INPUT_INTERACT);
+
+    // a blocking message effectively "pauses" the game
+    if (!message_block(w->message)) {
+      player_iterate(w, w->player);
+
+      if (level_iterate(w, w->level) != 0) {
+        return -1;
+      }
+    }
+  }
+
+  // sprites keep animating even while the game is paused
+  level_animate(w->level, w->dt);
+  w->tile_clock += w->dt;
+
+  // hashing takes a pass over every sprite, so it is only done if the hash is
+  // used
+  if (!w->hashing && w->hash_log == NULL) {
+    return 0;
+  }
+
+  w->hash = digest_world(w, w->hash);
+  return w->hash_log == NULL ? 0 : digest_log_step(w->hash_log, w);
+}
+
+void lily_world_status(const struct lily_world *w, struct lily_status *st) {
+  assert_not_null(4, w, st, w->player, w->level);
+  const struct player *p = w->player;
+
+  st->state = w->state;
+  st->lives = p->lives;
+  st->coins = p->coins;
+  st->x = p->s->x;
+  st->y = p->s->y;
+  st->vx = p->s->vx;
+  st->vy = p->s->vy;
+  st->air = p->air;
+  st->ladder = p->ladder;
+  st->active_sprites = w->level->active_sprites->l;
+  st->ticks = w->ticks;
+}
+
+Uint64 lily_world_hash(const struct lily_world *w) {
+  assert_not_null(1, w);
+  return w->hash;
+}
+
+const struct level *lily_world_level(const struct lily_world *w) {
+  assert_not_null(1, w);
+  return w->level;
+}
+
+const struct player *lily_world_player(const struct lily_world *w) {
+  assert_not_null(1, w);
+  return w->player;
+}
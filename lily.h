@@ -0,0 +1,135 @@
+#ifndef LILY_H
+#define LILY_H
+
+#include "base.h"
+
+#include "input.h"
+#include "level_template.h"
+#include "sound.h"
+#include "state.h"
+#include "token.h"
+#include <stdbool.h>
+#include <stdio.h>
+
+// lily.h is the API of the game engine core (liblily_core). It runs the game
+// logic without any window, renderer or audio device: a world is created, a
+// level is loaded into it, and the world is then stepped one frame at a time
+// with the player's inputs for that frame. The game itself (liblily_sdl) drives
+// the world the same way, with inputs read from the keyboard.
+
+// lily_world is a running game world, see state.h. Every world is independent
+// of the others: any number of worlds can exist at once, and different worlds
+// can be used from different threads at the same time. A single world must only
+// be used by one thread at a time.
+struct lily_world;
+
+// lily_status summarizes the state of a world, see lily_world_status
+struct lily_status {
+  // state is PROG_GAME_IN or PROG_GAME_KILLED (the player lost a life and
+  // respawned) while the level is being played, otherwise it is the reason the
+  // level stopped (PROG_GAME_OVER, PROG_GAME_LEVEL_COMPLETE).
+  enum prog_state state;
+  unsigned int lives; // how many lives the player has
+  unsigned int coins; // the number of coins the player has collected
+  double x;           // the player's x position
+  double y;           // the player's y position
+  double vx;          // the player's x velocity
+  double vy;          // the player's y velocity
+  bool air;           // true if the player is mid-air
+  bool ladder;        // true if the player is climbing a ladder
+  // active_sprites is the number of active sprites in the level, including
+  // the player
+  size_t active_sprites;
+  // ticks is the number of times the world was stepped since it was created
+  Uint64 ticks;
+};
+
+// lily_world_create creates a world without a level. The world has no sound
+// and its pseudo-random number generator is seeded with 0, see lily_world_seed.
+// Returns NULL on failure.
+struct lily_world *lily_world_create(void);
+
+// lily_world_destroy frees all the memory associated with the world, including
+// its level, and sets *pw to NULL.
+void lily_world_destroy(struct lily_world **pw);
+
+// lily_world_load_level replaces the level of the world with the level in the
+// `len` bytes of `buf`, which are in the level file format (see levels/). `arr`
+// maps each character of the level to a sprite (see default_levels.h). Returns
+// 0 on success, -1 on failure.
+int lily_world_load_level(struct lily_world *w, const char *buf,
+                          const size_t len, const struct token_entry *arr,
+                          const size_t arr_len);
+
+// lily_world_load_level_file works like lily_world_load_level but reads the
+// level from the file `filename`, using the level template cache (see
+// level_template.h). Returns 0 on success, -1 on failure.
+int lily_world_load_level_file(struct lily_world *w, const char *filename,
+                               const struct token_entry *arr,
+                               const size_t arr_len);
+
+// lily_world_load_level_template works like lily_world_load_level but
+// instantiates the level from an already parsed level template (see
+// level_template.h), which is much faster than parsing the level again. The
+// world holds its own reference to t. Returns 0 on success, -1 on failure.
+int lily_world_load_level_template(struct lily_world *w,
+                                   struct level_template *t);
+
+// lily_world_seed seeds the pseudo-random number generator used by the game
+// logic of the world. Two worlds with the same seed, the same level and the
+// same inputs are always in the same state.
+void lily_world_seed(struct lily_world *w, const Uint64 seed);
+
+// lily_world_set_hash_log sets the file the world logs its hash to, or stops
+// logging it if f is NULL. The file is not closed by the world. From then on,
+// every level loaded and every step are logged (see digest.h), so a log can be
+// compared to the log of another run, e.g of another build, to find the first
+// tick they diverge at. The world hashes its state while it has a log,
+// whether or not hashing is on (see lily_world_set_hashing).
+void lily_world_set_hash_log(struct lily_world *w, FILE *f);
+
+// lily_world_set_hashing makes the world hash its state at every step from
+// then on (see lily_world_hash), or stop doing so. Hashing takes a pass over
+// every active sprite and projectile, so it is off by default.
+void lily_world_set_hashing(struct lily_world *w, const bool on);
+
+// lily_world_set_sprite_defs makes the world use the custom sprite types of
+// the sprite definitions d (see sprite_def.h), or none if d is NULL. d is not
+// freed by the world and must outlive it. It must be called before a level is
+// loaded: returns 0 on success, -1 if the world has a level.
+int lily_world_set_sprite_defs(struct lily_world *w,
+                               const struct sprite_defs *d);
+
+// lily_world_set_sound_handler sets the handler used to play the sounds of the
+// world (see sound.h), or removes it if h is NULL.
+void lily_world_set_sound_handler(struct lily_world *w, const sound_handler h);
+
+// lily_world_load_default_level works like lily_world_load_level_file, but
+// loads the game's level number `index` (see default_levels.h), which must be
+// less than LEVEL_COUNT. Returns 0 on success, -1 on failure.
+int lily_world_load_default_level(struct lily_world *w, const size_t index);
+
+// lily_world_step advances the world by one frame of dt milliseconds (clamped
+// to MAX_STEP_TIME, see fps.h), with `input` being the bitmask of input_key
+// values held down during the frame. Returns 0 on success, -1 on failure.
+int lily_world_step(struct lily_world *w, const Uint32 input,
+                    const Uint64 dt);
+
+// lily_world_status populates st with the current status of the world
+void lily_world_status(const struct lily_world *w, struct lily_status *st);
+
+// lily_world_hash returns the hash of the state of the world at every tick it
+// was stepped so far while it was hashing its state (see
+// lily_world_set_hashing), or DIGEST_SEED if it never was (see digest.h). Two
+// worlds hashing from the start have the same hash only if they went through
+// the same states, tick by tick.
+Uint64 lily_world_hash(const struct lily_world *w);
+
+// lily_world_level returns the current level of the world, or NULL if no level
+// was loaded. Useful to query the tiles and the active sprites of the level.
+const struct level *lily_world_level(const struct lily_world *w);
+
+// lily_world_player returns the player of the world
+const struct player *lily_world_player(const struct lily_world *w);
+
+#endif // LILY_H
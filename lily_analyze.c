@@ -0,0 +1,200 @@
+#include "analyzer.h"
+
+#include "default_levels.h"
+#include "fps.h"
+#include "input.h"
+#include "safe.h"
+#include "sprite_type.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// lily_analyze checks that the door of a level can be reached before the level
+// is published (see analyzer.h). Usage:
+//
+//   lily_analyze [-t threads] [-b beam] [-h hold] [-d depth] [-i] LEVEL
+//
+// where LEVEL is either the number of one of the game's levels, or the path to
+// a custom level file. It prints whether the door is reachable, a map of the
+// tiles the player reached, the regions it never reached and, with -i, the
+// inputs of the shortest path found. The exit status is 0 if the door is
+// reachable, 1 if it is not, and 2 on error.
+
+static void usage(void) {
+  fprintf(stderr, "usage: lily_analyze [-t threads] [-b beam] [-h hold] "
+                  "[-d depth] [-i] LEVEL\n");
+}
+
+// print_input prints the names of the keys of `in`
+static void print_input(const Uint32 in) {
+  static const char *NAMES[INPUT_KEY_COUNT] = {
+      "LEFT", "RIGHT", "UP", "DOWN", "JUMP", "SHORT_JUMP", "SPRINT", "INTERACT",
+      "CYCLE"};
+
+  if (in == INPUT_NONE) {
+    printf("NONE");
+    return;
+  }
+
+  bool first = true;
+  register size_t i;
+  for (i = 0; i < INPUT_KEY_COUNT; i++) {
+    if (in & (1 << i)) {
+      printf("%s%s", first ? "" : "|", NAMES[i]);
+      first = false;
+    }
+  }
+}
+
+// print_inputs prints the inputs of the path, merging identical frames
+static void print_inputs(const struct analyzer_result *res) {
+  size_t i = 0;
+  while (i < res->input_count) {
+    size_t j = i;
+    while (j < res->input_count && res->inputs[j] == res->inputs[i]) {
+      j++;
+    }
+
+    printf("  %4zu frames: ", j - i);
+    print_input(res->inputs[i]);
+    printf("\n");
+    i = j;
+  }
+}
+
+// print_map prints every tile of the level: '#' for solid tiles, 'D' for
+// doors, '.' for the tiles the player reached, ' ' for the others
+static void print_map(const struct level_template *t,
+                      const struct analyzer_result *res) {
+  register size_t r, c;
+  for (r = 0; r < res->rows; r++) {
+    printf("  |");
+    for (c = 0; c < res->cols; c++) {
+      const size_t i = r * res->cols + c;
+      const struct sprite_type *type = &SPRITE_TYPES[t->passive_sprites[i]];
+      char ch = ' ';
+      if (type->parent_id == SPRITE_DOOR) {
+        ch = 'D';
+      } else if (type->solid_type != SOLID_NONE) {
+        ch = '#';
+      } else if (res->reached[i]) {
+        ch = '.';
+      }
+      printf("%c", ch);
+    }
+    printf("|\n");
+  }
+}
+
+// parse_size parses the value of the option argv[*i] into *v. Returns 0 on
+// success, -1 on failure.
+static int parse_size(int argc, char *argv[], int *i, size_t *v) {
+  if (*i + 1 >= argc) {
+    return -1;
+  }
+
+  char *end;
+  const unsigned long long n = strtoull(argv[++*i], &end, 10);
+  if (*end != '\0') {
+    return -1;
+  }
+
+  *v = n;
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  struct analyzer_options o = {0};
+  bool inputs = false;
+  const char *level = NULL;
+
+  int i;
+  for (i = 1; i < argc; i++) {
+    int ret = 0;
+    if (strcmp(argv[i], "-t") == 0) {
+      ret = parse_size(argc, argv, &i, &o.threads);
+    } else if (strcmp(argv[i], "-b") == 0) {
+      ret = parse_size(argc, argv, &i, &o.beam);
+    } else if (strcmp(argv[i], "-h") == 0) {
+      ret = parse_size(argc, argv, &i, &o.hold);
+    } else if (strcmp(argv[i], "-d") == 0) {
+      ret = parse_size(argc, argv, &i, &o.max_depth);
+    } else if (strcmp(argv[i], "-i") == 0) {
+      inputs = true;
+    } else if (level == NULL) {
+      level = argv[i];
+    } else {
+      ret = -1;
+    }
+
+    if (ret != 0) {
+      usage();
+      return 2;
+    }
+  }
+
+  if (level == NULL) {
+    usage();
+    return 2;
+  }
+
+  // a number is one of the game's levels, anything else a custom level file
+  char *end;
+  const unsigned long index = strtoul(level, &end, 10);
+  struct level_template *t;
+  if (*end == '\0' && index < LEVEL_COUNT) {
+    level = LEVELS[index];
+    t = level_template_get(level, LEVEL_TOKENS[index],
+                           LEVEL_TOKENS_COUNT[index]);
+  } else {
+    t = level_template_get(level, CUSTOM_LEVEL_TOKENS,
+                           CUSTOM_LEVEL_TOKEN_COUNT);
+  }
+
+  if (t == NULL) {
+    fprintf(stderr, "could not load level %s\n", level);
+    return 2;
+  }
+
+  struct analyzer_result res;
+  const Uint64 start = SDL_GetPerformanceCounter();
+  if (analyzer_run(t, &o, &res) != 0) {
+    fprintf(stderr, "could not analyze level %s\n", level);
+    level_template_release(&t);
+    level_template_cache_clear();
+    return 2;
+  }
+  const double seconds = (double)(SDL_GetPerformanceCounter() - start) /
+                         SDL_GetPerformanceFrequency();
+
+  printf("level: %s\n", level);
+  printf("door reachable: %s (%s search)\n", res.reachable ? "yes" : "no",
+         res.exhaustive ? "exhaustive" : "partial");
+  printf("states: %zu | depth: %zu | time: %.2f s\n", res.states, res.depth,
+         seconds);
+
+  if (res.reachable) {
+    printf("shortest path: %zu frames (%.2f s)\n", res.input_count,
+           (double)res.input_count / FRAME_RATE);
+    if (inputs) {
+      print_inputs(&res);
+    }
+  }
+
+  printf("unreachable regions: %zu\n", res.region_count);
+  register size_t j;
+  for (j = 0; j < res.region_count; j++) {
+    const struct analyzer_region *r = &res.regions[j];
+    printf("  rows %zu-%zu, columns %zu-%zu: %zu tiles\n", r->r,
+           r->r + r->h - 1, r->c, r->c + r->w - 1, r->size);
+  }
+
+  printf("reached tiles:\n");
+  print_map(t, &res);
+
+  const int ret = res.reachable ? 0 : 1;
+  analyzer_result_free(&res);
+  level_template_release(&t);
+  level_template_cache_clear();
+  return ret;
+}
@@ -0,0 +1,187 @@
+#include "replay.h"
+
+#include "default_levels.h"
+#include "fps.h"
+#include "level_template.h"
+#include "safe.h"
+#include "sprite_type.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// lily_replay plays recorded games again and sums up how the game's levels
+// were played (see replay.h). Usage:
+//
+//   lily_replay [-t threads] [-o FILE] [-m] LOG...
+//
+// where each LOG is a hash log, e.g written by `lily --hash-log LOG`. It
+// prints the games that did not play out the same way, and for every level
+// how many times it was started and completed, how many times the player
+// died, the coins collected and the distribution of the time it took to reach
+// the door. With -m, it prints a map of where the player died in each level.
+// With -o, the results of every game are written to FILE. The exit status is 0
+// if every game played out the same way, 1 if one did not, and 2 on error.
+
+static void usage(void) {
+  fprintf(stderr, "usage: lily_replay [-t threads] [-o FILE] [-m] LOG...\n");
+}
+
+// percentile returns the p-th percentile of the n sorted times
+static Uint64 percentile(const Uint64 *times, const size_t n, const size_t p) {
+  return times[SDL_min(n * p / 100, n - 1)];
+}
+
+// to_seconds returns the time t, in FRAME_TIME ticks, in seconds
+static double to_seconds(const Uint64 t) {
+  return (double)(t * FRAME_TIME) / 1000;
+}
+
+// print_heatmap prints every tile of the level number `index`: '#' for solid
+// tiles, 'D' for doors, the number of deaths on the tile (or '+' for more than
+// 9) and ' ' for the others
+static void print_heatmap(const size_t index, const struct replay_level *l) {
+  struct level_template *t = level_template_get(
+      LEVELS[index], LEVEL_TOKENS[index], LEVEL_TOKENS_COUNT[index]);
+  if (t == NULL) {
+    return;
+  }
+
+  register size_t r, c;
+  for (r = 0; r < l->rows; r++) {
+    printf("  |");
+    for (c = 0; c < l->cols; c++) {
+      const size_t i = r * l->cols + c;
+      const struct sprite_type *type = &SPRITE_TYPES[t->passive_sprites[i]];
+      char ch = ' ';
+      if (l->heatmap[i] > 9) {
+        ch = '+';
+      } else if (l->heatmap[i] > 0) {
+        ch = (char)('0' + l->heatmap[i]);
+      } else if (type->parent_id == SPRITE_DOOR) {
+        ch = 'D';
+      } else if (type->solid_type != SOLID_NONE) {
+        ch = '#';
+      }
+      printf("%c", ch);
+    }
+    printf("|\n");
+  }
+
+  level_template_release(&t);
+}
+
+// print_level prints the analytics of the level number `index`
+static void print_level(const size_t index, const struct replay_level *l,
+                        const bool map) {
+  printf("%s: started %zu | completed %zu | deaths %zu", LEVELS[index],
+         l->starts, l->doors, l->deaths);
+  if (l->doors == 0) {
+    printf("\n");
+  } else {
+    printf(" | coins %.1f\n", (double)l->coins / l->doors);
+    printf("  time to door (s): min %.2f | median %.2f | 90%% %.2f | "
+           "max %.2f\n",
+           to_seconds(l->times[0]),
+           to_seconds(percentile(l->times, l->doors, 50)),
+           to_seconds(percentile(l->times, l->doors, 90)),
+           to_seconds(l->times[l->doors - 1]));
+  }
+
+  if (map && l->deaths > 0) {
+    print_heatmap(index, l);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  size_t threads = 0;
+  const char *output = NULL;
+  bool map = false;
+
+  int i;
+  for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+    if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+      threads = strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+      output = argv[++i];
+    } else if (strcmp(argv[i], "-m") == 0) {
+      map = true;
+    } else {
+      usage();
+      return 2;
+    }
+  }
+
+  if (i == argc) {
+    usage();
+    return 2;
+  }
+
+  const char *const *filenames = (const char *const *)&argv[i];
+  const size_t count = argc - i;
+  struct replay_result *results = calloc(count, sizeof(struct replay_result));
+  if (results == NULL) {
+    return 2;
+  }
+
+  const Uint64 start = SDL_GetPerformanceCounter();
+  if (replay_run(filenames, count, threads, results) != 0) {
+    fprintf(stderr, "could not play the games again\n");
+    free(results);
+    return 2;
+  }
+  const double seconds = (double)(SDL_GetPerformanceCounter() - start) /
+                         SDL_GetPerformanceFrequency();
+
+  int ret = 0;
+  Uint64 ticks = 0;
+  size_t valid = 0, complete = 0;
+  register size_t j;
+  for (j = 0; j < count; j++) {
+    const struct replay_result *res = &results[j];
+    ticks += res->ticks;
+    if (res->status == REPLAY_VALID) {
+      valid++;
+      complete += res->complete;
+    } else if (res->status == REPLAY_DIVERGED) {
+      printf("%s: diverged at tick %llu\n", filenames[j],
+             (unsigned long long)res->ticks);
+      ret = 1;
+    } else {
+      printf("%s: invalid\n", filenames[j]);
+      ret = 1;
+    }
+  }
+
+  printf("games: %zu | valid: %zu | complete: %zu | ticks: %llu | "
+         "time: %.2f s\n",
+         count, valid, complete, (unsigned long long)ticks, seconds);
+
+  struct replay_level levels[LEVEL_COUNT];
+  if (replay_aggregate(results, count, levels) != 0) {
+    ret = 2;
+  } else {
+    for (j = 0; j < LEVEL_COUNT; j++) {
+      print_level(j, &levels[j], map);
+      replay_level_free(&levels[j]);
+    }
+  }
+
+  if (output != NULL) {
+    FILE *f = fopen(output, "w");
+    if (f == NULL || replay_write(f, filenames, results, count) != 0) {
+      fprintf(stderr, "could not write %s\n", output);
+      ret = 2;
+    }
+
+    if (f != NULL) {
+      fclose(f);
+    }
+  }
+
+  for (j = 0; j < count; j++) {
+    replay_result_free(&results[j]);
+  }
+  free(results);
+  level_template_cache_clear();
+  return ret;
+}
@@ -0,0 +1,90 @@
+#include "sprite_def.h"
+
+#include "safe.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// lily_sprites compiles sprite definitions (see sprite_def.h) to the binary
+// file the game loads. Usage:
+//
+//   lily_sprites SOURCE OUTPUT
+//
+// where SOURCE is a file in the text format, e.g
+// share/sprites/enemies.sprites. It prints the token and sprite id of every
+// definition. The exit status is 0 on success, 1 if SOURCE is invalid, and 2
+// on error.
+
+static void usage(void) {
+  fprintf(stderr, "usage: lily_sprites SOURCE OUTPUT\n");
+}
+
+// read_file reads the file `filename` into a buffer, which the caller frees.
+// Returns NULL on failure, and populates len with the size of the file.
+static char *read_file(const char *filename, size_t *len) {
+  FILE *f = fopen(filename, "rb");
+  if (f == NULL) {
+    return NULL;
+  }
+
+  fseek(f, 0, SEEK_END);
+  const long size = ftell(f);
+  rewind(f);
+
+  char *buf = size >= 0 ? malloc((size_t)size + 1) : NULL;
+  if (buf != NULL) {
+    *len = fread(buf, 1, (size_t)size, f);
+  }
+
+  fclose(f);
+  return buf;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc != 3) {
+    usage();
+    return 2;
+  }
+
+  size_t len;
+  char *src = read_file(argv[1], &len);
+  if (src == NULL) {
+    fprintf(stderr, "could not read %s\n", argv[1]);
+    return 2;
+  }
+
+  Uint8 buf[SPRITE_DEFS_SIZE];
+  const size_t size = sprite_defs_compile(src, len, buf, sizeof(buf));
+  free(src);
+  if (size == 0) {
+    fprintf(stderr, "%s is not valid\n", argv[1]);
+    return 1;
+  }
+
+  FILE *f = fopen(argv[2], "wb");
+  if (f == NULL || fwrite(buf, 1, size, f) != size) {
+    fprintf(stderr, "could not write %s\n", argv[2]);
+    if (f != NULL) {
+      fclose(f);
+    }
+    return 2;
+  }
+  fclose(f);
+
+  struct sprite_defs *d = sprite_defs_load(buf, size);
+  if (d == NULL) {
+    return 2;
+  }
+
+  register size_t i;
+  for (i = 0; i < d->count; i++) {
+    const struct sprite_def *def = &d->defs[i];
+    printf("%c: sprite %lu | %u states | %u operations\n", def->token,
+           (unsigned long)(SPRITE_CUSTOM + i), def->state_count,
+           def->op_count);
+  }
+
+  printf("%lu sprites, %lu bytes\n", (unsigned long)d->count,
+         (unsigned long)size);
+  sprite_defs_destroy(&d);
+  return 0;
+}
@@ -0,0 +1,318 @@
+#include "lily.h"
+
+#include "level.h"
+#include "player.h"
+#include "test.h"
+#include <string.h>
+
+static const struct token_entry TOKENS[] = {
+    {'=', SPRITE_WALL_TOP, token_passive_sprite},
+    {'*', SPRITE_WALL, token_passive_sprite},
+    {'P', SPRITE_PLAYER, token_player},
+    {' ', SPRITE_NONE, NULL}};
+
+static const size_t TOKEN_SIZE = 4;
+
+static const struct token_entry ALL_TOKENS[] = {
+    {'=', SPRITE_WALL_TOP, token_passive_sprite},
+    {'*', SPRITE_WALL, token_passive_sprite},
+    {'~', SPRITE_WATER_TOP, token_passive_sprite},
+    {'O', SPRITE_COIN, token_item},
+    {'E', SPRITE_EXTRA_LIFE, token_item},
+    {'P', SPRITE_PLAYER, token_player},
+    {' ', SPRITE_NONE, NULL}};
+
+static const size_t ALL_TOKEN_SIZE = 7;
+
+// the same level, with items to the right of the player
+static const char ITEM_LEVEL[] = "     P O O E  O     \n"
+                                 "====================\n"
+                                 "********************";
+
+// a single screen level with the player standing on the floor
+static const char LEVEL[] = "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "     P              \n"
+                            "====================\n"
+                            "********************";
+
+// the same level, with a pool of water to the right of the player
+static const char WATER_LEVEL[] = "     P              \n"
+                                  "==========~~~~======\n"
+                                  "**********~~~~******";
+
+static void step(struct lily_world *w, const Uint32 input, const size_t n) {
+  register size_t i;
+  for (i = 0; i < n; i++) {
+    assert(lily_world_step(w, input, FRAME_TIME) == 0);
+  }
+}
+
+static void test_invalid_level(void) {
+  struct lily_world *w = lily_world_create();
+  assert(w != NULL);
+
+  // the last line is missing
+  assert(lily_world_load_level(w, LEVEL, sizeof(LEVEL) - 22, TOKENS,
+                               TOKEN_SIZE) != 0);
+  assert(lily_world_level(w) == NULL);
+
+  lily_world_destroy(&w);
+  assert(w == NULL);
+}
+
+static void test_step(void) {
+  struct lily_world *w = lily_world_create();
+  assert(w != NULL);
+  assert(lily_world_load_level(w, LEVEL, sizeof(LEVEL) - 1, TOKENS,
+                               TOKEN_SIZE) == 0);
+  assert(lily_world_level(w) != NULL);
+  assert(lily_world_player(w) != NULL);
+
+  struct lily_status st;
+  lily_world_status(w, &st);
+  assert(st.state == PROG_GAME_IN);
+  assert(st.active_sprites == 1); // only the player
+  assert(st.ticks == 0);
+
+  const double x = st.x, y = st.y;
+
+  // without any input, the player stays on the floor
+  step(w, INPUT_NONE, 60);
+  lily_world_status(w, &st);
+  assert(st.ticks == 60);
+  assert(!st.air);
+  assert(st.x == x);
+  assert(st.y == y);
+
+  // walk right
+  step(w, INPUT_RIGHT, 30);
+  lily_world_status(w, &st);
+  assert(st.x > x);
+  assert(st.y == y);
+
+  // and back left
+  const double right = st.x;
+  step(w, INPUT_LEFT, 30);
+  lily_world_status(w, &st);
+  assert(st.x < right);
+
+  // jump, the player leaves the floor then lands on it again
+  step(w, INPUT_JUMP, 5);
+  lily_world_status(w, &st);
+  assert(st.air);
+  assert(st.y < y);
+
+  step(w, INPUT_NONE, 120);
+  lily_world_status(w, &st);
+  assert(!st.air);
+  assert(st.y == y);
+  assert(st.state == PROG_GAME_IN);
+
+  lily_world_destroy(&w);
+}
+
+// the same inputs always give the same world
+static void test_deterministic(void) {
+  struct lily_status st[2];
+
+  register size_t i;
+  for (i = 0; i < 2; i++) {
+    struct lily_world *w = lily_world_create();
+    assert(w != NULL);
+    assert(lily_world_load_level(w, LEVEL, sizeof(LEVEL) - 1, TOKENS,
+                                 TOKEN_SIZE) == 0);
+    step(w, INPUT_RIGHT | INPUT_JUMP, 20);
+    step(w, INPUT_LEFT, 20);
+    lily_world_status(w, &st[i]);
+    lily_world_destroy(&w);
+  }
+
+  assert(st[0].x == st[1].x);
+  assert(st[0].y == st[1].y);
+  assert(st[0].vx == st[1].vx);
+  assert(st[0].vy == st[1].vy);
+}
+
+// THREAD_COUNT is the number of worlds run concurrently by test_threads
+enum { THREAD_COUNT = 8 };
+
+// run plays a fixed sequence of inputs on a new world and stores its final
+// status in data, which points to a struct lily_status.
+static int run(void *data) {
+  struct lily_world *w = lily_world_create();
+  if (w == NULL) {
+    return -1;
+  }
+
+  lily_world_seed(w, 42);
+  if (lily_world_load_level(w, LEVEL, sizeof(LEVEL) - 1, TOKENS,
+                            TOKEN_SIZE) != 0) {
+    lily_world_destroy(&w);
+    return -1;
+  }
+
+  register size_t i;
+  for (i = 0; i < 10; i++) {
+    step(w, INPUT_RIGHT | INPUT_JUMP, 20);
+    step(w, INPUT_LEFT, 20);
+  }
+
+  lily_world_status(w, data);
+  lily_world_destroy(&w);
+  return 0;
+}
+
+// worlds running at the same time on different threads do not affect each
+// other: every one of them ends up in the same state as a world run alone.
+static void test_threads(void) {
+  struct lily_status expected;
+  assert(run(&expected) == 0);
+
+  struct lily_status st[THREAD_COUNT];
+  SDL_Thread *threads[THREAD_COUNT];
+
+  register size_t i;
+  for (i = 0; i < THREAD_COUNT; i++) {
+    threads[i] = SDL_CreateThread(run, "lily_test", &st[i]);
+    assert(threads[i] != NULL);
+  }
+
+  for (i = 0; i < THREAD_COUNT; i++) {
+    int ret;
+    SDL_WaitThread(threads[i], &ret);
+    assert(ret == 0);
+
+    assert(st[i].state == expected.state);
+    assert(st[i].ticks == expected.ticks);
+    assert(st[i].x == expected.x);
+    assert(st[i].y == expected.y);
+    assert(st[i].vx == expected.vx);
+    assert(st[i].vy == expected.vy);
+  }
+}
+
+// water is a tile: it is animated without being an active sprite, and kills
+// the player who touches it
+static void test_water(void) {
+  struct lily_world *w = test_world(WATER_LEVEL, ALL_TOKENS, ALL_TOKEN_SIZE);
+
+  struct lily_status st;
+  lily_world_status(w, &st);
+  assert(st.active_sprites == 1); // only the player
+  const unsigned int lives = st.lives;
+
+  // every water tile shows the same frame, which changes over time
+  const struct sprite_type *t = &w->sprite_types[SPRITE_WATER_TOP];
+  const int frame = sprite_type_tile_frame(t, w->tile_clock);
+  step(w, INPUT_NONE, FRAME_RATE / 2);
+  assert(sprite_type_tile_frame(t, w->tile_clock) != frame);
+
+  // walk into the water
+  register size_t i;
+  for (i = 0; i < 2 * FRAME_RATE && st.lives == lives; i++) {
+    step(w, INPUT_RIGHT, 1);
+    lily_world_status(w, &st);
+  }
+  assert(st.lives == lives - 1);
+  assert(st.active_sprites == 1);
+
+  lily_world_destroy(&w);
+}
+
+// items are not active sprites until they are collected, and then only until
+// they faded out
+static void test_items(void) {
+  struct lily_world *w = test_world(ITEM_LEVEL, ALL_TOKENS, ALL_TOKEN_SIZE);
+
+  struct lily_status st;
+  lily_world_status(w, &st);
+  assert(st.active_sprites == 1); // only the player
+  assert(st.coins == 0);
+  const unsigned int lives = st.lives;
+
+  const struct level *l = lily_world_level(w);
+  const size_t i = 12 * COLUMN_COUNT + 7;
+  assert(level_item(l, i) == SPRITE_COIN);
+
+  // walk over the first coin: it is collected once, and fades out
+  while (st.coins == 0) {
+    step(w, INPUT_RIGHT, 1);
+    lily_world_status(w, &st);
+  }
+  assert(level_item(l, i) == SPRITE_NONE);
+  assert(st.coins == 1);
+  assert(st.active_sprites == 2);
+
+  step(w, INPUT_NONE, FRAME_RATE);
+  lily_world_status(w, &st);
+  assert(st.coins == 1);
+  assert(st.active_sprites == 1);
+
+  // and over the others
+  step(w, INPUT_RIGHT, 2 * FRAME_RATE);
+  step(w, INPUT_NONE, FRAME_RATE);
+  lily_world_status(w, &st);
+  assert(st.coins == 3);
+  assert(st.lives == lives + 1);
+  assert(st.active_sprites == 1);
+
+  lily_world_destroy(&w);
+}
+
+// switching characters changes the tile of the player's sprite, not the tile
+// of the sprite type, which other worlds share, and lasts to the next level
+static void test_character(void) {
+  struct lily_world *w[2];
+  register size_t i;
+  for (i = 0; i < 2; i++) {
+    w[i] = lily_world_create();
+    assert(w[i] != NULL);
+    assert(lily_world_load_level(w[i], LEVEL, sizeof(LEVEL) - 1, TOKENS,
+                                 TOKEN_SIZE) == 0);
+  }
+
+  // characters can only be switched once a second
+  const SDL_Rect type = SPRITE_TYPES[SPRITE_PLAYER].rect;
+  for (i = 0; i < 2; i++) {
+    step(w[i], INPUT_NONE, 2 * FRAME_RATE);
+  }
+  step(w[0], INPUT_CYCLE, 1);
+  step(w[1], INPUT_NONE, 1);
+
+  const SDL_Rect *rect = &w[0]->player->s->rect;
+  assert(rect->x != type.x || rect->y != type.y);
+  assert(memcmp(&w[1]->player->s->rect, &type, sizeof(SDL_Rect)) == 0);
+  assert(memcmp(&SPRITE_TYPES[SPRITE_PLAYER].rect, &type, sizeof(SDL_Rect)) ==
+         0);
+
+  const SDL_Rect character = *rect;
+  assert(lily_world_load_level(w[0], LEVEL, sizeof(LEVEL) - 1, TOKENS,
+                               TOKEN_SIZE) == 0);
+  assert(memcmp(&w[0]->player->s->rect, &character, sizeof(SDL_Rect)) == 0);
+
+  for (i = 0; i < 2; i++) {
+    lily_world_destroy(&w[i]);
+  }
+}
+
+int main(void) {
+  RUN_TEST(test_invalid_level);
+  RUN_TEST(test_step);
+  RUN_TEST(test_deterministic);
+  RUN_TEST(test_threads);
+  RUN_TEST(test_water);
+  RUN_TEST(test_items);
+  RUN_TEST(test_character);
+  return 0;
+}
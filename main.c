@@ -3,9 +3,63 @@
 #include "safe.h"
 #include "state.h"
 
+#include <stdio.h>
+#include <string.h>
+
+// MAX_SCALE is the largest scale of the window, see --scale
+static const int MAX_SCALE = 8;
+
+// usage prints how to run the game
+static void usage(const char *name) {
+  printf("usage: %s [--stream LOCATION | --view LOCATION] [--scale SCALE]\n"
+         "          [--hash-log FILE]\n"
+         "\n"
+         "  --stream LOCATION  stream the games played to LOCATION, for\n"
+         "                     spectators\n"
+         "  --view LOCATION    watch the games streamed to LOCATION instead\n"
+         "                     of playing\n"
+         "  --scale SCALE      open a window SCALE times the size of the\n"
+         "                     game, from 1 to %d (%d by default)\n"
+         "  --hash-log FILE    log the hash of the game at every frame to\n"
+         "                     FILE, to check that it plays out the same\n"
+         "                     in other builds\n"
+         "\n"
+         "LOCATION is a file (which may be a named pipe), tcp:HOST:PORT to\n"
+         "connect to HOST, or tcp::PORT to wait for a connection on PORT.\n",
+         name, MAX_SCALE, SIZE_FACTOR);
+}
+
 int main(int argc, char *argv[]) {
-  SAFE_UNUSED(argc);
-  SAFE_UNUSED(argv);
+  register int i;
+  for (i = 1; i < argc; i++) {
+    const char **location = NULL;
+    if (strcmp(argv[i], "--stream") == 0) {
+      location = &g_prog.stream_location;
+    } else if (strcmp(argv[i], "--view") == 0) {
+      location = &g_prog.view_location;
+    } else if (strcmp(argv[i], "--hash-log") == 0) {
+      location = &g_prog.hash_log_location;
+    } else if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+      const int scale = atoi(argv[++i]);
+      if (scale < 1 || scale > MAX_SCALE) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+      }
+      g_prog.scale = (unsigned int)scale;
+      continue;
+    }
+
+    if (location == NULL || i + 1 == argc) {
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+    *location = argv[++i];
+  }
+
+  if (g_prog.stream_location != NULL && g_prog.view_location != NULL) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
 
   // let's first set the state of the game to GAME_NOT_STARTED, so the
   // game_main_loop initialized the game
@@ -1,24 +1,12 @@
 #include "message.h"
 
 #include "base.h"
-#include "fps.h"
 #include "safe.h"
 #include "sound.h"
+#include "state.h"
 
 static const Sint64 DELAY = 250;
 
-enum {
-  CONTINUE_MSG_LEN = 6,
-  // Maximum amount of monospaced characters that can fit in one game message,
-  // as we determined experimentally minus the len
-  MESSAGE_BUFFER_LEN = 146,
-  // The maximum messages we can deliver to the user in one go. After 4 messages
-  // in one go, it gets a bit tedious for a game.
-  MAX_MESSAGE_LEN = MESSAGE_BUFFER_LEN * 4,
-  // Number of messages the backup buffer can hold
-  BACKUP_BUFFER_MESSAGES = 3,
-};
-
 static const char CONTINUE_MSG[CONTINUE_MSG_LEN] = "\n ... ";
 
 struct message *message_create(void) {
@@ -27,17 +15,18 @@ struct message *message_create(void) {
     goto error_out;
   }
 
-  m->m = (char *)calloc(1, MESSAGE_BUFFER_LEN + CONTINUE_MSG_LEN + 1);
+  m->m = (char *)calloc(1, MESSAGE_M_SIZE);
   if (m->m == NULL) {
     goto m_error_out;
   }
 
-  m->buffer =
-      (char *)calloc(1, 1 + MESSAGE_BUFFER_LEN * BACKUP_BUFFER_MESSAGES);
+  m->buffer = (char *)calloc(1, MESSAGE_BACKUP_SIZE);
   if (m->buffer == NULL) {
     goto m_m_error_out;
   }
 
+  m->blocking = false;
+  m->respond = DELAY;
   return m;
 
 m_m_error_out:
@@ -59,8 +48,9 @@ void message_destroy(struct message **pm) {
   *pm = NULL;
 }
 
-void message_set(struct message *msg, const char *m, const bool blocking) {
-  assert_not_null(2, msg, m);
+void message_set(struct lily_world *w, const char *m, const bool blocking) {
+  assert_not_null(3, w, w->message, m);
+  struct message *msg = w->message;
   msg->blocking = blocking;
 
   size_t len = strnlen(m, MAX_MESSAGE_LEN);
@@ -69,7 +59,7 @@ void message_set(struct message *msg, const char *m, const bool blocking) {
   // if the previous message is empty AND the current message is empty, do *not*
   // play the sound effect
   if (strnlen(msg->m, 1) > 0 || min_len > 0) {
-    sound_play(SOUND_MESSAGE, CHANNEL_UI);
+    sound_play(w, SOUND_MESSAGE, CHANNEL_UI);
   }
 
   strlcpy(msg->m, m, min_len + 1);
@@ -77,7 +67,7 @@ void message_set(struct message *msg, const char *m, const bool blocking) {
   // if messager is longer than what msg->m can hold, buffer the rest of the
   // message
   if (min_len < len) {
-    strlcat(msg->m, CONTINUE_MSG, MESSAGE_BUFFER_LEN + CONTINUE_MSG_LEN + 1);
+    strlcat(msg->m, CONTINUE_MSG, MESSAGE_M_SIZE);
     strlcpy(msg->buffer, m + min_len, MAX_MESSAGE_LEN + 1);
   }
 }
@@ -92,14 +82,14 @@ bool message_block(const struct message *msg) {
   return strnlen(msg->m, 1) > 0;
 }
 
-void message_iterate(struct message *msg, const bool pressed) {
-  static Sint64 respond = DELAY;
+void message_iterate(struct lily_world *w, const bool pressed) {
+  assert_not_null(2, w, w->message);
+  struct message *msg = w->message;
 
-  const Uint64 dt = fps_frame_time();
-  respond -= dt;
+  msg->respond -= (Sint64)w->dt;
 
-  if (respond <= 0 && pressed) {
-    respond = DELAY;
+  if (msg->respond <= 0 && pressed) {
+    msg->respond = DELAY;
     bool buffer_empty = strnlen(msg->buffer, 1) == 0;
 
     if (!buffer_empty) {
@@ -109,8 +99,7 @@ void message_iterate(struct message *msg, const bool pressed) {
 
       buffer_empty = strnlen(msg->buffer, 1) == 0;
       if (!buffer_empty) {
-        strlcat(msg->m, CONTINUE_MSG,
-                MESSAGE_BUFFER_LEN + CONTINUE_MSG_LEN + 1);
+        strlcat(msg->m, CONTINUE_MSG, MESSAGE_M_SIZE);
       }
     } else {
       strlcpy(msg->m, "", MESSAGE_BUFFER_LEN + 1);
@@ -7,6 +7,23 @@
 // this file contains functionality for rendering and updating the game message
 // (shown at the bottom of the screen)
 
+enum {
+  CONTINUE_MSG_LEN = 6,
+  // Maximum amount of monospaced characters that can fit in one game message,
+  // as we determined experimentally minus the len
+  MESSAGE_BUFFER_LEN = 146,
+  // The maximum messages we can deliver to the user in one go. After 4 messages
+  // in one go, it gets a bit tedious for a game.
+  MAX_MESSAGE_LEN = MESSAGE_BUFFER_LEN * 4,
+  // Number of messages the backup buffer can hold
+  BACKUP_BUFFER_MESSAGES = 3,
+  // MESSAGE_M_SIZE is the size of message.m, including the null terminator
+  MESSAGE_M_SIZE = MESSAGE_BUFFER_LEN + CONTINUE_MSG_LEN + 1,
+  // MESSAGE_BACKUP_SIZE is the size of message.buffer, including the null
+  // terminator
+  MESSAGE_BACKUP_SIZE = MESSAGE_BUFFER_LEN * BACKUP_BUFFER_MESSAGES + 1,
+};
+
 // message is primarily used to store information regarding game messages,
 // rendered with time-outs
 struct message {
@@ -17,8 +34,14 @@ struct message {
   // if blocking is set to true, the game is effectively "paused" until the
   // user dismisses the message
   bool blocking;
+  // respond is the time left, in milliseconds, before the message can be
+  // progressed again
+  Sint64 respond;
 };
 
+// forward declaration, see state.h
+struct lily_world;
+
 // message_create creates a new message with default values, returns NULL on
 // error.
 struct message *message_create(void);
@@ -26,16 +49,16 @@ struct message *message_create(void);
 // message_destroy frees the memory taken up by the message
 void message_destroy(struct message **pm);
 
-// message_iterate updates the timeout value of the message and "progresses" the
-// message if `pressed` is true. This can be a key-press.
-void message_iterate(struct message *msg, const bool pressed);
+// message_iterate updates the timeout value of the message of the world w and
+// "progresses" the message if `pressed` is true. This can be a key-press.
+void message_iterate(struct lily_world *w, const bool pressed);
 
-// message_set sets the current game message. It can be a maximum of
-// MAX_MESSAGE_LEN characters. If it is larger than MESSAGE_BUFFER_LEN
-// characters, the message gets buffered. All characters beyond MAX_MESSAGE_LEN
-// are ignored. Set blocking to true if you want the game to effectively be
-// "paused" while the message is being displayed.
-void message_set(struct message *msg, const char *m, const bool blocking);
+// message_set sets the current game message of the world w. It can be a
+// maximum of MAX_MESSAGE_LEN characters. If it is larger than
+// MESSAGE_BUFFER_LEN characters, the message gets buffered. All characters
+// beyond MAX_MESSAGE_LEN are ignored. Set blocking to true if you want the game
+// to effectively be "paused" while the message is being displayed.
+void message_set(struct lily_world *w, const char *m, const bool blocking);
 
 // message_block returns true if we currently have a message being
 // displayed and we are in "blocking" mode. It returns false otherwise.
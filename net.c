@@ -0,0 +1,547 @@
+#ifndef _WIN32
+// for getaddrinfo
+#define _POSIX_C_SOURCE 200112L
+#endif // _WIN32
+
+#include "net.h"
+
+#include "safe.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif // _WIN32
+
+void net_destroy(struct net_transport **pt) {
+  assert_not_null(2, pt, *pt);
+  (*pt)->destroy(*pt);
+  *pt = NULL;
+}
+
+// ---------------
+// -- loopback --
+// ---------------
+
+// datagram is a datagram in flight between the two ends of a loopback pair
+struct datagram {
+  Uint64 due; // the tick of the pair at which the datagram can be received
+  size_t len;
+  Uint8 data[NET_MAX_DATAGRAM];
+};
+
+// queue is a ring buffer of the datagrams in flight to one end of a pair
+struct queue {
+  struct datagram *a;
+  size_t cap;
+  size_t start;
+  size_t len;
+};
+
+// pair is the state shared by the two ends of a loopback pair
+struct pair {
+  SDL_mutex *lock; // guards everything below
+  Uint64 clock;    // the number of ticks of the pair
+  Uint32 latency;
+  Uint32 loss_percent;
+  Uint64 rand;           // the state of the pseudo-random number generator
+  struct queue queue[2]; // queue[i] holds the datagrams sent to end i
+  int refs;              // the number of ends not destroyed yet
+};
+
+// loopback is one end of a pair. Its transport must be its first field, so a
+// pointer to the transport is a pointer to the loopback.
+struct loopback {
+  struct net_transport t;
+  struct pair *p;
+  int side; // 0 or 1
+};
+
+// pair_rand returns the next pseudo-random number of the pair, see util_rand
+static Uint32 pair_rand(struct pair *p) {
+  Uint64 z = (p->rand += 0x9E3779B97F4A7C15);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+  return (Uint32)((z ^ (z >> 31)) >> 32);
+}
+
+static int loopback_send(struct net_transport *t, const Uint8 *buf,
+                         const size_t len) {
+  assert_not_null(2, t, buf);
+  assert(len <= NET_MAX_DATAGRAM);
+  struct loopback *l = (struct loopback *)t;
+  struct pair *p = l->p;
+  int ret = 0;
+
+  SDL_LockMutex(p->lock);
+
+  struct queue *q = &p->queue[1 - l->side];
+  if (pair_rand(p) % 100 < p->loss_percent) {
+    goto out; // lost
+  }
+
+  if (q->len == q->cap) {
+    const size_t cap = q->cap == 0 ? 16 : 2 * q->cap;
+    struct datagram *a = malloc(cap * sizeof(struct datagram));
+    if (a == NULL) {
+      LOG_ERROR("could not allocate datagram");
+      ret = -1;
+      goto out;
+    }
+
+    // unwrap the ring buffer into the new one
+    register size_t i;
+    for (i = 0; i < q->len; i++) {
+      a[i] = q->a[(q->start + i) % q->cap];
+    }
+    free(q->a);
+    q->a = a;
+    q->cap = cap;
+    q->start = 0;
+  }
+
+  struct datagram *d = &q->a[(q->start + q->len) % q->cap];
+  d->due = p->clock + p->latency;
+  d->len = len;
+  memcpy(d->data, buf, len);
+  q->len++;
+
+out:
+  SDL_UnlockMutex(p->lock);
+  return ret;
+}
+
+static long loopback_recv(struct net_transport *t, Uint8 *buf,
+                          const size_t len) {
+  assert_not_null(2, t, buf);
+  struct loopback *l = (struct loopback *)t;
+  struct pair *p = l->p;
+  long ret = 0;
+
+  SDL_LockMutex(p->lock);
+
+  // every datagram has the same latency, so they are due in order
+  struct queue *q = &p->queue[l->side];
+  if (q->len > 0 && q->a[q->start].due <= p->clock) {
+    const struct datagram *d = &q->a[q->start];
+    const size_t n = SDL_min(len, d->len);
+    memcpy(buf, d->data, n);
+    ret = (long)n;
+    q->start = (q->start + 1) % q->cap;
+    q->len--;
+  }
+
+  SDL_UnlockMutex(p->lock);
+  return ret;
+}
+
+static void loopback_destroy(struct net_transport *t) {
+  struct loopback *l = (struct loopback *)t;
+  struct pair *p = l->p;
+
+  SDL_LockMutex(p->lock);
+  const int refs = --p->refs;
+  SDL_UnlockMutex(p->lock);
+
+  if (refs == 0) {
+    SDL_DestroyMutex(p->lock);
+    free(p->queue[0].a);
+    free(p->queue[1].a);
+    free(p);
+  }
+  free(l);
+}
+
+int net_loopback_create(struct net_transport **pa, struct net_transport **pb,
+                        const Uint32 latency, const Uint32 loss_percent,
+                        const Uint64 seed) {
+  assert_not_null(2, pa, pb);
+
+  struct pair *p = calloc(1, sizeof(struct pair));
+  struct loopback *a = calloc(1, sizeof(struct loopback));
+  struct loopback *b = calloc(1, sizeof(struct loopback));
+  if (p == NULL || a == NULL || b == NULL) {
+    LOG_ERROR("could not allocate loopback transport");
+    goto error_out;
+  }
+
+  p->lock = SDL_CreateMutex();
+  if (p->lock == NULL) {
+    LOG_ERROR("could not create mutex: %s", SDL_GetError());
+    goto error_out;
+  }
+
+  p->latency = latency;
+  p->loss_percent = loss_percent;
+  p->rand = seed;
+  p->refs = 2;
+
+  const struct net_transport t = {loopback_send, loopback_recv,
+                                  loopback_destroy};
+  a->t = t;
+  a->p = p;
+  a->side = 0;
+  b->t = t;
+  b->p = p;
+  b->side = 1;
+
+  *pa = &a->t;
+  *pb = &b->t;
+  return 0;
+
+error_out:
+  free(p);
+  free(a);
+  free(b);
+  return -1;
+}
+
+void net_loopback_tick(struct net_transport *t) {
+  assert_not_null(1, t);
+  assert(t->send == loopback_send); // t is a loopback transport
+  struct pair *p = ((struct loopback *)t)->p;
+
+  SDL_LockMutex(p->lock);
+  p->clock++;
+  SDL_UnlockMutex(p->lock);
+}
+
+// ---------
+// -- UDP --
+// ---------
+
+#ifdef _WIN32
+typedef SOCKET socket_t;
+#define close_socket closesocket
+#else
+typedef int socket_t;
+#define INVALID_SOCKET (-1)
+#define close_socket close
+#endif // _WIN32
+
+// udp is a UDP transport. Its transport must be its first field.
+struct udp {
+  struct net_transport t;
+  socket_t fd;
+};
+
+static int udp_send(struct net_transport *t, const Uint8 *buf,
+                    const size_t len) {
+  assert_not_null(2, t, buf);
+  assert(len <= NET_MAX_DATAGRAM);
+  struct udp *u = (struct udp *)t;
+
+  if (send(u->fd, (const char *)buf, (int)len, 0) < 0) {
+#ifdef _WIN32
+    const int err = WSAGetLastError();
+    if (err == WSAEWOULDBLOCK || err == WSAECONNRESET) {
+      return 0; // dropped, like any datagram can be
+    }
+#else
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ECONNREFUSED) {
+      return 0; // dropped, like any datagram can be
+    }
+#endif // _WIN32
+    LOG_ERROR("could not send datagram");
+    return -1;
+  }
+
+  return 0;
+}
+
+static long udp_recv(struct net_transport *t, Uint8 *buf, const size_t len) {
+  assert_not_null(2, t, buf);
+  struct udp *u = (struct udp *)t;
+
+  const long n = recv(u->fd, (char *)buf, (int)len, 0);
+  if (n < 0) {
+    // the remote peer may not be listening yet, which is reported as a
+    // refused connection
+#ifdef _WIN32
+    const int err = WSAGetLastError();
+    if (err == WSAEWOULDBLOCK || err == WSAECONNRESET || err == WSAEMSGSIZE) {
+      return err == WSAEMSGSIZE ? (long)len : 0;
+    }
+#else
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ECONNREFUSED) {
+      return 0;
+    }
+#endif // _WIN32
+    LOG_ERROR("could not receive datagram");
+    return -1;
+  }
+
+  return n;
+}
+
+static void udp_destroy(struct net_transport *t) {
+  struct udp *u = (struct udp *)t;
+  close_socket(u->fd);
+  free(u);
+#ifdef _WIN32
+  WSACleanup();
+#endif // _WIN32
+}
+
+// set_non_blocking makes the socket fd non-blocking. Returns 0 on success, -1
+// on failure.
+static int set_non_blocking(socket_t fd) {
+#ifdef _WIN32
+  u_long mode = 1;
+  return ioctlsocket(fd, FIONBIO, &mode) == 0 ? 0 : -1;
+#else
+  const int flags = fcntl(fd, F_GETFL, 0);
+  return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0 ? 0 : -1;
+#endif // _WIN32
+}
+
+struct net_transport *net_udp_create(const Uint16 port, const char *host,
+                                     const Uint16 remote_port) {
+  assert_not_null(1, host);
+
+#ifdef _WIN32
+  WSADATA data;
+  if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+    LOG_ERROR("could not initialize winsock");
+    return NULL;
+  }
+#endif // _WIN32
+
+  struct udp *u = calloc(1, sizeof(struct udp));
+  if (u == NULL) {
+    LOG_ERROR("could not allocate UDP transport");
+    goto wsa_out;
+  }
+  u->fd = INVALID_SOCKET;
+
+  char service[8];
+  snprintf(service, sizeof(service), "%u", (unsigned int)remote_port);
+
+  struct addrinfo hints, *remote = NULL, *local = NULL;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_DGRAM;
+  if (getaddrinfo(host, service, &hints, &remote) != 0) {
+    LOG_ERROR("could not resolve %s", host);
+    goto error_out;
+  }
+
+  // bind to the local port, with the address family of the remote peer
+  snprintf(service, sizeof(service), "%u", (unsigned int)port);
+  hints.ai_family = remote->ai_family;
+  hints.ai_flags = AI_PASSIVE;
+  if (getaddrinfo(NULL, service, &hints, &local) != 0) {
+    LOG_ERROR("could not resolve the local address");
+    goto error_out;
+  }
+
+  u->fd = socket(remote->ai_family, SOCK_DGRAM, 0);
+  if (u->fd == INVALID_SOCKET) {
+    LOG_ERROR("could not create socket");
+    goto error_out;
+  }
+
+  // connecting a UDP socket sets the peer used by send, and makes recv ignore
+  // datagrams from anyone else
+  if (bind(u->fd, local->ai_addr, (int)local->ai_addrlen) != 0 ||
+      connect(u->fd, remote->ai_addr, (int)remote->ai_addrlen) != 0 ||
+      set_non_blocking(u->fd) != 0) {
+    LOG_ERROR("could not set up the socket for %s:%u", host,
+              (unsigned int)remote_port);
+    goto error_out;
+  }
+
+  freeaddrinfo(remote);
+  freeaddrinfo(local);
+
+  const struct net_transport t = {udp_send, udp_recv, udp_destroy};
+  u->t = t;
+  return &u->t;
+
+error_out:
+  if (u->fd != INVALID_SOCKET) {
+    close_socket(u->fd);
+  }
+  if (remote != NULL) {
+    freeaddrinfo(remote);
+  }
+  if (local != NULL) {
+    freeaddrinfo(local);
+  }
+  free(u);
+wsa_out:
+#ifdef _WIN32
+  WSACleanup();
+#endif // _WIN32
+  return NULL;
+}
+
+// ---------
+// -- TCP --
+// ---------
+
+#ifdef MSG_NOSIGNAL
+// writing to a closed connection must fail instead of raising SIGPIPE
+#define SEND_FLAGS MSG_NOSIGNAL
+#else
+#define SEND_FLAGS 0
+#endif // MSG_NOSIGNAL
+
+// tcp_socket returns the socket of the TCP connection c
+static socket_t tcp_socket(SDL_RWops *c) {
+  return (socket_t)(uintptr_t)c->hidden.unknown.data1;
+}
+
+static Sint64 tcp_size(SDL_RWops *c) {
+  SAFE_UNUSED(c);
+  return SDL_SetError("a TCP connection has no size");
+}
+
+static Sint64 tcp_seek(SDL_RWops *c, Sint64 offset, int whence) {
+  SAFE_UNUSED(c);
+  SAFE_UNUSED(offset);
+  SAFE_UNUSED(whence);
+  return SDL_SetError("cannot seek a TCP connection");
+}
+
+static size_t tcp_read(SDL_RWops *c, void *ptr, size_t size, size_t maxnum) {
+  const size_t len = size * maxnum;
+  size_t n = 0;
+  while (n < len) {
+    const int chunk = (int)SDL_min(len - n, (size_t)1 << 20);
+    const long r = recv(tcp_socket(c), (char *)ptr + n, chunk, 0);
+    if (r <= 0) {
+      break; // closed, or failed
+    }
+    n += (size_t)r;
+  }
+
+  return size == 0 ? 0 : n / size;
+}
+
+static size_t tcp_write(SDL_RWops *c, const void *ptr, size_t size,
+                        size_t num) {
+  const size_t len = size * num;
+  size_t n = 0;
+  while (n < len) {
+    const int chunk = (int)SDL_min(len - n, (size_t)1 << 20);
+    const long r =
+        send(tcp_socket(c), (const char *)ptr + n, chunk, SEND_FLAGS);
+    if (r <= 0) {
+      break; // closed, or failed
+    }
+    n += (size_t)r;
+  }
+
+  return size == 0 ? 0 : n / size;
+}
+
+static int tcp_close(SDL_RWops *c) {
+  close_socket(tcp_socket(c));
+  SDL_FreeRW(c);
+#ifdef _WIN32
+  WSACleanup();
+#endif // _WIN32
+  return 0;
+}
+
+SDL_RWops *net_tcp_open(const char *host, const Uint16 port) {
+#ifdef _WIN32
+  WSADATA data;
+  if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+    LOG_ERROR("could not initialize winsock");
+    return NULL;
+  }
+#endif // _WIN32
+
+  socket_t fd = INVALID_SOCKET, peer = INVALID_SOCKET;
+  SDL_RWops *c = NULL;
+
+  char service[8];
+  snprintf(service, sizeof(service), "%u", (unsigned int)port);
+
+  struct addrinfo hints, *info = NULL;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = host == NULL ? AI_PASSIVE : 0;
+  if (getaddrinfo(host, service, &hints, &info) != 0) {
+    LOG_ERROR("could not resolve %s", host != NULL ? host : "local address");
+    goto error_out;
+  }
+
+  fd = socket(info->ai_family, SOCK_STREAM, 0);
+  if (fd == INVALID_SOCKET) {
+    LOG_ERROR("could not create socket");
+    goto error_out;
+  }
+
+  if (host != NULL) {
+    if (connect(fd, info->ai_addr, (int)info->ai_addrlen) != 0) {
+      LOG_ERROR("could not connect to %s:%u", host, (unsigned int)port);
+      goto error_out;
+    }
+    peer = fd;
+    fd = INVALID_SOCKET;
+  } else {
+    // the port can be listened on again right after a previous connection
+    const int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, (const char *)&yes, sizeof(yes));
+
+    if (bind(fd, info->ai_addr, (int)info->ai_addrlen) != 0 ||
+        listen(fd, 1) != 0) {
+      LOG_ERROR("could not listen on port %u", (unsigned int)port);
+      goto error_out;
+    }
+
+    LOG_INFO("waiting for a connection on port %u", (unsigned int)port);
+    peer = accept(fd, NULL, NULL);
+    if (peer == INVALID_SOCKET) {
+      LOG_ERROR("could not accept a connection on port %u",
+                (unsigned int)port);
+      goto error_out;
+    }
+    close_socket(fd);
+    fd = INVALID_SOCKET;
+  }
+
+  c = SDL_AllocRW();
+  if (c == NULL) {
+    LOG_ERROR("could not allocate TCP connection");
+    goto error_out;
+  }
+
+  c->size = tcp_size;
+  c->seek = tcp_seek;
+  c->read = tcp_read;
+  c->write = tcp_write;
+  c->close = tcp_close;
+  c->type = SDL_RWOPS_UNKNOWN;
+  c->hidden.unknown.data1 = (void *)(uintptr_t)peer;
+
+  freeaddrinfo(info);
+  return c;
+
+error_out:
+  if (fd != INVALID_SOCKET) {
+    close_socket(fd);
+  }
+  if (peer != INVALID_SOCKET) {
+    close_socket(peer);
+  }
+  if (info != NULL) {
+    freeaddrinfo(info);
+  }
+#ifdef _WIN32
+  WSACleanup();
+#endif // _WIN32
+  return NULL;
+}
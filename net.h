@@ -0,0 +1,68 @@
+#ifndef NET_H
+#define NET_H
+
+#include "base.h"
+
+#include <SDL2/SDL.h>
+
+// net contains the transports used to exchange datagrams with a remote peer
+// (see netplay.h). A transport is unreliable: datagrams may be lost, or
+// received out of order, and the user of the transport has to deal with it.
+// Every transport is non-blocking.
+//
+// Two transports are provided: UDP, to play over the network, and loopback, an
+// in-process pair of transports with a simulated latency and loss, to test
+// netplay deterministically without any network.
+//
+// A reliable byte stream over TCP is provided too, for the spectator streams
+// (see stream.h).
+
+enum {
+  // NET_MAX_DATAGRAM is the maximum size of a datagram, in bytes
+  NET_MAX_DATAGRAM = 512,
+};
+
+// net_transport is a transport to a single remote peer
+struct net_transport {
+  // send sends the `len` bytes of buf, at most NET_MAX_DATAGRAM, to the remote
+  // peer. Returns 0 on success (which does not mean the datagram will be
+  // received), -1 on failure.
+  int (*send)(struct net_transport *t, const Uint8 *buf, const size_t len);
+  // recv receives the next pending datagram into buf, which holds `len` bytes.
+  // Returns the size of the datagram, 0 if no datagram is pending, and -1 on
+  // failure. Datagrams larger than len are truncated.
+  long (*recv)(struct net_transport *t, Uint8 *buf, const size_t len);
+  // destroy frees the memory of the transport
+  void (*destroy)(struct net_transport *t);
+};
+
+// net_destroy destroys the transport *pt and sets *pt to NULL
+void net_destroy(struct net_transport **pt);
+
+// net_udp_create creates a UDP transport bound to the local port `port` (any
+// port if 0), exchanging datagrams with the peer at `host` (a host name or an
+// IP address) and `remote_port`. Returns NULL on failure.
+struct net_transport *net_udp_create(const Uint16 port, const char *host,
+                                     const Uint16 remote_port);
+
+// net_loopback_create creates two transports connected to each other,
+// stored in *pa and *pb. Each datagram is delayed by `latency` ticks of the
+// pair (see net_loopback_tick), and a datagram is dropped with a probability
+// of loss_percent / 100. The losses only depend on seed. The pair can be used
+// from two threads. Returns 0 on success, -1 on failure.
+int net_loopback_create(struct net_transport **pa, struct net_transport **pb,
+                        const Uint32 latency, const Uint32 loss_percent,
+                        const Uint64 seed);
+
+// net_loopback_tick advances the clock shared by the loopback pair of t by one
+// tick, making the datagrams that were delayed long enough available
+void net_loopback_tick(struct net_transport *t);
+
+// net_tcp_open opens a TCP connection, as an SDL_RWops whose reads and writes
+// block until every byte is transferred (or the connection is closed, in which
+// case they transfer fewer bytes). If host is not NULL, it connects to `host`
+// (a host name or an IP address) and `port`. Otherwise, it listens on `port`
+// and waits for a single peer to connect. Returns NULL on failure.
+SDL_RWops *net_tcp_open(const char *host, const Uint16 port);
+
+#endif // NET_H
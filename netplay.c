@@ -0,0 +1,350 @@
+#include "netplay.h"
+
+#include "input.h"
+#include "lily.h"
+#include "safe.h"
+#include "snapshot.h"
+
+#include <string.h>
+
+// A datagram holds, in little endian:
+// - NETPLAY_MAGIC (a Uint32)
+// - the tick of the first input in the datagram (a Uint32)
+// - the number of inputs of the receiver the sender has received, which
+//   acknowledges them (a Uint32)
+// - the number of inputs in the datagram (a Uint8)
+// - the inputs of the sender, one per tick from the first one (Uint16 each)
+
+// NETPLAY_MAGIC identifies the datagrams of a netplay session ("LNET")
+static const Uint32 NETPLAY_MAGIC = 0x54454E4C;
+
+enum {
+  HEADER_SIZE = 13,
+  // INPUT_WINDOW is the size of the rings of inputs, a power of two. It is
+  // large enough for every local input the remote peer may not have received,
+  // as neither player can be more than NETPLAY_MAX_ROLLBACK ticks ahead of the
+  // inputs it received from the other.
+  INPUT_WINDOW = 64,
+  // SNAPSHOT_COUNT is the size of the ring of snapshots
+  SNAPSHOT_COUNT = NETPLAY_MAX_ROLLBACK + 1,
+  // INPUT_MASK keeps the valid bits of an input, see input_key
+  INPUT_MASK = (1 << INPUT_KEY_COUNT) - 1,
+};
+
+// NO_TICK means that no prediction was wrong
+static const Uint64 NO_TICK = (Uint64)-1;
+
+// snapshot is a snapshot of the remote world, see snapshot.h
+struct snapshot {
+  Uint8 *buf;
+  size_t len;
+  size_t cap;
+};
+
+struct netplay {
+  struct net_transport *tr;
+  struct lily_world *worlds[NETPLAY_PLAYERS];
+  size_t local;  // the index of the local player
+  size_t remote; // the index of the remote player
+  size_t max_rollback;
+  Uint64 tick; // the number of ticks stepped
+
+  // local_inputs holds the local input of every tick in
+  // [recorded - INPUT_WINDOW, recorded)
+  Uint32 local_inputs[INPUT_WINDOW];
+  Uint64 recorded;
+  // acked is the number of local inputs the remote peer has received
+  Uint64 acked;
+
+  // remote_inputs holds the remote input of the ticks before confirmed, which
+  // is the number of remote inputs received
+  Uint32 remote_inputs[INPUT_WINDOW];
+  Uint64 confirmed;
+  // used holds the remote input the remote world was stepped with, for the
+  // ticks before tick
+  Uint32 used[INPUT_WINDOW];
+  // mispredicted is the first tick whose remote input was predicted wrong, or
+  // NO_TICK
+  Uint64 mispredicted;
+
+  // snapshots[t % SNAPSHOT_COUNT] is the remote world right before the tick
+  // t, for the last ticks whose remote input was not received before they
+  // were stepped
+  struct snapshot snapshots[SNAPSHOT_COUNT];
+
+  struct netplay_stats stats;
+};
+
+static void put32(Uint8 *buf, const Uint32 v) {
+  buf[0] = v & 0xFF;
+  buf[1] = (v >> 8) & 0xFF;
+  buf[2] = (v >> 16) & 0xFF;
+  buf[3] = (v >> 24) & 0xFF;
+}
+
+static Uint32 get32(const Uint8 *buf) {
+  return (Uint32)buf[0] | ((Uint32)buf[1] << 8) | ((Uint32)buf[2] << 16) |
+         ((Uint32)buf[3] << 24);
+}
+
+// remote_input returns the remote input of the tick t: the input received if
+// any, otherwise a prediction, which is the last input received
+static Uint32 remote_input(const struct netplay *n, const Uint64 t) {
+  if (t < n->confirmed) {
+    return n->remote_inputs[t % INPUT_WINDOW];
+  }
+
+  if (n->confirmed == 0) {
+    return INPUT_NONE;
+  }
+
+  return n->remote_inputs[(n->confirmed - 1) % INPUT_WINDOW];
+}
+
+// send_inputs sends the local inputs the remote peer did not acknowledge.
+// Returns 0 on success, -1 on failure.
+static int send_inputs(struct netplay *n) {
+  Uint8 buf[HEADER_SIZE + 2 * INPUT_WINDOW];
+
+  const Uint64 oldest = n->recorded - SDL_min(n->recorded, INPUT_WINDOW);
+  const Uint64 first = SDL_max(n->acked, oldest);
+  const size_t count = n->recorded - first;
+
+  put32(buf, NETPLAY_MAGIC);
+  put32(buf + 4, (Uint32)first);
+  put32(buf + 8, (Uint32)n->confirmed);
+  buf[12] = (Uint8)count;
+
+  register size_t i;
+  for (i = 0; i < count; i++) {
+    const Uint32 in = n->local_inputs[(first + i) % INPUT_WINDOW];
+    buf[HEADER_SIZE + 2 * i] = in & 0xFF;
+    buf[HEADER_SIZE + 2 * i + 1] = (in >> 8) & 0xFF;
+  }
+
+  return n->tr->send(n->tr, buf, HEADER_SIZE + 2 * count);
+}
+
+// receive processes a datagram from the remote peer
+static void receive(struct netplay *n, const Uint8 *buf, const size_t len) {
+  if (len < HEADER_SIZE || get32(buf) != NETPLAY_MAGIC ||
+      len != HEADER_SIZE + 2 * (size_t)buf[12]) {
+    LOG_INFO_VERBOSE("ignoring invalid datagram");
+    return;
+  }
+
+  const Uint64 first = get32(buf + 4);
+  const Uint64 ack = get32(buf + 8);
+  const size_t count = buf[12];
+
+  if (ack > n->acked && ack <= n->recorded) {
+    n->acked = ack;
+  }
+
+  // the remote inputs are only kept in order, so any inputs after a gap
+  // (i.e a lost datagram) are dropped, to be sent again
+  register size_t i;
+  for (i = 0; i < count; i++) {
+    const Uint64 t = first + i;
+    if (t < n->confirmed) {
+      continue;
+    }
+    if (t > n->confirmed ||
+        t >= n->tick + INPUT_WINDOW - NETPLAY_MAX_ROLLBACK - 1) {
+      break;
+    }
+
+    const Uint8 *p = buf + HEADER_SIZE + 2 * i;
+    const Uint32 in = ((Uint32)p[0] | ((Uint32)p[1] << 8)) & INPUT_MASK;
+    n->remote_inputs[t % INPUT_WINDOW] = in;
+    n->confirmed++;
+
+    if (t < n->tick && n->used[t % INPUT_WINDOW] != in) {
+      n->mispredicted = SDL_min(n->mispredicted, t);
+    }
+  }
+}
+
+// save saves the remote world into the snapshot of the tick t. Returns 0 on
+// success, -1 on failure.
+static int save(struct netplay *n, const Uint64 t) {
+  struct snapshot *s = &n->snapshots[t % SNAPSHOT_COUNT];
+  const struct lily_world *w = n->worlds[n->remote];
+
+  s->len = snapshot_save(w, s->buf, s->cap);
+  if (s->len > s->cap) {
+    Uint8 *buf = realloc(s->buf, s->len);
+    if (buf == NULL) {
+      LOG_ERROR("could not allocate snapshot");
+      return -1;
+    }
+    s->buf = buf;
+    s->cap = s->len;
+    snapshot_save(w, s->buf, s->cap);
+  }
+
+  return 0;
+}
+
+// step_remote steps the remote world through the tick t. Returns 0 on success,
+// -1 on failure.
+static int step_remote(struct netplay *n, const Uint64 t) {
+  // the state before a tick whose input is a prediction may be needed again
+  if (t >= n->confirmed && save(n, t) != 0) {
+    return -1;
+  }
+
+  const Uint32 in = remote_input(n, t);
+  n->used[t % INPUT_WINDOW] = in;
+  return lily_world_step(n->worlds[n->remote], in, FRAME_TIME);
+}
+
+// rollback restores the remote world to the first mispredicted tick, and
+// simulates it again up to the current tick. Returns 0 on success, -1 on
+// failure.
+static int rollback(struct netplay *n) {
+  const Uint64 from = n->mispredicted;
+  n->mispredicted = NO_TICK;
+
+  // waiting in netplay_step guarantees the snapshot is still in the ring
+  assert(n->tick - from <= n->max_rollback);
+  const struct snapshot *s = &n->snapshots[from % SNAPSHOT_COUNT];
+  if (snapshot_load(n->worlds[n->remote], s->buf, s->len) != 0) {
+    LOG_ERROR("could not roll back to tick %llu", (unsigned long long)from);
+    return -1;
+  }
+
+  // the snapshot of the tick `from` was just loaded, it is still valid
+  const Uint32 in = remote_input(n, from);
+  n->used[from % INPUT_WINDOW] = in;
+  if (lily_world_step(n->worlds[n->remote], in, FRAME_TIME) != 0) {
+    return -1;
+  }
+
+  register Uint64 t;
+  for (t = from + 1; t < n->tick; t++) {
+    if (step_remote(n, t) != 0) {
+      return -1;
+    }
+  }
+
+  const Uint64 depth = n->tick - from;
+  n->stats.rollbacks++;
+  n->stats.resimulated += depth;
+  n->stats.max_depth = SDL_max(n->stats.max_depth, depth);
+  return 0;
+}
+
+struct netplay *netplay_create(struct level_template *t, const Uint64 seed,
+                               const size_t local, struct net_transport *tr,
+                               const size_t max_rollback) {
+  assert_not_null(2, t, tr);
+  assert(local < NETPLAY_PLAYERS);
+  assert(max_rollback > 0 && max_rollback <= NETPLAY_MAX_ROLLBACK);
+
+  struct netplay *n = calloc(1, sizeof(struct netplay));
+  if (n == NULL) {
+    LOG_ERROR("could not allocate netplay session");
+    net_destroy(&tr);
+    return NULL;
+  }
+
+  n->tr = tr;
+  n->local = local;
+  n->remote = 1 - local;
+  n->max_rollback = max_rollback;
+  n->mispredicted = NO_TICK;
+
+  register size_t i;
+  for (i = 0; i < NETPLAY_PLAYERS; i++) {
+    n->worlds[i] = lily_world_create();
+    if (n->worlds[i] == NULL) {
+      netplay_destroy(&n);
+      return NULL;
+    }
+
+    lily_world_seed(n->worlds[i], seed);
+    if (lily_world_load_level_template(n->worlds[i], t) != 0) {
+      netplay_destroy(&n);
+      return NULL;
+    }
+  }
+
+  return n;
+}
+
+void netplay_destroy(struct netplay **pn) {
+  assert_not_null(2, pn, *pn);
+  struct netplay *n = *pn;
+
+  register size_t i;
+  for (i = 0; i < NETPLAY_PLAYERS; i++) {
+    if (n->worlds[i] != NULL) {
+      lily_world_destroy(&n->worlds[i]);
+    }
+  }
+
+  for (i = 0; i < SNAPSHOT_COUNT; i++) {
+    free(n->snapshots[i].buf);
+  }
+
+  net_destroy(&n->tr);
+  free(n);
+  *pn = NULL;
+}
+
+int netplay_step(struct netplay *n, const Uint32 input) {
+  assert_not_null(1, n);
+
+  Uint8 buf[NET_MAX_DATAGRAM];
+  long len;
+  while ((len = n->tr->recv(n->tr, buf, sizeof(buf))) > 0) {
+    receive(n, buf, len);
+  }
+
+  if (len < 0) {
+    return -1;
+  }
+
+  n->stats.confirmed = n->confirmed;
+
+  if (n->mispredicted < n->tick && rollback(n) != 0) {
+    return -1;
+  }
+
+  // predicting more than max_rollback ticks would leave the snapshot to roll
+  // back to out of the ring, so wait for the remote inputs instead
+  if (n->tick - n->confirmed >= n->max_rollback) {
+    n->stats.waits++;
+    // the remote peer may be waiting for lost inputs too
+    return send_inputs(n) == 0 ? NETPLAY_WAITING : -1;
+  }
+
+  n->local_inputs[n->tick % INPUT_WINDOW] = input & INPUT_MASK;
+  n->recorded = n->tick + 1;
+  if (send_inputs(n) != 0) {
+    return -1;
+  }
+
+  if (lily_world_step(n->worlds[n->local], input & INPUT_MASK, FRAME_TIME) !=
+          0 ||
+      step_remote(n, n->tick) != 0) {
+    return -1;
+  }
+
+  n->tick++;
+  n->stats.ticks = n->tick;
+  return NETPLAY_STEPPED;
+}
+
+const struct lily_world *netplay_world(const struct netplay *n,
+                                       const size_t player) {
+  assert_not_null(1, n);
+  assert(player < NETPLAY_PLAYERS);
+  return n->worlds[player];
+}
+
+void netplay_stats(const struct netplay *n, struct netplay_stats *st) {
+  assert_not_null(2, n, st);
+  *st = n->stats;
+}
@@ -0,0 +1,83 @@
+#ifndef NETPLAY_H
+#define NETPLAY_H
+
+#include "base.h"
+
+#include "level_template.h"
+#include "net.h"
+#include <stdbool.h>
+
+// netplay runs a race between two players on two computers: each player plays
+// the same level in their own world, and sees the other player's world too.
+// Only the inputs of the players are exchanged (see net.h), once per tick. As
+// lily_world_step is deterministic, both computers then simulate the exact
+// same worlds.
+//
+// Latency is hidden by rollback. The local player's world is stepped right
+// away with the local input. The remote player's world is stepped with a
+// prediction of the remote input (the last input received), and a snapshot
+// of it (see snapshot.h) is taken before every such tick. When the actual
+// input of a past tick arrives and differs from the prediction, the remote
+// world is restored to that tick and re-simulated up to the present with the
+// actual inputs. At
+// most `max_rollback` ticks are ever predicted: if the remote inputs are
+// late by more than that, netplay_step waits for them instead of stepping.
+//
+// Each datagram holds the local inputs of every tick that the remote peer has
+// not acknowledged yet, so lost datagrams are made up for by the next ones.
+
+enum {
+  NETPLAY_PLAYERS = 2,
+  // NETPLAY_MAX_ROLLBACK is the maximum value of max_rollback
+  NETPLAY_MAX_ROLLBACK = 16,
+  // netplay_step return values, see netplay_step
+  NETPLAY_STEPPED = 0,
+  NETPLAY_WAITING = 1,
+};
+
+// netplay is a netplay session
+struct netplay;
+
+// netplay_stats are statistics on a netplay session
+struct netplay_stats {
+  Uint64 ticks;     // the number of ticks stepped
+  Uint64 confirmed; // the number of ticks whose remote input was received
+  Uint64 waits;     // the number of times netplay_step waited
+  Uint64 rollbacks; // the number of mispredictions rolled back
+  // resimulated is the total number of ticks simulated again by rollbacks
+  Uint64 resimulated;
+  // max_depth is the largest number of ticks simulated again by a rollback
+  Uint64 max_depth;
+};
+
+// netplay_create starts a session on the level template t, with worlds seeded
+// with seed (see lily_world_seed), which must be the same for both players.
+// `local` is the index of the local player (0 or 1), the remote player being
+// the other one. The session takes ownership of the transport tr. max_rollback
+// is at most NETPLAY_MAX_ROLLBACK. Returns NULL on failure, in which case tr
+// is destroyed too.
+struct netplay *netplay_create(struct level_template *t, const Uint64 seed,
+                               const size_t local, struct net_transport *tr,
+                               const size_t max_rollback);
+
+// netplay_destroy ends the session, destroying its transport, and sets *pn to
+// NULL
+void netplay_destroy(struct netplay **pn);
+
+// netplay_step receives the pending inputs of the remote player, rolls back
+// if any prediction was wrong, and steps both worlds by one tick with the
+// local input `input` (see input.h). Returns NETPLAY_STEPPED on success,
+// NETPLAY_WAITING if the tick could not be stepped because the remote inputs
+// are too late (in which case input is ignored, and netplay_step should be
+// called again in the next frame), and -1 on failure.
+int netplay_step(struct netplay *n, const Uint32 input);
+
+// netplay_world returns the world of the player `player`. The world of the
+// remote player is a prediction from the last netplay_stats.confirmed tick.
+const struct lily_world *netplay_world(const struct netplay *n,
+                                       const size_t player);
+
+// netplay_stats populates st with the statistics of the session
+void netplay_stats(const struct netplay *n, struct netplay_stats *st);
+
+#endif // NETPLAY_H
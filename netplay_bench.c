@@ -0,0 +1,134 @@
+#include "netplay.h"
+
+#include "default_levels.h"
+#include "input.h"
+#include "lily.h"
+#include "safe.h"
+#include <stdio.h>
+
+// netplay_bench measures the cost of rollback (see netplay.h) on the first and
+// the last level of the game. Two peers are connected by a loopback transport
+// with a latency of BENCH_LATENCY ticks, and the remote input changes at every
+// tick, so nearly every tick rolls back BENCH_LATENCY ticks. The cost of a
+// tick is compared to stepping both worlds offline, and to the frame budget.
+// Run it with `make bench`.
+
+enum {
+  BENCH_LATENCY = 8, // ticks
+  BENCH_TICKS = 2000,
+};
+
+// input returns a pseudo-random input for the player p at the tick t
+static Uint32 input(const size_t p, const Uint64 t) {
+  static const Uint32 INPUTS[] = {INPUT_LEFT, INPUT_RIGHT,
+                                  INPUT_RIGHT | INPUT_JUMP, INPUT_JUMP};
+
+  Uint64 z = t * 0x9E3779B97F4A7C15 + p;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+  return INPUTS[(z ^ (z >> 31)) % (sizeof(INPUTS) / sizeof(INPUTS[0]))];
+}
+
+// offline returns the time to step two worlds by one tick, in microseconds
+static double offline(struct level_template *t) {
+  struct lily_world *w[NETPLAY_PLAYERS];
+  register size_t i, p;
+  for (p = 0; p < NETPLAY_PLAYERS; p++) {
+    w[p] = lily_world_create();
+    if (w[p] == NULL || lily_world_load_level_template(w[p], t) != 0) {
+      return -1;
+    }
+  }
+
+  const Uint64 start = SDL_GetPerformanceCounter();
+  for (i = 0; i < BENCH_TICKS; i++) {
+    for (p = 0; p < NETPLAY_PLAYERS; p++) {
+      if (lily_world_step(w[p], input(p, i), FRAME_TIME) != 0) {
+        return -1;
+      }
+    }
+  }
+  const double seconds = (double)(SDL_GetPerformanceCounter() - start) /
+                         SDL_GetPerformanceFrequency();
+
+  for (p = 0; p < NETPLAY_PLAYERS; p++) {
+    lily_world_destroy(&w[p]);
+  }
+
+  return seconds * 1e6 / BENCH_TICKS;
+}
+
+// run runs the benchmark on the level `index`. Returns 0 on success, -1 on
+// failure.
+static int run(const size_t index) {
+  struct level_template *t = level_template_get(
+      LEVELS[index], LEVEL_TOKENS[index], LEVEL_TOKENS_COUNT[index]);
+  if (t == NULL) {
+    return -1;
+  }
+
+  struct net_transport *ta, *tb;
+  if (net_loopback_create(&ta, &tb, BENCH_LATENCY, 0, 0) != 0) {
+    level_template_release(&t);
+    return -1;
+  }
+
+  struct net_transport *clock = ta;
+  struct netplay *n[NETPLAY_PLAYERS];
+  n[0] = netplay_create(t, 0, 0, ta, NETPLAY_MAX_ROLLBACK);
+  n[1] = netplay_create(t, 0, 1, tb, NETPLAY_MAX_ROLLBACK);
+  if (n[0] == NULL || n[1] == NULL) {
+    level_template_release(&t);
+    return -1;
+  }
+
+  // only the steps of the first peer are timed
+  Uint64 elapsed = 0;
+  struct netplay_stats st[NETPLAY_PLAYERS];
+  int ret = 0;
+  do {
+    register size_t p;
+    for (p = 0; p < NETPLAY_PLAYERS && ret == 0; p++) {
+      netplay_stats(n[p], &st[p]);
+      const Uint64 start = SDL_GetPerformanceCounter();
+      ret = netplay_step(n[p], input(p, st[p].ticks)) < 0 ? -1 : 0;
+      if (p == 0) {
+        elapsed += SDL_GetPerformanceCounter() - start;
+      }
+      netplay_stats(n[p], &st[p]);
+    }
+    net_loopback_tick(clock);
+  } while (ret == 0 && st[0].ticks < BENCH_TICKS);
+
+  const double us = (double)elapsed * 1e6 / SDL_GetPerformanceFrequency() /
+                    (double)st[0].ticks;
+  const double base = offline(t);
+  if (ret == 0 && base >= 0) {
+    printf("%s\n", LEVELS[index]);
+    printf("  offline: %8.1f us per tick\n", base);
+    printf("  netplay: %8.1f us per tick (%.1f%% of a %d ms frame), "
+           "%llu rollbacks, %.1f ticks deep on average (max %llu)\n",
+           us, us / (10.0 * FRAME_TIME), FRAME_TIME,
+           (unsigned long long)st[0].rollbacks,
+           (double)st[0].resimulated / SDL_max(st[0].rollbacks, 1),
+           (unsigned long long)st[0].max_depth);
+  }
+
+  netplay_destroy(&n[0]);
+  netplay_destroy(&n[1]);
+  level_template_release(&t);
+  return ret == 0 && base >= 0 ? 0 : -1;
+}
+
+int main(int argc, char *argv[]) {
+  SAFE_UNUSED(argc);
+  SAFE_UNUSED(argv);
+
+  int ret = 0;
+  if (run(0) != 0 || run(LEVEL_COUNT - 1) != 0) {
+    ret = 1;
+  }
+
+  level_template_cache_clear();
+  return ret;
+}
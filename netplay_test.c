@@ -0,0 +1,212 @@
+#include "netplay.h"
+
+#include "input.h"
+#include "lily.h"
+#include "snapshot.h"
+#include "test.h"
+#include "util.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const struct token_entry TOKENS[] = {
+    {'=', SPRITE_WALL_TOP, token_passive_sprite},
+    {'*', SPRITE_WALL, token_passive_sprite},
+    {'s', SPRITE_SPIDER, token_active_sprite},
+    {'G', SPRITE_GHOST, token_active_sprite},
+    {'O', SPRITE_COIN, token_active_sprite},
+    {'P', SPRITE_PLAYER, token_player},
+    {' ', SPRITE_NONE, NULL}};
+
+static const size_t TOKEN_SIZE = 7;
+
+// spiders move randomly, so the worlds only stay in sync if they are seeded
+// the same
+static const char LEVEL[] = "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "        =====       \n"
+                            "                    \n"
+                            " s   P O   s    G   \n"
+                            "====================\n"
+                            "********************";
+
+enum {
+  SEED = 42,
+  MAX_ROLLBACK = 8,
+  // the players play INPUT_TICKS ticks, then let go of every key
+  INPUT_TICKS = 400,
+  TICKS = INPUT_TICKS + 60,
+  BUFFER_SIZE = 1 << 16,
+};
+
+static struct level_template *template(void) {
+  char *str;
+  size_t w, h;
+  assert(util_level_from_buffer(LEVEL, sizeof(LEVEL) - 1, &str, &w, &h) > 0);
+
+  struct level_template *t =
+      level_template_from_string(str, w, h, TOKENS, TOKEN_SIZE);
+  assert(t != NULL);
+  free(str);
+  return t;
+}
+
+// input returns the input of the player p at the tick t. It changes every few
+// ticks, so the remote inputs are often predicted wrong.
+static Uint32 input(const size_t p, const Uint64 t) {
+  static const Uint32 INPUTS[] = {
+      INPUT_NONE,         INPUT_LEFT,  INPUT_RIGHT | INPUT_JUMP,
+      INPUT_RIGHT,        INPUT_JUMP,  INPUT_LEFT | INPUT_SHORT_JUMP,
+      INPUT_RIGHT | INPUT_SPRINT};
+
+  if (t >= INPUT_TICKS) {
+    return INPUT_NONE;
+  }
+
+  Uint64 z = (t / 5) * 0x9E3779B97F4A7C15 + p;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+  return INPUTS[(z ^ (z >> 31)) % (sizeof(INPUTS) / sizeof(INPUTS[0]))];
+}
+
+// same asserts that the world w is in the state of a world stepped `ticks`
+// times, offline, with the inputs of the player p
+static void same(struct level_template *t, const struct lily_world *w,
+                 const size_t p, const Uint64 ticks) {
+  static Uint8 a[BUFFER_SIZE], b[BUFFER_SIZE];
+
+  struct lily_world *ref = lily_world_create();
+  assert(ref != NULL);
+  lily_world_seed(ref, SEED);
+  assert(lily_world_load_level_template(ref, t) == 0);
+
+  register Uint64 i;
+  for (i = 0; i < ticks; i++) {
+    assert(lily_world_step(ref, input(p, i), FRAME_TIME) == 0);
+  }
+
+  const size_t n = snapshot_save(ref, a, BUFFER_SIZE);
+  assert(n <= BUFFER_SIZE);
+  assert(snapshot_save(w, b, BUFFER_SIZE) == n);
+  assert(memcmp(a, b, n) == 0);
+
+  lily_world_destroy(&ref);
+}
+
+// two peers connected by a slow and lossy transport end up in the same state
+// as the players would offline
+static void test_sync(void) {
+  struct level_template *t = template();
+  struct net_transport *ta, *tb;
+  assert(net_loopback_create(&ta, &tb, 4, 20, 7) == 0);
+
+  struct net_transport *clock = ta;
+  struct netplay *n[NETPLAY_PLAYERS];
+  n[0] = netplay_create(t, SEED, 0, ta, MAX_ROLLBACK);
+  n[1] = netplay_create(t, SEED, 1, tb, MAX_ROLLBACK);
+  assert(n[0] != NULL && n[1] != NULL);
+
+  struct netplay_stats st[NETPLAY_PLAYERS];
+  do {
+    register size_t p;
+    for (p = 0; p < NETPLAY_PLAYERS; p++) {
+      netplay_stats(n[p], &st[p]);
+      assert(netplay_step(n[p], input(p, st[p].ticks)) >= 0);
+      netplay_stats(n[p], &st[p]);
+    }
+    net_loopback_tick(clock);
+  } while (st[0].ticks < TICKS || st[1].ticks < TICKS);
+
+  register size_t p, q;
+  for (p = 0; p < NETPLAY_PLAYERS; p++) {
+    // wrong predictions were rolled back, but never by too many ticks
+    assert(st[p].rollbacks > 0);
+    assert(st[p].max_depth > 0 && st[p].max_depth <= MAX_ROLLBACK);
+
+    // the players let go of every key long enough ago that every prediction
+    // is right
+    for (q = 0; q < NETPLAY_PLAYERS; q++) {
+      same(t, netplay_world(n[p], q), q, st[p].ticks);
+    }
+  }
+
+  netplay_destroy(&n[0]);
+  netplay_destroy(&n[1]);
+  assert(n[0] == NULL);
+  level_template_release(&t);
+}
+
+// a peer that gets no inputs predicts at most max_rollback ticks, then waits
+static void test_wait(void) {
+  struct level_template *t = template();
+  struct net_transport *ta, *tb;
+  assert(net_loopback_create(&ta, &tb, 0, 0, 0) == 0);
+
+  struct netplay *n = netplay_create(t, SEED, 0, ta, MAX_ROLLBACK);
+  assert(n != NULL);
+
+  register size_t i;
+  for (i = 0; i < MAX_ROLLBACK; i++) {
+    assert(netplay_step(n, INPUT_RIGHT) == NETPLAY_STEPPED);
+  }
+  assert(netplay_step(n, INPUT_RIGHT) == NETPLAY_WAITING);
+  assert(netplay_step(n, INPUT_RIGHT) == NETPLAY_WAITING);
+
+  struct netplay_stats st;
+  netplay_stats(n, &st);
+  assert(st.ticks == MAX_ROLLBACK);
+  assert(st.confirmed == 0);
+  assert(st.waits == 2);
+
+  // the inputs were sent every time, even while waiting
+  Uint8 buf[NET_MAX_DATAGRAM];
+  size_t count = 0;
+  while (tb->recv(tb, buf, sizeof(buf)) > 0) {
+    count++;
+  }
+  assert(count == MAX_ROLLBACK + 2);
+
+  net_destroy(&tb);
+  netplay_destroy(&n);
+  level_template_release(&t);
+}
+
+// datagrams go through UDP on the local host
+static void test_udp(void) {
+  struct net_transport *a = net_udp_create(47601, "127.0.0.1", 47602);
+  struct net_transport *b = net_udp_create(47602, "127.0.0.1", 47601);
+  assert(a != NULL && b != NULL);
+
+  Uint8 buf[NET_MAX_DATAGRAM];
+  assert(b->recv(b, buf, sizeof(buf)) == 0); // nothing was sent yet
+
+  const Uint8 msg[] = "lily";
+  assert(a->send(a, msg, sizeof(msg)) == 0);
+
+  long n = 0;
+  register size_t i;
+  for (i = 0; i < 1000 && n == 0; i++) {
+    n = b->recv(b, buf, sizeof(buf));
+    SDL_Delay(1);
+  }
+  assert(n == sizeof(msg));
+  assert(memcmp(buf, msg, sizeof(msg)) == 0);
+
+  net_destroy(&a);
+  net_destroy(&b);
+  assert(a == NULL && b == NULL);
+}
+
+int main(void) {
+  RUN_TEST(test_sync);
+  RUN_TEST(test_wait);
+  RUN_TEST(test_udp);
+  return 0;
+}
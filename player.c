@@ -1,11 +1,11 @@
 #include "player.h"
 
+#include "fixed.h"
+#include "input.h"
 #include "level.h"
 #include "message.h"
 #include "player.h"
-#include "render.h"
 #include "safe.h"
-#include "scene.h"
 #include "sound.h"
 #include "state.h"
 #include "util.h"
@@ -42,20 +42,25 @@ static const Uint64 CHARACTER_DELAY = 1000;
 
 enum { CHARACTER_COUNT = 6 }; // number of choices
 
-// cycle cycles the player sprite tile effectively "changing
-// characters" in the game. index is the character to switch to
-void cycle(struct player *p) {
+void player_character(struct player *p) {
+  assert_not_null(2, p, p->s);
   assert(p->index < CHARACTER_COUNT);
 
-  size_t rows[CHARACTER_COUNT] = {1, 2, 1, 2, 2, 1};
-  size_t cols[CHARACTER_COUNT] = {38, 38, 32, 26, 32, 26};
+  static const size_t ROWS[CHARACTER_COUNT] = {1, 2, 1, 2, 2, 1};
+  static const size_t COLS[CHARACTER_COUNT] = {38, 38, 32, 26, 32, 26};
+
+  // the tile is the sprite's own, as the player's sprite type is shared
+  sprite_type_tile(&p->s->rect, ROWS[p->index], COLS[p->index]);
+}
 
-  struct sprite_type *t = p->s->type;
-  sprite_type_change_tile(t, rows[p->index], cols[p->index]);
+// cycle cycles the player sprite tile effectively "changing
+// characters" in the game. index is the character to switch to
+static void cycle(struct lily_world *w, struct player *p) {
+  player_character(p);
 
   char msg[255];
   sprintf(msg, "Switched player character.");
-  message_set(g_game.message, msg, false);
+  message_set(w, msg, false);
 }
 
 void player_respawn_update(struct player *p) {
@@ -78,22 +83,11 @@ int player_create(struct player *p) {
   p->sprint = false;
   p->index = 0;
 
-  struct fps_timer *t = fps_timer_create(CHARACTER_DELAY);
-  if (t == NULL) {
-    return -1;
-  }
-
-  struct fps_timer *t2 = fps_timer_create(BLINK_TIME);
-  if (t2 == NULL) {
-    free(t);
-    return -1;
-  }
-
-  p->character_timer = t;
-  p->blink_timer = t2;
+  fps_timer_init(&p->character_timer, CHARACTER_DELAY);
+  fps_timer_init(&p->blink_timer, BLINK_TIME);
 
   // no blinking at the very start
-  t2->time_left = 0;
+  p->blink_timer.time_left = 0;
 
   return 0;
 }
@@ -102,16 +96,16 @@ static void player_respawn(struct player *p) {
   assert_not_null(2, p, p->s);
 
   sprite_animation_set_frame(p->s, 0, 0, 0);
-  fps_timer_reset(p->blink_timer);
+  fps_timer_reset(&p->blink_timer);
   p->ladder = false;
   p->air = false;
   p->s->x = p->respawn_x;
   p->s->y = p->respawn_y;
 }
 
-void player_kill(struct player *p) {
+void player_kill(struct lily_world *w, struct player *p) {
   assert_not_null(2, p, p->s);
-  if (!fps_timer_done(p->blink_timer)) {
+  if (!fps_timer_done(&p->blink_timer)) {
     return; // don't kill if the player is blinking
   }
 
@@ -119,46 +113,46 @@ void player_kill(struct player *p) {
   sprite_animation_set_frame(p->s, 5, 5, 0);
 
   // play sound effect
-  sound_play(SOUND_KILL, CHANNEL_PLAYER);
+  sound_play(w, SOUND_KILL, CHANNEL_PLAYER);
 
   if (p->lives != 0) {
     p->lives--;
   }
 
   if (p->lives == 0) {
-    g_prog.state = PROG_GAME_OVER;
+    w->state = PROG_GAME_OVER;
     return;
   }
 
-  g_prog.state = PROG_GAME_KILLED;
+  w->state = PROG_GAME_KILLED;
 
   player_respawn(p);
 }
 
 // process_keys process how individual key presses effect the player
-static void process_keys(struct player *p) {
+static void process_keys(struct lily_world *w, struct player *p) {
   assert_not_null(2, p, p->s);
 
   struct sprite *s = p->s;
-  const Uint8 *k = g_prog.keys;
+  const Uint32 in = w->input;
 
   // -----------------------------
   // -- cycling the player tile --
   // -----------------------------
-  if (k[SDL_SCANCODE_Q] && fps_timer_done(p->character_timer)) {
-    fps_timer_reset(p->character_timer);
+  if ((in & INPUT_CYCLE) && fps_timer_done(&p->character_timer)) {
+    fps_timer_reset(&p->character_timer);
     p->index = (p->index + 1) % CHARACTER_COUNT;
-    cycle(p);
+    cycle(w, p);
   }
 
   // -------------------------
   // -- horizontal movement --
   // -------------------------
-  p->sprint = k[SDL_SCANCODE_SPACE]; // sprint
+  p->sprint = in & INPUT_SPRINT; // sprint
   Sint64 anim_speed = p->sprint ? ANIM_SPRINT : ANIM_WALK;
   double speed = p->sprint ? SPRINT : WALK;
 
-  if (k[SDL_SCANCODE_LEFT]) { // move left
+  if (in & INPUT_LEFT) { // move left
     s->animation.flip = SDL_FLIP_HORIZONTAL;
     s->vx = -speed;
 
@@ -169,7 +163,7 @@ static void process_keys(struct player *p) {
         sprite_animation_set_frame(s, 1, 2, anim_speed);
       }
     }
-  } else if (k[SDL_SCANCODE_RIGHT]) { // move right
+  } else if (in & INPUT_RIGHT) { // move right
     s->animation.flip = SDL_FLIP_NONE;
     s->vx = speed;
 
@@ -193,12 +187,12 @@ static void process_keys(struct player *p) {
   // -- vertical movement --
   // -----------------------
 
-  if (k[SDL_SCANCODE_UP]) { // move up
+  if (in & INPUT_UP) { // move up
     int r, c;
     util_nearest(s, &r, &c);
 
     // if the player is on a ladder
-    if (util_ladder(r, c)) {
+    if (util_ladder(w, r, c)) {
       p->ladder = true;
       s->vy = -LADDER;
       s->x = c * SPRITE_SIZE; // orient the player right on the ladder
@@ -207,12 +201,12 @@ static void process_keys(struct player *p) {
     } else {
       p->ladder = false;
     }
-  } else if (k[SDL_SCANCODE_DOWN]) { // move down
+  } else if (in & INPUT_DOWN) { // move down
     int r, c;
     util_nearest(s, &r, &c);
 
     // if the player is either on a ladder, or right above a ladder
-    if (p->ladder || util_ladder(r + 1, c)) {
+    if (p->ladder || util_ladder(w, r + 1, c)) {
       if (!p->ladder) {
         // get the player a "little bit" on the ladder
         s->y = r * SPRITE_SIZE + (SPRITE_SIZE / 2.0) + 1;
@@ -233,181 +227,87 @@ static void process_keys(struct player *p) {
   }
 
   // Jump or short jump
-  if (!p->air && p->jump && (k[SDL_SCANCODE_Z] || k[SDL_SCANCODE_X])) {
-    bool short_jump = k[SDL_SCANCODE_X];
+  if (!p->air && p->jump && (in & (INPUT_JUMP | INPUT_SHORT_JUMP))) {
+    bool short_jump = in & INPUT_SHORT_JUMP;
     enum sound_id sound = short_jump ? SOUND_SHORT_JUMP : SOUND_JUMP;
     double speed = short_jump ? SHORT_JUMP : JUMP;
 
     // play the sound effect
-    sound_play(sound, CHANNEL_PLAYER);
+    sound_play(w, sound, CHANNEL_PLAYER);
 
     // do the jump
     s->vy = -speed;
   }
 
   // Interact
-  if (k[SDL_SCANCODE_C]) {
+  if (in & INPUT_INTERACT) {
     int r, c;
     util_nearest(s, &r, &c);
 
-    if (util_door(r, c)) {
+    if (util_door(w, r, c)) {
       // play the door open sound effect
-      sound_play(SOUND_DOOR, CHANNEL_SPRITE);
-      g_prog.state = PROG_GAME_LEVEL_COMPLETE;
+      sound_play(w, SOUND_DOOR, CHANNEL_SPRITE);
+      w->state = PROG_GAME_LEVEL_COMPLETE;
     }
   }
 }
 
-void player_iterate(struct player *p) {
-  assert_not_null(2, p, p->s);
-  process_keys(p);
+void player_iterate(struct lily_world *w, struct player *p) {
+  assert_not_null(3, w, p, p->s);
+  process_keys(w, p);
 
   struct sprite *s = p->s;
 
-  fps_timer_iterate(p->character_timer);
-  fps_timer_iterate(p->blink_timer);
+  fps_timer_iterate(&p->character_timer, w->dt);
+  fps_timer_iterate(&p->blink_timer, w->dt);
 
-  // TODO: experiment with making this Uint64 and see how visible the change in
-  // the gameplay is.
-  const Uint64 dt_ms = fps_frame_time();
-  const double dt = dt_ms / 1000.0;
   const double hit = (SPRITE_SIZE - s->type->body.w) / 2.0;
 
-  int r, c;
-  struct borders passive, actual;
-  util_sprite_hints(s, &r, &c, &passive, &actual);
-
   s->vx = util_abs_limit(s->vx, MAX_VELOCITY);
   s->vy = util_abs_limit(s->vy, MAX_VELOCITY);
 
-  // process horizontal movement
-  s->x += s->vx * dt;
-  // new borders based on the horizontal movement for collision testing.
-  struct borders b = {s->x, s->x + SPRITE_SIZE, s->y, s->y + SPRITE_SIZE};
-
-  // -- is moving left okay? --
-
-  // if 1) our new left is more left than our old left, and 2) we are not
-  // moving right.
-  if (b.l < passive.l && s->vx <= 0) {
-    bool left_solid = util_solid(r, c - 1, SOLID_RIGHT);
-    // our top (plus some hit delta) is above the top of the passive sprite
-    // "grid" location we are mapped onto and the top level passive sprite is
-    // solid
-    bool top_left_solid =
-        b.t + hit < passive.t && util_solid(r - 1, c - 1, SOLID_RIGHT);
-
-    // our bottom (minus some hit delta) is below the bottom of the passive
-    // sprite "grid" location we are mapped onto and the bottom left passive
-    // sprite is solid
-    bool bottom_left_solid =
-        (b.b - hit > passive.b) && util_solid(r + 1, c - 1, SOLID_RIGHT);
-
-    if (left_solid || top_left_solid || bottom_left_solid) {
-      s->x = passive.l; // put the player back onto the old "grid" location
-      s->vx = 0;        // stop moving the player left
-    }
-
-    // -- is moving right okay? --
-    // if 1) our new right is more right than our old right, and 2) we are
-    // not moving left
-  } else if (b.r > passive.r && s->vx >= 0) {
-    bool right_solid = util_solid(r, c + 1, SOLID_LEFT);
-    // our top (plus some hit delta) is above the top of the passive sprite
-    // "grid" location we are mapped onto and the top right passive sprite is
-    // solid
-    bool top_right_solid =
-        b.t + hit < passive.t && util_solid(r - 1, c + 1, SOLID_LEFT);
-    // our bottom (minus some hit delta) is below the bottom of the passive
-    // sprite "grid" location we are mapped onto and the bottom right passive
-    // sprite is solid
-    bool bottom_right_solid =
-        b.b - hit > passive.b && util_solid(r + 1, c + 1, SOLID_LEFT);
-
-    if (right_solid || top_right_solid || bottom_right_solid) {
-      s->x = passive.l; // put the player back onto the old "grid" location
-      s->vx = 0;        // stop moving the player right
-    }
+  // process horizontal movement. The player collides with the tiles next to
+  // it, and with the diagonal ones if it overlaps their row by more than hit.
+  if (util_sweep_x(w, s, hit) != COLLISION_NONE) {
+    s->vx = 0; // stop moving the player
   }
 
-  // process vertical movement
-  s->y += s->vy * dt;
-  b = (struct borders){s->x, s->x + SPRITE_SIZE, s->y, s->y + SPRITE_SIZE};
-
-  // -- is moving down okay? --
-  // if 1) our new bottom is bellow our old bottom, and 2) we are not moving up
-  if (b.b > passive.b && s->vy >= 0) {
-    bool bottom_solid = util_solid(r + 1, c, SOLID_TOP);
-
-    // our left (plus some hit delta) is more left than the left of the passive
-    // sprite "grid" location we are mapped onto and the bottom left passive
-    // sprite is solid.
-    bool bottom_left_solid =
-        b.l + hit < passive.l && util_solid(r + 1, c - 1, SOLID_TOP);
-
-    // our right (minus some hit delta) is more right than the right of the
-    // passive sprite "grid" location we are mapped onto and the bottom right
-    // passive sprite is solid.
-    bool bottom_right_solid =
-        b.r - hit > passive.r && util_solid(r + 1, c + 1, SOLID_TOP);
-
-    bool ladder = !p->ladder && util_solid_ladder(r + 1, c);
-
-    if (bottom_solid || bottom_left_solid || bottom_right_solid || ladder) {
-      s->y = passive.t; // put the player back onto the old "grid" location
-      s->vy = 0;        // stop moving the player down
-      // player has touched the "ground", is no longer air-bound
-      p->air = false;
-      if (p->ladder) {
-        // we have reached the bottom of the ladder
-        p->ladder = false;
-        // remove the ladder frame, returning to "walking" mode
-        sprite_animation_set_frame(s, 0, 0, 0);
-      }
-    } else {
-      // if has not touched the "ground" but the player is on a ladder, the
-      // player is not air-bound. Otherwise, the player is air-bound.
-      p->air = !p->ladder;
-    }
+  // process vertical movement. Unless the player is already on one, the top of
+  // a ladder is solid.
+  bool crossed;
+  const enum collision vertical = util_sweep_y(w, s, hit, !p->ladder, &crossed);
 
-    // -- is moving up okay? --
-    // if 1) our new top is above our old top, and 2) we are not moving down
-  } else if (b.t < passive.t && s->vy <= 0) {
-    // we have moved up, if we are not on a ladder, we are air-bound.
+  if (vertical == COLLISION_BOTTOM) {
+    s->vy = 0; // stop moving the player down
+    // player has touched the "ground", is no longer air-bound
+    p->air = false;
+    if (p->ladder) {
+      // we have reached the bottom of the ladder
+      p->ladder = false;
+      // remove the ladder frame, returning to "walking" mode
+      sprite_animation_set_frame(s, 0, 0, 0);
+    }
+  } else if (crossed) {
+    // if the player moved up or fell, and is not on a ladder, it is air-bound
     p->air = !p->ladder;
 
-    // is the passive sprite "grid" location right above us solid?
-    bool top_solid = util_solid(r - 1, c, SOLID_BOTTOM);
-
-    // our left (plus some hit delta) is more left than the left of the
-    // passive sprite "grid" location we are mapped onto and the top left
-    // passive sprite is solid.
-    bool top_left_solid =
-        b.l + hit < passive.l && util_solid(r - 1, c - 1, SOLID_BOTTOM);
-
-    // our right (minus some hit delta) is more right than the right of the
-    // passive sprite "grid" location we are mapped onto and the top right
-    // passive sprite is solid.
-    bool top_right_solid =
-        b.r - hit > passive.r && util_solid(r - 1, c + 1, SOLID_BOTTOM);
-
-    if (top_solid || top_left_solid || top_right_solid) {
-      s->y = passive.t; // put the player back onto the old "grid" location
-      s->vy += 1;       // accelerate the player downwards
+    if (vertical == COLLISION_TOP) {
+      s->vy += 1; // accelerate the player downwards
     }
   }
 
   // -- other movement --
+  int r, c;
   util_nearest(s, &r, &c); // update our passive sprite "grid" location
 
   // implement 2D playformer "gravity"
   if (!p->ladder) {
-    s->vy += GRAVITY * dt;
+    s->vy += fixed_step(GRAVITY, w->dt);
     s->vy = SDL_min(s->vy, FALL_MAX);
   }
 
   // if we were on a ladder, but no longer are on a ladder
-  if (p->ladder && !util_ladder(r, c)) {
+  if (p->ladder && !util_ladder(w, r, c)) {
     p->ladder = false;
     // remove the ladder frame, returning to "walking" mode
     sprite_animation_set_frame(s, 0, 0, 0);
@@ -420,11 +320,11 @@ void player_iterate(struct player *p) {
   }
 
   // blink
-  if (fps_timer_done(p->blink_timer)) {
+  if (fps_timer_done(&p->blink_timer)) {
     return;
   }
 
-  Uint64 blink = p->blink_timer->time_left;
+  Uint64 blink = p->blink_timer.time_left;
   p->s->animation.alpha = 255 * (1 - (blink / BLINK_INTERVAL) % 2);
 }
 
@@ -433,9 +333,6 @@ void player_destroy(struct player **pp) {
   struct player *p = *pp;
   assert_not_null(1, p);
 
-  fps_timer_destroy(&p->blink_timer);
-  fps_timer_destroy(&p->character_timer);
-
   free(p);
   *pp = NULL;
 }
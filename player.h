@@ -24,7 +24,7 @@ struct player {
   // player temporarily (for the duration specified by this variable, in
   // milliseconds) cannot get killed again. This timer handles the delay for
   // blinking.
-  struct fps_timer *blink_timer;
+  struct fps_timer blink_timer;
 
   // Making these unsigned integers for easy conversion to strings, as we will
   // be probably displaying this information to the user in some way.
@@ -41,7 +41,7 @@ struct player {
   // the character index of the player
   size_t index;
   // this timer handles delay between toggling characters, in milliseconds
-  struct fps_timer *character_timer;
+  struct fps_timer character_timer;
 };
 
 // player_create initializes the player. Returns 0 on success, -1 on failure.
@@ -51,11 +51,17 @@ int player_create(struct player *p);
 // current position
 void player_respawn_update(struct player *p);
 
-// player_kill kills the player unless player.blinking is non-zero
-void player_kill(struct player *p);
+// player_character sets the tile of the sprite of the player p to the tile of
+// their character (see player.index)
+void player_character(struct player *p);
 
-// player_iterate processes the player state at each frame
-void player_iterate(struct player *p);
+// player_kill kills the player p of the world w unless player.blinking is
+// non-zero
+void player_kill(struct lily_world *w, struct player *p);
+
+// player_iterate processes the state of the player p of the world w at each
+// frame
+void player_iterate(struct lily_world *w, struct player *p);
 
 // player_destroy frees all memory associated with the player and sets *pp to
 // NULL
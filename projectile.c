@@ -0,0 +1,152 @@
+#include "projectile.h"
+
+#include "event.h"
+#include "fixed.h"
+#include "level.h"
+#include "player.h"
+#include "safe.h"
+#include "state.h"
+#include "util.h"
+
+struct projectile_pool *projectile_pool_create(const size_t cap) {
+  struct projectile_pool *pool = calloc(1, sizeof(struct projectile_pool));
+  if (pool == NULL) {
+    LOG_ERROR("could not allocate projectile pool");
+    return NULL;
+  }
+
+  // a power of two, so that the ring wraps around with a mask
+  pool->cap = 1;
+  while (pool->cap < cap) {
+    pool->cap *= 2;
+  }
+
+  pool->p = calloc(pool->cap, sizeof(struct projectile));
+  if (pool->p == NULL) {
+    LOG_ERROR("could not allocate projectile pool");
+    free(pool);
+    return NULL;
+  }
+
+  return pool;
+}
+
+void projectile_pool_destroy(struct projectile_pool **pp) {
+  assert_not_null(2, pp, *pp);
+  free((*pp)->p);
+  free(*pp);
+  *pp = NULL;
+}
+
+void projectile_pool_clear(struct projectile_pool *pool) {
+  assert_not_null(1, pool);
+  pool->head = 0;
+  pool->count = 0;
+}
+
+// slot returns the slot i of the pool, from the oldest one
+static struct projectile *slot(const struct projectile_pool *pool,
+                               const size_t i) {
+  return &pool->p[(pool->head + i) & (pool->cap - 1)];
+}
+
+struct sprite *projectile_get(const struct projectile_pool *pool,
+                              const size_t i) {
+  assert_not_null(1, pool);
+  assert(i < pool->count);
+  return &slot(pool, i)->s;
+}
+
+// wall returns the x position past which a projectile flying from column c of
+// row r with the velocity vx hits a wall. Like util_move_x does for active
+// sprites, the projectile stops on the last tile before the wall, and the
+// edges of the level are walls.
+static double wall(const struct lily_world *w, const int r, const int c,
+                   const double vx) {
+  const struct solid_map *m = w->level->solids;
+  if (vx > 0) {
+    return SPRITE_SIZE * (solid_map_find(m, r, c + 1, 1, SOLID_LEFT) - 1);
+  }
+
+  return SPRITE_SIZE * (solid_map_find(m, r, c - 1, -1, SOLID_RIGHT) + 1);
+}
+
+struct projectile *projectile_spawn(struct lily_world *w,
+                                    struct projectile_pool *pool,
+                                    const enum sprite_id id, const int r,
+                                    const int c, const double vx) {
+  assert_not_null(3, w, w->level, pool);
+
+  // make room by dropping the oldest projectile
+  if (pool->count == pool->cap) {
+    pool->head = (pool->head + 1) & (pool->cap - 1);
+    pool->count--;
+  }
+
+  struct projectile *p = slot(pool, pool->count);
+  if (sprite_init(w, &p->s, id) != 0) {
+    return NULL;
+  }
+
+  p->s.x = SPRITE_SIZE * c;
+  p->s.y = SPRITE_SIZE * r;
+  p->s.vx = util_abs_limit(vx, MAX_VELOCITY);
+  p->end = wall(w, r, c, p->s.vx);
+
+  pool->count++;
+  return p;
+}
+
+int projectile_iterate(struct lily_world *w, struct projectile_pool *pool) {
+  assert_not_null(3, w, w->player, pool);
+  struct sprite *player = w->player->s;
+
+  register size_t i;
+  for (i = 0; i < pool->count; i++) {
+    struct projectile *p = slot(pool, i);
+    struct sprite *s = &p->s;
+
+    s->x += fixed_step(s->vx, w->dt);
+    if (s->vx > 0 ? s->x > p->end : s->x < p->end) {
+      s->x = p->end;
+      s->removed = true;
+    }
+
+    // like an active sprite, a projectile can still hit the player on the tick
+    // it hits a wall
+    if (player != NULL && util_collide(s, player) &&
+        event_emit(w, EVENT_HIT, s) != 0) {
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+void projectile_clean(struct projectile_pool *pool) {
+  assert_not_null(1, pool);
+
+  // the projectiles still in flight are moved down to the slot j, so that the
+  // pool never has holes
+  register size_t i, j = 0;
+  for (i = 0; i < pool->count; i++) {
+    struct projectile *p = slot(pool, i);
+    if (!p->s.removed) {
+      if (i != j) {
+        *slot(pool, j) = *p;
+      }
+      j++;
+    }
+  }
+
+  pool->count = j;
+}
+
+void projectile_animate(struct projectile_pool *pool, const Uint64 dt) {
+  assert_not_null(1, pool);
+
+  register size_t i;
+  for (i = 0; i < pool->count; i++) {
+    sprite_animate(&slot(pool, i)->s, dt);
+  }
+}
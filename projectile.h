@@ -0,0 +1,87 @@
+#ifndef PROJECTILE_H
+#define PROJECTILE_H
+
+#include "base.h"
+
+#include "sprite.h"
+#include <stdbool.h>
+
+// projectile implements things that fly in a straight line until they hit a
+// wall or the player, like the shots of ghosts. Projectiles are not active
+// sprites: they live in a fixed capacity pool owned by the level, so spawning
+// one allocates nothing. The tile a projectile hits is found once, when it is
+// spawned, so moving it never looks at the tiles again: every tick, it only
+// moves, expires once it passed that tile, and is tested for collision with
+// the player.
+//
+// The pool is a ring: projectiles are spawned at its end, and the ones that
+// expired are removed once the pool was iterated, by moving the following ones
+// down, so the pool never has holes and stays ordered from the oldest
+// projectile to the newest. If the pool is full, the oldest projectile is
+// dropped to make room for a new one.
+
+// forward declaration, see state.h
+struct lily_world;
+
+enum {
+  // PROJECTILE_POOL_SIZE is the capacity of the projectile pool of a level
+  PROJECTILE_POOL_SIZE = 256,
+};
+
+// projectile is a projectile in flight
+struct projectile {
+  // s is the sprite of the projectile, which holds its type, position,
+  // velocity and animation like an active sprite would
+  struct sprite s;
+  // end is the x position past which the projectile hits a wall
+  double end;
+};
+
+// projectile_pool holds the projectiles of a level
+struct projectile_pool {
+  struct projectile *p;
+  size_t cap; // the number of elements of p, a power of two
+  // head is the index of the oldest projectile, and count the number of
+  // projectiles in flight
+  size_t head;
+  size_t count;
+};
+
+// projectile_pool_create creates a pool of at least `cap` projectiles. Returns
+// NULL on failure.
+struct projectile_pool *projectile_pool_create(const size_t cap);
+
+// projectile_pool_destroy frees the memory of the pool and sets *pp to NULL
+void projectile_pool_destroy(struct projectile_pool **pp);
+
+// projectile_pool_clear removes every projectile of the pool
+void projectile_pool_clear(struct projectile_pool *pool);
+
+// projectile_spawn spawns a projectile of type id in the current level of the
+// world w, on the tile at row r and column c, flying with the horizontal
+// velocity vx. Returns the projectile, or NULL on failure.
+struct projectile *projectile_spawn(struct lily_world *w,
+                                    struct projectile_pool *pool,
+                                    const enum sprite_id id, const int r,
+                                    const int c, const double vx);
+
+// projectile_iterate moves every projectile of the pool by w->dt, marks the
+// ones that hit a wall as removed, and emits a hit event for the ones that
+// collide with the player of the world w (see event.h). Returns 0 on success,
+// -1 on failure.
+int projectile_iterate(struct lily_world *w, struct projectile_pool *pool);
+
+// projectile_clean removes the projectiles of the pool that were removed, once
+// the events of the tick were resolved
+void projectile_clean(struct projectile_pool *pool);
+
+// projectile_animate advances the animation of every projectile in flight by dt
+// milliseconds
+void projectile_animate(struct projectile_pool *pool, const Uint64 dt);
+
+// projectile_get returns the sprite of the projectile i of the pool, from the
+// oldest (0) to the newest (pool->count - 1)
+struct sprite *projectile_get(const struct projectile_pool *pool,
+                              const size_t i);
+
+#endif // PROJECTILE_H
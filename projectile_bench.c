@@ -0,0 +1,175 @@
+#include "projectile.h"
+
+#include "default_levels.h"
+#include "event.h"
+#include "level.h"
+#include "lily.h"
+#include "player.h"
+#include "safe.h"
+#include "util.h"
+#include <stdio.h>
+
+// projectile_bench measures the cost of moving thousands of projectiles in
+// flight (see projectile.h) on the first level of the game, and compares it to
+// moving as many shots as active sprites, which look up the tiles around them
+// with util_move_x at every tick. Whenever a projectile hits a wall, a new one
+// is spawned at a pseudo-random tile, so that the number of projectiles in
+// flight stays the same. Run it with `make bench`.
+
+enum {
+  BENCH_TICKS = 10 * FRAME_RATE,
+  BENCH_SPEED = 72,
+};
+
+// spawn returns a pseudo-random row, column and direction for the projectile
+// spawned n-th in the level l
+static void spawn(const struct level *l, const Uint64 n, int *r, int *c,
+                  double *vx) {
+  Uint64 z = n * 0x9E3779B97F4A7C15;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+  z ^= z >> 31;
+
+  *r = (int)(z % (ROW_COUNT * l->h));
+  *c = (int)((z >> 16) % (COLUMN_COUNT * l->w));
+  *vx = (z >> 32) % 2 == 0 ? BENCH_SPEED : -BENCH_SPEED;
+}
+
+// pooled moves n projectiles for BENCH_TICKS ticks. Returns the time per
+// projectile per tick in nanoseconds, or a negative value on failure.
+static double pooled(struct lily_world *w, const size_t n) {
+  struct projectile_pool *pool = projectile_pool_create(n);
+  if (pool == NULL) {
+    return -1;
+  }
+
+  Uint64 spawned = 0;
+  int r, c;
+  double vx;
+  const Uint64 start = SDL_GetPerformanceCounter();
+
+  register size_t t;
+  for (t = 0; t < BENCH_TICKS; t++) {
+    while (pool->count < n) {
+      spawn(w->level, spawned++, &r, &c, &vx);
+      if (projectile_spawn(w, pool, SPRITE_SHOT, r, c, vx) == NULL) {
+        projectile_pool_destroy(&pool);
+        return -1;
+      }
+    }
+
+    if (projectile_iterate(w, pool) != 0 || event_resolve(w) != 0) {
+      projectile_pool_destroy(&pool);
+      return -1;
+    }
+    projectile_clean(pool);
+  }
+
+  const double elapsed = (double)(SDL_GetPerformanceCounter() - start) /
+                         SDL_GetPerformanceFrequency();
+  projectile_pool_destroy(&pool);
+  return elapsed * 1e9 / BENCH_TICKS / n;
+}
+
+// sprites moves n shots as active sprites for BENCH_TICKS ticks, like the game
+// did before projectiles. Returns the time per shot per tick in nanoseconds,
+// or a negative value on failure.
+static double sprites(struct lily_world *w, const size_t n) {
+  struct sprite **a = calloc(n, sizeof(struct sprite *));
+  bool *wall = calloc(n, sizeof(bool));
+  if (a == NULL || wall == NULL) {
+    free(a);
+    free(wall);
+    return -1;
+  }
+
+  Uint64 spawned = 0;
+  int r, c;
+  double vx;
+  double ret = -1;
+  const Uint64 start = SDL_GetPerformanceCounter();
+
+  register size_t t, i;
+  for (t = 0; t < BENCH_TICKS; t++) {
+    for (i = 0; i < n; i++) {
+      if (a[i] != NULL) {
+        continue;
+      }
+
+      spawn(w->level, spawned++, &r, &c, &vx);
+      a[i] = malloc(sizeof(struct sprite));
+      if (a[i] == NULL || sprite_init(w, a[i], SPRITE_SHOT) != 0) {
+        goto out;
+      }
+      a[i]->x = SPRITE_SIZE * c;
+      a[i]->y = SPRITE_SIZE * r;
+      a[i]->vx = vx;
+    }
+
+    for (i = 0; i < n; i++) {
+      struct sprite *s = a[i];
+      wall[i] = util_move_x(w, s) != COLLISION_NONE;
+      if (util_collide(s, w->player->s) && event_emit(w, EVENT_HIT, s) != 0) {
+        goto out;
+      }
+    }
+
+    if (event_resolve(w) != 0) {
+      goto out;
+    }
+
+    for (i = 0; i < n; i++) {
+      if (wall[i] || a[i]->removed) {
+        free(a[i]);
+        a[i] = NULL;
+      }
+    }
+  }
+
+  const double elapsed = (double)(SDL_GetPerformanceCounter() - start) /
+                         SDL_GetPerformanceFrequency();
+  ret = elapsed * 1e9 / BENCH_TICKS / n;
+
+out:
+  for (i = 0; i < n; i++) {
+    free(a[i]);
+  }
+  free(a);
+  free(wall);
+  return ret;
+}
+
+int main(int argc, char *argv[]) {
+  SAFE_UNUSED(argc);
+  SAFE_UNUSED(argv);
+
+  struct lily_world *w = lily_world_create();
+  if (w == NULL || lily_world_load_default_level(w, 0) != 0) {
+    return 1;
+  }
+  w->dt = FRAME_TIME;
+  // the player blinks for the whole benchmark, so that the shots hitting it
+  // do not end the game
+  fps_timer_init(&w->player->blink_timer, (Uint64)-1);
+
+  printf("%s, %d ticks\n", LEVELS[0], BENCH_TICKS);
+  static const size_t COUNTS[] = {1000, 4000, 16000};
+  int ret = 0;
+  register size_t i;
+  for (i = 0; i < sizeof(COUNTS) / sizeof(COUNTS[0]) && ret == 0; i++) {
+    const double p = pooled(w, COUNTS[i]);
+    const double s = sprites(w, COUNTS[i]);
+    if (p < 0 || s < 0) {
+      ret = 1;
+      break;
+    }
+
+    printf("  %6lu in flight: pool %6.1f ns, active sprites %6.1f ns per "
+           "projectile per tick (%.1fx)\n",
+           (unsigned long)COUNTS[i], p, s, s / p);
+  }
+
+  lily_world_destroy(&w);
+  level_template_cache_clear();
+  return ret;
+}
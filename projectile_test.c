@@ -0,0 +1,159 @@
+#include "projectile.h"
+
+#include "event.h"
+#include "level.h"
+#include "lily.h"
+#include "player.h"
+#include "test.h"
+#include "util.h"
+
+static const struct token_entry TOKENS[] = {
+    {'=', SPRITE_WALL_TOP, token_passive_sprite},
+    {'*', SPRITE_WALL, token_passive_sprite},
+    {'P', SPRITE_PLAYER, token_player},
+    {' ', SPRITE_NONE, NULL}};
+
+static const size_t TOKEN_SIZE = 4;
+
+// walls at different distances on every row, the player on the last one
+static const char LEVEL[] = "*                  *\n"
+                            "    *               \n"
+                            "               *    \n"
+                            "        *   *       \n"
+                            "                    \n"
+                            "  *              *  \n"
+                            "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "                    \n"
+                            "P                   \n"
+                            "====================\n"
+                            "********************";
+
+enum { ROWS = 7, SPEED = 72, TICKS = 10 * FRAME_RATE };
+
+// step moves the projectiles of the pool for a tick, resolves their events and
+// removes the ones that expired, like level_iterate does
+static void step(struct lily_world *w, struct projectile_pool *pool) {
+  assert(projectile_iterate(w, pool) == 0);
+  assert(event_resolve(w) == 0);
+  projectile_clean(pool);
+}
+
+// a projectile hits a wall at the same tick and position as a sprite moved
+// with util_move_x, without looking at the tiles while it flies
+static void test_impact(void) {
+  struct lily_world *w = test_world(LEVEL, TOKENS, TOKEN_SIZE);
+  struct projectile_pool *pool = w->level->projectiles;
+
+  register int r, c, dir;
+  for (r = 0; r < ROWS; r++) {
+    for (c = 0; c < COLUMN_COUNT; c += 3) {
+      for (dir = -1; dir <= 1; dir += 2) {
+        struct sprite s;
+        assert(sprite_init(w, &s, SPRITE_SHOT) == 0);
+        s.x = SPRITE_SIZE * c;
+        s.y = SPRITE_SIZE * r;
+        s.vx = dir * SPEED;
+
+        int expected = 0;
+        while (util_move_x(w, &s) == COLLISION_NONE) {
+          expected++;
+        }
+
+        struct projectile *p =
+            projectile_spawn(w, pool, SPRITE_SHOT, r, c, dir * SPEED);
+        assert(p != NULL);
+        assert(pool->count == 1);
+
+        int ticks = 0;
+        for (;;) {
+          step(w, pool);
+          if (pool->count == 0) {
+            break;
+          }
+          assert(++ticks < TICKS);
+        }
+
+        assert(ticks == expected);
+        assert(p->s.x == s.x);
+      }
+    }
+  }
+
+  lily_world_destroy(&w);
+}
+
+// the pool drops its oldest projectiles when full, and keeps the ones in flight
+// in order when others expire
+static void test_pool(void) {
+  struct lily_world *w = test_world(LEVEL, TOKENS, TOKEN_SIZE);
+  struct projectile_pool *pool = projectile_pool_create(5);
+  assert(pool != NULL);
+  assert(pool->cap == 8);
+
+  // the projectiles spawned on row 1 fly across the screen, the ones on row 4
+  // are next to a wall. They are numbered with their vy, which is unused.
+  register size_t i;
+  for (i = 0; i < pool->cap + 2; i++) {
+    struct projectile *p =
+        i % 2 == 0 ? projectile_spawn(w, pool, SPRITE_SHOT, 1, 9, SPEED)
+                   : projectile_spawn(w, pool, SPRITE_SHOT, 4, 11, SPEED);
+    assert(p != NULL);
+    p->s.vy = i;
+  }
+
+  // the two oldest ones were dropped
+  assert(pool->count == pool->cap);
+  assert(projectile_get(pool, 0)->vy == 2);
+
+  // the ones on row 4 hit the wall first
+  step(w, pool);
+  assert(pool->count == pool->cap / 2);
+  for (i = 0; i < pool->count; i++) {
+    assert(projectile_get(pool, i)->vy == 2 * (i + 1));
+  }
+
+  // a new projectile is the newest one
+  assert(projectile_spawn(w, pool, SPRITE_SHOT, 1, 9, SPEED) != NULL);
+  assert(projectile_get(pool, pool->count - 1)->vy == 0);
+
+  for (i = 0; i < TICKS && pool->count > 0; i++) {
+    step(w, pool);
+  }
+  assert(pool->count == 0);
+
+  projectile_pool_destroy(&pool);
+  assert(pool == NULL);
+  lily_world_destroy(&w);
+}
+
+// a shot kills the player it hits
+static void test_hit(void) {
+  struct lily_world *w = test_world(LEVEL, TOKENS, TOKEN_SIZE);
+  struct projectile_pool *pool = w->level->projectiles;
+  struct player *p = w->player;
+  const unsigned int lives = p->lives;
+
+  int r, c;
+  util_nearest(p->s, &r, &c);
+  assert(projectile_spawn(w, pool, SPRITE_SHOT, r, COLUMN_COUNT - 1, -SPEED) !=
+         NULL);
+
+  register size_t i;
+  for (i = 0; i < TICKS && pool->count > 0; i++) {
+    step(w, pool);
+  }
+
+  assert(pool->count == 0);
+  assert(p->lives == lives - 1);
+  lily_world_destroy(&w);
+}
+
+int main(void) {
+  RUN_TEST(test_impact);
+  RUN_TEST(test_pool);
+  RUN_TEST(test_hit);
+  return 0;
+}
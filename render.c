@@ -13,7 +13,7 @@ int render_create(void) {
     return -1;
   }
 
-  fps_init(); // initialize the frame rate limiter
+  fps_init(&g_prog.fps); // initialize the frame rate limiter
 
   return 0;
 }
@@ -23,7 +23,7 @@ void render_destroy(void) {
   scene_state_destroy(&_state);
 }
 
-// render_current_scene renders the scene pointed to by g_game.scene
+// render_current_scene renders the scene pointed to by g_prog.scene
 static int render_current_scene(void) {
   // this is an assert instead of an error since if the current scene is NULL,
   // that is a programming bug, not a runtime bug.
@@ -54,7 +54,7 @@ int render_iterate(void) {
 
   scene_state_present(_state); // SDL_RenderPresent
 
-  fps_iterate(); // maintain frame rate
+  fps_iterate(&g_prog.fps); // maintain frame rate
 
   return 0;
 }
@@ -0,0 +1,337 @@
+#include "replay.h"
+
+#include "digest.h"
+#include "fps.h"
+#include "job.h"
+#include "level.h"
+#include "lily.h"
+#include "player.h"
+#include "safe.h"
+#include "state.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// STATUS_NAMES are the names of the replay_status values in result files
+static const char *STATUS_NAMES[] = {"valid", "diverged", "invalid"};
+
+// game is a game being played again, see replay_play
+struct game {
+  struct replay_result *res;
+  size_t cap;         // the capacity of res->events
+  size_t level;       // the index of the current level
+  Uint64 time;        // the game time, in milliseconds
+  Uint64 start;       // the game time the current level started at
+  unsigned int coins; // the coins of the player when the level started
+};
+
+// add_event appends an event of the type `type` to the events of the game g,
+// at the current level and time. Returns the event, or NULL on failure.
+static struct replay_event *add_event(struct game *g,
+                                      const enum replay_event_type type) {
+  struct replay_result *res = g->res;
+  if (res->event_count == g->cap) {
+    const size_t cap = SDL_max(2 * g->cap, 16);
+    struct replay_event *events =
+        realloc(res->events, cap * sizeof(struct replay_event));
+    if (events == NULL) {
+      LOG_ERROR("could not allocate replay events");
+      return NULL;
+    }
+
+    res->events = events;
+    g->cap = cap;
+  }
+
+  struct replay_event *e = &res->events[res->event_count++];
+  memset(e, 0, sizeof(struct replay_event));
+  e->type = type;
+  e->level = g->level;
+  e->time = (g->time - g->start) / FRAME_TIME;
+  return e;
+}
+
+// tile returns the tile of n tiles that the pixel coordinate v is in, clamped
+// to the level
+static size_t tile(const double v, const size_t n) {
+  const double t = SDL_floor(v / SPRITE_SIZE);
+  return t < 0 ? 0 : SDL_min((size_t)t, n - 1);
+}
+
+// play_step records the events of the step of the world w that was just
+// played, the player having been at x, y with `lives` lives in the state
+// `state` before it. Returns 0 on success, -1 on failure.
+static int play_step(struct game *g, const struct lily_world *w,
+                     const double x, const double y, const unsigned int lives,
+                     const enum prog_state state) {
+  const struct player *p = w->player;
+  const struct level *l = w->level;
+  g->time += w->dt;
+
+  // the player respawns as soon as they die, so they died where they were
+  // before the step
+  if (p->lives < lives) {
+    struct replay_event *e = add_event(g, REPLAY_DEATH);
+    if (e == NULL) {
+      return -1;
+    }
+
+    e->r = tile(y + SPRITE_SIZE / 2, ROW_COUNT * l->h);
+    e->c = tile(x + SPRITE_SIZE / 2, COLUMN_COUNT * l->w);
+  }
+
+  if (w->state == PROG_GAME_LEVEL_COMPLETE &&
+      state != PROG_GAME_LEVEL_COMPLETE) {
+    struct replay_event *e = add_event(g, REPLAY_DOOR);
+    if (e == NULL) {
+      return -1;
+    }
+
+    e->coins = p->coins - g->coins;
+    g->res->complete = g->level == LEVEL_COUNT - 1;
+  }
+
+  return 0;
+}
+
+int replay_play(FILE *f, struct replay_result *res) {
+  assert_not_null(2, f, res);
+  memset(res, 0, sizeof(struct replay_result));
+
+  struct lily_world *w = lily_world_create();
+  if (w == NULL) {
+    return -1;
+  }
+  lily_world_set_hashing(w, true);
+
+  struct game g = {0};
+  g.res = res;
+  const struct player *p = w->player;
+
+  char line[DIGEST_LINE_SIZE];
+  int ret = 0;
+  while (ret == 0 && res->status == REPLAY_VALID &&
+         fgets(line, sizeof(line), f) != NULL) {
+    const Uint64 ticks = w->ticks;
+    const unsigned int lives = p->lives;
+    const enum prog_state state = w->state;
+    const double x = p->s != NULL ? p->s->x : 0;
+    const double y = p->s != NULL ? p->s->y : 0;
+
+    const int match = digest_log_line(w, line);
+    if (match != 0) {
+      res->status = match < 0 ? REPLAY_INVALID : REPLAY_DIVERGED;
+    } else if (w->ticks != ticks) {
+      ret = play_step(&g, w, x, y, lives, state);
+    } else {
+      // a level line
+      g.level = w->level_index;
+      g.start = g.time;
+      g.coins = p->coins;
+      ret = add_event(&g, REPLAY_START) != NULL ? 0 : -1;
+    }
+  }
+
+  if (ferror(f)) {
+    LOG_ERROR("could not read hash log");
+    res->status = REPLAY_INVALID;
+  }
+
+  res->ticks = w->ticks;
+  lily_world_destroy(&w);
+  if (ret != 0) {
+    replay_result_free(res);
+  }
+
+  return ret;
+}
+
+// batch is the games played again by replay_run, a job per game
+struct batch {
+  const char *const *filenames;
+  struct replay_result *results;
+};
+
+// play plays the game i of the batch `data` again, as the job i of the batch
+// (see job_func). Returns 0 on success, -1 on failure.
+static int play(void *data, const size_t thread, const size_t i) {
+  SAFE_UNUSED(thread);
+  struct batch *b = data;
+  struct replay_result *res = &b->results[i];
+  FILE *f = fopen(b->filenames[i], "r");
+  if (f == NULL) {
+    LOG_ERROR("could not open %s", b->filenames[i]);
+    res->status = REPLAY_INVALID;
+    return 0;
+  }
+
+  const int ret = replay_play(f, res);
+  fclose(f);
+  return ret;
+}
+
+int replay_run(const char *const *filenames, const size_t count,
+               const size_t threads, struct replay_result *results) {
+  assert_not_null(2, filenames, results);
+  memset(results, 0, count * sizeof(struct replay_result));
+
+  struct job_pool *j = job_pool_create(threads);
+  if (j == NULL) {
+    return -1;
+  }
+
+  struct batch b = {filenames, results};
+  const int ret = job_pool_run(j, count, play, &b);
+  job_pool_destroy(&j);
+
+  if (ret != 0) {
+    register size_t i;
+    for (i = 0; i < count; i++) {
+      replay_result_free(&results[i]);
+    }
+    return -1;
+  }
+
+  return 0;
+}
+
+void replay_result_free(struct replay_result *res) {
+  assert_not_null(1, res);
+  free(res->events);
+  res->events = NULL;
+  res->event_count = 0;
+}
+
+// compare_times orders times in ascending order, for qsort
+static int compare_times(const void *a, const void *b) {
+  const Uint64 x = *(const Uint64 *)a, y = *(const Uint64 *)b;
+  return (x > y) - (x < y);
+}
+
+// levels_create allocates the heatmaps and the times of the levels, from the
+// number of doors of each level. Returns 0 on success, -1 on failure.
+static int levels_create(struct replay_level *levels) {
+  register size_t i;
+  for (i = 0; i < LEVEL_COUNT; i++) {
+    struct replay_level *l = &levels[i];
+    struct level_template *t =
+        level_template_get(LEVELS[i], LEVEL_TOKENS[i], LEVEL_TOKENS_COUNT[i]);
+    if (t == NULL) {
+      return -1;
+    }
+
+    l->rows = ROW_COUNT * t->h;
+    l->cols = COLUMN_COUNT * t->w;
+    level_template_release(&t);
+
+    l->heatmap = calloc(l->rows * l->cols, sizeof(Uint32));
+    l->times = calloc(SDL_max(l->doors, 1), sizeof(Uint64));
+    if (l->heatmap == NULL || l->times == NULL) {
+      LOG_ERROR("could not allocate level analytics");
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+int replay_aggregate(const struct replay_result *results, const size_t count,
+                     struct replay_level *levels) {
+  assert_not_null(2, results, levels);
+  memset(levels, 0, LEVEL_COUNT * sizeof(struct replay_level));
+
+  // the doors are counted first, to allocate the times
+  register size_t i, j;
+  for (i = 0; i < count; i++) {
+    for (j = 0; j < results[i].event_count; j++) {
+      const struct replay_event *e = &results[i].events[j];
+      if (results[i].status == REPLAY_VALID && e->type == REPLAY_DOOR) {
+        levels[e->level].doors++;
+      }
+    }
+  }
+
+  if (levels_create(levels) != 0) {
+    for (i = 0; i < LEVEL_COUNT; i++) {
+      replay_level_free(&levels[i]);
+    }
+    return -1;
+  }
+
+  size_t doors[LEVEL_COUNT] = {0};
+  for (i = 0; i < count; i++) {
+    if (results[i].status != REPLAY_VALID) {
+      continue;
+    }
+
+    for (j = 0; j < results[i].event_count; j++) {
+      const struct replay_event *e = &results[i].events[j];
+      struct replay_level *l = &levels[e->level];
+      switch (e->type) {
+      case REPLAY_START:
+        l->starts++;
+        break;
+      case REPLAY_DEATH:
+        l->deaths++;
+        l->heatmap[e->r * l->cols + e->c]++;
+        break;
+      case REPLAY_DOOR:
+        l->coins += e->coins;
+        l->times[doors[e->level]++] = e->time;
+        break;
+      }
+    }
+  }
+
+  for (i = 0; i < LEVEL_COUNT; i++) {
+    qsort(levels[i].times, levels[i].doors, sizeof(Uint64), compare_times);
+  }
+
+  return 0;
+}
+
+void replay_level_free(struct replay_level *l) {
+  assert_not_null(1, l);
+  free(l->times);
+  free(l->heatmap);
+  l->times = NULL;
+  l->heatmap = NULL;
+}
+
+int replay_write(FILE *f, const char *const *filenames,
+                 const struct replay_result *results, const size_t count) {
+  assert_not_null(3, f, filenames, results);
+
+  register size_t i, j;
+  int ret = 0;
+  for (i = 0; i < count && ret >= 0; i++) {
+    const struct replay_result *res = &results[i];
+    ret = fprintf(f, "game %s %llu %d %s\n", STATUS_NAMES[res->status],
+                  (unsigned long long)res->ticks, res->complete ? 1 : 0,
+                  filenames[i]);
+
+    for (j = 0; j < res->event_count && ret >= 0; j++) {
+      const struct replay_event *e = &res->events[j];
+      switch (e->type) {
+      case REPLAY_START:
+        ret = fprintf(f, "start %zu\n", e->level);
+        break;
+      case REPLAY_DEATH:
+        ret = fprintf(f, "death %zu %llu %zu %zu\n", e->level,
+                      (unsigned long long)e->time, e->r, e->c);
+        break;
+      case REPLAY_DOOR:
+        ret = fprintf(f, "door %zu %llu %u\n", e->level,
+                      (unsigned long long)e->time, e->coins);
+        break;
+      }
+    }
+  }
+
+  if (ret < 0) {
+    LOG_ERROR("could not write replay results");
+    return -1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,130 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "base.h"
+
+#include "default_levels.h"
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+// replay plays recorded games again headless, on every core, to check them
+// and to gather analytics of the game's levels, e.g to balance the levels or
+// to validate leaderboard submissions.
+//
+// A recorded game is a hash log (see digest.h), e.g written by the game with
+// --hash-log. Playing it again checks every tick of it: a game whose hashes do
+// not all match was not played by this build of the game (or was tampered
+// with), and is not counted in the analytics. While a game is played again,
+// the events of each level are recorded: the level starting, the player dying
+// and the player reaching the door.
+//
+// Times are in game time, i.e the sum of the durations of the frames, so they
+// do not depend on the frame rate the game was played at. They are given in
+// FRAME_TIME ticks (see fps.h), i.e the number of ticks the game would have
+// taken at FRAME_RATE.
+
+// replay_status is the outcome of playing a game again
+enum replay_status {
+  // every hash of the game matched
+  REPLAY_VALID,
+  // a hash did not match, see replay_result.ticks
+  REPLAY_DIVERGED,
+  // the game could not be played again, e.g the file is not a hash log
+  REPLAY_INVALID,
+};
+
+// replay_event_type enumerates the events recorded while playing a game again
+enum replay_event_type {
+  // the level started
+  REPLAY_START,
+  // the player died on the tile of the event
+  REPLAY_DEATH,
+  // the player reached the door of the level
+  REPLAY_DOOR,
+};
+
+// replay_event is an event of a level, see replay_event_type
+struct replay_event {
+  enum replay_event_type type;
+  size_t level; // the index of the level, see default_levels.h
+  // time is the time since the level started, in FRAME_TIME ticks
+  Uint64 time;
+  // r and c are the tile the player was on, for REPLAY_DEATH
+  size_t r, c;
+  // coins is the number of coins collected in the level, for REPLAY_DOOR
+  unsigned int coins;
+};
+
+// replay_result is the outcome of playing a game again, see replay_play
+struct replay_result {
+  enum replay_status status;
+  // ticks is the number of ticks played, including the tick a hash did not
+  // match at if the game diverged
+  Uint64 ticks;
+  // complete is true if the player reached the door of the game's last level
+  bool complete;
+  // events lists the event_count events of the game, in order
+  struct replay_event *events;
+  size_t event_count;
+};
+
+// replay_level is the analytics of a level, over every valid game
+struct replay_level {
+  size_t starts; // the number of times the level was started
+  size_t doors;  // the number of times its door was reached
+  size_t deaths; // the number of times the player died in it
+  // coins is the number of coins collected in the level, summed over the
+  // times its door was reached
+  Uint64 coins;
+  // times lists the time it took to reach the door, for each of the `doors`
+  // times it was reached, in ascending order
+  Uint64 *times;
+  // heatmap has the number of deaths on every tile of the level, in rows *
+  // cols values, row by row
+  Uint32 *heatmap;
+  size_t rows;
+  size_t cols;
+};
+
+// replay_play plays the hash log f again, and populates res, which must be
+// freed with replay_result_free. Returns 0 on success, whatever the status of
+// the game, and -1 on failure.
+int replay_play(FILE *f, struct replay_result *res);
+
+// replay_run plays the `count` hash log files of `filenames` again, on
+// `threads` threads (or one per CPU if threads is 0), and populates the
+// results, an array of count results in the same order, which must each be
+// freed with replay_result_free. A file that cannot be opened is
+// REPLAY_INVALID. Returns 0 on success, -1 on failure.
+int replay_run(const char *const *filenames, const size_t count,
+               const size_t threads, struct replay_result *results);
+
+// replay_result_free frees the memory held by res
+void replay_result_free(struct replay_result *res);
+
+// replay_aggregate populates the analytics of every level of the game from the
+// `count` results, only counting valid games. levels must hold LEVEL_COUNT
+// values, each of which must be freed with replay_level_free. Returns 0 on
+// success, -1 on failure.
+int replay_aggregate(const struct replay_result *results, const size_t count,
+                     struct replay_level *levels);
+
+// replay_level_free frees the memory held by l
+void replay_level_free(struct replay_level *l);
+
+// replay_write writes the `count` results of the games of `filenames` to f, in
+// a line per game and a line per event:
+//
+//   game STATUS TICKS COMPLETE FILENAME
+//   start LEVEL
+//   death LEVEL TIME ROW COLUMN
+//   door LEVEL TIME COINS
+//
+// where STATUS is valid, diverged or invalid, COMPLETE is 1 if the game was
+// completed, 0 otherwise, and the event lines follow the line of their game.
+// Returns 0 on success, -1 on failure.
+int replay_write(FILE *f, const char *const *filenames,
+                 const struct replay_result *results, const size_t count);
+
+#endif // REPLAY_H
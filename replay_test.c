@@ -0,0 +1,224 @@
+#include "replay.h"
+
+#include "lily.h"
+#include "player.h"
+#include "state.h"
+#include "test.h"
+#include <string.h>
+
+// DOOR_PATH completes the game's first level, as found by lily_analyze -i 0.
+// If a change to the game logic changes the path on purpose, it can be
+// updated with the path printed by lily_analyze.
+static const struct {
+  size_t frames;
+  Uint32 input;
+} DOOR_PATH[] = {
+    {44, INPUT_RIGHT | INPUT_SPRINT},
+    {4, INPUT_RIGHT | INPUT_JUMP | INPUT_SPRINT},
+    {36, INPUT_RIGHT | INPUT_SPRINT},
+    {4, INPUT_RIGHT | INPUT_JUMP | INPUT_SPRINT},
+    {24, INPUT_RIGHT | INPUT_SPRINT},
+    {4, INPUT_JUMP},
+    {68, INPUT_LEFT | INPUT_SPRINT},
+    {4, INPUT_LEFT | INPUT_JUMP | INPUT_SPRINT},
+    {12, INPUT_LEFT | INPUT_SPRINT},
+    {4, INPUT_LEFT},
+    {24, INPUT_LEFT | INPUT_SPRINT},
+    {4, INPUT_LEFT | INPUT_JUMP | INPUT_SPRINT},
+    {4, INPUT_LEFT | INPUT_SPRINT},
+    {4, INPUT_LEFT},
+    {16, INPUT_LEFT | INPUT_SPRINT},
+    {4, INPUT_LEFT},
+    {4, INPUT_RIGHT | INPUT_SHORT_JUMP},
+    {28, INPUT_RIGHT | INPUT_SPRINT},
+    {4, INPUT_RIGHT | INPUT_SHORT_JUMP},
+    {40, INPUT_RIGHT | INPUT_SPRINT},
+    {4, INPUT_RIGHT | INPUT_SHORT_JUMP},
+    {32, INPUT_RIGHT | INPUT_SPRINT},
+    {4, INPUT_RIGHT | INPUT_SHORT_JUMP},
+    {24, INPUT_RIGHT | INPUT_SPRINT},
+    {4, INPUT_RIGHT},
+    {11, INPUT_RIGHT | INPUT_SPRINT},
+    {1, INPUT_RIGHT | INPUT_SPRINT | INPUT_INTERACT},
+};
+
+// the inputs of the games played at random
+static const Uint32 INPUTS[] = {INPUT_RIGHT | INPUT_SPRINT,
+                                INPUT_RIGHT | INPUT_JUMP,
+                                INPUT_LEFT | INPUT_SPRINT,
+                                INPUT_LEFT | INPUT_SHORT_JUMP};
+
+enum { GAMES = 12, TICKS = 30 * FRAME_RATE, HOLD = FRAME_RATE / 2 };
+
+// create creates a world seeded with `seed`, logging its hash to f, and loads
+// the game's level number `index` into it
+static struct lily_world *create(FILE *f, const size_t index,
+                                 const Uint64 seed) {
+  struct lily_world *w = lily_world_create();
+  assert(w != NULL);
+  lily_world_seed(w, seed);
+  lily_world_set_hash_log(w, f);
+  assert(lily_world_load_default_level(w, index) == 0);
+  return w;
+}
+
+// record_path plays the game's first level with DOOR_PATH in a world logging
+// its hash to f. Returns the number of ticks played.
+static size_t record_path(FILE *f) {
+  struct lily_world *w = create(f, 0, 0);
+
+  register size_t i, t;
+  for (i = 0; i < sizeof(DOOR_PATH) / sizeof(DOOR_PATH[0]); i++) {
+    for (t = 0; t < DOOR_PATH[i].frames; t++) {
+      assert(lily_world_step(w, DOOR_PATH[i].input, FRAME_TIME) == 0);
+    }
+  }
+
+  assert(w->state == PROG_GAME_LEVEL_COMPLETE);
+  const size_t ticks = w->ticks;
+  lily_world_destroy(&w);
+  return ticks;
+}
+
+// record plays the game's level number `index` with pseudo-random inputs drawn
+// from `seed` in a world logging its hash to f. The inputs are not drawn with
+// util_rand, which would change the state of the world. Returns the number of
+// times the player died.
+static size_t record(FILE *f, const size_t index, const Uint64 seed) {
+  struct lily_world *w = create(f, index, seed);
+
+  size_t deaths = 0;
+  register size_t t;
+  Uint64 z = seed;
+  Uint32 input = INPUT_NONE;
+  for (t = 0; t < TICKS; t++) {
+    if (t % HOLD == 0) {
+      z = z * 6364136223846793005 + 1442695040888963407;
+      input = INPUTS[(z >> 33) % (sizeof(INPUTS) / sizeof(INPUTS[0]))];
+    }
+
+    const unsigned int lives = w->player->lives;
+    assert(lily_world_step(w, input, FRAME_TIME) == 0);
+    deaths += w->player->lives < lives;
+  }
+
+  lily_world_destroy(&w);
+  return deaths;
+}
+
+// a game that reaches the door plays again with the same events
+static void test_play(void) {
+  FILE *f = tmpfile();
+  assert(f != NULL);
+  const size_t ticks = record_path(f);
+
+  struct replay_result res;
+  rewind(f);
+  assert(replay_play(f, &res) == 0);
+  assert(res.status == REPLAY_VALID);
+  assert(res.ticks == ticks);
+  assert(!res.complete);
+
+  assert(res.event_count >= 2);
+  assert(res.events[0].type == REPLAY_START && res.events[0].level == 0);
+  const struct replay_event *door = &res.events[res.event_count - 1];
+  assert(door->type == REPLAY_DOOR && door->level == 0);
+  assert(door->time == ticks);
+
+  replay_result_free(&res);
+  fclose(f);
+  level_template_cache_clear();
+}
+
+// games played again on any number of threads give the same results, and
+// their analytics count every death of the valid games
+static void test_run(void) {
+  char names[GAMES + 1][32];
+  const char *filenames[GAMES + 1];
+  size_t deaths[LEVEL_COUNT] = {0}, starts[LEVEL_COUNT] = {0};
+
+  register size_t i, j;
+  for (i = 0; i < GAMES; i++) {
+    snprintf(names[i], sizeof(names[i]), "replay_test_%zu.log", i);
+    filenames[i] = names[i];
+    FILE *f = fopen(names[i], "w");
+    assert(f != NULL);
+
+    // the first game reaches the door
+    const size_t index = i % LEVEL_COUNT;
+    const size_t n = i == 0 ? (record_path(f), 0) : record(f, index, i);
+    if (i != GAMES - 1) {
+      deaths[index] += n;
+      starts[index]++;
+    } else {
+      // the last game is tampered with
+      assert(fputs("1 0 20 0000000000000000\n", f) >= 0);
+    }
+    fclose(f);
+  }
+
+  // a game that does not exist
+  snprintf(names[GAMES], sizeof(names[GAMES]), "replay_test_none.log");
+  filenames[GAMES] = names[GAMES];
+
+  struct replay_result one[GAMES + 1], many[GAMES + 1];
+  assert(replay_run(filenames, GAMES + 1, 1, one) == 0);
+  assert(replay_run(filenames, GAMES + 1, 4, many) == 0);
+  for (i = 0; i <= GAMES; i++) {
+    assert(one[i].status == many[i].status);
+    assert(one[i].ticks == many[i].ticks);
+    assert(one[i].event_count == many[i].event_count);
+    assert(memcmp(one[i].events, many[i].events,
+                  one[i].event_count * sizeof(struct replay_event)) == 0);
+  }
+
+  assert(one[0].status == REPLAY_VALID);
+  assert(one[GAMES - 1].status == REPLAY_DIVERGED);
+  assert(one[GAMES].status == REPLAY_INVALID);
+
+  struct replay_level levels[LEVEL_COUNT];
+  assert(replay_aggregate(many, GAMES + 1, levels) == 0);
+  assert(levels[0].doors == 1);
+  for (i = 0; i < LEVEL_COUNT; i++) {
+    const struct replay_level *l = &levels[i];
+    assert(l->deaths == deaths[i]);
+    assert(l->starts == starts[i]);
+
+    Uint64 sum = 0;
+    for (j = 0; j < l->rows * l->cols; j++) {
+      sum += l->heatmap[j];
+    }
+    assert(sum == l->deaths);
+    replay_level_free(&levels[i]);
+  }
+
+  // a line per game and per event
+  FILE *f = tmpfile();
+  assert(f != NULL);
+  assert(replay_write(f, filenames, many, GAMES + 1) == 0);
+  size_t lines = 0, events = GAMES + 1;
+  for (i = 0; i <= GAMES; i++) {
+    events += many[i].event_count;
+  }
+
+  int ch;
+  rewind(f);
+  while ((ch = fgetc(f)) != EOF) {
+    lines += ch == '\n';
+  }
+  assert(lines == events);
+  fclose(f);
+
+  for (i = 0; i <= GAMES; i++) {
+    replay_result_free(&one[i]);
+    replay_result_free(&many[i]);
+    remove(names[i]);
+  }
+  level_template_cache_clear();
+}
+
+int main(void) {
+  RUN_TEST(test_play);
+  RUN_TEST(test_run);
+  return 0;
+}
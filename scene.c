@@ -7,6 +7,8 @@
 #include <SDL2/SDL.h>
 #include <errno.h>
 
+struct scene *g_scenes[SCENE_COUNT] = {NULL};
+
 static void g_scenes_destroy(void) {
   register size_t i;
 
@@ -36,6 +38,7 @@ static int g_scenes_create(void) {
   scene_game_load();
   scene_options_load();
   scene_acknowledgements_load();
+  scene_view_load();
 
   return 0;
 }
@@ -56,10 +59,10 @@ struct scene_state *scene_state_create(void) {
     goto ttf_error_out;
   }
 
-  if (SDL_CreateWindowAndRenderer(LEVEL_WIDTH * SIZE_FACTOR,
-                                  LEVEL_HEIGHT * SIZE_FACTOR +
-                                      TEXT_HEIGHT * SIZE_FACTOR,
-                                  0, &s->window, &s->renderer) != 0) {
+  const int scale = g_prog.scale > 0 ? (int)g_prog.scale : SIZE_FACTOR;
+  if (SDL_CreateWindowAndRenderer(
+          LEVEL_WIDTH * scale, (LEVEL_HEIGHT + TEXT_HEIGHT) * scale,
+          SDL_WINDOW_RESIZABLE, &s->window, &s->renderer) != 0) {
     goto state_error_out;
   }
 
@@ -91,6 +94,20 @@ struct scene_state *scene_state_create(void) {
 
   SDL_FreeSurface(surface); // we don't need the surface any more
 
+  s->batch = batch_create(s->sprite_sheet);
+  if (s->batch == NULL) {
+    goto state_error_out;
+  }
+
+  // the game world is scaled up without filtering, to keep its pixels sharp
+  s->world = SDL_CreateTexture(s->renderer, SDL_PIXELFORMAT_RGBA8888,
+                               SDL_TEXTUREACCESS_TARGET, LEVEL_WIDTH,
+                               LEVEL_HEIGHT);
+  if (s->world == NULL ||
+      SDL_SetTextureScaleMode(s->world, SDL_ScaleModeNearest) != 0) {
+    goto state_error_out;
+  }
+
   // --------------------
   // -- Load the Fonts --
   // --------------------
@@ -125,6 +142,8 @@ error_out:
 
 void scene_state_destroy(struct scene_state **ps) {
   struct scene_state *s = *ps;
+  batch_destroy(&s->batch);
+  SDL_DestroyTexture(s->world);
   SDL_DestroyTexture(s->sprite_sheet);
   TTF_CloseFont(s->font);
 
@@ -145,6 +164,11 @@ int scene_state_clear(struct scene_state *s) {
   SDL_Renderer *r = s->renderer;
   assert_not_null(1, r);
 
+  // clear the whole window, including what is outside of the screen
+  if (SDL_RenderSetScale(r, 1, 1) != 0 || SDL_RenderSetViewport(r, NULL) != 0) {
+    goto error_out;
+  }
+
   if (SDL_SetRenderDrawColor(r, 0, 0, 0, 0) != 0) {
     goto error_out;
   }
@@ -153,6 +177,27 @@ int scene_state_clear(struct scene_state *s) {
     goto error_out;
   }
 
+  int w, h;
+  if (SDL_GetRendererOutputSize(r, &w, &h) != 0) {
+    goto error_out;
+  }
+
+  s->scale = SDL_min(w / LEVEL_WIDTH, h / (LEVEL_HEIGHT + TEXT_HEIGHT));
+  s->scale = SDL_max(s->scale, 1);
+
+  SDL_Rect screen;
+  screen.w = LEVEL_WIDTH * s->scale;
+  screen.h = (LEVEL_HEIGHT + TEXT_HEIGHT) * s->scale;
+  screen.x = (w - screen.w) / 2;
+  screen.y = (h - screen.h) / 2;
+
+  // the viewport is set at a scale of 1, so it is in the pixels of the window
+  if (SDL_RenderSetViewport(r, &screen) != 0 ||
+      SDL_RenderSetScale(r, (float)s->scale / SIZE_FACTOR,
+                         (float)s->scale / SIZE_FACTOR) != 0) {
+    goto error_out;
+  }
+
   return 0;
 
 error_out:
@@ -160,6 +205,35 @@ error_out:
   return -1;
 }
 
+int scene_world_begin(struct scene_state *s) {
+  assert_not_null(3, s, s->renderer, s->world);
+
+  // SDL resets the viewport and the scale while rendering to a texture, and
+  // restores them after
+  if (SDL_SetRenderTarget(s->renderer, s->world) != 0 ||
+      SDL_SetRenderDrawColor(s->renderer, 0, 0, 0, 255) != 0 ||
+      SDL_RenderClear(s->renderer) != 0) {
+    LOG_ERROR("%s", SDL_GetError());
+    return -1;
+  }
+
+  return 0;
+}
+
+int scene_world_end(struct scene_state *s) {
+  assert_not_null(3, s, s->renderer, s->world);
+
+  static const SDL_Rect dst = {0, 0, LEVEL_WIDTH * SIZE_FACTOR,
+                               LEVEL_HEIGHT * SIZE_FACTOR};
+  if (SDL_SetRenderTarget(s->renderer, NULL) != 0 ||
+      SDL_RenderCopy(s->renderer, s->world, NULL, &dst) != 0) {
+    LOG_ERROR("%s", SDL_GetError());
+    return -1;
+  }
+
+  return 0;
+}
+
 void scene_state_present(struct scene_state *s) {
   assert_not_null(2, s, s->renderer);
   SDL_RenderPresent(s->renderer);
@@ -186,7 +260,7 @@ int scene_state_fullscreen(struct scene_state *s, bool fullscreen) {
 
   return 0;
 #else
-  Uint32 flags = fullscreen ? SDL_WINDOW_FULLSCREEN : 0;
+  Uint32 flags = fullscreen ? SDL_WINDOW_FULLSCREEN_DESKTOP : 0;
   if (SDL_SetWindowFullscreen(s->window, flags) != 0) {
     LOG_ERROR("could not toggle fullscreen: %s", SDL_GetError());
     return -1;
@@ -3,6 +3,7 @@
 
 #include "base.h"
 
+#include "batch.h"
 #include "message.h"
 #include <SDL2/SDL_ttf.h>
 
@@ -27,6 +28,15 @@ struct scene_state {
   SDL_Window *window;
   // The sprite sheet
   SDL_Texture *sprite_sheet;
+  // The batch the sprites are drawn with, one draw call per layer of sprites
+  // (see batch.h)
+  struct batch *batch;
+  // The game world is rendered into this texture at its native size, see
+  // scene_world_begin
+  SDL_Texture *world;
+  // scale is the number of pixels of the window per pixel of the game world.
+  // It is the largest integer that fits the window, see scene_state_clear.
+  int scale;
   // The font we will be using to render the text for our game messages
   TTF_Font *font;
 };
@@ -56,6 +66,9 @@ enum scene_id {
   // SCENE_ACKNOWLEDGEMENTS displays acknowledgements for public domain content
   // we used in the game
   SCENE_ACKNOWLEDGEMENTS,
+  // SCENE_VIEW shows a game streamed by another instance of the game, see
+  // stream.h
+  SCENE_VIEW,
   // SCENE_COUNT should always be the final element as it is the size used
   // to initialize the g_scenes array.
   SCENE_COUNT,
@@ -75,6 +88,9 @@ struct scene {
   scene_handler destroy;
 };
 
+// g_scenes is a global static array containing all the scenes declared.
+extern struct scene *g_scenes[];
+
 // scene_state_create creates all the necessary state (window, sprites, fonts)
 // for rendering all scenes in the game. Returns NULL on failure.
 struct scene_state *scene_state_create(void);
@@ -82,9 +98,22 @@ struct scene_state *scene_state_create(void);
 // scene_state_destroy deallocates the state created by create_scene_state
 void scene_state_destroy(struct scene_state **ps);
 
-// scene_state_clear paints the screen black
+// scene_state_clear paints the screen black, and lays it out at the largest
+// integer scale that fits the window, centered. Everything is then drawn in the
+// pixels of a window of scale SIZE_FACTOR, and scaled to the actual scale.
+// Returns 0 on success, -1 on failure.
 int scene_state_clear(struct scene_state *s);
 
+// scene_world_begin clears the game world, and makes the following draws
+// render into it at its native size: LEVEL_WIDTH x LEVEL_HEIGHT pixels, one
+// per pixel of the sprite sheet. Returns 0 on success, -1 on failure.
+int scene_world_begin(struct scene_state *s);
+
+// scene_world_end copies the game world to the top of the screen, scaled up by
+// an integer, and makes the following draws render to the screen again.
+// Returns 0 on success, -1 on failure.
+int scene_world_end(struct scene_state *s);
+
 // scene_state_present internally calls SDL_RenderPresent
 void scene_state_present(struct scene_state *s);
 
@@ -129,5 +158,6 @@ void scene_end_load(void);
 void scene_menu_load(void);
 void scene_options_load(void);
 void scene_acknowledgements_load(void);
+void scene_view_load(void);
 
 #endif // SCENE_H
@@ -3,7 +3,7 @@
 #include "fps.h"
 #include "render.h"
 #include "safe.h"
-#include "sound.h"
+#include "sound_mixer.h"
 #include "state.h"
 
 #define BUF_LEN 2048
@@ -31,7 +31,7 @@ static int scene_acknowledgements_iterate(void) {
 
   if (k[SDL_SCANCODE_LEFT] || k[SDL_SCANCODE_RIGHT]) {
     // play the sound effect either way
-    sound_play(SOUND_MENU_MOVE, CHANNEL_UI);
+    sound_mixer_play(SOUND_MENU_MOVE, CHANNEL_UI);
   }
 
   return 0;
@@ -70,7 +70,7 @@ static int scene_end_render(struct scene_state *s) {
 static int scene_end_iterate(void) {
   assert_not_null(1, end_timer);
 
-  fps_timer_iterate(end_timer);
+  fps_timer_iterate(end_timer, fps_frame_time(&g_prog.fps));
 
   if (!fps_timer_done(end_timer)) {
     return 0;
@@ -3,20 +3,51 @@
 #include "camera.h"
 #include "default_levels.h"
 #include "fps.h"
+#include "history.h"
 #include "level.h"
+#include "lily.h"
 #include "message.h"
 #include "player.h"
 #include "safe.h"
+#include "sound_mixer.h"
+#include "sprite_def.h"
 #include "state.h"
+#include "stream.h"
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
 
 // DEBUG_LEVEL_START is the level to start the game with. Can be changed to a
 // value other than 0, for debugging specific levels.
 static const size_t DEBUG_LEVEL_START = 0;
 
+// DEBUG_SOLIDS outlines the solid rectangles of the level (see solid.h) over
+// its tiles. Can be set to true, for debugging collisions.
+static const bool DEBUG_SOLIDS = false;
+
 // This file contains the implementation for SCENE_GAME. Any functions required
 // outside the scope of this file are declared in scene.h.
 
-static size_t _level;
+// game is the state of the game played in the scene
+struct game {
+  // world is the game world, see lily.h
+  struct lily_world *world;
+  // sprite_defs are the custom sprite types of the game, or NULL if there are
+  // none, and tokens the token_count tokens of custom levels, which include
+  // the tokens of the custom sprite types
+  struct sprite_defs *sprite_defs;
+  struct token_entry tokens[CUSTOM_LEVEL_TOKEN_COUNT + SPRITE_DEF_COUNT];
+  size_t token_count;
+};
+
+// _game is the game played in the scene, from its creation to its destruction
+static struct game *_game = NULL;
+
+// _camera helps keep track of the part of the level to render, based on the
+// position of the player. We use this to implement side-scrolling
+// functionality.
+static SDL_Rect _camera;
 
 // secret_timer is a timer for a secret cheat code in the game that makes the
 // player scroll through levels
@@ -24,192 +55,222 @@ static struct fps_timer *secret_timer = NULL;
 
 static const Uint64 SECRET_DELAY = 250;
 
-// multiplies the size factor to a rect
-static void rect_factor_size(SDL_Rect *r) {
-  r->x *= SIZE_FACTOR;
-  r->y *= SIZE_FACTOR;
-  r->w *= SIZE_FACTOR;
-  r->h *= SIZE_FACTOR;
-}
+// _history records the last frames of the game, so the player can rewind them
+// by holding down R
+static struct history *_history = NULL;
+
+enum {
+  // REWIND_SECONDS is how far back the game can be rewound
+  REWIND_SECONDS = 10,
+  // REWIND_BUDGET is the memory used to record the frames that can be rewound
+  REWIND_BUDGET = 4 * 1024 * 1024,
+};
+
+// SPRITE_DEFS is the file of the custom sprite types of the game, compiled by
+// lily_sprites (see sprite_def.h). The game runs without it.
+static const char *SPRITE_DEFS = "share/sprites/sprites.bin";
+
+// _hash_log is the file the hash of the game is logged to, if
+// g_prog.hash_log_location is set. It only holds the game being played, so
+// that it can be played again headless (see digest_log_replay).
+static FILE *_hash_log = NULL;
+
+// stream_frame streams the current frame of the world w to the spectators, if
+// the game is streamed (see stream.h). If the stream fails, e.g because the
+// spectators disconnected, the game goes on without it.
+static void stream_frame(const struct lily_world *w) {
+  if (g_prog.stream == NULL) {
+    return;
+  }
 
-// render all active sprites
-static int active_sprites(struct scene_state *state, struct level *l,
-                          SDL_Rect *cam) {
-  struct array *arr = l->active_sprites;
-  SDL_Texture *sheet = state->sprite_sheet;
+  if (stream_writer_write(g_prog.stream, w) != 0) {
+    LOG_ERROR("stopped streaming the game");
+    stream_writer_destroy(&g_prog.stream);
+  }
+}
 
-  assert_not_null(5, state, l, cam, arr, sheet);
+// add_sprite adds the sprite s to the batch b, unless it was removed or is out
+// of the camera cam. Returns 0 on success, -1 on failure.
+static int add_sprite(struct batch *b, const struct sprite *s,
+                      const SDL_Rect *cam) {
+  assert_not_null(1, s);
 
-  const double dt = fps_frame_time(); // in milliseconds
+  if (s->removed) {
+    // don't render removed sprites
+    return 0;
+  }
 
-  register size_t i;
-  for (i = 0; i < arr->l; i++) {
-    struct sprite *s = arr->a[i];
-    assert_not_null(1, s);
+  const struct animation *a = &s->animation;
 
-    if (s->removed) {
-      // don't render removed sprites
-      continue;
-    }
+  // -- render the active sprite --
+  SDL_Rect src = s->rect;
+  if (a->type == ANIMATION_FRAME_VERTICAL) {
+    src.y += src.h * a->frame;
+  } else {
+    src.x += src.w * a->frame;
+  }
 
-    // -- animation --
-    struct animation *a = &s->animation;
-    a->frame_delay_counter -= dt;
-    if (a->frame_delay_counter <= 0) {
-      a->frame_delay_counter = a->frame_delay; // reset
-      a->frame += 1;                           // increment frame
-      if (a->frame > a->frame_end) {
-        a->frame = a->frame_start; // loop frames
-      }
+  SDL_Rect dst = {
+      s->x,  // x
+      s->y,  // y
+      src.w, // w
+      src.h  // h
+  };
 
-      if (a->type == ANIMATION_FLIP) { // switch out the flip
-        if (a->flip == SDL_FLIP_HORIZONTAL) {
-          a->flip = SDL_FLIP_NONE;
-        } else {
-          a->flip = SDL_FLIP_HORIZONTAL;
-        }
-      }
-    }
+  if (!camera_map(cam, &dst)) {
+    return 0;
+  }
 
-    SDL_SetTextureAlphaMod(sheet, a->alpha);
+  return batch_add(b, &src, &dst, a->alpha, a->flip);
+}
 
-    // -- render the active sprite --
-    SDL_Rect src = s->type->rect;
-    if (a->type == ANIMATION_FRAME_VERTICAL) {
-      src.y += src.h * a->frame;
-    } else {
-      src.x += src.w * a->frame;
-    }
+// render all active sprites and projectiles, with one draw call (see batch.h)
+static int active_sprites(struct scene_state *state, struct level *l,
+                          SDL_Rect *cam) {
+  struct array *arr = l->active_sprites;
+  const struct projectile_pool *pool = l->projectiles;
+  struct batch *b = state->batch;
 
-    SDL_Rect dst = {
-        s->x,  // x
-        s->y,  // y
-        src.w, // w
-        src.h  // h
-    };
+  assert_not_null(5, state, l, cam, arr, pool);
 
-    if (!camera_map(cam, &dst)) {
-      continue;
+  // the projectiles are shots, which are rendered after the active sprites of
+  // a higher depth
+  register size_t i, j;
+  for (i = 0; i < arr->l && arr->a[i]->type->id > SPRITE_SHOT; i++) {
+    if (add_sprite(b, arr->a[i], cam) != 0) {
+      return -1;
     }
+  }
 
-    rect_factor_size(&dst);
-
-    if (SDL_RenderCopyEx(state->renderer, sheet, &src, &dst, 0, NULL,
-                         a->flip) != 0) {
-      LOG_ERROR("%s", SDL_GetError());
+  for (j = 0; j < pool->count; j++) {
+    if (add_sprite(b, projectile_get(pool, j), cam) != 0) {
       return -1;
     }
+  }
 
-    SDL_SetTextureAlphaMod(sheet, 255);
+  for (; i < arr->l; i++) {
+    if (add_sprite(b, arr->a[i], cam) != 0) {
+      return -1;
+    }
   }
 
-  return 0;
+  return batch_flush(b, state->renderer);
 }
 
-// render all passive sprites
-static int passive_sprites(struct scene_state *s, struct level *l,
-                           SDL_Rect *cam) {
+// render all passive sprites and the items that were not collected, with one
+// draw call (see batch.h)
+static int passive_sprites(struct scene_state *s, const struct lily_world *w,
+                           struct level *l, SDL_Rect *cam) {
   register size_t r, c;
   for (r = 0; r < ROW_COUNT * l->h; r++) {
     for (c = 0; c < COLUMN_COUNT * l->w; c++) {
 
-      struct sprite_type *t = l->passive_sprites[r * COLUMN_COUNT * l->w + c];
+      // a tile holds either a passive sprite or an item
+      const size_t i = r * COLUMN_COUNT * l->w + c;
+      enum sprite_id id = l->passive_sprites[i];
+      if (id == SPRITE_NONE) {
+        id = level_item(l, i);
+      }
+      const struct sprite_type *t = &w->sprite_types[id];
 
-      // draw the passive sprite
+      // draw the passive sprite, at the current frame of its type if it is
+      // animated
       SDL_Rect src = t->rect; // source rect
+      src.x += src.w * sprite_type_tile_frame(t, w->tile_clock);
       // destination rect
       SDL_Rect dst = {SPRITE_SIZE * c, SPRITE_SIZE * r, src.w, src.h};
       if (!camera_map(cam, &dst)) {
         continue;
       }
 
-      rect_factor_size(&dst);
-
-      if (SDL_RenderCopy(s->renderer, s->sprite_sheet, &src, &dst) != 0) {
-        LOG_ERROR("%s", SDL_GetError());
+      if (batch_add(s->batch, &src, &dst, 255, SDL_FLIP_NONE) != 0) {
         return -1;
       }
     }
   }
 
-  return 0;
+  return batch_flush(s->batch, s->renderer);
 }
 
-// g_game_create initializes the global game state. Returns 0 on success, -1 on
-// failure.
-static int g_game_create(void) {
-  // start at the first level, unless we are debugging.
-  _level = DEBUG_LEVEL_START;
-  g_prog.state = PROG_GAME_IN; // we are officially in the game
-  g_game.level = NULL;
-  g_game.player = malloc(sizeof(struct player));
-  if (g_game.player == NULL) {
-    // errno = ENOMEM;
+// solids outlines every solid rectangle of the level l, see DEBUG_SOLIDS.
+// Returns 0 on success, -1 on failure.
+static int solids(struct scene_state *s, const struct level *l,
+                  const SDL_Rect *cam) {
+  const struct solid_map *m = l->solids;
+  if (SDL_SetRenderDrawColor(s->renderer, 255, 0, 255, 255) != 0) {
+    LOG_ERROR("failed to outline solid rects: %s", SDL_GetError());
     return -1;
   }
 
-  // start with an empty, null-terminated message
-  g_game.message = message_create();
-  if (g_game.message == NULL) {
-    return -1;
-  }
+  register size_t i;
+  for (i = 0; i < m->count; i++) {
+    const struct solid_rect *rect = &m->rects[i];
+    SDL_Rect dst = {SPRITE_SIZE * rect->c, SPRITE_SIZE * rect->r,
+                    SPRITE_SIZE * rect->w, SPRITE_SIZE * rect->h};
+    if (!camera_map(cam, &dst)) {
+      continue;
+    }
 
-  // initialize the player
-  if (player_create(g_game.player) != 0) {
-    free(g_game.player);
-    g_game.player = NULL;
-    return -1;
+    if (SDL_RenderDrawRect(s->renderer, &dst) != 0) {
+      LOG_ERROR("failed to outline solid rects: %s", SDL_GetError());
+      return -1;
+    }
   }
 
   return 0;
 }
 
-// g_game_destroy destroys all game state and frees up any memory allocated on
-// the heap in the g_game struct.
-static void g_game_destroy(void) {
-  // If we currently have a level, free that level
-  struct level *l = g_game.level;
-  if (l != NULL) {
-    level_free(&l); // this should also free player->sprite
+// load_sprite_defs loads the custom sprite types of the game g into its world,
+// if there are any, so that custom levels can use them. Returns 0 on success,
+// -1 on failure.
+static int load_sprite_defs(struct game *g) {
+  memcpy(g->tokens, CUSTOM_LEVEL_TOKENS, sizeof(CUSTOM_LEVEL_TOKENS));
+  g->token_count = CUSTOM_LEVEL_TOKEN_COUNT;
+
+  g->sprite_defs = sprite_defs_load_file(SPRITE_DEFS);
+  if (g->sprite_defs == NULL) {
+    return errno == ENOENT ? 0 : -1;
   }
 
-  message_destroy(&g_game.message);
+  const int n = sprite_defs_tokens(g->sprite_defs, CUSTOM_LEVEL_TOKENS,
+                                   CUSTOM_LEVEL_TOKEN_COUNT, g->tokens,
+                                   sizeof(g->tokens) / sizeof(g->tokens[0]));
+  if (n < 0 || lily_world_set_sprite_defs(g->world, g->sprite_defs) != 0) {
+    return -1;
+  }
 
-  // Free the player
-  player_destroy(&g_game.player);
+  g->token_count = (size_t)n;
+  LOG_INFO("%lu custom sprites loaded.", (unsigned long)g->sprite_defs->count);
+  return 0;
+}
 
-  // free the sprite types
-  g_sprite_types_destroy();
+// load_level loads the level number `index` of the game g, or the custom level
+// if there is one. Returns 0 on success, -1 on failure.
+static int load_level(struct game *g, const size_t index) {
+  const char *filename = g_prog.custom_level_path;
 
-  // if we have a custom level path set, free it.
-  if (g_game.custom_level_path != NULL) {
-    free(g_game.custom_level_path);
-    g_game.custom_level_path = NULL;
-  }
-}
+  // frames of the previous level cannot be rewound to
+  history_clear(_history);
 
-static int load_current_level(void) {
-  const char *filename;
-  const struct token_entry *tokens;
-  size_t tokens_count;
+  if (filename == NULL) {
+    if (lily_world_load_default_level(g->world, index) != 0) {
+      LOG_ERROR("failed to load %s", LEVELS[index]);
+      return -1;
+    }
 
-  bool custom = g_game.custom_level_path != NULL;
-  if (custom) {
-    filename = g_game.custom_level_path;
-    tokens = CUSTOM_LEVEL_TOKENS;
-    tokens_count = CUSTOM_LEVEL_TOKEN_COUNT;
-  } else {
-    filename = LEVELS[_level];
-    tokens = LEVEL_TOKENS[_level];
-    tokens_count = LEVEL_TOKENS_COUNT[_level];
+    LOG_INFO("level %lu loaded.", (unsigned long)index);
+    return 0;
   }
 
-  if (level_load(filename, tokens, tokens_count) != 0) {
+  if (lily_world_load_level_file(g->world, filename, g->tokens,
+                                 g->token_count) != 0) {
     LOG_ERROR("failed to load %s", filename);
     return -1;
   }
 
-  LOG_INFO("level %lu loaded.", (unsigned long)_level);
+  // the custom level is played as many times as there are levels in the game
+  g->world->level_index = index;
+  LOG_INFO("custom level loaded.");
   return 0;
 }
 
@@ -219,42 +280,95 @@ static int scene_game_create(void) {
     return -1;
   }
 
-  // initialize the sprite types
-  if (g_sprite_types_create() != 0) {
-    LOG_ERROR("failed to load sprite types");
+  _history = history_create(REWIND_BUDGET, REWIND_SECONDS * FRAME_RATE);
+  if (_history == NULL) {
+    return -1;
+  }
+
+  // initialize the game world
+  _game = calloc(1, sizeof(struct game));
+  if (_game == NULL) {
+    LOG_ERROR("failed to load game state");
+    return -1;
   }
 
-  // initialize the global game state
-  if (g_game_create() != 0) {
+  _game->world = lily_world_create();
+  if (_game->world == NULL) {
     LOG_ERROR("failed to load game state");
     return -1;
   }
 
-  if (load_current_level() != 0) {
+  if (load_sprite_defs(_game) != 0) {
+    LOG_ERROR("failed to load %s", SPRITE_DEFS);
+    return -1;
+  }
+
+  struct lily_world *w = _game->world;
+  lily_world_seed(w, time(NULL));
+  lily_world_set_sound_handler(w, sound_mixer_play);
+
+  if (g_prog.hash_log_location != NULL) {
+    _hash_log = fopen(g_prog.hash_log_location, "w");
+    if (_hash_log == NULL) {
+      LOG_ERROR("could not open %s", g_prog.hash_log_location);
+      return -1;
+    }
+
+    lily_world_set_hash_log(w, _hash_log);
+  }
+
+  // start at the first level, unless we are debugging.
+  if (load_level(_game, DEBUG_LEVEL_START) != 0) {
     return -1;
   }
 
-  struct level *l = g_game.level;
-  camera_create(&g_game.camera, g_game.player->s, l->w, l->h);
+  struct level *l = w->level;
+  camera_create(&_camera, w->player->s, l->w, l->h);
 
-  if (g_game.custom_level_path == NULL) {
+  if (g_prog.custom_level_path == NULL) {
     message_set(
-        g_game.message,
+        w,
         "Press C to interact with people and to dismiss this message. Use the "
         "LEFT and RIGHT arrow keys to walk. Press Q to toggle character.",
         false);
     return 0;
   }
 
-  message_set(g_game.message, "Loaded user-created level.", false);
+  message_set(w, "Loaded user-created level.", false);
   return 0;
 }
 
 static int scene_game_destroy(void) {
   assert_not_null(1, secret_timer);
   fps_timer_destroy(&secret_timer);
-  // free up any elements that are taking up heap memory in g_game
-  g_game_destroy();
+  if (_game != NULL) {
+    if (_game->world != NULL) {
+      lily_world_destroy(&_game->world);
+    }
+
+    if (_game->sprite_defs != NULL) {
+      sprite_defs_destroy(&_game->sprite_defs);
+    }
+
+    free(_game);
+    _game = NULL;
+  }
+
+  if (_history != NULL) {
+    history_destroy(&_history);
+  }
+
+  if (_hash_log != NULL) {
+    fclose(_hash_log);
+    _hash_log = NULL;
+  }
+
+  // if we have a custom level path set, free it.
+  if (g_prog.custom_level_path != NULL) {
+    free(g_prog.custom_level_path);
+    g_prog.custom_level_path = NULL;
+  }
+
   return 0;
 }
 
@@ -262,57 +376,69 @@ static bool _game_over_message_set = false;
 
 static int scene_game_iterate(void) {
   const Uint8 *k = g_prog.keys;
-  enum prog_state *s = &g_prog.state;
-  struct message *msg = g_game.message;
+  struct lily_world *w = w;
+  enum prog_state *s = &w->state;
+  struct message *msg = w->message;
 
   if (*s == PROG_GAME_LEVEL_COMPLETE) {
-    _level = SDL_min(_level + 1, LEVEL_COUNT);
+    const size_t next = w->level_index + 1;
 
-    if (_level == LEVEL_COUNT) {
-      *s = PROG_GAME_COMPLETE;
+    if (next == LEVEL_COUNT) {
+      g_prog.state = PROG_GAME_COMPLETE;
       scene_change(SCENE_END);
       return 0;
     }
 
-    *s = PROG_GAME_IN;
-
-    if (load_current_level() != 0) {
+    if (load_level(_game, next) != 0) {
       return -1;
     }
 
-    assert(g_game.player->s != NULL);
+    assert(w->player->s != NULL);
   }
 
   if (k[SDL_SCANCODE_ESCAPE]) {
     return scene_change(SCENE_MENU);
   }
 
-  if (g_prog.state == PROG_GAME_OVER) {
+  if (*s == PROG_GAME_OVER) {
 
     if (!_game_over_message_set) {
-      message_set(msg, "Game over. Press ESC to return to menu.", false);
+      message_set(w, "Game over. Press ESC to return to menu.", false);
       _game_over_message_set = true;
     }
-
-    return 0;
+  } else {
+    _game_over_message_set = false;
   }
 
-  _game_over_message_set = false;
-
-  message_iterate(msg, k[SDL_SCANCODE_C]);
+  // rewind the game by one frame instead of playing it while R is held down
+  if (k[SDL_SCANCODE_R] && history_frames(_history) > 0) {
+    if (history_pop(_history, w) != 0) {
+      return -1;
+    }
 
-  if (message_block(msg)) {
+    stream_frame(w);
     return 0;
   }
 
-  player_iterate(g_game.player);
+  // run the game logic for this frame. Once the game is over, this only keeps
+  // the sprites animated.
+  const Uint64 dt = fps_frame_time(&g_prog.fps);
+  if (lily_world_step(w, input_from_keyboard(k), dt) != 0) {
+    return -1;
+  }
 
-  if (level_iterate(g_game.level) != 0) {
+  if (history_push(_history, w) != 0) {
     return -1;
   }
 
+  stream_frame(w);
+
+  if (message_block(msg) || *s == PROG_GAME_OVER) {
+    return 0;
+  }
+
   // secret code to toggle levels
-  fps_timer_iterate(secret_timer);
+  fps_timer_iterate(secret_timer, dt);
 
   if (!fps_timer_done(secret_timer)) {
     return 0;
@@ -329,22 +455,37 @@ static int scene_game_iterate(void) {
 }
 
 static int scene_game_render(struct scene_state *s) {
-  struct player *p = g_game.player;
-  struct level *l = g_game.level;
-  struct message *msg = g_game.message;
+  const struct lily_world *w = w;
+  struct player *p = w->player;
+  struct level *l = w->level;
+  struct message *msg = w->message;
 
-  SDL_Rect *cam = &g_game.camera;
+  SDL_Rect *cam = &_camera;
   assert_not_null(4, s, p, p->s, l);
 
   // update the camera based on the player's current location
   camera_update(cam, p->s, l->w, l->h);
 
+  // the sprites are rendered at the native size of the game world, see
+  // scene_world_begin
+  if (scene_world_begin(s) != 0) {
+    return -1;
+  }
+
   // render all the passive sprites
-  passive_sprites(s, l, cam);
+  passive_sprites(s, w, l, cam);
 
   // render all active sprites
   active_sprites(s, l, cam);
 
+  if (DEBUG_SOLIDS && solids(s, l, cam) != 0) {
+    return -1;
+  }
+
+  if (scene_world_end(s) != 0) {
+    return -1;
+  }
+
   // the status and message are deliberately render *after* the sprites so they
   // aren't "behind" the sprites
 
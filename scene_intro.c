@@ -93,7 +93,7 @@ static int scene_intro_render(struct scene_state *s) {
 static int scene_intro_iterate(void) {
   assert_not_null(1, intro_timer);
 
-  fps_timer_iterate(intro_timer);
+  fps_timer_iterate(intro_timer, fps_frame_time(&g_prog.fps));
 
   if (!fps_timer_done(intro_timer)) {
     return 0;
@@ -2,8 +2,9 @@
 
 #include "file_chooser.h"
 #include "fps.h"
+#include "level_template.h"
 #include "safe.h"
-#include "sound.h"
+#include "sound_mixer.h"
 #include "state.h"
 
 #define BUF_LEN 256
@@ -58,8 +59,8 @@ static int scene_menu_destroy(void) {
 static int scene_menu_iterate(void) {
   const Uint8 *k = g_prog.keys;
 
-  fps_timer_iterate(init_timer);
-  fps_timer_iterate(scroll_timer);
+  fps_timer_iterate(init_timer, fps_frame_time(&g_prog.fps));
+  fps_timer_iterate(scroll_timer, fps_frame_time(&g_prog.fps));
 
   if (!fps_timer_done(init_timer)) {
     return 0;
@@ -71,11 +72,11 @@ static int scene_menu_iterate(void) {
 
   if (k[SDL_SCANCODE_RETURN]) {
     // play the sound effect
-    sound_play(SOUND_MENU_SELECT, CHANNEL_UI);
+    sound_mixer_play(SOUND_MENU_SELECT, CHANNEL_UI);
 
     switch (_item) {
     case MENU_START:
-      g_game.custom_level_path = NULL;
+      g_prog.custom_level_path = NULL;
       if (scene_change(SCENE_GAME) != 0) {
         goto error_out;
       }
@@ -86,22 +87,26 @@ static int scene_menu_iterate(void) {
       return 0;
 #else
       // if we already have a custom level set, destroy it
-      if (g_game.custom_level_path != NULL) {
-        free(g_game.custom_level_path);
-        g_game.custom_level_path = NULL;
+      if (g_prog.custom_level_path != NULL) {
+        free(g_prog.custom_level_path);
+        g_prog.custom_level_path = NULL;
       }
 
-      g_game.custom_level_path = file_chooser_open();
-      if (g_game.custom_level_path == NULL) {
+      g_prog.custom_level_path = file_chooser_open();
+      if (g_prog.custom_level_path == NULL) {
         LOG_INFO("could not load custom level");
         break;
       }
 
-      LOG_INFO("loading level: %s", g_game.custom_level_path);
+      LOG_INFO("loading level: %s", g_prog.custom_level_path);
+
+      // the level file may have been edited since it was last loaded, so make
+      // sure it is parsed again.
+      level_template_cache_clear();
 
       if (scene_change(SCENE_GAME) != 0) {
-        free(g_game.custom_level_path);
-        g_game.custom_level_path = NULL;
+        free(g_prog.custom_level_path);
+        g_prog.custom_level_path = NULL;
 
         goto error_out;
       }
@@ -133,7 +138,7 @@ static int scene_menu_iterate(void) {
 
   if (k[SDL_SCANCODE_DOWN] || k[SDL_SCANCODE_UP]) {
     // play the sound effect either way
-    sound_play(SOUND_MENU_MOVE, CHANNEL_UI);
+    sound_mixer_play(SOUND_MENU_MOVE, CHANNEL_UI);
     fps_timer_reset(scroll_timer);
   }
 
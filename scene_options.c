@@ -3,12 +3,12 @@
 #include "fps.h"
 #include "render.h"
 #include "safe.h"
-#include "sound.h"
+#include "sound_mixer.h"
 #include "state.h"
 
 #define BUF_LEN 256
 
-// OPTIONS_SOUND_ENABLED is in sound.c
+// OPTIONS_SOUND_ENABLED is in sound_mixer.c
 extern bool OPTIONS_SOUND_ENABLED;
 static bool OPTIONS_FULLSCREEN_ENABLED = false;
 
@@ -52,8 +52,8 @@ static int scene_options_destroy(void) {
 static int scene_options_iterate(void) {
   const Uint8 *k = g_prog.keys;
 
-  fps_timer_iterate(init_timer);
-  fps_timer_iterate(scroll_timer);
+  fps_timer_iterate(init_timer, fps_frame_time(&g_prog.fps));
+  fps_timer_iterate(scroll_timer, fps_frame_time(&g_prog.fps));
 
   if (!fps_timer_done(init_timer)) {
     return 0;
@@ -69,7 +69,7 @@ static int scene_options_iterate(void) {
 
   if (k[SDL_SCANCODE_RETURN]) {
     // play the sound effect
-    sound_play(SOUND_MENU_SELECT, CHANNEL_UI);
+    sound_mixer_play(SOUND_MENU_SELECT, CHANNEL_UI);
     fps_timer_reset(scroll_timer);
 
     switch (_item) {
@@ -87,7 +87,7 @@ static int scene_options_iterate(void) {
 
   if (k[SDL_SCANCODE_DOWN] || k[SDL_SCANCODE_UP]) {
     // play the sound effect either way
-    sound_play(SOUND_MENU_MOVE, CHANNEL_UI);
+    sound_mixer_play(SOUND_MENU_MOVE, CHANNEL_UI);
     fps_timer_reset(scroll_timer);
   }
 
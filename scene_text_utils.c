@@ -4,6 +4,7 @@
 #include "message.h"
 #include "player.h"
 #include "safe.h"
+#include "state.h"
 
 // This file contains utilities for rendering text in scenes. Any functions
 // required outside the scope of this file are declared in scene.h
@@ -157,7 +158,7 @@ int scene_player_status(struct scene_state *s, const unsigned int lives,
     return -1;
   }
 
-  unsigned int fps = (unsigned int)fps_get();
+  unsigned int fps = (unsigned int)fps_get(&g_prog.fps);
 
   const size_t BUF_LEN = 255;
   char buf[BUF_LEN];
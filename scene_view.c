@@ -0,0 +1,249 @@
+#include "scene.h"
+
+#include "camera.h"
+#include "safe.h"
+#include "sprite.h"
+#include "state.h"
+#include "stream.h"
+
+#include <string.h>
+
+// This file contains the implementation for SCENE_VIEW, which shows a game
+// streamed by another instance of the game (see stream.h) instead of playing
+// one. Nothing is simulated: the frames of the stream are rendered as is.
+//
+// Reading the stream blocks until the next frame is streamed, so the stream is
+// read on a thread of its own. The thread hands the frames over one at a time,
+// which shows every frame of the stream at the frame rate of the game.
+
+// _thread reads the stream at g_prog.view_location
+static SDL_Thread *_thread = NULL;
+// _lock guards every variable below, up to _frame
+static SDL_mutex *_lock = NULL;
+// _cond is signaled whenever _pending or _quit change
+static SDL_cond *_cond = NULL;
+// _next is the frame read last, to be shown next if _pending is true
+static struct stream_frame _next;
+static bool _pending = false;
+// _status is 1 while the stream is being read, and then the return value of
+// stream_reader_next: 0 once it ended, -1 if it could not be read
+static int _status = 1;
+// _quit is true once the scene is destroyed
+static bool _quit = false;
+
+// _frame is the frame being shown, if _shown is true
+static struct stream_frame _frame;
+static bool _shown = false;
+
+// _camera follows the player of the streamed game, see scene_game.c
+static SDL_Rect _camera;
+
+// read_stream reads the frames of the stream, and hands them over to the scene
+static int read_stream(void *data) {
+  SAFE_UNUSED(data);
+
+  SDL_RWops *rw = stream_open(g_prog.view_location, false);
+  struct stream_reader *sr = rw != NULL ? stream_reader_create(rw) : NULL;
+  int ret = sr != NULL ? 1 : -1;
+  bool quit = false;
+
+  while (ret == 1 && !quit) {
+    ret = stream_reader_next(sr);
+
+    SDL_LockMutex(_lock);
+    // wait for the previous frame to be shown
+    while (_pending && !_quit) {
+      SDL_CondWait(_cond, _lock);
+    }
+
+    if (ret == 1 && !_quit) {
+      ret = stream_frame_copy(&_next, stream_reader_frame(sr)) == 0 ? 1 : -1;
+      _pending = ret == 1;
+    }
+    _status = ret;
+    quit = _quit;
+    SDL_UnlockMutex(_lock);
+  }
+
+  if (sr != NULL) {
+    stream_reader_destroy(&sr);
+  }
+
+  return 0;
+}
+
+static int scene_view_create(void) {
+  assert_not_null(1, g_prog.view_location);
+
+  _lock = SDL_CreateMutex();
+  _cond = SDL_CreateCond();
+  if (_lock == NULL || _cond == NULL) {
+    LOG_ERROR("could not create the stream lock: %s", SDL_GetError());
+    return -1;
+  }
+
+  _pending = false;
+  _status = 1;
+  _quit = false;
+  _shown = false;
+
+  _thread = SDL_CreateThread(read_stream, "stream", NULL);
+  if (_thread == NULL) {
+    LOG_ERROR("could not create the stream thread: %s", SDL_GetError());
+    return -1;
+  }
+
+  LOG_INFO("watching %s", g_prog.view_location);
+  return 0;
+}
+
+static int scene_view_destroy(void) {
+  SDL_LockMutex(_lock);
+  _quit = true;
+  const bool done = _status != 1;
+  SDL_CondSignal(_cond);
+  SDL_UnlockMutex(_lock);
+
+  if (done) {
+    SDL_WaitThread(_thread, NULL);
+    SDL_DestroyCond(_cond);
+    SDL_DestroyMutex(_lock);
+    _cond = NULL;
+    _lock = NULL;
+  } else {
+    // the thread may be blocked reading the stream for as long as nothing is
+    // streamed: it is left to end on its own, and never touches the frames
+    // again
+    SDL_DetachThread(_thread);
+  }
+  _thread = NULL;
+
+  stream_frame_free(&_next);
+  stream_frame_free(&_frame);
+  return 0;
+}
+
+static int scene_view_iterate(void) {
+  if (g_prog.keys[SDL_SCANCODE_ESCAPE]) {
+    g_prog.state = PROG_EXIT;
+    return 0;
+  }
+
+  // show the next frame, if there is one
+  SDL_LockMutex(_lock);
+  if (_pending) {
+    const struct stream_frame tmp = _frame;
+    _frame = _next;
+    _next = tmp;
+    _pending = false;
+    _shown = true;
+    SDL_CondSignal(_cond);
+  }
+  SDL_UnlockMutex(_lock);
+
+  return 0;
+}
+
+// render the tiles of the level, with one draw call (see batch.h)
+static int passive_sprites(struct scene_state *s, const struct stream_frame *f,
+                           const SDL_Rect *cam) {
+  register size_t r, c;
+  for (r = 0; r < ROW_COUNT * f->h; r++) {
+    for (c = 0; c < COLUMN_COUNT * f->w; c++) {
+      const enum sprite_id id = f->passive_sprites[r * COLUMN_COUNT * f->w + c];
+      SDL_Rect src = f->tiles[id];
+      src.x += src.w * f->tile_frames[id];
+      SDL_Rect dst = {SPRITE_SIZE * c, SPRITE_SIZE * r, src.w, src.h};
+      if (!camera_map(cam, &dst)) {
+        continue;
+      }
+
+      if (batch_add(s->batch, &src, &dst, 255, SDL_FLIP_NONE) != 0) {
+        return -1;
+      }
+    }
+  }
+
+  return batch_flush(s->batch, s->renderer);
+}
+
+// render the active sprites, like scene_game.c does
+static int active_sprites(struct scene_state *s, const struct stream_frame *f,
+                          const SDL_Rect *cam) {
+  register size_t i;
+  for (i = 0; i < f->sprite_count; i++) {
+    const struct stream_sprite *sp = &f->sprites[i];
+    if (sp->flags & STREAM_REMOVED) {
+      continue;
+    }
+
+    SDL_Rect src = f->tiles[sp->id];
+    if (sp->flags & STREAM_FRAME_VERTICAL) {
+      src.y += src.h * sp->frame;
+    } else {
+      src.x += src.w * sp->frame;
+    }
+
+    SDL_Rect dst = {sp->x, sp->y, src.w, src.h};
+    if (!camera_map(cam, &dst)) {
+      continue;
+    }
+
+    int flip = SDL_FLIP_NONE;
+    flip |= (sp->flags & STREAM_FLIP_HORIZONTAL) ? SDL_FLIP_HORIZONTAL : 0;
+    flip |= (sp->flags & STREAM_FLIP_VERTICAL) ? SDL_FLIP_VERTICAL : 0;
+
+    if (batch_add(s->batch, &src, &dst, sp->alpha, (SDL_RendererFlip)flip) !=
+        0) {
+      return -1;
+    }
+  }
+
+  return batch_flush(s->batch, s->renderer);
+}
+
+static int scene_view_render(struct scene_state *s) {
+  SDL_LockMutex(_lock);
+  const int status = _pending ? 1 : _status;
+  SDL_UnlockMutex(_lock);
+
+  char text[MESSAGE_M_SIZE] = "Waiting for the stream...";
+  struct message msg = {text, NULL, false, 0};
+  const struct stream_frame *f = &_frame;
+
+  if (_shown) {
+    // the camera follows the player, if it has a sprite
+    struct sprite player;
+    memset(&player, 0, sizeof(player));
+    if (f->player < f->sprite_count) {
+      player.x = f->sprites[f->player].x;
+      player.y = f->sprites[f->player].y;
+    }
+    camera_create(&_camera, &player, f->w, f->h);
+
+    if (scene_world_begin(s) != 0 || passive_sprites(s, f, &_camera) != 0 ||
+        active_sprites(s, f, &_camera) != 0 || scene_world_end(s) != 0 ||
+        scene_player_status(s, f->lives, f->coins) != 0) {
+      return -1;
+    }
+
+    memcpy(text, f->message, MESSAGE_M_SIZE);
+    msg.blocking = f->message_blocking;
+  }
+
+  if (status == 0) {
+    strcpy(text, "The stream has ended. Press ESC to quit.");
+  } else if (status < 0) {
+    strcpy(text, "Could not read the stream. Press ESC to quit.");
+  }
+
+  return scene_message(s, &msg);
+}
+
+void scene_view_load(void) {
+  struct scene *s = g_scenes[SCENE_VIEW];
+  s->create = scene_view_create;
+  s->destroy = scene_view_destroy;
+  s->iterate = scene_view_iterate;
+  s->render = scene_view_render;
+}
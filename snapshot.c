@@ -0,0 +1,452 @@
+#include "snapshot.h"
+
+#include "level.h"
+#include "message.h"
+#include "player.h"
+#include "safe.h"
+#include "state.h"
+
+#include <string.h>
+
+// SNAPSHOT_MAGIC identifies a snapshot ("LILY" in ASCII)
+static const Uint32 SNAPSHOT_MAGIC = 0x594C494C;
+// SNAPSHOT_VERSION must be incremented whenever the snapshot format changes
+static const Uint32 SNAPSHOT_VERSION = 8;
+// NO_SPRITE is the player sprite index when the player has no sprite
+static const Uint32 NO_SPRITE = 0xFFFFFFFF;
+
+// header is the start of every snapshot. It identifies the level the snapshot
+// was taken in, and gives the size of the variable length parts.
+struct header {
+  Uint32 magic;
+  Uint32 version;
+  // the hash, width, height and spawn count of the level template, which
+  // identify the level
+  Uint64 level_hash;
+  Uint32 level_w;
+  Uint32 level_h;
+  Uint32 spawn_count;
+  Uint32 sprite_count;     // the number of active sprites
+  Uint32 player;           // the index of the player's sprite, or NO_SPRITE
+  Uint32 projectile_count; // the number of projectiles in flight
+  Uint32 m_len;            // the length of message.m
+  Uint32 buffer_len;       // the length of message.buffer
+};
+
+// writer appends values to a buffer of len bytes. off keeps on growing past
+// len, so the final value of off is the size the buffer needs to be.
+struct writer {
+  Uint8 *buf;
+  size_t len;
+  size_t off;
+};
+
+static void put(struct writer *wr, const void *src, const size_t n) {
+  if (wr->off + n <= wr->len) {
+    memcpy(wr->buf + wr->off, src, n);
+  }
+  wr->off += n;
+}
+
+// reader reads values from a buffer of len bytes. error is set if reading
+// past the end of the buffer.
+struct reader {
+  const Uint8 *buf;
+  size_t len;
+  size_t off;
+  bool error;
+};
+
+// get reads n bytes into dst, or skips them if dst is NULL
+static void get(struct reader *rd, void *dst, const size_t n) {
+  if (rd->error || n > rd->len - rd->off) {
+    rd->error = true;
+    return;
+  }
+
+  if (dst != NULL) {
+    memcpy(dst, rd->buf + rd->off, n);
+  }
+  rd->off += n;
+}
+
+// PUT and GET write and read a variable or struct field as is
+#define PUT(wr, v) put((wr), &(v), sizeof(v))
+#define GET(rd, v) get((rd), &(v), sizeof(v))
+
+// the world, player and message fields are staged in these structures when
+// loading a snapshot, so nothing is modified before the whole snapshot is
+// validated.
+
+struct world_fields {
+  Uint8 state;
+  Uint64 level_index;
+  Uint32 input;
+  Uint64 dt;
+  Uint64 ticks;
+  Uint64 rand;
+  Uint64 tile_clock;
+  Uint64 hash;
+};
+
+struct player_fields {
+  bool air;
+  bool ladder;
+  bool sprint;
+  bool jump;
+  struct fps_timer blink_timer;
+  struct fps_timer character_timer;
+  Uint32 lives;
+  Uint32 coins;
+  Uint64 respawn_x;
+  Uint64 respawn_y;
+  Uint64 index;
+};
+
+struct message_fields {
+  bool blocking;
+  Sint64 respond;
+};
+
+// the fields of each struct are saved one by one, so that padding bytes never
+// end up in a snapshot.
+
+static void put_world(struct writer *wr, const struct lily_world *w) {
+  struct world_fields f;
+  f.state = w->state;
+  f.level_index = w->level_index;
+  f.input = w->input;
+  f.dt = w->dt;
+  f.ticks = w->ticks;
+  f.rand = w->rand;
+  f.tile_clock = w->tile_clock;
+  f.hash = w->hash;
+
+  PUT(wr, f.state);
+  PUT(wr, f.level_index);
+  PUT(wr, f.input);
+  PUT(wr, f.dt);
+  PUT(wr, f.ticks);
+  PUT(wr, f.rand);
+  PUT(wr, f.tile_clock);
+  PUT(wr, f.hash);
+}
+
+static void get_world(struct reader *rd, struct world_fields *f) {
+  GET(rd, f->state);
+  GET(rd, f->level_index);
+  GET(rd, f->input);
+  GET(rd, f->dt);
+  GET(rd, f->ticks);
+  GET(rd, f->rand);
+  GET(rd, f->tile_clock);
+  GET(rd, f->hash);
+}
+
+static void put_player(struct writer *wr, const struct player *p) {
+  struct player_fields f;
+  f.air = p->air;
+  f.ladder = p->ladder;
+  f.sprint = p->sprint;
+  f.jump = p->jump;
+  f.blink_timer = p->blink_timer;
+  f.character_timer = p->character_timer;
+  f.lives = p->lives;
+  f.coins = p->coins;
+  f.respawn_x = p->respawn_x;
+  f.respawn_y = p->respawn_y;
+  f.index = p->index;
+
+  PUT(wr, f.air);
+  PUT(wr, f.ladder);
+  PUT(wr, f.sprint);
+  PUT(wr, f.jump);
+  PUT(wr, f.blink_timer.delay);
+  PUT(wr, f.blink_timer.time_left);
+  PUT(wr, f.character_timer.delay);
+  PUT(wr, f.character_timer.time_left);
+  PUT(wr, f.lives);
+  PUT(wr, f.coins);
+  PUT(wr, f.respawn_x);
+  PUT(wr, f.respawn_y);
+  PUT(wr, f.index);
+}
+
+static void get_player(struct reader *rd, struct player_fields *f) {
+  GET(rd, f->air);
+  GET(rd, f->ladder);
+  GET(rd, f->sprint);
+  GET(rd, f->jump);
+  GET(rd, f->blink_timer.delay);
+  GET(rd, f->blink_timer.time_left);
+  GET(rd, f->character_timer.delay);
+  GET(rd, f->character_timer.time_left);
+  GET(rd, f->lives);
+  GET(rd, f->coins);
+  GET(rd, f->respawn_x);
+  GET(rd, f->respawn_y);
+  GET(rd, f->index);
+}
+
+static void put_sprite(struct writer *wr, const struct sprite *s) {
+  const Uint8 id = s->type->id;
+  const Uint8 type = s->animation.type;
+  const Uint8 flip = s->animation.flip;
+  const Uint8 removed = s->removed;
+
+  PUT(wr, id);
+  PUT(wr, s->rect);
+  PUT(wr, type);
+  PUT(wr, s->animation.frame);
+  PUT(wr, s->animation.frame_start);
+  PUT(wr, s->animation.frame_end);
+  PUT(wr, s->animation.frame_delay);
+  PUT(wr, s->animation.frame_delay_counter);
+  PUT(wr, flip);
+  PUT(wr, s->animation.alpha);
+  PUT(wr, s->x);
+  PUT(wr, s->y);
+  PUT(wr, s->vx);
+  PUT(wr, s->vy);
+  PUT(wr, removed);
+  // sprite_init zeroes the data of every sprite, so it has no uninitialized
+  // padding bytes and can be saved as a whole
+  PUT(wr, s->data);
+}
+
+// get_sprite reads a sprite of the world w into s, and stores its sprite id in
+// id
+static void get_sprite(struct reader *rd, struct lily_world *w,
+                       struct sprite *s, Uint8 *id) {
+  GET(rd, *id);
+  if (rd->error || *id >= SPRITE_TYPE_COUNT) {
+    rd->error = true;
+    return;
+  }
+
+  Uint8 type, flip, removed;
+  s->type = &w->sprite_types[*id];
+  GET(rd, s->rect);
+  GET(rd, type);
+  GET(rd, s->animation.frame);
+  GET(rd, s->animation.frame_start);
+  GET(rd, s->animation.frame_end);
+  GET(rd, s->animation.frame_delay);
+  GET(rd, s->animation.frame_delay_counter);
+  GET(rd, flip);
+  GET(rd, s->animation.alpha);
+  GET(rd, s->x);
+  GET(rd, s->y);
+  GET(rd, s->vx);
+  GET(rd, s->vy);
+  GET(rd, removed);
+  GET(rd, s->data);
+
+  s->animation.type = type;
+  s->animation.flip = flip;
+  s->removed = removed;
+}
+
+size_t snapshot_save(const struct lily_world *w, Uint8 *buf,
+                     const size_t len) {
+  assert_not_null(4, w, w->level, w->player, w->message);
+  const struct level *l = w->level;
+  const struct array *a = l->active_sprites;
+  const struct message *msg = w->message;
+
+  struct header h = {SNAPSHOT_MAGIC,
+                     SNAPSHOT_VERSION,
+                     l->template->hash,
+                     l->template->w,
+                     l->template->h,
+                     l->template->spawn_count,
+                     a->l,
+                     NO_SPRITE,
+                     l->projectiles->count,
+                     strlen(msg->m),
+                     strlen(msg->buffer)};
+
+  register size_t i;
+  for (i = 0; i < a->l; i++) {
+    if (a->a[i] == w->player->s) {
+      h.player = i;
+    }
+  }
+
+  struct writer wr = {buf, len, 0};
+  PUT(&wr, h);
+  put_world(&wr, w);
+  put_player(&wr, w->player);
+
+  const struct message_fields mf = {msg->blocking, msg->respond};
+  PUT(&wr, mf.blocking);
+  PUT(&wr, mf.respond);
+  put(&wr, msg->m, h.m_len);
+  put(&wr, msg->buffer, h.buffer_len);
+
+  put(&wr, l->collected, level_collected_size(l));
+
+  for (i = 0; i < a->l; i++) {
+    put_sprite(&wr, a->a[i]);
+  }
+
+  // the projectiles in flight, from the oldest one
+  const struct projectile_pool *pool = l->projectiles;
+  for (i = 0; i < pool->count; i++) {
+    const struct projectile *pr = &pool->p[(pool->head + i) % pool->cap];
+    put_sprite(&wr, &pr->s);
+    PUT(&wr, pr->end);
+  }
+
+  return wr.off;
+}
+
+// resize sets the length of the array of active sprites of the level of w to
+// n, allocating or freeing sprites as required. The contents of new sprites
+// are undefined. Returns 0 on success, -1 on failure, in which case the array
+// is left unchanged.
+static int resize(struct lily_world *w, struct array *a, const size_t n) {
+  const size_t l = a->l;
+
+  register size_t i;
+  for (i = l; i < n; i++) {
+    struct sprite *s = malloc(sizeof(struct sprite));
+    if (s == NULL || array_append(a, s) != 0) {
+      free(s);
+      goto error_out;
+    }
+  }
+
+  for (i = n; i < l; i++) {
+    struct sprite *s = a->a[i];
+    assert(s->type->destroy_handler(w, s) == 0);
+    free(s);
+    a->a[i] = NULL;
+  }
+
+  a->l = n;
+  return 0;
+
+error_out:
+  for (i = l; i < a->l; i++) {
+    free(a->a[i]);
+    a->a[i] = NULL;
+  }
+  a->l = l;
+  LOG_ERROR("could not allocate sprites to load the snapshot");
+  return -1;
+}
+
+int snapshot_load(struct lily_world *w, const Uint8 *buf, const size_t len) {
+  assert_not_null(5, w, w->level, w->player, w->message, buf);
+  struct level *l = w->level;
+  struct array *a = l->active_sprites;
+  struct message *msg = w->message;
+
+  struct reader rd = {buf, len, 0, false};
+  struct header h;
+  GET(&rd, h);
+
+  if (rd.error || h.magic != SNAPSHOT_MAGIC || h.version != SNAPSHOT_VERSION) {
+    LOG_ERROR("invalid snapshot");
+    return -1;
+  }
+
+  if (h.level_hash != l->template->hash || h.level_w != l->template->w ||
+      h.level_h != l->template->h ||
+      h.spawn_count != l->template->spawn_count) {
+    LOG_ERROR("the snapshot was taken in a different level");
+    return -1;
+  }
+
+  struct world_fields wf;
+  struct player_fields pf;
+  struct message_fields mf;
+  get_world(&rd, &wf);
+  get_player(&rd, &pf);
+  GET(&rd, mf.blocking);
+  GET(&rd, mf.respond);
+
+  // validate the rest of the snapshot before modifying anything
+  struct reader check = rd;
+  get(&check, NULL, h.m_len);
+  get(&check, NULL, h.buffer_len);
+  get(&check, NULL, level_collected_size(l));
+
+  register size_t i;
+  for (i = 0; i < h.sprite_count && !check.error; i++) {
+    struct sprite s;
+    Uint8 id;
+    get_sprite(&check, w, &s, &id);
+  }
+
+  for (i = 0; i < h.projectile_count && !check.error; i++) {
+    struct sprite s;
+    Uint8 id;
+    get_sprite(&check, w, &s, &id);
+    get(&check, NULL, sizeof(double));
+  }
+
+  if (check.error || check.off != len || h.m_len >= MESSAGE_M_SIZE ||
+      h.buffer_len >= MESSAGE_BACKUP_SIZE ||
+      (h.player != NO_SPRITE && h.player >= h.sprite_count) ||
+      h.projectile_count > l->projectiles->cap) {
+    LOG_ERROR("invalid snapshot");
+    return -1;
+  }
+
+  if (resize(w, a, h.sprite_count) != 0) {
+    return -1;
+  }
+
+  w->state = wf.state;
+  w->level_index = wf.level_index;
+  w->input = wf.input;
+  w->dt = wf.dt;
+  w->ticks = wf.ticks;
+  w->rand = wf.rand;
+  w->tile_clock = wf.tile_clock;
+  w->hash = wf.hash;
+
+  struct player *p = w->player;
+  p->air = pf.air;
+  p->ladder = pf.ladder;
+  p->sprint = pf.sprint;
+  p->jump = pf.jump;
+  p->blink_timer = pf.blink_timer;
+  p->character_timer = pf.character_timer;
+  p->lives = pf.lives;
+  p->coins = pf.coins;
+  p->respawn_x = pf.respawn_x;
+  p->respawn_y = pf.respawn_y;
+  p->index = pf.index;
+
+  msg->blocking = mf.blocking;
+  msg->respond = mf.respond;
+  get(&rd, msg->m, h.m_len);
+  msg->m[h.m_len] = '\0';
+  get(&rd, msg->buffer, h.buffer_len);
+  msg->buffer[h.buffer_len] = '\0';
+
+  get(&rd, l->collected, level_collected_size(l));
+
+  for (i = 0; i < h.sprite_count; i++) {
+    Uint8 id;
+    get_sprite(&rd, w, a->a[i], &id);
+  }
+
+  p->s = h.player == NO_SPRITE ? NULL : a->a[h.player];
+
+  struct projectile_pool *pool = l->projectiles;
+  projectile_pool_clear(pool);
+  for (i = 0; i < h.projectile_count; i++) {
+    Uint8 id;
+    get_sprite(&rd, w, &pool->p[i].s, &id);
+    GET(&rd, pool->p[i].end);
+  }
+  pool->count = h.projectile_count;
+
+  // the sprites were saved in their order of depth, which this only checks
+  array_sort(a);
+  return 0;
+}
@@ -0,0 +1,39 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "base.h"
+
+#include <SDL2/SDL.h>
+
+// snapshot saves the complete state of a world (see state.h) into a compact
+// buffer, and restores a world from such a buffer. Besides the level, every
+// active sprite and projectile, the player, the game message, the
+// pseudo-random number generator and the hash of the world (see digest.h) are
+// saved. The buffer holds no pointers: sprites are stored by value, with their
+// own tile, and refer to their sprite type by id, which never changes (see
+// SPRITE_TYPES), and the player refers to its sprite by index. So a
+// snapshot can be copied, stored, compared or diffed freely (see history.h).
+//
+// The tiles of the level are not saved, as they never change, only which of
+// its items were collected: a snapshot can only be restored into a world
+// playing the same level as the world it was taken from, i.e a level whose
+// template has the same tiles, items and spawns (see level_template.hash).
+// Snapshots are only meant to be restored by the same build of the game, as the
+// values are stored in the byte order and layout of the machine.
+
+// forward declaration, see state.h
+struct lily_world;
+
+// snapshot_save saves the state of the world w, which must have a level, into
+// the buffer buf of `len` bytes. Returns the size of the snapshot in bytes. If
+// it is larger than len, the contents of buf are undefined and snapshot_save
+// must be called again with a larger buffer (buf may be NULL if len is 0).
+size_t snapshot_save(const struct lily_world *w, Uint8 *buf, const size_t len);
+
+// snapshot_load restores the world w to the state saved in the `len` bytes of
+// buf, which was populated by snapshot_save. Returns 0 on success, and -1 if
+// the snapshot is invalid or was taken in a different level, in which case w
+// is left unchanged.
+int snapshot_load(struct lily_world *w, const Uint8 *buf, const size_t len);
+
+#endif // SNAPSHOT_H
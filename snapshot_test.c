@@ -0,0 +1,158 @@
+#include "snapshot.h"
+
+#include "level.h"
+#include "lily.h"
+#include "test.h"
+#include <string.h>
+
+static const struct token_entry TOKENS[] = {
+    {'=', SPRITE_WALL_TOP, token_passive_sprite},
+    {'*', SPRITE_WALL, token_passive_sprite},
+    {'s', SPRITE_SPIDER, token_active_sprite},
+    {'G', SPRITE_GHOST, token_active_sprite},
+    {'O', SPRITE_COIN, token_active_sprite},
+    {'o', SPRITE_COIN, token_item},
+    {'P', SPRITE_PLAYER, token_player},
+    {' ', SPRITE_NONE, NULL}};
+
+static const size_t TOKEN_SIZE = 8;
+
+// a single screen level with spiders, which move randomly, a ghost, which
+// shoots at the player and so creates new sprites, and coins to collect
+static const char LEVEL[] = " s   P O o s    G   \n"
+                            "====================\n"
+                            "********************";
+
+// OTHER_LEVEL is another level, of a different size
+static const char OTHER_LEVEL[] = "                    \n"
+                                  "                    \n"
+                                  "                    \n"
+                                  "                    \n"
+                                  "                    \n"
+                                  "                    \n"
+                                  "                    \n"
+                                  "                    \n"
+                                  "                    \n"
+                                  "                    \n"
+                                  "                    \n"
+                                  "                    \n"
+                                  "     P              \n"
+                                  "====================\n"
+                                  "********************\n"
+                                  "                    \n"
+                                  "                    \n"
+                                  "                    \n"
+                                  "                    \n"
+                                  "                    \n"
+                                  "                    \n"
+                                  "                    \n"
+                                  "                    \n"
+                                  "                    \n"
+                                  "                    \n"
+                                  "                    \n"
+                                  "                    \n"
+                                  "                    \n"
+                                  "                    \n"
+                                  "                    ";
+
+enum { BUFFER_SIZE = 1 << 16 };
+
+// step steps the world n frames with a fixed sequence of inputs
+static void step(struct lily_world *w, const size_t n) {
+  register size_t i;
+  for (i = 0; i < n; i++) {
+    const Uint32 in = (i / 8) % 2 == 0 ? INPUT_RIGHT : INPUT_LEFT | INPUT_JUMP;
+    assert(lily_world_step(w, in, FRAME_TIME) == 0);
+  }
+}
+
+static void test_size(void) {
+  struct lily_world *w = test_world(LEVEL, TOKENS, TOKEN_SIZE);
+
+  // the size is returned even if the buffer is too small
+  static Uint8 buf[BUFFER_SIZE];
+  const size_t n = snapshot_save(w, NULL, 0);
+  assert(n > 0);
+  assert(snapshot_save(w, buf, n - 1) == n);
+  assert(snapshot_save(w, buf, BUFFER_SIZE) == n);
+
+  lily_world_destroy(&w);
+}
+
+// restoring a snapshot gives back the exact same world, which then keeps on
+// playing exactly like the original one
+static void test_restore(void) {
+  static Uint8 buf[BUFFER_SIZE], a[BUFFER_SIZE], b[BUFFER_SIZE];
+  struct lily_world *w = test_world(LEVEL, TOKENS, TOKEN_SIZE);
+  step(w, 30);
+
+  const size_t n = snapshot_save(w, buf, BUFFER_SIZE);
+  assert(n <= BUFFER_SIZE);
+
+  // play on, so that shots are fired and sprites are removed
+  step(w, 200);
+  const size_t na = snapshot_save(w, a, BUFFER_SIZE);
+  assert(na != n || memcmp(a, buf, n) != 0);
+
+  // restore and replay the same frames
+  assert(snapshot_load(w, buf, n) == 0);
+  assert(snapshot_save(w, b, BUFFER_SIZE) == n);
+  assert(memcmp(b, buf, n) == 0);
+
+  step(w, 200);
+  assert(snapshot_save(w, b, BUFFER_SIZE) == na);
+  assert(memcmp(a, b, na) == 0);
+
+  // a snapshot can also be restored into another world playing the level
+  struct lily_world *other = test_world(LEVEL, TOKENS, TOKEN_SIZE);
+  assert(snapshot_load(other, buf, n) == 0);
+  step(other, 200);
+  assert(snapshot_save(other, b, BUFFER_SIZE) == na);
+  assert(memcmp(a, b, na) == 0);
+
+  lily_world_destroy(&other);
+  lily_world_destroy(&w);
+}
+
+static void test_invalid(void) {
+  static Uint8 buf[BUFFER_SIZE], before[BUFFER_SIZE], after[BUFFER_SIZE];
+  struct lily_world *w = test_world(LEVEL, TOKENS, TOKEN_SIZE);
+  step(w, 30);
+  const size_t n = snapshot_save(w, buf, BUFFER_SIZE);
+
+  struct lily_world *other = test_world(OTHER_LEVEL, TOKENS, TOKEN_SIZE);
+  const size_t m = snapshot_save(other, before, BUFFER_SIZE);
+
+  // the snapshot was taken in a different level
+  assert(snapshot_load(other, buf, n) != 0);
+
+  // or in a level of the same size and spawn count, with another tile
+  char level[sizeof(LEVEL)];
+  memcpy(level, LEVEL, sizeof(LEVEL));
+  *strchr(level, '=') = '*';
+  struct lily_world *same = test_world(level, TOKENS, TOKEN_SIZE);
+  assert(same->level->template->spawn_count ==
+         w->level->template->spawn_count);
+  assert(snapshot_load(same, buf, n) != 0);
+  lily_world_destroy(&same);
+
+  // truncated snapshot
+  assert(snapshot_load(w, buf, n - 1) != 0);
+  // corrupted snapshot
+  buf[0] ^= 0xFF;
+  assert(snapshot_load(w, buf, n) != 0);
+
+  // a failed load leaves the world unchanged
+  assert(snapshot_save(other, after, BUFFER_SIZE) == m);
+  assert(memcmp(before, after, m) == 0);
+
+  lily_world_destroy(&other);
+  lily_world_destroy(&w);
+}
+
+int main(void) {
+  RUN_TEST(test_size);
+  RUN_TEST(test_restore);
+  RUN_TEST(test_invalid);
+  return 0;
+}
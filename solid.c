@@ -0,0 +1,198 @@
+#include "solid.h"
+
+#include "safe.h"
+
+// mesh merges the solid tiles of the map m into rectangles, greedily: from the
+// top left, each rectangle is grown as far right, then as far down, as the
+// tiles have the same solid type and are not part of another rectangle.
+// owners is populated with the index + 1 of the rectangle of every tile, or 0.
+static void mesh(struct solid_map *m, const enum sprite_id *tiles,
+                 const struct sprite_type *types, Uint32 *owners) {
+  const int cols = m->cols;
+#define TYPE(r, c) types[tiles[(r) * cols + (c)]].solid_type
+
+  register int r, c, i, j;
+  for (r = 0; r < m->rows; r++) {
+    for (c = 0; c < cols; c++) {
+      const enum solid_type type = TYPE(r, c);
+      if (type == SOLID_NONE || owners[r * cols + c] != 0) {
+        continue;
+      }
+
+      int w = 1;
+      while (c + w < cols && owners[r * cols + c + w] == 0 &&
+             TYPE(r, c + w) == type) {
+        w++;
+      }
+
+      int h = 1;
+      for (; r + h < m->rows; h++) {
+        for (j = c; j < c + w; j++) {
+          if (owners[(r + h) * cols + j] != 0 || TYPE(r + h, j) != type) {
+            break;
+          }
+        }
+
+        if (j < c + w) {
+          break;
+        }
+      }
+
+      const struct solid_rect rect = {r, c, w, h, type};
+      m->rects[m->count++] = rect;
+      for (i = r; i < r + h; i++) {
+        for (j = c; j < c + w; j++) {
+          owners[i * cols + j] = (Uint32)m->count;
+        }
+      }
+    }
+  }
+
+#undef TYPE
+}
+
+// rows_index populates the rectangles crossing every row of the map m, from the
+// owners of its tiles (see mesh). Returns 0 on success, -1 on failure.
+static int rows_index(struct solid_map *m, const Uint32 *owners) {
+  register int r, c;
+  register size_t i;
+
+  m->row_start = calloc(m->rows + 1, sizeof(size_t));
+  if (m->row_start == NULL) {
+    return -1;
+  }
+
+  for (i = 0; i < m->count; i++) {
+    for (r = m->rects[i].r; r < m->rects[i].r + m->rects[i].h; r++) {
+      m->row_start[r + 1]++;
+    }
+  }
+
+  for (r = 0; r < m->rows; r++) {
+    m->row_start[r + 1] += m->row_start[r];
+  }
+
+  m->row_rects = calloc(SDL_max(m->row_start[m->rows], 1), sizeof(Uint32));
+  if (m->row_rects == NULL) {
+    return -1;
+  }
+
+  // the rectangles do not overlap, so walking a row gives them in order
+  i = 0;
+  for (r = 0; r < m->rows; r++) {
+    for (c = 0; c < m->cols; c++) {
+      const Uint32 o = owners[r * m->cols + c];
+      if (o != 0) {
+        m->row_rects[i++] = o - 1;
+        c += m->rects[o - 1].w - 1;
+      }
+    }
+  }
+
+  return 0;
+}
+
+struct solid_map *solid_map_create(const enum sprite_id *tiles,
+                                   const struct sprite_type *types,
+                                   const int rows, const int cols) {
+  assert_not_null(2, tiles, types);
+  assert(rows >= 0 && cols >= 0);
+
+  struct solid_map *m = calloc(1, sizeof(struct solid_map));
+  // there are at most as many rectangles as tiles
+  Uint32 *owners = calloc(SDL_max(rows * cols, 1), sizeof(Uint32));
+  if (m == NULL || owners == NULL ||
+      (m->rects = calloc(SDL_max(rows * cols, 1),
+                         sizeof(struct solid_rect))) == NULL) {
+    LOG_ERROR("could not allocate solid map");
+    free(owners);
+    free(m);
+    return NULL;
+  }
+
+  m->rows = rows;
+  m->cols = cols;
+  mesh(m, tiles, types, owners);
+
+  if (rows_index(m, owners) != 0) {
+    LOG_ERROR("could not allocate solid map");
+    free(owners);
+    solid_map_destroy(&m);
+    return NULL;
+  }
+  free(owners);
+
+  // keep only the memory the rectangles need
+  struct solid_rect *rects =
+      realloc(m->rects, SDL_max(m->count, 1) * sizeof(struct solid_rect));
+  if (rects != NULL) {
+    m->rects = rects;
+  }
+
+  return m;
+}
+
+void solid_map_destroy(struct solid_map **pm) {
+  assert_not_null(2, pm, *pm);
+  free((*pm)->rects);
+  free((*pm)->row_rects);
+  free((*pm)->row_start);
+  free(*pm);
+  *pm = NULL;
+}
+
+int solid_map_find(const struct solid_map *m, const int r, const int c,
+                   const int dir, const enum solid_type s) {
+  assert_not_null(1, m);
+  assert(dir == 1 || dir == -1);
+
+  // the columns on either side of the level are solid
+  if (c < 0 || c >= m->cols) {
+    return c;
+  }
+
+  const int edge = dir > 0 ? m->cols : -1;
+  if (r < 0 || r >= m->rows) {
+    return edge;
+  }
+
+  const Uint32 *a = m->row_rects + m->row_start[r];
+  const size_t n = m->row_start[r + 1] - m->row_start[r];
+
+  // lo is the first rectangle of the row that ends after column c
+  register size_t lo = 0, hi = n;
+  while (lo < hi) {
+    const size_t mid = lo + (hi - lo) / 2;
+    const struct solid_rect *rect = &m->rects[a[mid]];
+    if (rect->c + rect->w <= c) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  if (dir > 0) {
+    for (; lo < n; lo++) {
+      const struct solid_rect *rect = &m->rects[a[lo]];
+      if ((rect->type & s) == s) {
+        return SDL_max(rect->c, c);
+      }
+    }
+
+    return edge;
+  }
+
+  // the rectangle lo may start after column c
+  if (lo < n && m->rects[a[lo]].c <= c) {
+    lo++;
+  }
+
+  while (lo-- > 0) {
+    const struct solid_rect *rect = &m->rects[a[lo]];
+    if ((rect->type & s) == s) {
+      return SDL_min(rect->c + rect->w - 1, c);
+    }
+  }
+
+  return edge;
+}
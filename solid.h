@@ -0,0 +1,59 @@
+#ifndef SOLID_H
+#define SOLID_H
+
+#include "base.h"
+
+#include "sprite_type.h"
+
+// solid holds the solid geometry of a level. Once a level is parsed, its solid
+// tiles are merged into as few rectangles of tiles of the same solid type as
+// possible (greedy meshing), so a wall made of hundreds of tiles is a handful
+// of rectangles. The rectangles crossing each row are indexed in column order,
+// so sweeping along a row, e.g to find the wall a shot hits or whether a ghost
+// can see the player, is a binary search among a few rectangles instead of a
+// look up of every tile on the way.
+//
+// Like util_solid, the columns on either side of the level are solid, and the
+// rows above and below it are not.
+
+// solid_rect is a rectangle of tiles of the same solid type
+struct solid_rect {
+  int r; // the row of its top left tile
+  int c; // the column of its top left tile
+  int w; // its width, in tiles
+  int h; // its height, in tiles
+  enum solid_type type;
+};
+
+// solid_map is the solid geometry of a level
+struct solid_map {
+  struct solid_rect *rects;
+  size_t count; // the number of elements of rects
+  // rows and cols are the size of the level, in tiles
+  int rows;
+  int cols;
+  // row_rects holds the indices in rects of the rectangles crossing every row,
+  // in increasing order of column: the ones crossing row r are the elements
+  // row_start[r] to row_start[r + 1] - 1.
+  Uint32 *row_rects;
+  size_t *row_start;
+};
+
+// solid_map_create meshes the tile grid `tiles` of rows x cols sprite ids, in
+// row-major order, into the solid rectangles of the sprite types `types`.
+// Returns NULL on failure.
+struct solid_map *solid_map_create(const enum sprite_id *tiles,
+                                   const struct sprite_type *types,
+                                   const int rows, const int cols);
+
+// solid_map_destroy frees the memory of the map and sets *pm to NULL
+void solid_map_destroy(struct solid_map **pm);
+
+// solid_map_find returns the first column of row r, from column c in the
+// direction dir (1 for right, -1 for left), whose tile has every solid_type
+// value in s. If there is none, returns the column past the edge of the level
+// in that direction, i.e cols or -1.
+int solid_map_find(const struct solid_map *m, const int r, const int c,
+                   const int dir, const enum solid_type s);
+
+#endif // SOLID_H
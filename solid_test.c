@@ -0,0 +1,98 @@
+#include "solid.h"
+
+#include "default_levels.h"
+#include "level.h"
+#include "lily.h"
+#include "state.h"
+#include "test.h"
+#include "util.h"
+
+// the solid types that collisions are tested with
+static const enum solid_type SOLIDS[] = {SOLID_LEFT, SOLID_RIGHT, SOLID_TOP,
+                                         SOLID_BOTTOM, SOLID_ALL};
+
+// every solid tile of every level of the game is in exactly one rectangle of
+// its solid type, and no other tile is
+static void test_mesh(void) {
+  register size_t i, j;
+  register int r, c;
+  for (i = 0; i < LEVEL_COUNT; i++) {
+    struct level_template *t =
+        level_template_get(LEVELS[i], LEVEL_TOKENS[i], LEVEL_TOKENS_COUNT[i]);
+    assert(t != NULL);
+    const struct solid_map *m = t->solids;
+    assert(m->rows == ROW_COUNT * size_t_to_int(t->h));
+    assert(m->cols == COLUMN_COUNT * size_t_to_int(t->w));
+
+    int *covered = calloc(m->rows * m->cols, sizeof(int));
+    assert(covered != NULL);
+    for (j = 0; j < m->count; j++) {
+      const struct solid_rect *rect = &m->rects[j];
+      assert(rect->w > 0 && rect->h > 0);
+      for (r = rect->r; r < rect->r + rect->h; r++) {
+        for (c = rect->c; c < rect->c + rect->w; c++) {
+          const enum sprite_id id = t->passive_sprites[r * m->cols + c];
+          assert(SPRITE_TYPES[id].solid_type == rect->type);
+          covered[r * m->cols + c]++;
+        }
+      }
+    }
+
+    size_t tiles = 0;
+    for (r = 0; r < m->rows; r++) {
+      for (c = 0; c < m->cols; c++) {
+        const enum sprite_id id = t->passive_sprites[r * m->cols + c];
+        const bool solid = SPRITE_TYPES[id].solid_type != SOLID_NONE;
+        assert(covered[r * m->cols + c] == (solid ? 1 : 0));
+        tiles += solid;
+      }
+    }
+
+    // the walls of a level are a handful of rectangles, e.g wall.level has 6
+    // times fewer rectangles than solid tiles
+    assert(m->count * 2 <= tiles);
+
+    free(covered);
+    level_template_release(&t);
+  }
+
+  level_template_cache_clear();
+}
+
+// solid_map_find finds the same tile as looking up every tile on the way with
+// util_solid, inside and around every level of the game
+static void test_find(void) {
+  struct lily_world *w = lily_world_create();
+  assert(w != NULL);
+
+  register size_t i, s;
+  register int r, c, dir;
+  for (i = 0; i < LEVEL_COUNT; i++) {
+    assert(lily_world_load_default_level(w, i) == 0);
+    const struct solid_map *m = w->level->solids;
+
+    for (s = 0; s < sizeof(SOLIDS) / sizeof(SOLIDS[0]); s++) {
+      for (r = -1; r <= m->rows; r++) {
+        for (c = -1; c <= m->cols; c++) {
+          for (dir = -1; dir <= 1; dir += 2) {
+            int expected = c;
+            while (!util_solid(w, r, expected, SOLIDS[s])) {
+              expected += dir;
+            }
+
+            assert(solid_map_find(m, r, c, dir, SOLIDS[s]) == expected);
+          }
+        }
+      }
+    }
+  }
+
+  lily_world_destroy(&w);
+  level_template_cache_clear();
+}
+
+int main(void) {
+  RUN_TEST(test_mesh);
+  RUN_TEST(test_find);
+  return 0;
+}
@@ -2,7 +2,6 @@
 #define SOUND_H
 
 #include <SDL2/SDL.h>
-#include <SDL2/SDL_mixer.h>
 
 // sound_channel contains all the channels used in the game
 enum sound_channel {
@@ -48,15 +47,19 @@ enum sound_id {
   SOUND_COUNT
 };
 
-// sound_create sets up the state necessary to have sound in the game. Returns 0
-// on success, -1 on failure.
-int sound_create(void);
+// forward declaration, see state.h
+struct lily_world;
 
-// sound_destroy destroys all sound state and frees up used resources
-void sound_destroy(void);
+// sound_handler plays the sound with id `id` at channel `c`. Returns 0 on
+// success, -1 on failure.
+typedef int (*sound_handler)(const enum sound_id id,
+                             const enum sound_channel c);
 
-// sound_play plays the sound with id `id` at channel `c`. Returns 0 on success,
-// -1 on failure.
-int sound_play(const enum sound_id id, const enum sound_channel c);
+// sound_play plays the sound with id `id` at channel `c` using the sound
+// handler of the world w (see sound_mixer.h), if it has one. The game logic
+// only ever requests sounds through sound_play, so a world can run without any
+// audio device. Returns 0 on success, -1 on failure.
+int sound_play(const struct lily_world *w, const enum sound_id id,
+               const enum sound_channel c);
 
 #endif // SOUND_H
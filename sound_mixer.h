@@ -0,0 +1,21 @@
+#ifndef SOUND_MIXER_H
+#define SOUND_MIXER_H
+
+#include "sound.h"
+
+// the SDL2_mixer backend for sound.h
+
+// sound_create sets up the state necessary to have sound in the game. Returns 0
+// on success, -1 on failure.
+int sound_create(void);
+
+// sound_destroy destroys all sound state and frees up used resources
+void sound_destroy(void);
+
+// sound_mixer_play plays the sound with id `id` at channel `c`, unless sound is
+// disabled in the options. It is the sound handler of the game's world (see
+// sound_handler), and is also used directly for the sounds of the menus.
+// Returns 0 on success, -1 on failure.
+int sound_mixer_play(const enum sound_id id, const enum sound_channel c);
+
+#endif // SOUND_MIXER_H
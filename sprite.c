@@ -48,12 +48,37 @@ void sprite_animation_set_flip(struct sprite *s, const int frame,
   animation_set(s, frame, frame, fps, ANIMATION_FLIP);
 }
 
-int sprite_init(struct sprite *s, const enum sprite_id id) {
+void sprite_animate(struct sprite *s, const Uint64 dt) {
   assert_not_null(1, s);
-  s->type = g_sprite_types[id];
+  struct animation *a = &s->animation;
+
+  a->frame_delay_counter -= (Sint64)dt;
+  if (a->frame_delay_counter <= 0) {
+    a->frame_delay_counter = a->frame_delay; // reset
+    a->frame += 1;                           // increment frame
+    if (a->frame > a->frame_end) {
+      a->frame = a->frame_start; // loop frames
+    }
+
+    if (a->type == ANIMATION_FLIP) { // switch out the flip
+      if (a->flip == SDL_FLIP_HORIZONTAL) {
+        a->flip = SDL_FLIP_NONE;
+      } else {
+        a->flip = SDL_FLIP_HORIZONTAL;
+      }
+    }
+  }
+}
+
+int sprite_init(struct lily_world *w, struct sprite *s,
+                const enum sprite_id id) {
+  assert_not_null(2, w, s);
+  s->type = &w->sprite_types[id];
+  s->rect = s->type->rect;
   // all are ints, multiple assignment seems fine here
   s->x = s->y = s->vx = s->vy = 0;
   s->removed = false;
+  SDL_memset(&s->data, 0, sizeof(union sprite_data));
 
   // initialize the animation
   s->animation.flip = SDL_FLIP_NONE;
@@ -65,8 +90,14 @@ int sprite_init(struct sprite *s, const enum sprite_id id) {
   // second.
   sprite_animation_set_frame(s, 0, 0, 0);
   // since we are initializing this sprite, also call its initialization
-  // sprite handler.
-  if (s->type->init_handler(s) != 0) {
+  // sprite handler. A custom sprite type has none unless the world has its
+  // sprite definition (see lily_world_set_sprite_defs).
+  if (s->type->init_handler == NULL) {
+    LOG_ERROR("no handlers for sprite with id: %d", id);
+    return -1;
+  }
+
+  if (s->type->init_handler(w, s) != 0) {
     LOG_ERROR("failed to initialize sprite with id: %d", s->type->id);
     return -1;
   }
@@ -13,8 +13,12 @@ struct sprite {
   // those sprites. As an example, let's see we have a sprite_type of TREE and
   // we have three trees in a level. Then we will have three `sprite`s and 1
   // `sprite_type`. Each of the three sprites will store the same sprite_type
-  // pointer.
-  struct sprite_type *type;
+  // pointer. Sprite types never change (see SPRITE_TYPES).
+  const struct sprite_type *type;
+  // rect is the rect of the sprite in the sprite sheet, which is the rect of
+  // its type unless the sprite changed its tile, e.g the player switching
+  // characters
+  SDL_Rect rect;
   struct animation animation;
 
   // TODO: figure out if these can be simplified to integers
@@ -42,9 +46,13 @@ void sprite_animation_set_frame_vertical(struct sprite *s, const int start,
 void sprite_animation_set_flip(struct sprite *s, const int frame,
                                const int fps);
 
+// sprite_animate advances the animation of the sprite by dt milliseconds
+void sprite_animate(struct sprite *s, const Uint64 dt);
+
 // sprite_init takes in a pointer to a sprite along with a
-// sprite_id and sets up the default values for all its fields. Returns 0 on
-// success, -1 on failure.
-int sprite_init(struct sprite *s, const enum sprite_id id);
+// sprite_id and sets up the default values for all its fields, using the sprite
+// types of the world w. Returns 0 on success, -1 on failure.
+int sprite_init(struct lily_world *w, struct sprite *s,
+                const enum sprite_id id);
 
 #endif // SPRITE_H
@@ -20,17 +20,27 @@ struct data_item {
 struct data_enemy {
   enum direction dir;
   bool alive;
-  struct fps_timer *remove_timer;
-  struct fps_timer *shoot_timer;
+  struct fps_timer remove_timer;
+  struct fps_timer shoot_timer;
+  // rand is the state of the pseudo-random number generator of the enemy, see
+  // util_rand_state
+  Uint64 rand;
+  // state is the state of an enemy defined by a sprite definition, and
+  // state_time the time it has been in that state for, in milliseconds (see
+  // sprite_def.h)
+  Uint8 state;
+  Uint32 state_time;
 };
 
 // data_helper contains the data necessary to process a helper character
 struct data_helper {
-  struct fps_timer *interaction_timer;
+  struct fps_timer interaction_timer;
 };
 
 // sprite_data contains sprite type specific information we will need for the
-// game. A union is the best data structure we could think of for this.
+// game. A union is the best data structure we could think of for this. It only
+// holds plain values (no pointers), so a sprite can be copied as is, e.g to
+// take a snapshot of a world (see snapshot.h).
 union sprite_data {
   struct data_item item;
   struct data_enemy enemy;
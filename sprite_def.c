@@ -0,0 +1,893 @@
+#include "sprite_def.h"
+
+#include "event.h"
+#include "handlers.h"
+#include "level.h"
+#include "player.h"
+#include "safe.h"
+#include "sound.h"
+#include "state.h"
+#include "util.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// SPRITE_DEFS_MAGIC starts a compiled sprite definitions file
+static const char SPRITE_DEFS_MAGIC[4] = {'L', 'S', 'P', 'R'};
+// SPRITE_DEFS_VERSION must be incremented whenever the binary format changes
+static const Uint8 SPRITE_DEFS_VERSION = 1;
+
+// The binary format is SPRITE_DEFS_MAGIC, SPRITE_DEFS_VERSION and the number
+// of definitions (a Uint8), followed by every definition: its token, tile row
+// and column, body, solid (0 for none, 1 for all), animation start, end and
+// fps, hit, bounce, dead frame, dead delay, state count and op count, then the
+// first operation of every state and the operations, as a code, a and b.
+// Uint16 values are little-endian, and every other value is a Uint8.
+
+enum {
+  // LINE_SIZE is the maximum length of a line of the text format
+  LINE_SIZE = 256,
+  // NAME_SIZE is the maximum length of a state name, plus one
+  NAME_SIZE = 32,
+  // MAX_WORDS is the maximum number of words of a line
+  MAX_WORDS = 6,
+};
+
+// ---------------
+// -- Compiling --
+// ---------------
+
+// parser is the state of sprite_defs_compile
+struct parser {
+  struct sprite_defs *d;
+  struct sprite_def *def; // the definition being parsed, or NULL
+  size_t line;            // the number of the line being parsed
+  // the names of the states of def
+  char states[SPRITE_DEF_STATES][NAME_SIZE];
+  // the state names the operations of def go to, and the lines they are on,
+  // which are resolved once every state of def was parsed
+  char refs[SPRITE_DEF_OPS][NAME_SIZE];
+  size_t ref_lines[SPRITE_DEF_OPS];
+};
+
+// number parses the word s as an integer from 0 to max. Returns true on
+// success, and populates v with it.
+static bool number(const char *s, const long max, long *v) {
+  char *end;
+  errno = 0;
+  *v = strtol(s, &end, 10);
+  return errno == 0 && end != s && *end == '\0' && *v >= 0 && *v <= max;
+}
+
+// split splits the line s into at most MAX_WORDS words, ending s at the start
+// of a comment. Returns the number of words, or -1 if there are too many.
+static int split(char *s, char *words[MAX_WORDS]) {
+  char *comment = strchr(s, '#');
+  if (comment != NULL) {
+    *comment = '\0';
+  }
+
+  int n = 0;
+  for (;;) {
+    while (*s == ' ' || *s == '\t' || *s == '\r') {
+      s++;
+    }
+
+    if (*s == '\0') {
+      return n;
+    }
+
+    if (n == MAX_WORDS) {
+      return -1;
+    }
+
+    words[n++] = s;
+    while (*s != '\0' && *s != ' ' && *s != '\t' && *s != '\r') {
+      s++;
+    }
+
+    if (*s != '\0') {
+      *s++ = '\0';
+    }
+  }
+}
+
+// finish completes the definition being parsed, resolving the states its
+// operations go to. Returns 0 on success, -1 on failure.
+static int finish(struct parser *p) {
+  struct sprite_def *def = p->def;
+  if (def == NULL) {
+    return 0;
+  }
+
+  if (def->token == '\0' || def->state_count == 0) {
+    LOG_ERROR("line %lu: sprite without a token or a state",
+              (unsigned long)p->line);
+    return -1;
+  }
+
+  def->states[def->state_count] = def->op_count;
+
+  register size_t i, k;
+  for (i = 0; i < def->op_count; i++) {
+    struct sprite_op *op = &def->ops[i];
+    if (op->code != SPRITE_OP_SIGHT && op->code != SPRITE_OP_LOST &&
+        op->code != SPRITE_OP_AFTER) {
+      continue;
+    }
+
+    for (k = 0; k < def->state_count; k++) {
+      if (strcmp(p->refs[i], p->states[k]) == 0) {
+        break;
+      }
+    }
+
+    if (k == def->state_count) {
+      LOG_ERROR("line %lu: unknown state %s", (unsigned long)p->ref_lines[i],
+                p->refs[i]);
+      return -1;
+    }
+
+    *(op->code == SPRITE_OP_AFTER ? &op->b : &op->a) = (Uint16)k;
+  }
+
+  p->def = NULL;
+  return 0;
+}
+
+// begin starts the definition of a new sprite. Returns 0 on success, -1 on
+// failure.
+static int begin(struct parser *p) {
+  if (finish(p) != 0) {
+    return -1;
+  }
+
+  if (p->d->count == SPRITE_DEF_COUNT) {
+    LOG_ERROR("line %lu: more than %d sprites", (unsigned long)p->line,
+              SPRITE_DEF_COUNT);
+    return -1;
+  }
+
+  struct sprite_def *def = &p->d->defs[p->d->count++];
+  memset(def, 0, sizeof(struct sprite_def));
+  def->rect = (SDL_Rect){0, 0, SPRITE_SIZE, SPRITE_SIZE};
+  def->body = (SDL_Rect){0, 0, SPRITE_SIZE, SPRITE_SIZE};
+  def->solid = SOLID_ALL;
+  def->dead_frame = 5;
+  def->dead_delay = 2000;
+  def->hit = SPRITE_DEF_HIT_KILL;
+  p->def = def;
+  return 0;
+}
+
+// add_op adds an operation to the current state of the definition being
+// parsed. ref is the name of the state it goes to, or NULL. Returns 0 on
+// success, -1 on failure.
+static int add_op(struct parser *p, const enum sprite_op_code code,
+                  const long a, const long b, const char *ref) {
+  struct sprite_def *def = p->def;
+  if (def->op_count == SPRITE_DEF_OPS) {
+    LOG_ERROR("line %lu: more than %d operations", (unsigned long)p->line,
+              SPRITE_DEF_OPS);
+    return -1;
+  }
+
+  if (ref != NULL) {
+    if (strlen(ref) >= NAME_SIZE) {
+      LOG_ERROR("line %lu: state name too long", (unsigned long)p->line);
+      return -1;
+    }
+
+    strcpy(p->refs[def->op_count], ref);
+    p->ref_lines[def->op_count] = p->line;
+  }
+
+  def->ops[def->op_count++] =
+      (struct sprite_op){(Uint8)code, (Uint16)a, (Uint16)b};
+  return 0;
+}
+
+// parse_line parses the n words of a line. Returns 0 on success, -1 on
+// failure.
+static int parse_line(struct parser *p, char *words[MAX_WORDS], const int n) {
+  const char *k = words[0];
+  long v[MAX_WORDS] = {0};
+  register int i;
+
+  if (strcmp(k, "sprite") == 0 && n == 2) {
+    return begin(p);
+  }
+
+  struct sprite_def *def = p->def;
+  if (def == NULL) {
+    LOG_ERROR("line %lu: %s outside of a sprite", (unsigned long)p->line, k);
+    return -1;
+  }
+
+  // every keyword but these takes numbers only
+  const bool words_only = strcmp(k, "token") == 0 ||
+                          strcmp(k, "solid") == 0 || strcmp(k, "hit") == 0 ||
+                          strcmp(k, "state") == 0 || strcmp(k, "sight") == 0 ||
+                          strcmp(k, "lost") == 0 || strcmp(k, "after") == 0;
+  // and these take bytes only
+  const bool bytes = strcmp(k, "tile") == 0 || strcmp(k, "body") == 0 ||
+                     strcmp(k, "anim") == 0;
+  for (i = 1; i < n && !words_only; i++) {
+    if (!number(words[i], bytes ? SDL_MAX_UINT8 : SDL_MAX_UINT16,
+                &v[i - 1])) {
+      LOG_ERROR("line %lu: invalid number %s", (unsigned long)p->line,
+                words[i]);
+      return -1;
+    }
+  }
+
+  if (strcmp(k, "token") == 0 && n == 2 && strlen(words[1]) == 1) {
+    def->token = words[1][0];
+  } else if (strcmp(k, "tile") == 0 && n == 3) {
+    def->rect.y = (int)v[0] * SPRITE_SIZE;
+    def->rect.x = (int)v[1] * SPRITE_SIZE;
+  } else if (strcmp(k, "body") == 0 && n == 5) {
+    def->body = (SDL_Rect){(int)v[0], (int)v[1], (int)v[2], (int)v[3]};
+  } else if (strcmp(k, "solid") == 0 && n == 2 &&
+             (strcmp(words[1], "none") == 0 || strcmp(words[1], "all") == 0)) {
+    def->solid = strcmp(words[1], "all") == 0 ? SOLID_ALL : SOLID_NONE;
+  } else if (strcmp(k, "anim") == 0 && n == 4) {
+    def->anim_start = (Uint8)v[0];
+    def->anim_end = (Uint8)v[1];
+    def->anim_fps = (Uint8)v[2];
+  } else if (strcmp(k, "dead") == 0 && n == 3 && v[0] <= SDL_MAX_UINT8) {
+    def->dead_frame = (Uint8)v[0];
+    def->dead_delay = (Uint16)v[1];
+  } else if (strcmp(k, "hit") == 0 && n == 2 &&
+             strcmp(words[1], "none") == 0) {
+    def->hit = SPRITE_DEF_HIT_NONE;
+  } else if (strcmp(k, "hit") == 0 && n == 2 &&
+             strcmp(words[1], "kill") == 0) {
+    def->hit = SPRITE_DEF_HIT_KILL;
+  } else if (strcmp(k, "hit") == 0 && n == 3 &&
+             strcmp(words[1], "bounce") == 0 &&
+             number(words[2], SDL_MAX_UINT16, &v[0])) {
+    def->hit = SPRITE_DEF_HIT_BOUNCE;
+    def->bounce = (Uint16)v[0];
+  } else if (strcmp(k, "state") == 0 && n == 2) {
+    if (def->state_count == SPRITE_DEF_STATES ||
+        strlen(words[1]) >= NAME_SIZE) {
+      LOG_ERROR("line %lu: too many states, or state name too long",
+                (unsigned long)p->line);
+      return -1;
+    }
+
+    strcpy(p->states[def->state_count], words[1]);
+    def->states[def->state_count++] = def->op_count;
+  } else if (def->state_count == 0) {
+    LOG_ERROR("line %lu: invalid %s, or outside of a state",
+              (unsigned long)p->line, k);
+    return -1;
+  } else if (strcmp(k, "patrol") == 0 && n == 2) {
+    return add_op(p, SPRITE_OP_PATROL, v[0], 0, NULL);
+  } else if (strcmp(k, "chase") == 0 && n == 2) {
+    return add_op(p, SPRITE_OP_CHASE, v[0], 0, NULL);
+  } else if (strcmp(k, "shoot") == 0 && n == 3) {
+    return add_op(p, SPRITE_OP_SHOOT, v[0], v[1], NULL);
+  } else if (strcmp(k, "sight") == 0 && n == 2) {
+    return add_op(p, SPRITE_OP_SIGHT, 0, 0, words[1]);
+  } else if (strcmp(k, "lost") == 0 && n == 2) {
+    return add_op(p, SPRITE_OP_LOST, 0, 0, words[1]);
+  } else if (strcmp(k, "after") == 0 && n == 3 &&
+             number(words[1], SDL_MAX_UINT16, &v[0])) {
+    return add_op(p, SPRITE_OP_AFTER, v[0], 0, words[2]);
+  } else {
+    LOG_ERROR("line %lu: invalid %s", (unsigned long)p->line, k);
+    return -1;
+  }
+
+  return 0;
+}
+
+// writer appends values to a buffer of len bytes. off keeps on growing past
+// len, so the final value of off is the size the buffer needs to be.
+struct writer {
+  Uint8 *buf;
+  size_t len;
+  size_t off;
+};
+
+static void put8(struct writer *wr, const Uint8 v) {
+  if (wr->off < wr->len) {
+    wr->buf[wr->off] = v;
+  }
+  wr->off++;
+}
+
+static void put16(struct writer *wr, const Uint16 v) {
+  put8(wr, (Uint8)(v & 0xFF));
+  put8(wr, (Uint8)(v >> 8));
+}
+
+// encode writes the sprite definitions d in the binary format to wr
+static void encode(const struct sprite_defs *d, struct writer *wr) {
+  register size_t i, j;
+  for (i = 0; i < sizeof(SPRITE_DEFS_MAGIC); i++) {
+    put8(wr, (Uint8)SPRITE_DEFS_MAGIC[i]);
+  }
+  put8(wr, SPRITE_DEFS_VERSION);
+  put8(wr, (Uint8)d->count);
+
+  for (i = 0; i < d->count; i++) {
+    const struct sprite_def *def = &d->defs[i];
+    put8(wr, (Uint8)def->token);
+    put8(wr, (Uint8)(def->rect.y / SPRITE_SIZE));
+    put8(wr, (Uint8)(def->rect.x / SPRITE_SIZE));
+    put8(wr, (Uint8)def->body.x);
+    put8(wr, (Uint8)def->body.y);
+    put8(wr, (Uint8)def->body.w);
+    put8(wr, (Uint8)def->body.h);
+    put8(wr, def->solid == SOLID_ALL);
+    put8(wr, def->anim_start);
+    put8(wr, def->anim_end);
+    put8(wr, def->anim_fps);
+    put8(wr, def->hit);
+    put16(wr, def->bounce);
+    put8(wr, def->dead_frame);
+    put16(wr, def->dead_delay);
+    put8(wr, def->state_count);
+    put8(wr, def->op_count);
+    for (j = 0; j < def->state_count; j++) {
+      put8(wr, def->states[j]);
+    }
+    for (j = 0; j < def->op_count; j++) {
+      put8(wr, def->ops[j].code);
+      put16(wr, def->ops[j].a);
+      put16(wr, def->ops[j].b);
+    }
+  }
+}
+
+size_t sprite_defs_compile(const char *src, const size_t len, Uint8 *buf,
+                           const size_t cap) {
+  assert_not_null(2, src, buf);
+
+  struct parser *p = calloc(1, sizeof(struct parser));
+  struct sprite_defs *d = calloc(1, sizeof(struct sprite_defs));
+  if (p == NULL || d == NULL) {
+    LOG_ERROR("could not allocate sprite definitions");
+    free(p);
+    free(d);
+    return 0;
+  }
+
+  p->d = d;
+  size_t ret = 0;
+  size_t off = 0;
+  while (off < len) {
+    const char *end = memchr(src + off, '\n', len - off);
+    const size_t n = (end != NULL ? (size_t)(end - src) : len) - off;
+    p->line++;
+    if (n >= LINE_SIZE) {
+      LOG_ERROR("line %lu: line too long", (unsigned long)p->line);
+      goto out;
+    }
+
+    char line[LINE_SIZE];
+    memcpy(line, src + off, n);
+    line[n] = '\0';
+    off += n + 1;
+
+    char *words[MAX_WORDS];
+    const int count = split(line, words);
+    if (count < 0) {
+      LOG_ERROR("line %lu: too many words", (unsigned long)p->line);
+      goto out;
+    }
+
+    if (count > 0 && parse_line(p, words, count) != 0) {
+      goto out;
+    }
+  }
+
+  if (finish(p) != 0) {
+    goto out;
+  }
+
+  struct writer wr = {buf, cap, 0};
+  encode(d, &wr);
+  if (wr.off > cap) {
+    LOG_ERROR("sprite definitions too large");
+    goto out;
+  }
+
+  // the binary is loaded back, which validates what the syntax does not
+  struct sprite_defs *check = sprite_defs_load(buf, wr.off);
+  if (check != NULL) {
+    sprite_defs_destroy(&check);
+    ret = wr.off;
+  }
+
+out:
+  free(p);
+  free(d);
+  return ret;
+}
+
+// -------------
+// -- Loading --
+// -------------
+
+// reader reads values from a buffer of len bytes. error is set if reading
+// past the end of the buffer.
+struct reader {
+  const Uint8 *buf;
+  size_t len;
+  size_t off;
+  bool error;
+};
+
+static Uint8 get8(struct reader *rd) {
+  if (rd->error || rd->off == rd->len) {
+    rd->error = true;
+    return 0;
+  }
+
+  return rd->buf[rd->off++];
+}
+
+static Uint16 get16(struct reader *rd) {
+  const Uint16 lo = get8(rd);
+  return lo | (Uint16)(get8(rd) << 8);
+}
+
+// valid_ops returns true if the operations of the definition def are valid
+static bool valid_ops(const struct sprite_def *def) {
+  register size_t i;
+  for (i = 0; i < def->state_count; i++) {
+    if (def->states[i] > def->states[i + 1]) {
+      return false;
+    }
+  }
+
+  for (i = 0; i < def->op_count; i++) {
+    const struct sprite_op *op = &def->ops[i];
+    switch (op->code) {
+    case SPRITE_OP_PATROL:
+    case SPRITE_OP_CHASE:
+      break;
+    case SPRITE_OP_SHOOT:
+      if (op->a == 0) {
+        return false;
+      }
+      break;
+    case SPRITE_OP_SIGHT:
+    case SPRITE_OP_LOST:
+      if (op->a >= def->state_count) {
+        return false;
+      }
+      break;
+    case SPRITE_OP_AFTER:
+      if (op->b >= def->state_count) {
+        return false;
+      }
+      break;
+    default:
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// decode reads a definition from rd into def. Returns true if it is valid.
+static bool decode(struct reader *rd, struct sprite_def *def) {
+  register size_t i;
+  def->token = (char)get8(rd);
+  const int row = get8(rd);
+  const int col = get8(rd);
+  def->rect = (SDL_Rect){col * SPRITE_SIZE, row * SPRITE_SIZE, SPRITE_SIZE,
+                         SPRITE_SIZE};
+  def->body.x = get8(rd);
+  def->body.y = get8(rd);
+  def->body.w = get8(rd);
+  def->body.h = get8(rd);
+  const Uint8 solid = get8(rd);
+  def->solid = solid ? SOLID_ALL : SOLID_NONE;
+  def->anim_start = get8(rd);
+  def->anim_end = get8(rd);
+  def->anim_fps = get8(rd);
+  def->hit = get8(rd);
+  def->bounce = get16(rd);
+  def->dead_frame = get8(rd);
+  def->dead_delay = get16(rd);
+  def->state_count = get8(rd);
+  def->op_count = get8(rd);
+  if (rd->error || def->state_count == 0 ||
+      def->state_count > SPRITE_DEF_STATES ||
+      def->op_count > SPRITE_DEF_OPS) {
+    return false;
+  }
+
+  for (i = 0; i < def->state_count; i++) {
+    def->states[i] = get8(rd);
+  }
+  def->states[def->state_count] = def->op_count;
+
+  for (i = 0; i < def->op_count; i++) {
+    def->ops[i].code = get8(rd);
+    def->ops[i].a = get16(rd);
+    def->ops[i].b = get16(rd);
+  }
+
+  return !rd->error && def->token > ' ' && def->token <= '~' &&
+         def->body.w > 0 && def->body.h > 0 &&
+         def->body.x + def->body.w <= SPRITE_SIZE &&
+         def->body.y + def->body.h <= SPRITE_SIZE && solid <= 1 &&
+         def->anim_start <= def->anim_end &&
+         def->hit < SPRITE_DEF_HIT_COUNT && def->states[0] == 0 &&
+         valid_ops(def);
+}
+
+// the handlers of the custom sprite types, see below
+static int custom_init(struct lily_world *w, struct sprite *s);
+static int custom_hit(struct lily_world *w, struct sprite *s);
+
+struct sprite_defs *sprite_defs_load(const Uint8 *buf, const size_t len) {
+  assert_not_null(1, buf);
+
+  struct sprite_defs *d = calloc(1, sizeof(struct sprite_defs));
+  if (d == NULL) {
+    LOG_ERROR("could not allocate sprite definitions");
+    return NULL;
+  }
+
+  struct reader rd = {buf, len, 0, false};
+  register size_t i, j;
+  for (i = 0; i < sizeof(SPRITE_DEFS_MAGIC); i++) {
+    if (get8(&rd) != (Uint8)SPRITE_DEFS_MAGIC[i]) {
+      LOG_ERROR("not a sprite definitions file");
+      goto error_out;
+    }
+  }
+
+  if (get8(&rd) != SPRITE_DEFS_VERSION) {
+    LOG_ERROR("unsupported sprite definitions version");
+    goto error_out;
+  }
+
+  d->count = get8(&rd);
+  if (d->count > SPRITE_DEF_COUNT) {
+    LOG_ERROR("too many sprite definitions: %lu", (unsigned long)d->count);
+    goto error_out;
+  }
+
+  for (i = 0; i < d->count; i++) {
+    if (!decode(&rd, &d->defs[i])) {
+      LOG_ERROR("invalid sprite definition %lu", (unsigned long)i);
+      goto error_out;
+    }
+
+    for (j = 0; j < i; j++) {
+      if (d->defs[j].token == d->defs[i].token) {
+        LOG_ERROR("token %c used by two sprite definitions", d->defs[i].token);
+        goto error_out;
+      }
+    }
+  }
+
+  if (rd.off != len) {
+    LOG_ERROR("invalid sprite definitions: %lu trailing bytes",
+              (unsigned long)(len - rd.off));
+    goto error_out;
+  }
+
+  memcpy(d->types, SPRITE_TYPES, sizeof(d->types));
+  for (i = 0; i < d->count; i++) {
+    const struct sprite_def *def = &d->defs[i];
+    struct sprite_type *t = &d->types[SPRITE_CUSTOM + i];
+    t->id = t->parent_id = (enum sprite_id)(SPRITE_CUSTOM + i);
+    t->rect = def->rect;
+    t->body = def->body;
+    t->solid_type = def->solid;
+    t->init_handler = custom_init;
+    t->frame_handler = sprite_def_frame;
+    t->hit_handler = custom_hit;
+    t->destroy_handler = handler_sprite_destroy;
+  }
+
+  return d;
+
+error_out:
+  free(d);
+  return NULL;
+}
+
+struct sprite_defs *sprite_defs_load_file(const char *filename) {
+  assert_not_null(1, filename);
+
+  FILE *f = fopen(filename, "rb");
+  if (f == NULL) {
+    if (errno != ENOENT) {
+      LOG_ERROR("could not open %s", filename);
+    }
+    return NULL;
+  }
+
+  // one more byte than the largest file, to tell if the file is too large
+  Uint8 buf[SPRITE_DEFS_SIZE + 1];
+  const size_t len = fread(buf, 1, sizeof(buf), f);
+  const bool error = ferror(f) != 0;
+  fclose(f);
+  if (error || len > SPRITE_DEFS_SIZE) {
+    LOG_ERROR("could not read %s", filename);
+    errno = EINVAL;
+    return NULL;
+  }
+
+  struct sprite_defs *d = sprite_defs_load(buf, len);
+  if (d == NULL) {
+    errno = EINVAL;
+  }
+  return d;
+}
+
+void sprite_defs_destroy(struct sprite_defs **pd) {
+  assert_not_null(2, pd, *pd);
+  free(*pd);
+  *pd = NULL;
+}
+
+const struct sprite_def *sprite_defs_get(const struct sprite_defs *d,
+                                         const enum sprite_id id) {
+  assert_not_null(1, d);
+  if (id < SPRITE_CUSTOM || (size_t)(id - SPRITE_CUSTOM) >= d->count) {
+    return NULL;
+  }
+
+  return &d->defs[id - SPRITE_CUSTOM];
+}
+
+int sprite_defs_tokens(const struct sprite_defs *d,
+                       const struct token_entry *arr, const size_t n,
+                       struct token_entry *out, const size_t cap) {
+  assert_not_null(3, d, arr, out);
+  if (n + d->count > cap) {
+    LOG_ERROR("too many tokens");
+    return -1;
+  }
+
+  memcpy(out, arr, n * sizeof(struct token_entry));
+  register size_t i, j;
+  for (i = 0; i < d->count; i++) {
+    for (j = 0; j < n; j++) {
+      if (arr[j].t == d->defs[i].token) {
+        LOG_ERROR("token %c of a sprite definition is taken", arr[j].t);
+        return -1;
+      }
+    }
+
+    out[n + i] = (struct token_entry){d->defs[i].token,
+                                      (enum sprite_id)(SPRITE_CUSTOM + i),
+                                      token_active_sprite};
+  }
+
+  return (int)(n + d->count);
+}
+
+// ------------------
+// -- Interpreting --
+// ------------------
+
+// walk makes the sprite s walk in the direction dir at `speed`
+static void walk(struct sprite *s, const enum direction dir,
+                 const double speed) {
+  s->data.enemy.dir = dir;
+  s->animation.flip = dir == DIR_LEFT ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE;
+  s->vx = dir == DIR_LEFT ? -speed : speed;
+}
+
+// patrol moves the sprite s at `speed`, turning it around at walls, like a
+// spider (see handler_spider_frame)
+static void patrol(struct lily_world *w, struct sprite *s, const double speed) {
+  walk(s, s->data.enemy.dir, speed);
+  const enum collision c = util_move_x(w, s);
+
+  if (c & COLLISION_LEFT) {
+    walk(s, DIR_RIGHT, speed);
+  }
+
+  if (c & COLLISION_RIGHT) {
+    walk(s, DIR_LEFT, speed);
+  }
+}
+
+// chase moves the sprite s at `speed` to the player along the flow field of
+// the level (see flow.h), like a skeleton that does not see the player (see
+// handler_skeleton_frame). It stands still where the path leaves its floor,
+// and patrols if the player is out of reach.
+static void chase(struct lily_world *w, struct sprite *s, const double speed) {
+  int r, c;
+  util_nearest(s, &r, &c);
+  switch (flow_field_dir(w->level->flow, r, c)) {
+  case FLOW_LEFT:
+    s->data.enemy.dir = DIR_LEFT;
+    patrol(w, s, speed);
+    break;
+  case FLOW_RIGHT:
+    s->data.enemy.dir = DIR_RIGHT;
+    patrol(w, s, speed);
+    break;
+  case FLOW_WAIT:
+    walk(s, s->data.enemy.dir, 0);
+    break;
+  case FLOW_NONE:
+    patrol(w, s, speed);
+    break;
+  }
+}
+
+// shoot shoots at the player every `delay` milliseconds if they are visible,
+// like a ghost (see handler_ghost_frame). Returns 0 on success, -1 on failure.
+static int shoot(struct lily_world *w, struct sprite *s, const Uint16 delay,
+                 const double speed) {
+  struct fps_timer *t = &s->data.enemy.shoot_timer;
+  if (t->delay != delay) {
+    fps_timer_init(t, delay);
+  }
+
+  fps_timer_iterate(t, w->dt);
+  if (!fps_timer_done(t) || !util_visible(w, s, w->player->s)) {
+    return 0;
+  }
+
+  fps_timer_reset(t);
+
+  int r, c;
+  util_nearest(s, &r, &c);
+  const double vx = s->data.enemy.dir == DIR_LEFT ? -speed : speed;
+  return event_emit_tile(w, EVENT_SPAWN, SPRITE_SHOT, r, c, vx);
+}
+
+// transition takes the first transition of the current state of the sprite s
+// whose condition holds, if any
+static void transition(struct lily_world *w, const struct sprite_def *def,
+                       struct sprite *s) {
+  struct data_enemy *e = &s->data.enemy;
+  int visible = -1; // computed once, if a transition needs it
+
+  register size_t i;
+  for (i = def->states[e->state]; i < def->states[e->state + 1]; i++) {
+    const struct sprite_op *op = &def->ops[i];
+    if (op->code == SPRITE_OP_AFTER && e->state_time >= op->a) {
+      e->state = (Uint8)op->b;
+      e->state_time = 0;
+      return;
+    }
+
+    if (op->code != SPRITE_OP_SIGHT && op->code != SPRITE_OP_LOST) {
+      continue;
+    }
+
+    if (visible < 0) {
+      visible = util_visible(w, s, w->player->s);
+    }
+
+    if (visible == (op->code == SPRITE_OP_SIGHT)) {
+      e->state = (Uint8)op->a;
+      e->state_time = 0;
+      return;
+    }
+  }
+}
+
+// step runs a frame of the custom sprite s, of definition def, in the world w.
+// Returns 0 on success, -1 on failure.
+static int step(struct lily_world *w, const struct sprite_def *def,
+                struct sprite *s) {
+  assert_not_null(4, w, def, s, w->player->s);
+  struct data_enemy *e = &s->data.enemy;
+
+  if (!e->alive) {
+    fps_timer_iterate(&e->remove_timer, w->dt);
+    return fps_timer_done(&e->remove_timer) ? event_emit(w, EVENT_DESPAWN, s)
+                                            : 0;
+  }
+
+  const Uint64 time = (Uint64)e->state_time + w->dt;
+  e->state_time = (Uint32)SDL_min(time, SDL_MAX_UINT32);
+  transition(w, def, s);
+
+  register size_t i;
+  for (i = def->states[e->state]; i < def->states[e->state + 1]; i++) {
+    const struct sprite_op *op = &def->ops[i];
+
+    switch (op->code) {
+    case SPRITE_OP_CHASE:
+      chase(w, s, op->a);
+      break;
+    case SPRITE_OP_PATROL:
+      patrol(w, s, op->a);
+      break;
+    case SPRITE_OP_SHOOT:
+      if (shoot(w, s, op->a, op->b) != 0) {
+        return -1;
+      }
+      break;
+    default:
+      // transitions were taken already
+      break;
+    }
+  }
+
+  return 0;
+}
+
+// custom_init initializes a custom sprite like a spider (see
+// handler_spider_init), with the animation of its definition, in the initial
+// state of its definition
+static int custom_init(struct lily_world *w, struct sprite *s) {
+  assert_not_null(3, w, w->sprite_defs, s);
+  const struct sprite_def *def = sprite_defs_get(w->sprite_defs, s->type->id);
+  if (def == NULL) {
+    LOG_ERROR("no sprite definition for sprite with id: %d", s->type->id);
+    return -1;
+  }
+
+  struct data_enemy *e = &s->data.enemy;
+  walk(s, util_fair_coin_flip(w) ? DIR_LEFT : DIR_RIGHT, 0);
+  e->alive = true;
+  e->state = 0;
+  e->state_time = 0;
+  fps_timer_init(&e->remove_timer, def->dead_delay);
+
+  // the shoot timer starts with the delay of the first shoot operation
+  register size_t i;
+  for (i = 0; i < def->op_count; i++) {
+    if (def->ops[i].code == SPRITE_OP_SHOOT) {
+      fps_timer_init(&e->shoot_timer, def->ops[i].a);
+      break;
+    }
+  }
+
+  sprite_animation_set_frame(s, def->anim_start, def->anim_end,
+                             def->anim_fps);
+  return 0;
+}
+
+int sprite_def_frame(struct lily_world *w, struct sprite *s) {
+  assert_not_null(3, w, w->sprite_defs, s);
+  const struct sprite_def *def = sprite_defs_get(w->sprite_defs, s->type->id);
+  if (def == NULL) {
+    LOG_ERROR("no sprite definition for sprite with id: %d", s->type->id);
+    return -1;
+  }
+
+  return step(w, def, s);
+}
+
+// custom_hit does what the definition of the sprite s says it does when it
+// collides with the player, like a spider for SPRITE_DEF_HIT_BOUNCE (see
+// handler_spider_hit)
+static int custom_hit(struct lily_world *w, struct sprite *s) {
+  struct player *p = w->player;
+  assert_not_null(4, w->sprite_defs, p, p->s, s);
+  const struct sprite_def *def = sprite_defs_get(w->sprite_defs, s->type->id);
+  if (def == NULL) {
+    LOG_ERROR("no sprite definition for sprite with id: %d", s->type->id);
+    return -1;
+  }
+
+  if (!s->data.enemy.alive || def->hit == SPRITE_DEF_HIT_NONE) {
+    return 0;
+  }
+
+  if (def->hit == SPRITE_DEF_HIT_BOUNCE && p->air && p->s->y < s->y &&
+      p->s->vy > 0) {
+    sound_play(w, SOUND_HIT, CHANNEL_SPRITE);
+
+    p->s->vy = -(double)def->bounce;
+    s->data.enemy.alive = false;
+    sprite_animation_set_frame(s, def->dead_frame, def->dead_frame, 0);
+    return 0;
+  }
+
+  return event_emit(w, EVENT_KILL, s);
+}
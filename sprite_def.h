@@ -0,0 +1,168 @@
+#ifndef SPRITE_DEF_H
+#define SPRITE_DEF_H
+
+#include "base.h"
+
+#include "sprite_type.h"
+#include "token.h"
+
+// sprite_def implements the custom sprite types (see SPRITE_CUSTOM), which are
+// defined by a file rather than by the code, so that enemies can be added to
+// the game without compiling it. A sprite definition gives the tile and body
+// of the sprite, whether it is solid, its animation and what happens when it
+// hits the player. Its behaviour is a small state machine: each state is a
+// list of operations, which are parameterized primitives (walking, chasing,
+// shooting) and transitions to other states (on seeing the player, on losing
+// sight of them, after a delay).
+//
+// Sprite definitions are written in a text file, e.g share/sprites/, which is
+// compiled to a compact binary file by lily_sprites (see sprite_defs_compile).
+// The game loads the binary file, and the levels map tokens to the custom
+// sprite types (see sprite_defs_tokens). The text format is one keyword and its
+// arguments per line, and `#` starts a comment until the end of the line:
+//
+//   sprite NAME        starts the definition of the sprite NAME
+//   token C            the token of the sprite in levels, a single character
+//   tile ROW COL       its tile on the sprite sheet
+//   body X Y W H       its body within the tile (default: the whole tile)
+//   solid none|all     whether it is solid (default: all)
+//   anim START END FPS its animation frames (default: 0 0 0)
+//   dead FRAME DELAY   the frame shown once it is squished, and the time in
+//                      milliseconds before it is removed (default: 5 2000)
+//   hit none|kill      what happens when it collides with the player: nothing,
+//   hit bounce V       the player is killed, or the player squishes it and
+//                      bounces up at V pixels per second if they fall on it,
+//                      and is killed otherwise (default: kill)
+//   state NAME         starts the state NAME. The first state is the initial
+//                      state of the sprite.
+//
+// followed, within a state, by its operations, run in order at every frame:
+//
+//   patrol SPEED       walk at SPEED pixels per second, turning at walls
+//   chase SPEED        walk at SPEED pixels per second to the player along
+//                      the flow field of the level (see flow.h), standing
+//                      still where the path leaves the floor, or like patrol
+//                      if the player is out of reach
+//   shoot DELAY SPEED  shoot at the player every DELAY milliseconds if they
+//                      are visible, the shot flying at SPEED pixels per second
+//   sight STATE        go to STATE if the player is visible (see util_visible)
+//   lost STATE         go to STATE if the player is not visible
+//   after MS STATE     go to STATE once MS milliseconds were spent in the state
+//
+// A sprite takes at most one transition per frame, the first one of its state
+// whose condition holds, before running the operations of the state it is in.
+
+// forward declarations, see state.h and sprite.h
+struct lily_world;
+struct sprite;
+
+enum {
+  // SPRITE_DEF_COUNT is the maximum number of sprite definitions of a file
+  SPRITE_DEF_COUNT = SPRITE_CUSTOM_LAST - SPRITE_CUSTOM + 1,
+  // SPRITE_DEF_STATES is the maximum number of states of a sprite definition
+  SPRITE_DEF_STATES = 8,
+  // SPRITE_DEF_OPS is the maximum number of operations of a sprite definition,
+  // over all of its states
+  SPRITE_DEF_OPS = 32,
+  // SPRITE_DEFS_SIZE is the maximum size of a compiled sprite definitions file
+  SPRITE_DEFS_SIZE = 6 + SPRITE_DEF_COUNT *
+                             (20 + SPRITE_DEF_STATES + 5 * SPRITE_DEF_OPS),
+};
+
+// sprite_op_code enumerates the operations of the states of a sprite
+// definition, see the text format above
+enum sprite_op_code {
+  SPRITE_OP_PATROL, // a is the speed
+  SPRITE_OP_CHASE,  // a is the speed
+  SPRITE_OP_SHOOT,  // a is the delay, b the speed of the shot
+  SPRITE_OP_SIGHT,  // a is the state to go to
+  SPRITE_OP_LOST,   // a is the state to go to
+  SPRITE_OP_AFTER,  // a is the delay, b the state to go to
+  SPRITE_OP_COUNT,
+};
+
+// sprite_def_hit enumerates what happens when a custom sprite collides with
+// the player
+enum sprite_def_hit {
+  SPRITE_DEF_HIT_NONE,
+  SPRITE_DEF_HIT_KILL,
+  SPRITE_DEF_HIT_BOUNCE,
+  SPRITE_DEF_HIT_COUNT,
+};
+
+// sprite_op is an operation of a state, with its arguments a and b
+struct sprite_op {
+  Uint8 code;
+  Uint16 a, b;
+};
+
+// sprite_def is the definition of a custom sprite type
+struct sprite_def {
+  char token;
+  SDL_Rect rect; // the tile of the sprite on the sprite sheet
+  SDL_Rect body;
+  enum solid_type solid;
+  Uint8 anim_start, anim_end, anim_fps;
+  Uint8 dead_frame;
+  Uint16 dead_delay; // milliseconds
+  Uint8 hit;         // a sprite_def_hit value
+  Uint16 bounce;     // the bounce velocity, for SPRITE_DEF_HIT_BOUNCE
+  Uint8 state_count;
+  // states has the index of the first operation of every state, and
+  // states[state_count] is op_count, so the operations of the state k are
+  // ops[states[k]] to ops[states[k + 1] - 1]
+  Uint8 states[SPRITE_DEF_STATES + 1];
+  Uint8 op_count;
+  struct sprite_op ops[SPRITE_DEF_OPS];
+};
+
+// sprite_defs is a set of sprite definitions, the definition k being the
+// sprite type SPRITE_CUSTOM + k
+struct sprite_defs {
+  size_t count;
+  struct sprite_def defs[SPRITE_DEF_COUNT];
+  // types is SPRITE_TYPES with the sprite types of the definitions, to be used
+  // as the sprite types of a world (see lily_world_set_sprite_defs)
+  struct sprite_type types[SPRITE_TYPE_COUNT];
+};
+
+// sprite_defs_compile compiles the sprite definitions in the text format in
+// the `len` bytes of src to the binary format, in buf of `cap` bytes
+// (SPRITE_DEFS_SIZE is always enough). Returns the size of the binary, or 0 on
+// failure, e.g a syntax error, which is logged with its line number.
+size_t sprite_defs_compile(const char *src, const size_t len, Uint8 *buf,
+                           const size_t cap);
+
+// sprite_defs_load loads the compiled sprite definitions in the `len` bytes of
+// buf, which are validated. Returns NULL on failure.
+struct sprite_defs *sprite_defs_load(const Uint8 *buf, const size_t len);
+
+// sprite_defs_load_file works like sprite_defs_load but reads the compiled
+// sprite definitions from the file `filename`. Returns NULL on failure, with
+// errno set to ENOENT if the file does not exist, which is not logged, as
+// sprite definitions are optional.
+struct sprite_defs *sprite_defs_load_file(const char *filename);
+
+// sprite_defs_destroy frees the memory of the sprite definitions and sets *pd
+// to NULL
+void sprite_defs_destroy(struct sprite_defs **pd);
+
+// sprite_defs_get returns the definition of the custom sprite type id, or NULL
+// if d has none
+const struct sprite_def *sprite_defs_get(const struct sprite_defs *d,
+                                         const enum sprite_id id);
+
+// sprite_defs_tokens populates out, of `cap` entries, with the `n` token
+// entries of arr followed by an entry for the token of every definition of d.
+// Returns the number of entries, or -1 on failure, e.g if a definition uses a
+// token of arr.
+int sprite_defs_tokens(const struct sprite_defs *d,
+                       const struct token_entry *arr, const size_t n,
+                       struct token_entry *out, const size_t cap);
+
+// sprite_def_frame is the frame handler of the custom sprite types: it runs a
+// frame of the custom sprite s in the world w, as its sprite definition says.
+// Returns 0 on success, -1 on failure.
+int sprite_def_frame(struct lily_world *w, struct sprite *s);
+
+#endif // SPRITE_DEF_H
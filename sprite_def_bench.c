@@ -0,0 +1,110 @@
+#include "sprite_def.h"
+
+#include "input.h"
+#include "level.h"
+#include "lily.h"
+#include "player.h"
+#include "safe.h"
+#include "state.h"
+#include "test.h"
+#include <stdio.h>
+
+// sprite_def_bench compares the time it takes to update the enemies defined
+// by the sprite definitions shipped with the game (see sprite_def.h) with the
+// time it takes to update the hand-written enemies they mimic, on the synthetic
+// level of test_crowd (see test.h), whose floors are covered in enemies. Run it
+// with `make bench`.
+
+enum {
+  BENCH_TICKS = FRAME_RATE,
+  BENCH_SPRITES = 20000,
+};
+
+// SOURCE is the sprite definitions shipped with the game
+static const char *SOURCE = "share/sprites/enemies.sprites";
+
+// pair is a hand-written enemy and the custom enemy of the same behaviour
+struct pair {
+  const char *name;
+  enum sprite_id hand, custom;
+};
+
+static const struct pair PAIRS[] = {
+    {"spider / crawler", SPRITE_SPIDER, SPRITE_CUSTOM},
+    {"skeleton / stalker", SPRITE_SKELETON, SPRITE_CUSTOM + 1},
+    {"ghost / wraith", SPRITE_GHOST, SPRITE_CUSTOM + 2},
+};
+
+// compile compiles the sprite definitions of the file SOURCE. Returns NULL on
+// failure.
+static struct sprite_defs *compile(void) {
+  static char src[4096];
+  FILE *f = fopen(SOURCE, "rb");
+  if (f == NULL) {
+    return NULL;
+  }
+  const size_t len = fread(src, 1, sizeof(src), f);
+  fclose(f);
+
+  Uint8 buf[SPRITE_DEFS_SIZE];
+  const size_t size = sprite_defs_compile(src, len, buf, sizeof(buf));
+  return size > 0 ? sprite_defs_load(buf, size) : NULL;
+}
+
+// run steps a world with the sprite definitions d and BENCH_SPRITES enemies of
+// type id for BENCH_TICKS ticks. Returns the time per sprite per tick in
+// nanoseconds, or a negative value on failure.
+static double run(const struct sprite_defs *d, const enum sprite_id id) {
+  struct lily_world *w = test_crowd(d, &id, 1, BENCH_SPRITES);
+  double ret = -1;
+  const Uint64 start = SDL_GetPerformanceCounter();
+  register size_t t;
+  for (t = 0; t < BENCH_TICKS; t++) {
+    if (lily_world_step(w, INPUT_NONE, FRAME_TIME) != 0) {
+      goto out;
+    }
+  }
+
+  const double elapsed = (double)(SDL_GetPerformanceCounter() - start) /
+                         SDL_GetPerformanceFrequency();
+  ret = elapsed * 1e9 / BENCH_TICKS / BENCH_SPRITES;
+
+out:
+  lily_world_destroy(&w);
+  return ret;
+}
+
+int main(int argc, char *argv[]) {
+  SAFE_UNUSED(argc);
+  SAFE_UNUSED(argv);
+
+  struct sprite_defs *d = compile();
+  if (d == NULL) {
+    return 1;
+  }
+
+  // the rows are printed once every run is done, so the logs of the runs do
+  // not end up between them
+  double ms[sizeof(PAIRS) / sizeof(PAIRS[0])][2];
+  register size_t i;
+  for (i = 0; i < sizeof(PAIRS) / sizeof(PAIRS[0]); i++) {
+    ms[i][0] = run(d, PAIRS[i].hand);
+    ms[i][1] = run(d, PAIRS[i].custom);
+    if (ms[i][0] < 0 || ms[i][1] < 0) {
+      sprite_defs_destroy(&d);
+      return 1;
+    }
+  }
+
+  printf("%d sprites, %d ticks, ns per sprite per tick, hand-written / "
+         "defined\n",
+         BENCH_SPRITES, BENCH_TICKS);
+  for (i = 0; i < sizeof(PAIRS) / sizeof(PAIRS[0]); i++) {
+    printf("  %-18s: %7.1f | %7.1f (x%.2f)\n", PAIRS[i].name, ms[i][0],
+           ms[i][1], ms[i][1] / ms[i][0]);
+  }
+
+  sprite_defs_destroy(&d);
+  level_template_cache_clear();
+  return 0;
+}
@@ -0,0 +1,288 @@
+#include "sprite_def.h"
+
+#include "default_levels.h"
+#include "input.h"
+#include "level.h"
+#include "lily.h"
+#include "player.h"
+#include "projectile.h"
+#include "state.h"
+#include "test.h"
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+// SOURCE is the sprite definitions shipped with the game
+static const char *SOURCE = "share/sprites/enemies.sprites";
+
+static const struct token_entry TOKENS[] = {
+    {'=', SPRITE_WALL_TOP, token_passive_sprite},
+    {'*', SPRITE_WALL, token_passive_sprite},
+    {'P', SPRITE_PLAYER, token_player},
+    {'s', SPRITE_SPIDER, token_active_sprite},
+    {'k', SPRITE_SKELETON, token_active_sprite},
+    {'G', SPRITE_GHOST, token_active_sprite},
+    {' ', SPRITE_NONE, NULL}};
+
+// the player and an enemy X on the same floor, between two walls
+static const char LEVEL[] = "=P          X      =\n"
+                            "====================\n"
+                            "********************";
+
+enum { TICKS = 10 * FRAME_RATE };
+
+// compile compiles the sprite definitions of the file SOURCE. Returns them.
+static struct sprite_defs *compile(void) {
+  static char src[4096];
+  FILE *f = fopen(SOURCE, "rb");
+  assert(f != NULL);
+  const size_t len = fread(src, 1, sizeof(src), f);
+  fclose(f);
+  assert(len > 0 && len < sizeof(src));
+
+  Uint8 buf[SPRITE_DEFS_SIZE];
+  const size_t size = sprite_defs_compile(src, len, buf, sizeof(buf));
+  assert(size > 0);
+
+  struct sprite_defs *d = sprite_defs_load(buf, size);
+  assert(d != NULL);
+  return d;
+}
+
+// world creates a world with the sprite definitions d, or none if d is NULL,
+// playing LEVEL with the enemy X being the token `token`
+static struct lily_world *world(const struct sprite_defs *d, const char token) {
+  char level[sizeof(LEVEL)];
+  memcpy(level, LEVEL, sizeof(LEVEL));
+  *strchr(level, 'X') = token;
+
+  struct token_entry tokens[sizeof(TOKENS) / sizeof(TOKENS[0]) +
+                            SPRITE_DEF_COUNT];
+  int n = sizeof(TOKENS) / sizeof(TOKENS[0]);
+  memcpy(tokens, TOKENS, sizeof(TOKENS));
+  if (d != NULL) {
+    n = sprite_defs_tokens(d, TOKENS, n, tokens,
+                           sizeof(tokens) / sizeof(tokens[0]));
+    assert(n > 0);
+  }
+
+  struct lily_world *w = lily_world_create();
+  assert(w != NULL);
+  assert(lily_world_set_sprite_defs(w, d) == 0);
+  test_world_load(w, level, tokens, (size_t)n);
+  return w;
+}
+
+// enemy returns the enemy of the world w
+static const struct sprite *enemy(const struct lily_world *w) {
+  const struct array *a = w->level->active_sprites;
+  register size_t i;
+  for (i = 0; i < a->l; i++) {
+    if (a->a[i]->type->id != SPRITE_PLAYER) {
+      return a->a[i];
+    }
+  }
+
+  assert(false);
+  return NULL;
+}
+
+// same asserts that the enemies, the shots and the players of the worlds a and
+// b are in the same place
+static void same(const struct lily_world *a, const struct lily_world *b) {
+  const struct sprite *ea = enemy(a), *eb = enemy(b);
+  assert(ea->x == eb->x && ea->y == eb->y);
+  assert(ea->animation.flip == eb->animation.flip);
+  assert(ea->data.enemy.alive == eb->data.enemy.alive);
+  assert(a->player->s->x == b->player->s->x);
+  assert(a->player->s->y == b->player->s->y);
+  assert(a->player->lives == b->player->lives);
+
+  const struct projectile_pool *pa = a->level->projectiles;
+  const struct projectile_pool *pb = b->level->projectiles;
+  assert(pa->count == pb->count);
+  register size_t i;
+  for (i = 0; i < pa->count; i++) {
+    assert(projectile_get(pa, i)->x == projectile_get(pb, i)->x);
+  }
+}
+
+// race steps a world with the hand-written enemy `token` and a world with the
+// custom enemy `custom` side by side, asserting that they play out the same.
+// Returns the number of ticks the custom enemy was in a state other than its
+// first, and populates shots with the number of ticks a shot was in flight.
+static size_t race(const struct sprite_defs *d, const char token,
+                   const char custom, size_t *shots) {
+  struct lily_world *a = world(NULL, token);
+  struct lily_world *b = world(d, custom);
+  assert(enemy(b)->type->id >= SPRITE_CUSTOM);
+
+  size_t states = 0;
+  *shots = 0;
+  register size_t t;
+  for (t = 0; t < TICKS; t++) {
+    assert(lily_world_step(a, INPUT_NONE, FRAME_TIME) == 0);
+    assert(lily_world_step(b, INPUT_NONE, FRAME_TIME) == 0);
+    same(a, b);
+    states += enemy(b)->data.enemy.state != 0;
+    *shots += b->level->projectiles->count > 0;
+  }
+
+  lily_world_destroy(&a);
+  lily_world_destroy(&b);
+  return states;
+}
+
+// the shipped sprite definitions compile, with their states resolved
+static void test_compile(void) {
+  struct sprite_defs *d = compile();
+  assert(d->count == 3);
+  assert(d->types[SPRITE_SPIDER].frame_handler ==
+         SPRITE_TYPES[SPRITE_SPIDER].frame_handler);
+
+  const struct sprite_def *stalker = sprite_defs_get(d, SPRITE_CUSTOM + 1);
+  assert(stalker != NULL && stalker->token == 't');
+  assert(stalker->state_count == 2 && stalker->op_count == 4);
+  assert(stalker->ops[0].code == SPRITE_OP_SIGHT && stalker->ops[0].a == 1);
+  assert(stalker->ops[2].code == SPRITE_OP_LOST && stalker->ops[2].a == 0);
+  assert(stalker->hit == SPRITE_DEF_HIT_BOUNCE && stalker->bounce == 128);
+  assert(sprite_defs_get(d, SPRITE_CUSTOM + 3) == NULL);
+  assert(sprite_defs_get(d, SPRITE_SPIDER) == NULL);
+
+  const struct sprite_type *t = &d->types[SPRITE_CUSTOM + 2];
+  assert(t->id == SPRITE_CUSTOM + 2 && t->solid_type == SOLID_ALL);
+  assert(t->rect.x == 26 * SPRITE_SIZE && t->rect.y == 7 * SPRITE_SIZE);
+  assert(t->body.y == 6 && t->body.h == 10);
+
+  sprite_defs_destroy(&d);
+  assert(d == NULL);
+}
+
+// invalid sources and binaries are rejected
+static void test_invalid(void) {
+  static const char *SOURCES[] = {
+      "token c\n",
+      "sprite a\nstate s\npatrol 36\n",
+      "sprite a\ntoken c\n",
+      "sprite a\ntoken c\npatrol 36\n",
+      "sprite a\ntoken c\nstate s\nsight nowhere\n",
+      "sprite a\ntoken c\nstate s\npatrol -1\n",
+      "sprite a\ntoken c\nstate s\npatrol 36 36\n",
+      "sprite a\ntoken c\nstate s\nshoot 0 72\n",
+      "sprite a\ntoken c\nstate s\nfly 3\n",
+      "sprite a\ntoken cc\nstate s\n",
+      "sprite a\ntoken c\nbody 0 0 17 16\nstate s\n",
+      "sprite a\ntoken c\ntile 256 0\nstate s\n",
+      "sprite a\ntoken c\nstate s\nsprite b\ntoken c\nstate s\n",
+  };
+
+  Uint8 buf[SPRITE_DEFS_SIZE];
+  register size_t i;
+  for (i = 0; i < sizeof(SOURCES) / sizeof(SOURCES[0]); i++) {
+    assert(sprite_defs_compile(SOURCES[i], strlen(SOURCES[i]), buf,
+                               sizeof(buf)) == 0);
+  }
+
+  static const char VALID[] = "# a comment\n\nsprite a # a sprite\n"
+                              "\ttoken c\nstate s\nafter 500 s";
+  const size_t size =
+      sprite_defs_compile(VALID, sizeof(VALID) - 1, buf, sizeof(buf));
+  assert(size > 0);
+
+  // truncated, with a trailing byte, and with another magic or version
+  struct sprite_defs *d = sprite_defs_load(buf, size);
+  assert(d != NULL);
+  sprite_defs_destroy(&d);
+  assert(sprite_defs_load(buf, size - 1) == NULL);
+  assert(sprite_defs_load(buf, size + 1) == NULL);
+  buf[0] = 'X';
+  assert(sprite_defs_load(buf, size) == NULL);
+  buf[0] = 'L';
+  buf[4]++;
+  assert(sprite_defs_load(buf, size) == NULL);
+
+  errno = 0;
+  assert(sprite_defs_load_file("share/sprites/nothing.bin") == NULL);
+  assert(errno == ENOENT);
+}
+
+// the tokens of the definitions are added to the tokens of a level, unless
+// they are taken
+static void test_tokens(void) {
+  struct sprite_defs *d = compile();
+  struct token_entry out[CUSTOM_LEVEL_TOKEN_COUNT + SPRITE_DEF_COUNT];
+  const int n = sprite_defs_tokens(d, CUSTOM_LEVEL_TOKENS,
+                                   CUSTOM_LEVEL_TOKEN_COUNT, out, 64);
+  assert(n == CUSTOM_LEVEL_TOKEN_COUNT + 3);
+  assert(out[n - 1].t == 'w' && out[n - 1].s == SPRITE_CUSTOM + 2);
+  assert(out[n - 1].f == token_active_sprite);
+  assert(sprite_defs_tokens(d, CUSTOM_LEVEL_TOKENS, CUSTOM_LEVEL_TOKEN_COUNT,
+                            out, CUSTOM_LEVEL_TOKEN_COUNT + 2) == -1);
+  sprite_defs_destroy(&d);
+
+  static const char TAKEN[] = "sprite a\ntoken s\nstate s\n";
+  Uint8 buf[SPRITE_DEFS_SIZE];
+  const size_t size =
+      sprite_defs_compile(TAKEN, sizeof(TAKEN) - 1, buf, sizeof(buf));
+  d = sprite_defs_load(buf, size);
+  assert(d != NULL);
+  assert(sprite_defs_tokens(d, CUSTOM_LEVEL_TOKENS, CUSTOM_LEVEL_TOKEN_COUNT,
+                            out, 64) == -1);
+  sprite_defs_destroy(&d);
+}
+
+// the sprite types of a world can only change before it has a level
+static void test_set_sprite_defs(void) {
+  struct sprite_defs *d = compile();
+  struct lily_world *w = world(d, 'c');
+  assert(w->sprite_types == d->types);
+  assert(lily_world_set_sprite_defs(w, NULL) == -1);
+  lily_world_destroy(&w);
+
+  // without the definitions, the custom sprites cannot be created
+  w = lily_world_create();
+  assert(w != NULL);
+  assert(w->sprite_types == SPRITE_TYPES);
+  size_t len;
+  char *level = test_level(LEVEL, &len);
+  *strchr(level, 'X') = 'c';
+  static const struct token_entry CUSTOM[] = {
+      {'=', SPRITE_WALL_TOP, token_passive_sprite},
+      {'*', SPRITE_WALL, token_passive_sprite},
+      {'P', SPRITE_PLAYER, token_player},
+      {'c', SPRITE_CUSTOM, token_active_sprite},
+      {' ', SPRITE_NONE, NULL}};
+  assert(lily_world_load_level(w, level, len, CUSTOM,
+                               sizeof(CUSTOM) / sizeof(CUSTOM[0])) != 0);
+  free(level);
+  lily_world_destroy(&w);
+  sprite_defs_destroy(&d);
+}
+
+// the crawler walks like a spider, the stalker sprints like a skeleton and the
+// wraith shoots like a ghost, tick for tick
+static void test_behaviours(void) {
+  struct sprite_defs *d = compile();
+  size_t shots;
+
+  assert(race(d, 's', 'c', &shots) == 0);
+  assert(shots == 0);
+
+  // the stalker sees the player, and runs at them
+  assert(race(d, 'k', 't', &shots) > 0);
+
+  assert(race(d, 'G', 'w', &shots) == 0);
+  assert(shots > 0);
+
+  sprite_defs_destroy(&d);
+}
+
+int main(void) {
+  RUN_TEST(test_compile);
+  RUN_TEST(test_invalid);
+  RUN_TEST(test_tokens);
+  RUN_TEST(test_set_sprite_defs);
+  RUN_TEST(test_behaviours);
+  level_template_cache_clear();
+  return 0;
+}
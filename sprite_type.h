@@ -32,10 +32,10 @@ enum sprite_id {
   SPRITE_LADDER,
   SPRITE_DOOR,
   SPRITE_WATER,
+  SPRITE_WATER_TOP,
   SPRITE_LEFT_ARROW,
 
   // Active sprites -- here the depth matters
-  SPRITE_WATER_TOP,
   SPRITE_PLAYER,
   SPRITE_SPIDER,
   SPRITE_SPRINTING_SPIDER,
@@ -55,18 +55,25 @@ enum sprite_id {
   SPRITE_CAT_HELPER_LAST_LEVEL,
   SPRITE_LADDER_HELPER_LAST_LEVEL,
   SPRITE_GHOST_HELPER_LAST_LEVEL,
-  // SPRITE_TYPE_COUNT should always be the final element as it is the size used
-  // to initialize the g_sprite_types array. This is not to be confused with
-  // SPRITE_COUNT defined above.
+  // SPRITE_CUSTOM is the first of SPRITE_CUSTOM_COUNT sprite types that are not
+  // defined in the code but by a sprite definition file (see sprite_def.h).
+  // They have no sprite type in SPRITE_TYPES.
+  SPRITE_CUSTOM,
+  SPRITE_CUSTOM_LAST = SPRITE_CUSTOM + 15,
+  // SPRITE_TYPE_COUNT should always be the final element as it is the size of
+  // the sprite_types array of a world. This is not to be confused with
+  // SPRITE_COUNT defined in base.h.
   SPRITE_TYPE_COUNT,
 };
 
-// We need to forward-declare sprite here to declare sprite_handler.
+// We need to forward-declare sprite and lily_world (see state.h) here to
+// declare sprite_handler.
 struct sprite;
+struct lily_world;
 
-// sprite_handler is used to perform functions on a particular type of sprite.
-// Returns 0 on success, -1 on failure.
-typedef int (*sprite_handler)(struct sprite *);
+// sprite_handler is used to perform functions on a particular type of sprite,
+// in the world w. Returns 0 on success, -1 on failure.
+typedef int (*sprite_handler)(struct lily_world *w, struct sprite *);
 
 // solid_type is used for collision detection in the game logic
 enum solid_type {
@@ -78,6 +85,14 @@ enum solid_type {
   SOLID_ALL = SOLID_LEFT | SOLID_RIGHT | SOLID_TOP | SOLID_BOTTOM
 };
 
+// tile_flag are the properties of a passive sprite (a tile), which the game
+// logic reads from the tile grid of a level
+enum tile_flag {
+  TILE_NONE = 0,
+  // TILE_KILL kills the player on touch, e.g water
+  TILE_KILL = (1 << 0),
+};
+
 // sprite_type contains information on how to process a particular type of
 // sprites.
 struct sprite_type {
@@ -99,25 +114,38 @@ struct sprite_type {
   // -- Now for the sprite handlers --
   // To be called when the sprite is initialized
   sprite_handler init_handler;
-  // To be called at each frame
+  // To be called at each frame. It only changes its own sprite, and emits
+  // events for anything else (see event.h).
   sprite_handler frame_handler;
-  // To be called on a collision
+  // To be called on a collision, once the frame handlers of the tick were
+  // called (see EVENT_HIT)
   sprite_handler hit_handler;
   // To be called when the sprite is destroyed
   sprite_handler destroy_handler;
+  // -- And for the sprite as a tile, i.e a passive sprite --
+  // tile_flags are tile_flag values
+  int tile_flags;
+  // tile_frames is the number of frames of the animation of the tile, laid out
+  // from left to right in the sprite sheet starting at rect, or 0 if the tile
+  // is not animated. Every tile of a type shows the same frame.
+  int tile_frames;
+  // tile_fps is the number of frames of that animation per second
+  int tile_fps;
 };
 
-// sprite_type_change_tile changes the tile used by the sprite type in the
-// sprite sheet to the tile on row r and column c.
-void sprite_type_change_tile(struct sprite_type *t, const size_t r,
-                             const size_t c);
+// SPRITE_TYPES holds every sprite type, by sprite id. It is built at compile
+// time and never changes, so it is shared by every world and every thread.
+// What differs from a sprite to another of the same type, like the tile of the
+// player (see sprite.rect), is held by the sprite.
+extern const struct sprite_type SPRITE_TYPES[SPRITE_TYPE_COUNT];
 
-// g_sprite_types_create initializes all the sprite types in the g_sprite_types
-// array.
-int g_sprite_types_create(void);
+// sprite_type_tile sets rect to the tile on row r and column c of the sprite
+// sheet, keeping its size
+void sprite_type_tile(SDL_Rect *rect, const size_t r, const size_t c);
 
-// g_sprite_types_destroy frees all the memory allocated to sprite_types within
-// the g_sprite_types array
-void g_sprite_types_destroy(void);
+// sprite_type_tile_frame returns the frame of the animation of the tiles of
+// type t, once they have been animated for `clock` milliseconds (see
+// lily_world.tile_clock)
+int sprite_type_tile_frame(const struct sprite_type *t, const Uint64 clock);
 
 #endif // SPRITE_TYPE_H
@@ -2,12 +2,18 @@
 #define STATE_H
 
 #include <SDL2/SDL.h>
-#include <SDL2/SDL_mixer.h>
+#include <stdbool.h>
+#include <stdio.h>
 
-// contains all the global state of the game
+#include "fps.h"
+#include "sound.h"
+#include "sprite_type.h"
 
-// prog_state enumerates all the (valid) states in which the program can be
-// in.
+// contains all the state of the game: the state of each game world, and the
+// program-wide state of the game's window
+
+// prog_state enumerates all the (valid) states in which the program, or a game
+// world, can be in.
 enum prog_state {
   // the game has not started yet
   PROG_NOT_STARTED,
@@ -27,55 +33,96 @@ enum prog_state {
   PROG_GAME_LEVEL_COMPLETE
 };
 
-// Some forward declarations so we can hold pointers in the game and prog
+// Some forward declarations so we can hold pointers in the lily_world and prog
 // structs
-struct level;  // see level.h
-struct player; // see player.h
-struct scene;  // see scene.h
+struct level;         // see level.h
+struct player;        // see player.h
+struct message;       // see message.h
+struct scene;         // see scene.h
+struct stream_writer; // see stream.h
+struct sprite_defs;   // see sprite_def.h
+
+// lily_world contains the whole state of a game world (see lily.h). Nothing in
+// the game logic is stored outside of a world, so any number of worlds can
+// exist at once, and different worlds can be stepped on different threads.
+// A world must only be used by one thread at a time.
+struct lily_world {
+  // state is the state of the game in this world, one of the PROG_GAME_*
+  // values
+  enum prog_state state;
+
+  // level keeps track of the current level the player is on
+  struct level *level;
+  // level_index is the index of the current level among the game's levels, if
+  // it is one of them (see lily_world_load_default_level)
+  size_t level_index;
+  struct player *player;   // the player
+  struct message *message; // the game message
+
+  // input is the bitmask of input_key values (see input.h) the game logic
+  // processes during the current frame.
+  Uint32 input;
+  // dt is the duration of the current frame, in milliseconds. It is never more
+  // than MAX_STEP_TIME (see fps.h).
+  Uint64 dt;
+  // ticks is the number of times the world was stepped
+  Uint64 ticks;
+  // rand is the state of the pseudo-random number generator of the world, see
+  // util_rand
+  Uint64 rand;
+  // tile_clock is the time the tiles have been animated for, in milliseconds.
+  // It is the frame clock of every animated tile, see sprite_type_tile_frame.
+  Uint64 tile_clock;
+  // hash is the hash of the state of the world at every tick so far, see
+  // digest.h. It is only updated while hashing is true or hash_log is set.
+  Uint64 hash;
+  // hashing makes the world hash its state at every tick, see
+  // lily_world_set_hashing
+  bool hashing;
+  // hash_log is where the world logs its hash at every tick, or NULL, see
+  // lily_world_set_hash_log
+  FILE *hash_log;
+
+  // sound plays the sounds requested by the game logic, see sound_play. It is
+  // NULL if the world has no sound.
+  sound_handler sound;
+
+  // sprite_types contains all the sprite types of the world, SPRITE_TYPES or
+  // the sprite types of sprite_defs. Each sprite instance points to one of
+  // these sprite_types.
+  const struct sprite_type *sprite_types;
+  // sprite_defs are the sprite definitions of the custom sprite types of the
+  // world, or NULL if it has none (see lily_world_set_sprite_defs)
+  const struct sprite_defs *sprite_defs;
+};
 
 // prog contains program-wide state
 struct prog {
   enum prog_state state; // the state of the program
   const Uint8 *keys;     // the state of the keyboard
   struct scene *scene;   // the current scene
-};
-
-struct game {
-  // the time, in milliseconds, in between cleaning removed active sprites
-  Sint64 clean;
-
-  // level keeps track of the current level the player is on
-  struct level *level;
-  struct player *player;   // the player
-  struct message *message; // the game message
+  struct fps fps;        // the frame rate limiter of the game loop
 
   // path to a custom level, in case we want to run a user-created level
   char *custom_level_path;
 
-  // camera helps keep track of the part of the level to render, based on the
-  // position of the player. We use this to implement side-scrolling
-  // functionality. See scene.c for uses of the camera for rendering.
-  SDL_Rect camera;
+  // stream_location is where the games played are streamed to, for
+  // spectators, or NULL (see stream_open)
+  const char *stream_location;
+  // stream writes the games played to stream_location, if it is not NULL
+  struct stream_writer *stream;
+  // view_location is the stream to watch instead of playing, or NULL
+  const char *view_location;
+  // hash_log_location is the file the hash of every game played is logged to
+  // (see lily_world_set_hash_log), or NULL
+  const char *hash_log_location;
+
+  // scale is the scale the window is created at, or 0 for SIZE_FACTOR. Once
+  // created, the window can be resized to any size.
+  unsigned int scale;
 };
 
-// the global game state
-extern struct game g_game;
-
 // the global program state
 extern struct prog g_prog;
 
-// g_sounds is an array of Mix_Chunk* pointers to store all the sound effects
-// used in the game. Used in sound.h and sound.c
-extern Mix_Chunk *g_sounds[];
-
-// Forward declaration. See sprite_type.h and sprite_type.c
-struct sprite_type;
-
-// g_sprite_types is a global static array containing all the sprite_types
-// declared. Each sprite instance points to one of these sprite_types.
-extern struct sprite_type *g_sprite_types[];
-
-// g_scenes is a global static array containing all the scenes declared.
-extern struct scene *g_scenes[];
-
 #endif // STATE_H
@@ -0,0 +1,858 @@
+#include "stream.h"
+
+#include "delta.h"
+#include "level.h"
+#include "net.h"
+#include "player.h"
+#include "safe.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// A stream starts with STREAM_MAGIC and STREAM_VERSION (a Uint32 and a Uint8),
+// followed by records. A record is made of its type (a Uint8), the size of its
+// payload (a varint, see delta.h) and its payload:
+// - RECORD_TILES: the rect of every sprite type in the sprite sheet. The
+//   number of sprite types, then x, y, w and h of each one, as varints.
+// - RECORD_LEVEL: the width and height of the level as varints, then the ids
+//   of its tiles (a Uint8 each), row by row, encoded as the difference to the
+//   row above them (the first row being compared to zeroes).
+// - RECORD_KEYFRAME: a frame, encoded as the difference to zeroes.
+// - RECORD_DELTA: a frame, encoded as the difference to the previous frame.
+// The frames are encoded with delta_encode, which needs both frames to have
+// the same size: the smaller one is padded with zeroes. Their payload starts
+// with the size of the frame, as a varint.
+//
+// A frame is a header, followed by a record of SPRITE_RECORD_SIZE bytes per
+// active sprite. The offsets of their fields are below.
+
+// STREAM_MAGIC identifies a stream ("LSTR" in ASCII)
+static const Uint32 STREAM_MAGIC = 0x5254534C;
+// STREAM_VERSION must be incremented whenever the stream format changes
+static const Uint8 STREAM_VERSION = 3;
+// NO_PLAYER is the player field of a frame when the player has no sprite
+static const Uint32 NO_PLAYER = 0xFFFFFFFF;
+
+enum record_type {
+  RECORD_TILES = 1,
+  RECORD_LEVEL,
+  RECORD_KEYFRAME,
+  RECORD_DELTA,
+};
+
+enum {
+  // the fields of the header of a frame
+  HEADER_TICKS = 0,    // Uint32
+  HEADER_STATE = 4,    // Uint8
+  HEADER_FLAGS = 5,    // Uint8, 1 if the message is blocking
+  HEADER_LIVES = 6,    // Uint16
+  HEADER_COINS = 8,    // Uint16
+  HEADER_COUNT = 10,   // Uint32, the number of active sprites
+  HEADER_PLAYER = 14,  // Uint32, the index of the player sprite or NO_PLAYER
+  HEADER_MESSAGE = 18, // MESSAGE_M_SIZE bytes, padded with zeroes
+  // HEADER_TILE_FRAMES is SPRITE_TYPE_COUNT Uint8, the frame of the tiles of
+  // every sprite type
+  HEADER_TILE_FRAMES = HEADER_MESSAGE + MESSAGE_M_SIZE,
+  HEADER_SIZE = HEADER_TILE_FRAMES + SPRITE_TYPE_COUNT,
+
+  // the fields of the record of an active sprite
+  SPRITE_ID = 0,    // Uint8
+  SPRITE_FRAME = 1, // Uint8
+  SPRITE_FLAGS = 2, // Uint8
+  SPRITE_ALPHA = 3, // Uint8
+  SPRITE_X = 4,     // Sint32
+  SPRITE_Y = 8,     // Sint32
+  SPRITE_RECORD_SIZE = 12,
+
+  // MAX_FRAME_SIZE is the size of the largest frame a reader accepts
+  MAX_FRAME_SIZE = 1 << 26,
+  // MAX_LEVEL_SIZE is the number of screens of the largest level a reader
+  // accepts
+  MAX_LEVEL_SIZE = 1 << 12,
+  // the stream header and the header of a record (its type and size)
+  STREAM_HEADER_SIZE = 5,
+  RECORD_HEADER_SIZE = 1 + DELTA_MAX_VARINT,
+};
+
+// a frame must fit the ids of the sprite types in a byte
+SDL_COMPILE_TIME_ASSERT(sprite_id_size, SPRITE_TYPE_COUNT <= 256);
+
+// buffer is a growable buffer
+struct buffer {
+  Uint8 *buf;
+  size_t len; // the number of bytes used
+  size_t cap;
+};
+
+struct stream_writer {
+  SDL_RWops *rw;
+  size_t keyframe_interval;
+  struct stream_stats stats;
+
+  // prev is the frame written last, next is the frame being written
+  struct buffer prev;
+  struct buffer next;
+  // tiles and level are the tiles and level written last
+  SDL_Rect tiles[SPRITE_TYPE_COUNT];
+  struct buffer level;
+  size_t level_w;
+  size_t level_h;
+  // out holds the records of the frame being written
+  struct buffer out;
+};
+
+struct stream_reader {
+  SDL_RWops *rw;
+  bool has_frame; // true once a keyframe was read
+  struct buffer curr;
+  struct buffer payload;
+  struct stream_frame frame;
+};
+
+// reserve makes sure the buffer b holds at least n bytes. New bytes are zeroed.
+// Returns 0 on success, -1 on failure.
+static int reserve(struct buffer *b, const size_t n) {
+  if (n <= b->cap) {
+    return 0;
+  }
+
+  const size_t cap = SDL_max(n, 2 * b->cap);
+  Uint8 *buf = realloc(b->buf, cap);
+  if (buf == NULL) {
+    LOG_ERROR("could not allocate stream buffer");
+    return -1;
+  }
+
+  memset(buf + b->cap, 0, cap - b->cap);
+  b->buf = buf;
+  b->cap = cap;
+  return 0;
+}
+
+static void put16(Uint8 *buf, const Uint16 v) {
+  buf[0] = v & 0xFF;
+  buf[1] = (v >> 8) & 0xFF;
+}
+
+static void put32(Uint8 *buf, const Uint32 v) {
+  buf[0] = v & 0xFF;
+  buf[1] = (v >> 8) & 0xFF;
+  buf[2] = (v >> 16) & 0xFF;
+  buf[3] = (v >> 24) & 0xFF;
+}
+
+static Uint16 get16(const Uint8 *buf) {
+  return (Uint16)(buf[0] | (buf[1] << 8));
+}
+
+static Uint32 get32(const Uint8 *buf) {
+  return (Uint32)buf[0] | ((Uint32)buf[1] << 8) | ((Uint32)buf[2] << 16) |
+         ((Uint32)buf[3] << 24);
+}
+
+SDL_RWops *stream_open(const char *location, const bool write) {
+  assert_not_null(1, location);
+
+  static const char TCP[] = "tcp:";
+  if (strncmp(location, TCP, sizeof(TCP) - 1) != 0) {
+    SDL_RWops *rw = SDL_RWFromFile(location, write ? "wb" : "rb");
+    if (rw == NULL) {
+      LOG_ERROR("could not open %s: %s", location, SDL_GetError());
+    }
+    return rw;
+  }
+
+  // the port follows the last colon, as IPv6 addresses have colons too
+  const char *host = location + sizeof(TCP) - 1;
+  const char *colon = strrchr(host, ':');
+  char *end;
+  const unsigned long port = colon == NULL ? 0 : strtoul(colon + 1, &end, 10);
+  if (colon == NULL || colon[1] == '\0' || *end != '\0' || port == 0 ||
+      port > 0xFFFF) {
+    LOG_ERROR("invalid stream location %s", location);
+    return NULL;
+  }
+
+  if (colon == host) {
+    return net_tcp_open(NULL, (Uint16)port);
+  }
+
+  const size_t len = colon - host;
+  char *name = malloc(len + 1);
+  if (name == NULL) {
+    LOG_ERROR("could not allocate host name");
+    return NULL;
+  }
+  memcpy(name, host, len);
+  name[len] = '\0';
+
+  SDL_RWops *rw = net_tcp_open(name, (Uint16)port);
+  free(name);
+  return rw;
+}
+
+// ------------
+// -- writer --
+// ------------
+
+struct stream_writer *stream_writer_create(SDL_RWops *rw,
+                                           const size_t keyframe_interval) {
+  assert_not_null(1, rw);
+  assert(keyframe_interval > 0);
+
+  struct stream_writer *sw = calloc(1, sizeof(struct stream_writer));
+  if (sw == NULL) {
+    LOG_ERROR("could not allocate stream writer");
+    SDL_RWclose(rw);
+    return NULL;
+  }
+
+  sw->rw = rw;
+  sw->keyframe_interval = keyframe_interval;
+
+  Uint8 header[STREAM_HEADER_SIZE];
+  put32(header, STREAM_MAGIC);
+  header[4] = STREAM_VERSION;
+  if (SDL_RWwrite(rw, header, sizeof(header), 1) != 1) {
+    LOG_ERROR("could not write stream: %s", SDL_GetError());
+    stream_writer_destroy(&sw);
+    return NULL;
+  }
+
+  sw->stats.bytes = sizeof(header);
+  return sw;
+}
+
+void stream_writer_destroy(struct stream_writer **psw) {
+  assert_not_null(2, psw, *psw);
+  struct stream_writer *sw = *psw;
+
+  SDL_RWclose(sw->rw);
+  free(sw->prev.buf);
+  free(sw->next.buf);
+  free(sw->level.buf);
+  free(sw->out.buf);
+  free(sw);
+  *psw = NULL;
+}
+
+// put_sprite lays out the record of the sprite s at r
+static void put_sprite(Uint8 *r, const struct sprite *s) {
+  const struct animation *a = &s->animation;
+
+  Uint8 flags = 0;
+  flags |= (a->flip & SDL_FLIP_HORIZONTAL) ? STREAM_FLIP_HORIZONTAL : 0;
+  flags |= (a->flip & SDL_FLIP_VERTICAL) ? STREAM_FLIP_VERTICAL : 0;
+  flags |= a->type == ANIMATION_FRAME_VERTICAL ? STREAM_FRAME_VERTICAL : 0;
+  flags |= s->removed ? STREAM_REMOVED : 0;
+
+  r[SPRITE_ID] = (Uint8)s->type->id;
+  r[SPRITE_FRAME] = (Uint8)a->frame;
+  r[SPRITE_FLAGS] = flags;
+  r[SPRITE_ALPHA] = (Uint8)a->alpha;
+  // positions are truncated to whole pixels, like when rendering
+  put32(r + SPRITE_X, (Uint32)(Sint32)s->x);
+  put32(r + SPRITE_Y, (Uint32)(Sint32)s->y);
+}
+
+// put_frame lays out the frame of the world w into sw->next. Returns 0 on
+// success, -1 on failure.
+static int put_frame(struct stream_writer *sw, const struct lily_world *w) {
+  const struct array *arr = w->level->active_sprites;
+  const struct projectile_pool *pool = w->level->projectiles;
+  const struct sprite *player = w->player != NULL ? w->player->s : NULL;
+  // the projectiles in flight are streamed as active sprites
+  const size_t count = arr->l + pool->count;
+
+  struct buffer *b = &sw->next;
+  b->len = HEADER_SIZE + SPRITE_RECORD_SIZE * count;
+  if (reserve(b, b->len) != 0) {
+    return -1;
+  }
+
+  Uint8 *h = b->buf;
+  put32(h + HEADER_TICKS, (Uint32)w->ticks);
+  h[HEADER_STATE] = (Uint8)w->state;
+  h[HEADER_FLAGS] = message_block(w->message) ? 1 : 0;
+  put16(h + HEADER_LIVES,
+        w->player != NULL ? (Uint16)SDL_min(w->player->lives, 0xFFFF) : 0);
+  put16(h + HEADER_COINS,
+        w->player != NULL ? (Uint16)SDL_min(w->player->coins, 0xFFFF) : 0);
+  put32(h + HEADER_COUNT, (Uint32)count);
+  put32(h + HEADER_PLAYER, NO_PLAYER);
+  // strncpy pads the message with zeroes, so the unused bytes never differ
+  strncpy((char *)h + HEADER_MESSAGE, w->message->m, MESSAGE_M_SIZE - 1);
+  h[HEADER_MESSAGE + MESSAGE_M_SIZE - 1] = '\0';
+
+  register size_t i, j;
+  for (i = 0; i < SPRITE_TYPE_COUNT; i++) {
+    h[HEADER_TILE_FRAMES + i] =
+        (Uint8)sprite_type_tile_frame(&w->sprite_types[i], w->tile_clock);
+  }
+
+  // the sprites are streamed in the order they are rendered: the projectiles
+  // are shots, rendered after the active sprites of a higher depth (see
+  // scene_game.c)
+  Uint8 *r = h + HEADER_SIZE;
+  for (i = 0; i < arr->l && arr->a[i]->type->id > SPRITE_SHOT; i++) {
+    put_sprite(r, arr->a[i]);
+    r += SPRITE_RECORD_SIZE;
+  }
+
+  for (j = 0; j < pool->count; j++) {
+    put_sprite(r, projectile_get(pool, j));
+    r += SPRITE_RECORD_SIZE;
+  }
+
+  for (; i < arr->l; i++) {
+    if (arr->a[i] == player) {
+      put32(h + HEADER_PLAYER, (Uint32)(i + pool->count));
+    }
+    put_sprite(r, arr->a[i]);
+    r += SPRITE_RECORD_SIZE;
+  }
+
+  return 0;
+}
+
+// begin_record appends the header of a record of type `type` to sw->out, for
+// a payload of at most `bound` bytes. Returns the offset of the payload in
+// sw->out, or 0 on failure. The record must be ended with end_record.
+static size_t begin_record(struct stream_writer *sw, const enum record_type t,
+                           const size_t bound) {
+  struct buffer *out = &sw->out;
+  if (reserve(out, out->len + RECORD_HEADER_SIZE + bound) != 0) {
+    return 0;
+  }
+
+  // the size of the payload is not known yet: it is moved into place by
+  // end_record
+  out->buf[out->len] = (Uint8)t;
+  out->len += RECORD_HEADER_SIZE;
+  return out->len;
+}
+
+// end_record ends the record whose payload starts at `start` in sw->out
+static void end_record(struct stream_writer *sw, const size_t start) {
+  struct buffer *out = &sw->out;
+  const size_t size = out->len - start;
+
+  Uint8 varint[DELTA_MAX_VARINT];
+  const size_t n = delta_put_varint(varint, size);
+  Uint8 *header = out->buf + start - RECORD_HEADER_SIZE;
+  memcpy(header + 1, varint, n);
+  memmove(header + 1 + n, out->buf + start, size);
+  out->len -= DELTA_MAX_VARINT - n;
+}
+
+// tile returns the rect in the sprite sheet of the sprites of type i in the
+// world w. The player's is the tile of their character (see player_character).
+static const SDL_Rect *tile(const struct lily_world *w, const size_t i) {
+  if (i == SPRITE_PLAYER && w->player != NULL && w->player->s != NULL) {
+    return &w->player->s->rect;
+  }
+
+  return &w->sprite_types[i].rect;
+}
+
+// put_tiles appends a RECORD_TILES record with the sprite types of w, if they
+// changed or if force is true. Returns 0 on success, -1 on failure.
+static int put_tiles(struct stream_writer *sw, const struct lily_world *w,
+                     const bool force) {
+  register size_t i;
+  bool changed = force;
+  for (i = 0; i < SPRITE_TYPE_COUNT && !changed; i++) {
+    const SDL_Rect *a = tile(w, i), *b = &sw->tiles[i];
+    changed = a->x != b->x || a->y != b->y || a->w != b->w || a->h != b->h;
+  }
+
+  if (!changed) {
+    return 0;
+  }
+
+  const size_t start =
+      begin_record(sw, RECORD_TILES, (4 * SPRITE_TYPE_COUNT + 1) * 5);
+  if (start == 0) {
+    return -1;
+  }
+
+  struct buffer *out = &sw->out;
+  out->len += delta_put_varint(out->buf + out->len, SPRITE_TYPE_COUNT);
+  for (i = 0; i < SPRITE_TYPE_COUNT; i++) {
+    const SDL_Rect *r = tile(w, i);
+    sw->tiles[i] = *r;
+    out->len += delta_put_varint(out->buf + out->len, (Uint32)r->x);
+    out->len += delta_put_varint(out->buf + out->len, (Uint32)r->y);
+    out->len += delta_put_varint(out->buf + out->len, (Uint32)r->w);
+    out->len += delta_put_varint(out->buf + out->len, (Uint32)r->h);
+  }
+
+  end_record(sw, start);
+  return 0;
+}
+
+// put_level appends a RECORD_LEVEL record with the tiles of the level of w,
+// if they changed or if force is true. Returns 0 on success, -1 on failure.
+static int put_level(struct stream_writer *sw, const struct lily_world *w,
+                     const bool force) {
+  const struct level *l = w->level;
+  const size_t cols = COLUMN_COUNT * l->w;
+  const size_t n = ROW_COUNT * l->h * cols;
+
+  // the tiles only change when another level is loaded or an item is
+  // collected, which is rare enough to just compare them every frame. Items
+  // are streamed as the tiles they sit on, and removed once collected.
+  bool changed = force || l->w != sw->level_w || l->h != sw->level_h;
+  if (reserve(&sw->level, cols + n) != 0) {
+    return -1;
+  }
+
+  // level holds a row of zeroes followed by the ids of the tiles, so the
+  // difference to the row above is the difference between level and level
+  // shifted by one row
+  Uint8 *ids = sw->level.buf + cols;
+  register size_t i;
+  for (i = 0; i < n; i++) {
+    const enum sprite_id tile = l->passive_sprites[i];
+    const Uint8 id = (Uint8)(tile != SPRITE_NONE ? tile : level_item(l, i));
+    changed = changed || ids[i] != id;
+    ids[i] = id;
+  }
+  memset(sw->level.buf, 0, cols);
+
+  if (!changed) {
+    return 0;
+  }
+
+  sw->level_w = l->w;
+  sw->level_h = l->h;
+
+  const size_t start =
+      begin_record(sw, RECORD_LEVEL, 2 * DELTA_MAX_VARINT + delta_bound(n));
+  if (start == 0) {
+    return -1;
+  }
+
+  struct buffer *out = &sw->out;
+  out->len += delta_put_varint(out->buf + out->len, l->w);
+  out->len += delta_put_varint(out->buf + out->len, l->h);
+  out->len += delta_encode(sw->level.buf, ids, n, out->buf + out->len);
+  end_record(sw, start);
+  return 0;
+}
+
+// put_delta appends the frame in sw->next as a RECORD_KEYFRAME record if
+// keyframe is true, or as a RECORD_DELTA record otherwise. Returns 0 on
+// success, -1 on failure.
+static int put_delta(struct stream_writer *sw, const bool keyframe) {
+  struct buffer *prev = &sw->prev, *next = &sw->next;
+
+  // pad both frames with zeroes to the size of the larger one. A keyframe is
+  // the difference to zeroes.
+  const size_t len = SDL_max(prev->len, next->len);
+  if (reserve(prev, len) != 0 || reserve(next, len) != 0) {
+    return -1;
+  }
+  memset(next->buf + next->len, 0, len - next->len);
+  memset(prev->buf, 0, keyframe ? len : 0);
+  memset(prev->buf + prev->len, 0, keyframe ? 0 : len - prev->len);
+
+  const size_t start =
+      begin_record(sw, keyframe ? RECORD_KEYFRAME : RECORD_DELTA,
+                   DELTA_MAX_VARINT + delta_bound(len));
+  if (start == 0) {
+    return -1;
+  }
+
+  struct buffer *out = &sw->out;
+  out->len += delta_put_varint(out->buf + out->len, next->len);
+  out->len += delta_encode(prev->buf, next->buf, len, out->buf + out->len);
+  end_record(sw, start);
+  return 0;
+}
+
+int stream_writer_write(struct stream_writer *sw, const struct lily_world *w) {
+  assert_not_null(4, sw, w, w->level, w->message);
+
+  const bool keyframe = sw->stats.frames % sw->keyframe_interval == 0;
+  sw->out.len = 0;
+  if (put_frame(sw, w) != 0 || put_tiles(sw, w, keyframe) != 0 ||
+      put_level(sw, w, keyframe) != 0 || put_delta(sw, keyframe) != 0) {
+    return -1;
+  }
+
+  if (SDL_RWwrite(sw->rw, sw->out.buf, sw->out.len, 1) != 1) {
+    LOG_ERROR("could not write stream: %s", SDL_GetError());
+    return -1;
+  }
+
+  sw->stats.frames++;
+  sw->stats.keyframes += keyframe ? 1 : 0;
+  sw->stats.bytes += sw->out.len;
+  sw->stats.raw_bytes += sw->next.len;
+
+  // the new frame becomes the previous one
+  const struct buffer tmp = sw->prev;
+  sw->prev = sw->next;
+  sw->next = tmp;
+  return 0;
+}
+
+void stream_writer_stats(const struct stream_writer *sw,
+                         struct stream_stats *st) {
+  assert_not_null(2, sw, st);
+  *st = sw->stats;
+}
+
+// ------------
+// -- reader --
+// ------------
+
+struct stream_reader *stream_reader_create(SDL_RWops *rw) {
+  assert_not_null(1, rw);
+
+  struct stream_reader *sr = calloc(1, sizeof(struct stream_reader));
+  if (sr == NULL) {
+    LOG_ERROR("could not allocate stream reader");
+    SDL_RWclose(rw);
+    return NULL;
+  }
+  sr->rw = rw;
+
+  Uint8 header[STREAM_HEADER_SIZE];
+  if (SDL_RWread(rw, header, sizeof(header), 1) != 1 ||
+      get32(header) != STREAM_MAGIC || header[4] != STREAM_VERSION) {
+    LOG_ERROR("invalid stream");
+    stream_reader_destroy(&sr);
+    return NULL;
+  }
+
+  return sr;
+}
+
+void stream_reader_destroy(struct stream_reader **psr) {
+  assert_not_null(2, psr, *psr);
+  struct stream_reader *sr = *psr;
+
+  SDL_RWclose(sr->rw);
+  free(sr->curr.buf);
+  free(sr->payload.buf);
+  stream_frame_free(&sr->frame);
+  free(sr);
+  *psr = NULL;
+}
+
+// read_varint reads a varint from the stream of sr into *v. Returns 1 on
+// success, 0 at the end of the stream, and -1 if the varint is invalid.
+static int read_varint(struct stream_reader *sr, Uint64 *v) {
+  Uint8 buf[DELTA_MAX_VARINT];
+  register size_t i;
+  for (i = 0; i < DELTA_MAX_VARINT; i++) {
+    if (SDL_RWread(sr->rw, buf + i, 1, 1) != 1) {
+      return 0;
+    }
+    if (!(buf[i] & 0x80)) {
+      return delta_get_varint(buf, i + 1, v) == i + 1 ? 1 : -1;
+    }
+  }
+
+  return -1;
+}
+
+// cursor reads varints from a payload
+struct cursor {
+  const Uint8 *buf;
+  size_t len;
+  size_t off;
+  bool error;
+};
+
+// next_varint returns the next varint of the cursor, which must be at most
+// max. The error flag of the cursor is set if it is invalid.
+static Uint64 next_varint(struct cursor *c, const Uint64 max) {
+  Uint64 v = 0;
+  const size_t n =
+      c->error ? 0 : delta_get_varint(c->buf + c->off, c->len - c->off, &v);
+  if (n == 0 || v > max) {
+    c->error = true;
+    return 0;
+  }
+
+  c->off += n;
+  return v;
+}
+
+// read_tiles reads a RECORD_TILES payload. Returns 0 on success, -1 if it is
+// invalid.
+static int read_tiles(struct stream_reader *sr, struct cursor *c) {
+  SDL_Rect tiles[SPRITE_TYPE_COUNT];
+  const size_t count = next_varint(c, SPRITE_TYPE_COUNT);
+
+  register size_t i;
+  for (i = 0; i < count; i++) {
+    tiles[i].x = (int)next_varint(c, 0xFFFF);
+    tiles[i].y = (int)next_varint(c, 0xFFFF);
+    tiles[i].w = (int)next_varint(c, 0xFFFF);
+    tiles[i].h = (int)next_varint(c, 0xFFFF);
+  }
+
+  if (c->error || c->off != c->len) {
+    return -1;
+  }
+
+  memcpy(sr->frame.tiles, tiles, count * sizeof(SDL_Rect));
+  return 0;
+}
+
+// read_level reads a RECORD_LEVEL payload. Returns 0 on success, -1 if it is
+// invalid.
+static int read_level(struct stream_reader *sr, struct cursor *c) {
+  const size_t w = next_varint(c, MAX_LEVEL_SIZE);
+  const size_t h = next_varint(c, MAX_LEVEL_SIZE / SDL_max(w, 1));
+  if (c->error || w == 0 || h == 0) {
+    return -1;
+  }
+
+  const size_t cols = COLUMN_COUNT * w;
+  const size_t n = ROW_COUNT * h * cols;
+  struct buffer ids = {NULL, 0, 0};
+  if (reserve(&ids, n) != 0) {
+    return -1;
+  }
+
+  enum sprite_id *tiles = malloc(n * sizeof(enum sprite_id));
+  if (tiles == NULL ||
+      delta_decode(c->buf + c->off, c->len - c->off, ids.buf, n) != 0) {
+    free(tiles);
+    free(ids.buf);
+    return -1;
+  }
+
+  // each row was encoded as the difference to the row above
+  register size_t i;
+  for (i = cols; i < n; i++) {
+    ids.buf[i] ^= ids.buf[i - cols];
+  }
+  for (i = 0; i < n; i++) {
+    if (ids.buf[i] >= SPRITE_TYPE_COUNT) {
+      free(tiles);
+      free(ids.buf);
+      return -1;
+    }
+    tiles[i] = (enum sprite_id)ids.buf[i];
+  }
+  free(ids.buf);
+
+  free(sr->frame.passive_sprites);
+  sr->frame.passive_sprites = tiles;
+  sr->frame.w = w;
+  sr->frame.h = h;
+  return 0;
+}
+
+// parse_frame parses the frame in sr->curr into sr->frame. Returns 0 on
+// success, -1 if it is invalid.
+static int parse_frame(struct stream_reader *sr) {
+  const Uint8 *h = sr->curr.buf;
+  struct stream_frame *f = &sr->frame;
+
+  if (sr->curr.len < HEADER_SIZE) {
+    return -1;
+  }
+
+  const size_t count = get32(h + HEADER_COUNT);
+  const Uint32 player = get32(h + HEADER_PLAYER);
+  if (count != (sr->curr.len - HEADER_SIZE) / SPRITE_RECORD_SIZE ||
+      (sr->curr.len - HEADER_SIZE) % SPRITE_RECORD_SIZE != 0 ||
+      (player != NO_PLAYER && player >= count) ||
+      h[HEADER_STATE] > PROG_GAME_LEVEL_COMPLETE) {
+    return -1;
+  }
+
+  if (count > f->sprite_count) {
+    struct stream_sprite *sprites =
+        realloc(f->sprites, count * sizeof(struct stream_sprite));
+    if (sprites == NULL) {
+      LOG_ERROR("could not allocate stream sprites");
+      return -1;
+    }
+    f->sprites = sprites;
+  }
+
+  register size_t i;
+  for (i = 0; i < count; i++) {
+    const Uint8 *r = h + HEADER_SIZE + SPRITE_RECORD_SIZE * i;
+    struct stream_sprite *s = &f->sprites[i];
+    if (r[SPRITE_ID] >= SPRITE_TYPE_COUNT) {
+      return -1;
+    }
+
+    s->id = (enum sprite_id)r[SPRITE_ID];
+    s->frame = r[SPRITE_FRAME];
+    s->flags = r[SPRITE_FLAGS];
+    s->alpha = r[SPRITE_ALPHA];
+    s->x = (Sint32)get32(r + SPRITE_X);
+    s->y = (Sint32)get32(r + SPRITE_Y);
+  }
+
+  f->ticks = get32(h + HEADER_TICKS);
+  f->state = (enum prog_state)h[HEADER_STATE];
+  f->message_blocking = h[HEADER_FLAGS] & 1;
+  f->lives = get16(h + HEADER_LIVES);
+  f->coins = get16(h + HEADER_COINS);
+  memcpy(f->message, h + HEADER_MESSAGE, MESSAGE_M_SIZE);
+  f->message[MESSAGE_M_SIZE - 1] = '\0';
+  memcpy(f->tile_frames, h + HEADER_TILE_FRAMES, SPRITE_TYPE_COUNT);
+  f->sprite_count = count;
+  f->player = player == NO_PLAYER ? count : player;
+  return 0;
+}
+
+// read_frame reads a RECORD_KEYFRAME or RECORD_DELTA payload into sr->curr.
+// Returns 0 on success, -1 if it is invalid.
+static int read_frame(struct stream_reader *sr, struct cursor *c,
+                      const bool keyframe) {
+  const size_t len = next_varint(c, MAX_FRAME_SIZE);
+  if (c->error) {
+    return -1;
+  }
+
+  struct buffer *b = &sr->curr;
+  const size_t max = SDL_max(len, b->len);
+  if (reserve(b, max) != 0) {
+    return -1;
+  }
+
+  // the previous frame is padded with zeroes, and a keyframe is the
+  // difference to zeroes
+  memset(b->buf + (keyframe ? 0 : b->len), 0, keyframe ? max : max - b->len);
+  if (delta_decode(c->buf + c->off, c->len - c->off, b->buf, max) != 0) {
+    return -1;
+  }
+
+  b->len = len;
+  return parse_frame(sr);
+}
+
+int stream_reader_next(struct stream_reader *sr) {
+  assert_not_null(1, sr);
+
+  for (;;) {
+    Uint8 type;
+    if (SDL_RWread(sr->rw, &type, 1, 1) != 1) {
+      return 0;
+    }
+
+    Uint64 size;
+    const int ret = read_varint(sr, &size);
+    if (ret <= 0) {
+      return ret;
+    }
+
+    if (size > 2 * (Uint64)MAX_FRAME_SIZE + DELTA_MAX_VARINT ||
+        reserve(&sr->payload, size) != 0) {
+      LOG_ERROR("invalid stream record");
+      return -1;
+    }
+
+    if (size > 0 && SDL_RWread(sr->rw, sr->payload.buf, size, 1) != 1) {
+      return 0; // the stream ended in the middle of the record
+    }
+
+    struct cursor c = {sr->payload.buf, size, 0, false};
+    int err = 0;
+    switch (type) {
+    case RECORD_TILES:
+      err = read_tiles(sr, &c);
+      break;
+    case RECORD_LEVEL:
+      err = read_level(sr, &c);
+      break;
+    case RECORD_KEYFRAME:
+      err = read_frame(sr, &c, true);
+      sr->has_frame = err == 0;
+      break;
+    case RECORD_DELTA:
+      if (!sr->has_frame) {
+        continue; // the stream is joined after its start
+      }
+      err = read_frame(sr, &c, false);
+      break;
+    default:
+      err = -1;
+      break;
+    }
+
+    if (err != 0) {
+      LOG_ERROR("invalid stream record");
+      return -1;
+    }
+
+    // a frame can only be rendered once the level is known
+    if ((type == RECORD_KEYFRAME || type == RECORD_DELTA) &&
+        sr->frame.passive_sprites != NULL) {
+      return 1;
+    }
+  }
+}
+
+const struct stream_frame *stream_reader_frame(const struct stream_reader *sr) {
+  assert_not_null(1, sr);
+  return &sr->frame;
+}
+
+int stream_frame_copy(struct stream_frame *dst,
+                      const struct stream_frame *src) {
+  assert_not_null(2, dst, src);
+
+  const size_t n = ROW_COUNT * src->h * COLUMN_COUNT * src->w;
+  struct stream_sprite *sprites =
+      realloc(dst->sprites, SDL_max(src->sprite_count, 1) *
+                                sizeof(struct stream_sprite));
+  if (sprites == NULL) {
+    LOG_ERROR("could not allocate stream frame");
+    return -1;
+  }
+  dst->sprites = sprites;
+
+  enum sprite_id *tiles = dst->passive_sprites;
+  if (dst->w != src->w || dst->h != src->h) {
+    tiles = realloc(tiles, SDL_max(n, 1) * sizeof(enum sprite_id));
+    if (tiles == NULL) {
+      LOG_ERROR("could not allocate stream frame");
+      return -1;
+    }
+  }
+  dst->passive_sprites = tiles;
+
+  // copy everything but the pointers
+  *dst = (struct stream_frame){
+      .ticks = src->ticks,
+      .state = src->state,
+      .lives = src->lives,
+      .coins = src->coins,
+      .message_blocking = src->message_blocking,
+      .sprites = sprites,
+      .sprite_count = src->sprite_count,
+      .player = src->player,
+      .w = src->w,
+      .h = src->h,
+      .passive_sprites = tiles,
+  };
+  memcpy(dst->message, src->message, MESSAGE_M_SIZE);
+  memcpy(dst->tiles, src->tiles, sizeof(src->tiles));
+  memcpy(dst->tile_frames, src->tile_frames, sizeof(src->tile_frames));
+  memcpy(sprites, src->sprites,
+         src->sprite_count * sizeof(struct stream_sprite));
+  if (n > 0) {
+    memcpy(tiles, src->passive_sprites, n * sizeof(enum sprite_id));
+  }
+  return 0;
+}
+
+void stream_frame_free(struct stream_frame *f) {
+  assert_not_null(1, f);
+  free(f->sprites);
+  free(f->passive_sprites);
+  memset(f, 0, sizeof(struct stream_frame));
+}
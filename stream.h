@@ -0,0 +1,157 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include "base.h"
+
+#include "message.h"
+#include "sprite_type.h"
+#include "state.h"
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+
+// stream broadcasts a game to spectators: a stream writer turns the state of a
+// world into a stream of frames, one per tick, that a viewer can render
+// without running the game (see SCENE_VIEW). Only what is rendered is
+// streamed: the tiles of the level, and for each tick the frame of the animated
+// tiles, the position, animation frame and removed flag of every active
+// sprite and projectile, the status of the player and the game message.
+//
+// A frame is laid out as fixed size fields, so that each frame can be sent as
+// the difference to the previous one (see delta.h), which is mostly zeroes.
+// Every keyframe_interval frames, a whole frame (a keyframe) is sent instead,
+// along with the tiles of the level, so a viewer can start watching from any
+// keyframe. Every integer is stored in little endian, so streams can be
+// watched on any machine.
+//
+// A stream is written to and read from an SDL_RWops, which can be opened with
+// stream_open.
+
+enum {
+  // STREAM_KEYFRAME_INTERVAL is the default number of frames between two
+  // keyframes
+  STREAM_KEYFRAME_INTERVAL = 5 * FRAME_RATE,
+};
+
+// stream_sprite_flag are the flags of a stream_sprite
+enum stream_sprite_flag {
+  STREAM_FLIP_HORIZONTAL = 1 << 0,
+  STREAM_FLIP_VERTICAL = 1 << 1,
+  // STREAM_FRAME_VERTICAL is set if the frames of the animation are arranged
+  // vertically in the sprite sheet, see ANIMATION_FRAME_VERTICAL
+  STREAM_FRAME_VERTICAL = 1 << 2,
+  // STREAM_REMOVED is set if the sprite was removed from the game during the
+  // tick
+  STREAM_REMOVED = 1 << 3,
+};
+
+// stream_sprite is an active sprite, as streamed
+struct stream_sprite {
+  enum sprite_id id;
+  int x;       // x position, in pixels
+  int y;       // y position, in pixels
+  Uint8 frame; // the frame of the animation
+  Uint8 alpha; // see animation.alpha
+  Uint8 flags; // stream_sprite_flag values
+};
+
+// stream_frame is the state of a streamed game at a tick
+struct stream_frame {
+  Uint32 ticks; // the number of times the world was stepped, see lily_world
+  enum prog_state state;
+  unsigned int lives;
+  unsigned int coins;
+  // message is the game message, blocking if message_blocking is true
+  char message[MESSAGE_M_SIZE];
+  bool message_blocking;
+
+  // sprites are the active sprites, in the order they are rendered
+  struct stream_sprite *sprites;
+  size_t sprite_count;
+  // player is the index of the player's sprite in sprites, or sprite_count if
+  // the player has no sprite
+  size_t player;
+
+  // w and h are the size of the level, in screens (see struct level)
+  size_t w;
+  size_t h;
+  // passive_sprites are the sprite ids of the tiles of the level, see struct
+  // level
+  enum sprite_id *passive_sprites;
+  // tiles holds the rect in the sprite sheet of every sprite type
+  SDL_Rect tiles[SPRITE_TYPE_COUNT];
+  // tile_frames holds the frame of the animation of the tiles of every sprite
+  // type, see sprite_type_tile_frame
+  Uint8 tile_frames[SPRITE_TYPE_COUNT];
+};
+
+// stream_stats are statistics on a stream writer
+struct stream_stats {
+  Uint64 frames;    // the number of frames written
+  Uint64 keyframes; // the number of keyframes among them
+  Uint64 bytes;     // the number of bytes written
+  // raw_bytes is the number of bytes the frames would take without encoding
+  // them as differences
+  Uint64 raw_bytes;
+};
+
+// stream_writer writes a stream
+struct stream_writer;
+
+// stream_reader reads a stream
+struct stream_reader;
+
+// stream_open opens the stream at `location` for writing if write is true, or
+// for reading otherwise. location is either "tcp:HOST:PORT", to connect to
+// HOST on PORT, "tcp::PORT", to wait for a connection on PORT (see
+// net_tcp_open), or the path of a file, which may be a named pipe. Returns
+// NULL on failure.
+SDL_RWops *stream_open(const char *location, const bool write);
+
+// stream_writer_create creates a writer writing a stream to rw, which the
+// writer takes ownership of, with a keyframe every keyframe_interval frames.
+// Returns NULL on failure, in which case rw is closed.
+struct stream_writer *stream_writer_create(SDL_RWops *rw,
+                                           const size_t keyframe_interval);
+
+// stream_writer_destroy closes the stream of the writer, frees its memory, and
+// sets *psw to NULL
+void stream_writer_destroy(struct stream_writer **psw);
+
+// stream_writer_write writes the current state of the world w, which must have
+// a level, as the next frame of the stream. Returns 0 on success, -1 on
+// failure.
+int stream_writer_write(struct stream_writer *sw, const struct lily_world *w);
+
+// stream_writer_stats populates st with the statistics of the writer
+void stream_writer_stats(const struct stream_writer *sw,
+                         struct stream_stats *st);
+
+// stream_reader_create creates a reader reading the stream in rw, which the
+// reader takes ownership of. Returns NULL on failure, in which case rw is
+// closed.
+struct stream_reader *stream_reader_create(SDL_RWops *rw);
+
+// stream_reader_destroy closes the stream of the reader, frees its memory, and
+// sets *psr to NULL
+void stream_reader_destroy(struct stream_reader **psr);
+
+// stream_reader_next reads the next frame of the stream, blocking until it is
+// available. The frames before the first keyframe are skipped. Returns 1 if a
+// frame was read (see stream_reader_frame), 0 at the end of the stream, and -1
+// on failure or if the stream is invalid.
+int stream_reader_next(struct stream_reader *sr);
+
+// stream_reader_frame returns the frame read last by stream_reader_next. It is
+// valid until the next call to stream_reader_next.
+const struct stream_frame *stream_reader_frame(const struct stream_reader *sr);
+
+// stream_frame_copy copies the frame src into dst, which must be zeroed or a
+// copy of another frame. Returns 0 on success, -1 on failure.
+int stream_frame_copy(struct stream_frame *dst,
+                      const struct stream_frame *src);
+
+// stream_frame_free frees the memory of a frame populated by
+// stream_frame_copy, and zeroes it
+void stream_frame_free(struct stream_frame *f);
+
+#endif // STREAM_H
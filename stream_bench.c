@@ -0,0 +1,113 @@
+#include "stream.h"
+
+#include "default_levels.h"
+#include "input.h"
+#include "lily.h"
+#include "safe.h"
+#include <stdio.h>
+
+// stream_bench measures the bandwidth of a spectator stream (see stream.h) and
+// the cost of encoding it, on the first and the last level of the game. A
+// minute of pseudo-random play is streamed to a writer that only counts the
+// bytes, with keyframes every STREAM_KEYFRAME_INTERVAL frames, and with
+// keyframes only for comparison. Run it with `make bench`.
+
+enum {
+  BENCH_TICKS = 60 * FRAME_RATE, // a minute of play
+};
+
+// input returns a pseudo-random input for the tick t. It changes every few
+// ticks, like the input of a player would.
+static Uint32 input(const Uint64 t) {
+  static const Uint32 INPUTS[] = {INPUT_LEFT, INPUT_RIGHT,
+                                  INPUT_RIGHT | INPUT_JUMP, INPUT_JUMP,
+                                  INPUT_RIGHT | INPUT_SPRINT};
+
+  Uint64 z = (t / 12) * 0x9E3779B97F4A7C15;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+  return INPUTS[(z ^ (z >> 31)) % (sizeof(INPUTS) / sizeof(INPUTS[0]))];
+}
+
+static size_t null_write(SDL_RWops *rw, const void *ptr, size_t size,
+                         size_t num) {
+  SAFE_UNUSED(rw);
+  SAFE_UNUSED(ptr);
+  SAFE_UNUSED(size);
+  return num;
+}
+
+static int null_close(SDL_RWops *rw) {
+  SDL_FreeRW(rw);
+  return 0;
+}
+
+// run streams a minute of the level `index` with a keyframe every
+// keyframe_interval frames. Returns 0 on success, -1 on failure.
+static int run(const size_t index, const size_t keyframe_interval) {
+  SDL_RWops *rw = SDL_AllocRW();
+  if (rw == NULL) {
+    return -1;
+  }
+  rw->write = null_write;
+  rw->close = null_close;
+
+  struct stream_writer *sw = stream_writer_create(rw, keyframe_interval);
+  struct lily_world *w = lily_world_create();
+  if (sw == NULL || w == NULL || lily_world_load_default_level(w, index) != 0) {
+    return -1;
+  }
+
+  // only the writes are timed
+  Uint64 elapsed = 0;
+  register size_t i;
+  for (i = 0; i < BENCH_TICKS; i++) {
+    if (lily_world_step(w, input(i), FRAME_TIME) != 0) {
+      return -1;
+    }
+
+    // restart the level once it is over, like the game would
+    if (w->state != PROG_GAME_IN && w->state != PROG_GAME_KILLED &&
+        lily_world_load_default_level(w, index) != 0) {
+      return -1;
+    }
+
+    const Uint64 start = SDL_GetPerformanceCounter();
+    if (stream_writer_write(sw, w) != 0) {
+      return -1;
+    }
+    elapsed += SDL_GetPerformanceCounter() - start;
+  }
+
+  struct stream_stats st;
+  stream_writer_stats(sw, &st);
+  const double us =
+      (double)elapsed * 1e6 / SDL_GetPerformanceFrequency() / BENCH_TICKS;
+  printf("  keyframe every %4lu frames: %8.1f KiB per minute (%6.1f kbit/s, "
+         "%4.1f%% of the raw frames), %5.2f us per tick\n",
+         (unsigned long)keyframe_interval, st.bytes / 1024.0,
+         st.bytes * 8.0 / 1000.0 / 60.0, 100.0 * st.bytes / st.raw_bytes, us);
+
+  stream_writer_destroy(&sw);
+  lily_world_destroy(&w);
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  SAFE_UNUSED(argc);
+  SAFE_UNUSED(argv);
+
+  const size_t levels[] = {0, LEVEL_COUNT - 1};
+  int ret = 0;
+  register size_t i;
+  for (i = 0; i < 2 && ret == 0; i++) {
+    printf("%s\n", LEVELS[levels[i]]);
+    if (run(levels[i], STREAM_KEYFRAME_INTERVAL) != 0 ||
+        run(levels[i], 1) != 0) {
+      ret = 1;
+    }
+  }
+
+  level_template_cache_clear();
+  return ret;
+}
@@ -0,0 +1,259 @@
+#include "stream.h"
+
+#include "input.h"
+#include "level.h"
+#include "lily.h"
+#include "player.h"
+#include "test.h"
+#include <string.h>
+
+static const struct token_entry TOKENS[] = {
+    {'=', SPRITE_WALL_TOP, token_passive_sprite},
+    {'*', SPRITE_WALL, token_passive_sprite},
+    {'s', SPRITE_SPIDER, token_active_sprite},
+    {'O', SPRITE_COIN, token_active_sprite},
+    {'P', SPRITE_PLAYER, token_player},
+    {' ', SPRITE_NONE, NULL}};
+
+static const size_t TOKEN_SIZE = 6;
+
+// the player walks right and collects the coins, which removes them
+static const char LEVEL[] = "        =====       \n"
+                            "                    \n"
+                            " s   P O O O   s    \n"
+                            "====================\n"
+                            "********************";
+
+enum {
+  TICKS = 300,
+  KEYFRAME_INTERVAL = 50,
+  // MESSAGE_TICK is the tick at which a message is set
+  MESSAGE_TICK = 100,
+  BUFFER_SIZE = 1 << 20,
+};
+
+static Uint8 buffer[BUFFER_SIZE];
+
+// step steps the world w through the tick t
+static void step(struct lily_world *w, const size_t t) {
+  if (t == MESSAGE_TICK) {
+    message_set(w, "Hello, spectators.", false);
+  }
+  const Uint32 in = t < TICKS / 2 ? INPUT_RIGHT : INPUT_LEFT | INPUT_JUMP;
+  assert(lily_world_step(w, in, FRAME_TIME) == 0);
+}
+
+// write_stream writes TICKS frames of a game into buffer. Returns the size of
+// the stream.
+static size_t write_stream(struct stream_stats *st) {
+  SDL_RWops *rw = SDL_RWFromMem(buffer, BUFFER_SIZE);
+  assert(rw != NULL);
+  struct stream_writer *sw = stream_writer_create(rw, KEYFRAME_INTERVAL);
+  assert(sw != NULL);
+
+  struct lily_world *w = test_world(LEVEL, TOKENS, TOKEN_SIZE);
+  register size_t t;
+  for (t = 0; t < TICKS; t++) {
+    step(w, t);
+    assert(stream_writer_write(sw, w) == 0);
+  }
+
+  stream_writer_stats(sw, st);
+  stream_writer_destroy(&sw);
+  assert(sw == NULL);
+  lily_world_destroy(&w);
+  return st->bytes;
+}
+
+// same asserts that the frame f is the state of the world w
+static void same(const struct stream_frame *f, const struct lily_world *w) {
+  const struct level *l = w->level;
+  const struct array *arr = l->active_sprites;
+
+  assert(f->ticks == w->ticks);
+  assert(f->state == w->state);
+  assert(f->lives == w->player->lives);
+  assert(f->coins == w->player->coins);
+  assert(strcmp(f->message, w->message->m) == 0);
+  assert(f->w == l->w && f->h == l->h);
+  assert(memcmp(f->passive_sprites, l->passive_sprites,
+                ROW_COUNT * l->h * COLUMN_COUNT * l->w *
+                    sizeof(enum sprite_id)) == 0);
+  assert(f->tile_frames[SPRITE_WATER_TOP] ==
+         sprite_type_tile_frame(&w->sprite_types[SPRITE_WATER_TOP],
+                                w->tile_clock));
+
+  assert(f->sprite_count == arr->l);
+  assert(f->player < f->sprite_count);
+  assert(arr->a[f->player] == w->player->s);
+
+  register size_t i;
+  for (i = 0; i < arr->l; i++) {
+    const struct sprite *s = arr->a[i];
+    const struct stream_sprite *ss = &f->sprites[i];
+    assert(ss->id == s->type->id);
+    assert(ss->x == (int)s->x && ss->y == (int)s->y);
+    assert(ss->frame == s->animation.frame);
+    assert(!(ss->flags & STREAM_REMOVED) == !s->removed);
+    assert(f->tiles[ss->id].x == s->rect.x);
+    assert(f->tiles[ss->id].y == s->rect.y);
+  }
+}
+
+// a game read from a stream is the game that was written
+static void test_roundtrip(void) {
+  struct stream_stats st;
+  const size_t size = write_stream(&st);
+
+  assert(st.frames == TICKS);
+  assert(st.keyframes == TICKS / KEYFRAME_INTERVAL);
+  // a frame is mostly unchanged since the previous one
+  assert(st.bytes < st.raw_bytes / 8);
+
+  struct stream_reader *sr =
+      stream_reader_create(SDL_RWFromConstMem(buffer, (int)size));
+  assert(sr != NULL);
+
+  struct lily_world *w = test_world(LEVEL, TOKENS, TOKEN_SIZE);
+  const size_t count = w->level->active_sprites->l;
+  register size_t t;
+  for (t = 0; t < TICKS; t++) {
+    step(w, t);
+    assert(stream_reader_next(sr) == 1);
+    same(stream_reader_frame(sr), w);
+  }
+
+  // the coins that were collected are no longer streamed
+  assert(w->player->coins > 0);
+  assert(stream_reader_frame(sr)->sprite_count < count);
+  assert(stream_reader_next(sr) == 0);
+
+  stream_reader_destroy(&sr);
+  assert(sr == NULL);
+  lily_world_destroy(&w);
+}
+
+// a stream can be watched from any keyframe, and invalid streams are rejected
+static void test_join(void) {
+  struct stream_stats st;
+  const size_t size = write_stream(&st);
+
+  // a viewer joining in the middle of the stream skips to the next keyframe.
+  // The records are found by reading them one by one: the first byte of a
+  // record is its type, and the varint that follows is the size of its payload.
+  size_t off = 5, frames = 0, joined = 0;
+  while (off < size && joined == 0) {
+    const Uint8 type = buffer[off];
+    size_t len = 0, shift = 0, n = 1;
+    do {
+      len |= (size_t)(buffer[off + n] & 0x7F) << shift;
+      shift += 7;
+    } while (buffer[off + n++] & 0x80);
+
+    // 3 is a keyframe, 4 is a delta
+    if (type == 4 && ++frames > KEYFRAME_INTERVAL) {
+      joined = off;
+    }
+    off += n + len;
+  }
+  assert(joined > 0);
+
+  // the header of the stream, followed by the records after joined
+  static Uint8 joined_stream[BUFFER_SIZE];
+  memcpy(joined_stream, buffer, 5);
+  memcpy(joined_stream + 5, buffer + joined, size - joined);
+
+  struct stream_reader *sr = stream_reader_create(
+      SDL_RWFromConstMem(joined_stream, (int)(5 + size - joined)));
+  assert(sr != NULL);
+
+  struct lily_world *w = test_world(LEVEL, TOKENS, TOKEN_SIZE);
+  register size_t t;
+  // the first frame read is the keyframe written after stepping through the
+  // tick 2 * KEYFRAME_INTERVAL
+  for (t = 0; t <= 2 * KEYFRAME_INTERVAL; t++) {
+    step(w, t);
+  }
+
+  size_t read = 0;
+  while (stream_reader_next(sr) == 1) {
+    same(stream_reader_frame(sr), w);
+    step(w, t++);
+    read++;
+  }
+  assert(read == TICKS - 2 * KEYFRAME_INTERVAL);
+  stream_reader_destroy(&sr);
+  lily_world_destroy(&w);
+
+  // a truncated stream ends early
+  sr = stream_reader_create(SDL_RWFromConstMem(buffer, (int)size / 2));
+  assert(sr != NULL);
+  while (stream_reader_next(sr) == 1) {
+  }
+  stream_reader_destroy(&sr);
+
+  // a corrupted stream fails
+  static const Uint8 garbage[] = {'L', 'S', 'T', 'R', 3, 3, 2, 0xFF, 0xFF};
+  sr = stream_reader_create(SDL_RWFromConstMem(garbage, sizeof(garbage)));
+  assert(sr != NULL);
+  assert(stream_reader_next(sr) == -1);
+  stream_reader_destroy(&sr);
+
+  assert(stream_reader_create(SDL_RWFromConstMem(LEVEL, 16)) == NULL);
+}
+
+// accept_stream reads a stream from a TCP connection, and returns the number of
+// frames read
+static int accept_stream(void *data) {
+  SAFE_UNUSED(data);
+  struct stream_reader *sr =
+      stream_reader_create(stream_open("tcp::47611", false));
+  assert(sr != NULL);
+
+  int frames = 0;
+  while (stream_reader_next(sr) == 1) {
+    frames++;
+  }
+
+  stream_reader_destroy(&sr);
+  return frames;
+}
+
+// streams go through TCP on the local host
+static void test_tcp(void) {
+  assert(stream_open("tcp:localhost", true) == NULL);
+  assert(stream_open("tcp:localhost:0", true) == NULL);
+
+  SDL_Thread *thread = SDL_CreateThread(accept_stream, "accept", NULL);
+  assert(thread != NULL);
+
+  // wait for the other thread to listen
+  SDL_RWops *rw = NULL;
+  register size_t i;
+  for (i = 0; i < 100 && rw == NULL; i++) {
+    SDL_Delay(10);
+    rw = stream_open("tcp:127.0.0.1:47611", true);
+  }
+  assert(rw != NULL);
+
+  struct stream_writer *sw = stream_writer_create(rw, KEYFRAME_INTERVAL);
+  assert(sw != NULL);
+  struct lily_world *w = test_world(LEVEL, TOKENS, TOKEN_SIZE);
+  for (i = 0; i < TICKS; i++) {
+    step(w, i);
+    assert(stream_writer_write(sw, w) == 0);
+  }
+  stream_writer_destroy(&sw);
+  lily_world_destroy(&w);
+
+  int frames;
+  SDL_WaitThread(thread, &frames);
+  assert(frames == TICKS);
+}
+
+int main(void) {
+  RUN_TEST(test_roundtrip);
+  RUN_TEST(test_join);
+  RUN_TEST(test_tcp);
+  return 0;
+}
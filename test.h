@@ -1,9 +1,15 @@
 #ifndef TEST_H
 #define TEST_H
 
+#include "level.h"
+#include "lily.h"
+#include "player.h"
 #include "safe.h"   // most likely needed for tests
+#include "state.h"
 #include <assert.h> // most likely needed for tests
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 // utilities for testing
 
@@ -26,4 +32,103 @@
     printf("%ssuccess%s.\n", CLR_GRN, CLR_RST);                                \
   } while (0)
 
+// test_level returns the level `level` a screen high, in a buffer to be freed,
+// and its length in len: a level less than a screen high only needs its bottom
+// rows, the rows above them are blank.
+static inline char *test_level(const char *level, size_t *len) {
+  const size_t n = strlen(level);
+  const size_t width = strcspn(level, "\n");
+  size_t rows = 1;
+  register size_t i;
+  for (i = 0; i < n; i++) {
+    rows += level[i] == '\n';
+  }
+
+  // the blank rows, and then the level
+  const size_t blank = rows < ROW_COUNT ? (ROW_COUNT - rows) * (width + 1) : 0;
+  char *buf = malloc(blank + n);
+  assert(buf != NULL);
+  for (i = 0; i < blank; i++) {
+    buf[i] = i % (width + 1) == width ? '\n' : ' ';
+  }
+  memcpy(buf + blank, level, n);
+
+  *len = blank + n;
+  return buf;
+}
+
+// test_world_load loads the level `level`, a string with the tokens of the n
+// token entries of `tokens` (see token.h) made a screen high by test_level,
+// into the world w, asserting that it loads
+static inline void test_world_load(struct lily_world *w, const char *level,
+                                   const struct token_entry *tokens,
+                                   const size_t n) {
+  size_t len;
+  char *buf = test_level(level, &len);
+  assert(lily_world_load_level(w, buf, len, tokens, n) == 0);
+  free(buf);
+}
+
+// test_world creates a world playing the level `level` with the n token
+// entries of `tokens`, like test_world_load, and stepped by FRAME_TIME
+static inline struct lily_world *test_world(const char *level,
+                                            const struct token_entry *tokens,
+                                            const size_t n) {
+  struct lily_world *w = lily_world_create();
+  assert(w != NULL);
+  test_world_load(w, level, tokens, n);
+  w->dt = FRAME_TIME;
+  return w;
+}
+
+enum {
+  TEST_CROWD_W = 8,                              // screens
+  TEST_CROWD_H = 8,                              // screens
+  TEST_CROWD_COLS = TEST_CROWD_W * COLUMN_COUNT, // tiles
+  TEST_CROWD_ROWS = TEST_CROWD_H * ROW_COUNT,    // tiles
+};
+
+// test_crowd creates a world with the sprite definitions d, or none if d is
+// NULL, playing a level of TEST_CROWD_W by TEST_CROWD_H screens: an empty row,
+// a row of enemies, and a floor, with the player at the top. n sprites of the
+// `count` types of ids, in turn, are spawned at pseudo-random tiles of the
+// rows of enemies. The player blinks for as long as the world is played, so
+// that the sprites hitting it do not end the game.
+static inline struct lily_world *test_crowd(const struct sprite_defs *d,
+                                            const enum sprite_id *ids,
+                                            const size_t count,
+                                            const size_t n) {
+  static const struct token_entry TOKENS[] = {
+      {'=', SPRITE_WALL_TOP, token_passive_sprite},
+      {'P', SPRITE_PLAYER, token_player},
+      {' ', SPRITE_NONE, NULL}};
+  static char buf[TEST_CROWD_ROWS * (TEST_CROWD_COLS + 1)];
+  register size_t r, c, i;
+  char *b = buf;
+  for (r = 0; r < TEST_CROWD_ROWS; r++) {
+    for (c = 0; c < TEST_CROWD_COLS; c++) {
+      *b++ = r % 3 == 2 ? '=' : r == 0 && c == 0 ? 'P' : ' ';
+    }
+    *b++ = '\n';
+  }
+  buf[sizeof(buf) - 1] = '\0';
+
+  struct lily_world *w = lily_world_create();
+  assert(w != NULL);
+  assert(lily_world_set_sprite_defs(w, d) == 0);
+  test_world_load(w, buf, TOKENS, sizeof(TOKENS) / sizeof(TOKENS[0]));
+  w->dt = FRAME_TIME;
+  fps_timer_init(&w->player->blink_timer, (Uint64)-1);
+
+  Uint64 z = n;
+  for (i = 0; i < n; i++) {
+    z = z * 6364136223846793005 + 1442695040888963407;
+    const int row = (int)((z >> 33) % (TEST_CROWD_ROWS / 3)) * 3 + 1;
+    const int col = (int)((z >> 17) % TEST_CROWD_COLS);
+    assert(token_active_sprite(w, w->level, ids[i % count], row, col) == 0);
+  }
+
+  return w;
+}
+
 #endif // TEST_H
@@ -1,5 +1,6 @@
 #include "token.h"
 #include "level.h"
+#include "level_template.h"
 #include "player.h"
 #include "safe.h"
 #include "state.h"
@@ -8,19 +9,25 @@
 // technically 128 but most computers use 8 bits for a char
 #define LEN_ASCII 256
 
-int token_passive_sprite(struct level *l, const enum sprite_id id,
-                         const size_t r, const size_t c) {
+int token_passive_sprite(struct lily_world *w, struct level *l,
+                         const enum sprite_id id, const size_t r,
+                         const size_t c) {
   // some quick validation
+  assert_not_null(2, w, l);
   assert(r < ROW_COUNT * l->h && c < COLUMN_COUNT * l->w);
-  assert_not_null(1, l);
-
-  l->passive_sprites[r * COLUMN_COUNT * l->w + c] = g_sprite_types[id];
+  SAFE_UNUSED(id);
   return 0;
 }
 
-int token_active_sprite(struct level *l, const enum sprite_id id,
-                        const size_t r, const size_t c) {
-  assert_not_null(1, l);
+int token_item(struct lily_world *w, struct level *l, const enum sprite_id id,
+               const size_t r, const size_t c) {
+  return token_passive_sprite(w, l, id, r, c);
+}
+
+int token_active_sprite(struct lily_world *w, struct level *l,
+                        const enum sprite_id id, const size_t r,
+                        const size_t c) {
+  assert_not_null(2, w, l);
 
   struct sprite *s = (struct sprite *)malloc(sizeof(struct sprite));
   if (s == NULL) {
@@ -29,7 +36,7 @@ int token_active_sprite(struct level *l, const enum sprite_id id,
     return -1;
   }
 
-  if (sprite_init(s, id) != 0) {
+  if (sprite_init(w, s, id) != 0) {
     goto error_out;
   }
 
@@ -48,9 +55,8 @@ error_out:
   return -1;
 }
 
-int token_player(struct level *l, const enum sprite_id id, const size_t r,
-                 const size_t c) {
-  LOG_ERROR("TOKEN PLAYER");
+int token_player(struct lily_world *w, struct level *l,
+                 const enum sprite_id id, const size_t r, const size_t c) {
   SAFE_UNUSED(id);
   if (l->player_found) { // something went wrong here, there can only
                          // be only player in a level
@@ -59,7 +65,7 @@ int token_player(struct level *l, const enum sprite_id id, const size_t r,
   }
 
   // set the player's start position
-  struct player *p = g_game.player;
+  struct player *p = w->player;
 
   assert_not_null(1, p);
   // player->sprite should have been freed by the previous level or set to NULL
@@ -75,9 +81,10 @@ int token_player(struct level *l, const enum sprite_id id, const size_t r,
   p->s = s;
 
   // initialize the player's sprite
-  if (sprite_init(p->s, SPRITE_PLAYER) != 0) {
+  if (sprite_init(w, p->s, SPRITE_PLAYER) != 0) {
     return -1;
   }
+  player_character(p);
 
   p->s->x = SPRITE_SIZE * c;
   p->s->y = SPRITE_SIZE * r;
@@ -94,18 +101,43 @@ int token_player(struct level *l, const enum sprite_id id, const size_t r,
   return 0;
 }
 
-int token_level_populate(struct level *l, const char *s,
-                         const struct token_entry *arr, const size_t arr_len) {
-  assert_not_null(3, l, s, arr);
+// the item grid of a level template holds a sprite id in a byte
+SDL_COMPILE_TIME_ASSERT(item_id_size, SPRITE_TYPE_COUNT <= 256);
+
+// spawn_compare is used for qsort in token_template_populate. It orders spawns
+// by descending sprite id, which is the depth order of array_sort, and spawns
+// of a same sprite id by row and column. qsort is not stable, and the order of
+// the spawns is the order their sprites are created and updated in, so no two
+// spawns may compare equal.
+static int spawn_compare(const void *a, const void *b) {
+  assert_not_null(2, a, b);
+  const struct spawn *sa = (const struct spawn *)a;
+  const struct spawn *sb = (const struct spawn *)b;
+
+  if (sa->id != sb->id) {
+    return sa->id < sb->id ? 1 : -1;
+  }
+
+  if (sa->r != sb->r) {
+    return sa->r < sb->r ? -1 : 1;
+  }
+
+  return sa->c < sb->c ? -1 : sa->c > sb->c;
+}
+
+int token_template_populate(struct level_template *t, const char *s,
+                            const struct token_entry *arr,
+                            const size_t arr_len) {
+  assert_not_null(5, t, t->passive_sprites, t->items, s, arr);
 
   // Some multiplication overflow checks
   size_t overflow_check;
 
-  if (SDL_size_mul_overflow(SPRITE_COUNT, l->w, &overflow_check) != 0) {
+  if (SDL_size_mul_overflow(SPRITE_COUNT, t->w, &overflow_check) != 0) {
     goto overflow_error;
   }
 
-  if (SDL_size_mul_overflow(overflow_check, l->h, &overflow_check) != 0) {
+  if (SDL_size_mul_overflow(overflow_check, t->h, &overflow_check) != 0) {
     goto overflow_error;
   }
 
@@ -140,13 +172,13 @@ int token_level_populate(struct level *l, const char *s,
 
   // the total number of columns in the level
   size_t level_cols;
-  if (SDL_size_mul_overflow(COLUMN_COUNT, l->w, &level_cols) != 0) {
+  if (SDL_size_mul_overflow(COLUMN_COUNT, t->w, &level_cols) != 0) {
     goto overflow_error;
   }
 
   // the total number of rows in the level
   size_t level_rows;
-  if (SDL_size_mul_overflow(ROW_COUNT, l->h, &level_rows) != 0) {
+  if (SDL_size_mul_overflow(ROW_COUNT, t->h, &level_rows) != 0) {
     goto overflow_error;
   }
 
@@ -154,39 +186,90 @@ int token_level_populate(struct level *l, const char *s,
   register size_t i;
 
   for (i = 0; i < arr_len; i++) {
-    token_map[(size_t)arr[i].t] = &arr[i];
+    token_map[(unsigned char)arr[i].t] = &arr[i];
   }
 
-  for (r = 0; r < level_rows; r++) {   // iterate over the rows
-    for (c = 0; c < level_cols; c++) { // iterate over the columns
-      const char token = s[r * level_cols + c];
-      const struct token_entry *entry = token_map[(size_t)token];
+  // first pass: fill in the tile and item grids, validate every token and count
+  // the sprites we will need to spawn, so the spawn list is allocated only
+  // once.
+  size_t spawn_count = 0;
+  size_t player_count = 0;
 
-      // we could not recognize the token
-      if (entry == NULL) {
-        LOG_ERROR("failed to handle token: %c", token);
-        goto invalid_error;
-      }
+  for (i = 0; i < len_expected; i++) {
+    const char token = s[i];
+    const struct token_entry *entry = token_map[(unsigned char)token];
 
-      // it is NULL in the case of SPRITE_NONE, which is allowed
-      if (entry->f != NULL) {
-        if (entry->f(l, entry->s, r, c) != 0) {
-          return -1;
-        }
-      }
+    // we could not recognize the token
+    if (entry == NULL) {
+      LOG_ERROR("failed to handle token: %c", token);
+      goto invalid_error;
+    }
+
+    t->items[i] = SPRITE_NONE;
+
+    // it is NULL in the case of SPRITE_NONE, which is allowed
+    if (entry->f == NULL) {
+      t->passive_sprites[i] = SPRITE_NONE;
+      continue;
+    }
+
+    if (entry->f == token_passive_sprite) {
+      t->passive_sprites[i] = entry->s;
+      continue;
+    }
+
+    if (entry->f == token_item) {
+      t->passive_sprites[i] = SPRITE_NONE;
+      t->items[i] = (Uint8)entry->s;
+      continue;
+    }
+
+    t->passive_sprites[i] = SPRITE_NONE;
+    spawn_count++;
+
+    if (entry->f == token_player) {
+      player_count++;
     }
   }
 
   // every level needs to specify a player
-  if (!l->player_found) {
+  if (player_count == 0) {
     LOG_ERROR("player not found");
     goto invalid_error;
   }
 
-  // After every sprite has been added, sort the level's active sprites by
-  // their depth
-  array_sort(l->active_sprites);
-  LOG_INFO_VERBOSE("loaded level from level file");
+  if (player_count > 1) {
+    LOG_ERROR("player already added, more than 1 player not allowed per level");
+    goto invalid_error;
+  }
+
+  t->spawns = (struct spawn *)calloc(spawn_count, sizeof(struct spawn));
+  if (t->spawns == NULL) {
+    // errno = ENOMEM
+    LOG_ERROR("failed to allocate level spawn list");
+    return -1;
+  }
+
+  // second pass: record the spawn list
+  t->spawn_count = 0;
+  for (r = 0; r < level_rows; r++) {   // iterate over the rows
+    for (c = 0; c < level_cols; c++) { // iterate over the columns
+      const struct token_entry *entry =
+          token_map[(unsigned char)s[r * level_cols + c]];
+
+      if (entry->f == NULL || entry->f == token_passive_sprite ||
+          entry->f == token_item) {
+        continue;
+      }
+
+      t->spawns[t->spawn_count++] = (struct spawn){entry->f, entry->s, r, c};
+    }
+  }
+
+  // After every sprite has been recorded, sort the spawn list by depth, so
+  // that instantiating the level appends its active sprites already sorted.
+  qsort(t->spawns, t->spawn_count, sizeof(struct spawn), spawn_compare);
+  LOG_INFO_VERBOSE("parsed level template");
   return 0;
 
 overflow_error:
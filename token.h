@@ -5,8 +5,11 @@
 
 #include "sprite_type.h"
 
-// forward declaration for struct level, to definition token_entry->f
+// forward declarations for struct level and struct lily_world (see state.h), to
+// define token_entry->f, and for struct level_template (see level_template.h)
 struct level;
+struct lily_world;
+struct level_template;
 
 // implements functionality for handling character token to sprite creation
 // mapping for levels
@@ -17,29 +20,44 @@ struct token_entry {
   char t;           // the token
   enum sprite_id s; // the sprite id to create with the token
   // the function to use for sprite creation
-  int (*f)(struct level *, const enum sprite_id, const size_t, const size_t);
+  int (*f)(struct lily_world *, struct level *, const enum sprite_id,
+           const size_t, const size_t);
 };
 
-// token_level_populate takes in a string representing a level and populates the
-// passive sprites and active sprites in the level based on the string. It also
-// takes in an array of token entries taken contain information on how to create
-// a sprite from each ASCII character. Returns 0 on success, -1 on failure.
-int token_level_populate(struct level *l, const char *s,
-                         const struct token_entry *arr, const size_t arr_len);
-
-// token_passive_sprite constructs a passive sprite. Return 0 on success, -1 on
-// failure. The current implementation always returns 0 unless an assertion
-// fails (in which case execution stops).
-int token_passive_sprite(struct level *l, const enum sprite_id id,
-                         const size_t r, const size_t c);
-
-// token_active_sprite constructs an active sprite and adds it to the level.
-// Returns 0 on success, -1 on failure.
-int token_active_sprite(struct level *l, const enum sprite_id id,
-                        const size_t r, const size_t c);
-
-// token_player puts the player in the level. Returns 0 on success, -1 on error.
-int token_player(struct level *l, const enum sprite_id id, const size_t r,
-                 const size_t c);
+// token_template_populate takes in a string representing a level and populates
+// the tile grid and the spawn list of the level template t based on the string.
+// It also takes in an array of token entries taken contain information on how
+// to create a sprite from each ASCII character. t->passive_sprites and t->items
+// must already be allocated for t->w and t->h. Returns 0 on success, -1 on
+// failure.
+int token_template_populate(struct level_template *t, const char *s,
+                            const struct token_entry *arr,
+                            const size_t arr_len);
+
+// token_passive_sprite marks a token as a passive sprite. Passive sprites are
+// written into the tile grid of a level template by token_template_populate and
+// are shared by every level instantiated from that template, so there is
+// nothing left to construct per level: this always returns 0.
+int token_passive_sprite(struct lily_world *w, struct level *l,
+                         const enum sprite_id id, const size_t r,
+                         const size_t c);
+
+// token_item marks a token as an item, such as a coin. Items are written into
+// the item grid of a level template by token_template_populate, and collected
+// by touching their tile (see level_item), so like token_passive_sprite there
+// is nothing to construct per level: this always returns 0.
+int token_item(struct lily_world *w, struct level *l, const enum sprite_id id,
+               const size_t r, const size_t c);
+
+// token_active_sprite constructs an active sprite of the world w and adds it to
+// the level. Returns 0 on success, -1 on failure.
+int token_active_sprite(struct lily_world *w, struct level *l,
+                        const enum sprite_id id, const size_t r,
+                        const size_t c);
+
+// token_player puts the player of the world w in the level. Returns 0 on
+// success, -1 on error.
+int token_player(struct lily_world *w, struct level *l,
+                 const enum sprite_id id, const size_t r, const size_t c);
 
 #endif // TOKEN_H
@@ -1,8 +1,7 @@
 #include "util.h"
 
 #include "base.h"
-#include "fps.h"
-#include "game.h"
+#include "fixed.h"
 #include "level.h"
 #include "safe.h"
 #include "state.h"
@@ -10,28 +9,59 @@
 #include <errno.h>
 #include <limits.h>
 
-bool util_fair_coin_flip(void) { return rand() % 2 == 0; }
+void util_seed(struct lily_world *w, const Uint64 seed) {
+  assert_not_null(1, w);
+  w->rand = seed;
+}
+
+// util_rand_state uses the splitmix64 generator, which is fast, has a small
+// state, and is fine for gameplay randomness.
+Uint32 util_rand_state(Uint64 *state) {
+  assert_not_null(1, state);
+  Uint64 z = (*state += 0x9E3779B97F4A7C15);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+  return (Uint32)((z ^ (z >> 31)) >> 32);
+}
+
+Uint32 util_rand(struct lily_world *w) {
+  assert_not_null(1, w);
+  return util_rand_state(&w->rand);
+}
+
+bool util_fair_coin_flip(struct lily_world *w) {
+  return util_rand(w) % 2 == 0;
+}
 
-static bool valid_x(const int c) {
-  struct level *l = g_game.level;
+static bool valid_x(const struct lily_world *w, const int c) {
+  struct level *l = w->level;
   assert_not_null(1, l);
   return (c >= 0 && c < COLUMN_COUNT * size_t_to_int(l->w));
 }
 
-static bool valid_y(const int r) {
-  struct level *l = g_game.level;
+static bool valid_y(const struct lily_world *w, const int r) {
+  struct level *l = w->level;
   assert_not_null(1, l);
   return (r >= 0 && r < ROW_COUNT * size_t_to_int(l->h));
 }
 
 // valid checks if the row and column is within the screen
-static bool valid(const int r, const int c) {
-  struct level *l = g_game.level;
+static bool valid(const struct lily_world *w, const int r, const int c) {
+  struct level *l = w->level;
   assert_not_null(1, l);
   return (r >= 0 && r < ROW_COUNT * size_t_to_int(l->h) && c >= 0 &&
           c < COLUMN_COUNT * size_t_to_int(l->w));
 }
 
+// tile returns the sprite type of the passive sprite at row r and column c in
+// the current level of the world w. r and c must be valid.
+static const struct sprite_type *tile(const struct lily_world *w, const int r,
+                                      const int c) {
+  struct level *l = w->level;
+  assert_not_null(1, l);
+  return &w->sprite_types[l->passive_sprites[r * COLUMN_COUNT * l->w + c]];
+}
+
 void util_nearest(const struct sprite *s, int *r, int *c) {
   assert_not_null(3, s, r, c);
   const SDL_Rect b = s->type->body;
@@ -46,30 +76,24 @@ void util_nearest(const struct sprite *s, int *r, int *c) {
   *c = SDL_floor((s->x + b.x + b.w / 2.0) / SPRITE_SIZE);
 }
 
-bool util_ladder(const int r, const int c) {
-  struct level *l = g_game.level;
-  assert_not_null(1, l);
+bool util_ladder(const struct lily_world *w, const int r, const int c) {
+  assert_not_null(2, w, w->level);
 
-  if (!valid(r, c)) {
+  if (!valid(w, r, c)) {
     return false;
   }
 
-  struct sprite_type *t = l->passive_sprites[r * COLUMN_COUNT * l->w + c];
-
-  return t->parent_id == SPRITE_LADDER;
+  return tile(w, r, c)->parent_id == SPRITE_LADDER;
 }
 
-bool util_door(const int r, const int c) {
-  struct level *l = g_game.level;
-  assert_not_null(1, l);
+bool util_door(const struct lily_world *w, const int r, const int c) {
+  assert_not_null(2, w, w->level);
 
-  if (!valid(r, c)) {
+  if (!valid(w, r, c)) {
     return false;
   }
 
-  struct sprite_type *t = l->passive_sprites[r * COLUMN_COUNT * l->w + c];
-
-  return t->parent_id == SPRITE_DOOR;
+  return tile(w, r, c)->parent_id == SPRITE_DOOR;
 }
 
 // util_borders takes a sprite and populates a borders struct corresponding to
@@ -93,6 +117,42 @@ bool util_collide(const struct sprite *s1, const struct sprite *s2) {
   return (b1.l < b2.r && b1.r > b2.l && b1.t < b2.b && b1.b > b2.t);
 }
 
+void util_tiles(const struct lily_world *w, const struct sprite *s, int *r0,
+                int *c0, int *r1, int *c1) {
+  assert_not_null(6, w, w->level, s, r0, c0, r1, c1);
+  const struct level *l = w->level;
+
+  struct borders b;
+  util_borders(s, &b);
+
+  // a tile is overlapped if the body overlaps more than its edge
+  *c0 = SDL_max((int)SDL_floor(b.l / SPRITE_SIZE), 0);
+  *c1 = SDL_min((int)SDL_ceil(b.r / SPRITE_SIZE),
+                COLUMN_COUNT * size_t_to_int(l->w)) -
+        1;
+  *r0 = SDL_max((int)SDL_floor(b.t / SPRITE_SIZE), 0);
+  *r1 = SDL_min((int)SDL_ceil(b.b / SPRITE_SIZE),
+                ROW_COUNT * size_t_to_int(l->h)) -
+        1;
+}
+
+bool util_touch(const struct lily_world *w, const struct sprite *s,
+                const int flags) {
+  int r0, c0, r1, c1;
+  util_tiles(w, s, &r0, &c0, &r1, &c1);
+
+  register int r, c;
+  for (r = r0; r <= r1; r++) {
+    for (c = c0; c <= c1; c++) {
+      if ((tile(w, r, c)->tile_flags & flags) == flags) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
 void util_sprite_hints(const struct sprite *s, int *r, int *c,
                        struct borders *passive, struct borders *actual) {
   util_nearest(s, r, c);
@@ -116,32 +176,31 @@ double util_abs_limit(const double v, const double m) {
   return v;
 }
 
-bool util_solid(const int r, const int c, const enum solid_type s) {
-  if (!valid_x(c)) {
+bool util_solid(const struct lily_world *w, const int r, const int c,
+                const enum solid_type s) {
+  if (!valid_x(w, c)) {
     return true;
   }
 
-  if (!valid_y(r)) {
+  if (!valid_y(w, r)) {
     return false;
   }
 
-  assert_not_null(1, g_game.level);
-  struct level *l = g_game.level;
-  return (l->passive_sprites[r * COLUMN_COUNT * l->w + c]->solid_type & s) == s;
+  return (tile(w, r, c)->solid_type & s) == s;
 }
 
-bool util_solid_ladder(const int r, const int c) {
-  if (!util_ladder(r, c)) {
+bool util_solid_ladder(const struct lily_world *w, const int r, const int c) {
+  if (!util_ladder(w, r, c)) {
     return false;
   }
 
-  return (util_solid(r, c - 1, SOLID_TOP) || util_solid(r, c + 1, SOLID_TOP) ||
-          !util_ladder(r - 1, c));
+  return (util_solid(w, r, c - 1, SOLID_TOP) ||
+          util_solid(w, r, c + 1, SOLID_TOP) || !util_ladder(w, r - 1, c));
 }
 
-bool util_visible(const struct sprite *s1, const struct sprite *s2) {
-  struct level *l = g_game.level;
-  assert_not_null(3, s1, s2, l);
+bool util_visible(const struct lily_world *w, const struct sprite *s1,
+                  const struct sprite *s2) {
+  assert_not_null(4, w, s1, s2, w->level);
 
   // we can assume here that both s1 and s2 are on the screen, as this function
   // is intended to be called from within a sprite's frame or hit handlers which
@@ -161,75 +220,44 @@ bool util_visible(const struct sprite *s1, const struct sprite *s2) {
   enum direction dir;
   dir = s1->animation.flip == SDL_FLIP_NONE ? DIR_RIGHT : DIR_LEFT;
 
-  register int i;
-
+  // are there any solid passive sprites between these two? The solid
+  // rectangles of the row are searched instead of every tile in between.
+  const struct solid_map *m = w->level->solids;
   if (dir == DIR_LEFT) {
-    if (c1 <= c2) {
-      return false;
-    }
-
-    // s2 is to the left of s1, but are there any solid passive sprites between
-    // these two?
-    for (i = c2; i < c1; i++) {
-      if (util_solid(r1, i, SOLID_LEFT)) {
-        return false;
-      }
-    }
-
-    return true;
+    return c1 > c2 && solid_map_find(m, r1, c2, 1, SOLID_LEFT) >= c1;
   }
 
   // DIR_RIGHT
-  if (c1 >= c2) {
-    return false;
-  }
-
-  for (i = c1; i < c2; i++) {
-    if (util_solid(r1, i, SOLID_RIGHT)) {
-      return false;
-    }
-  }
-
-  return true;
+  return c1 < c2 && solid_map_find(m, r1, c1, 1, SOLID_RIGHT) >= c2;
 }
 
-long util_level_from_file(const char *filename, char **str, size_t *w,
-                          size_t *h) {
-  FILE *file = fopen(filename, "r");
-  if (file == NULL) {
-    LOG_ERROR("error opening file: %s", filename);
-    return -1;
-  }
-
-  // get file size
-  fseek(file, 0, SEEK_END);
-  long file_size = ftell(file);
-  rewind(file);
+long util_level_from_buffer(const char *buf, const size_t len, char **str,
+                            size_t *w, size_t *h) {
+  assert_not_null(4, buf, str, w, h);
 
   // allocate memory for the string
-  // TODO: find a safer way to convert this long to size_t
-  char *content = malloc((size_t)(file_size + 1));
+  char *content = malloc(len + 1);
   if (content == NULL) {
     perror("memory allocation failed");
-    fclose(file);
     return -1;
   }
 
-  // read file content
+  // read the level content
   size_t total_read = 0;
   size_t lines = 0;
 
-  char ch;
   bool first_line = true;
-  while ((ch = fgetc(file)) != EOF) {
+  register size_t i;
+  for (i = 0; i < len; i++) {
+    const char ch = buf[i];
     if (ch == '\n' && first_line) {
       lines++;
       first_line = false;
 
       if (total_read % COLUMN_COUNT != 0) {
-        LOG_ERROR("incorrect level width for %s, got width %lu (expected "
+        LOG_ERROR("incorrect level width, got width %lu (expected "
                   "multiple of %u)",
-                  filename, (unsigned long)total_read, COLUMN_COUNT);
+                  (unsigned long)total_read, COLUMN_COUNT);
         goto error_out;
       }
 
@@ -247,7 +275,7 @@ long util_level_from_file(const char *filename, char **str, size_t *w,
   }
 
   if (first_line) {
-    LOG_ERROR("first line of level %s not found", filename);
+    LOG_ERROR("first line of level not found");
     goto error_out;
   }
 
@@ -255,68 +283,151 @@ long util_level_from_file(const char *filename, char **str, size_t *w,
   lines++;
 
   if (lines % ROW_COUNT != 0) {
-    LOG_ERROR("incorrect level height for %s, got height %lu (expected "
+    LOG_ERROR("incorrect level height, got height %lu (expected "
               "multiple of %u), last "
               "line should *NOT* end with a new line character.",
-              filename, (unsigned long)lines, ROW_COUNT);
+              (unsigned long)lines, ROW_COUNT);
     goto error_out;
   }
 
   *h = lines / ROW_COUNT;
 
   content[total_read] = '\0'; // null-terminate the string
-
-  fclose(file);
   *str = content;
 
-  LOG_INFO_VERBOSE("loaded level file %s [w = %lu, h = %lu]", filename,
-                   (unsigned long)*w, (unsigned long)*h);
-
-  return file_size;
+  return (long)total_read;
 
 error_out:
   errno = EINVAL;
-  fclose(file);
   free(content);
   return -1;
 }
 
-enum collision util_move_x(struct sprite *s) {
-  int r, c;
-  struct borders passive, actual;
-  util_sprite_hints(s, &r, &c, &passive, &actual);
+long util_level_from_file(const char *filename, char **str, size_t *w,
+                          size_t *h) {
+  FILE *file = fopen(filename, "r");
+  if (file == NULL) {
+    LOG_ERROR("error opening file: %s", filename);
+    return -1;
+  }
 
-  const double dt = fps_frame_time() / 1000.0;
-  s->vx = util_abs_limit(s->vx, MAX_VELOCITY);
-  s->x += s->vx * dt;
+  // get file size
+  fseek(file, 0, SEEK_END);
+  long file_size = ftell(file);
+  rewind(file);
+
+  if (file_size < 0) {
+    LOG_ERROR("error reading file: %s", filename);
+    fclose(file);
+    return -1;
+  }
 
-  // new borders based on the horizontal movement for collision testing.
-  struct borders b = {s->x, s->x + SPRITE_SIZE, s->y, s->y + SPRITE_SIZE};
+  char *buf = malloc((size_t)file_size + 1);
+  if (buf == NULL) {
+    perror("memory allocation failed");
+    fclose(file);
+    return -1;
+  }
 
-  // if 1) our new left is more left than our old left, and 2) we are not
-  // moving right.
-  if (b.l < passive.l && s->vx <= 0) {
-    bool left_solid = util_solid(r, c - 1, SOLID_RIGHT);
+  // in text mode, fewer bytes than file_size may be read (e.g \r\n line
+  // endings being translated on windows)
+  size_t len = fread(buf, 1, (size_t)file_size, file);
+  fclose(file);
 
-    if (left_solid) {
-      s->x = passive.l; // put the sprite back onto the old "grid" location
-      return COLLISION_LEFT;
-    }
+  long ret = util_level_from_buffer(buf, len, str, w, h);
+  free(buf);
+
+  if (ret < 0) {
+    LOG_ERROR("failed to load level file %s", filename);
+    return -1;
+  }
+
+  LOG_INFO_VERBOSE("loaded level file %s [w = %lu, h = %lu]", filename,
+                   (unsigned long)*w, (unsigned long)*h);
 
+  return file_size;
+}
+
+// sweep moves the sprite s in the current level of the world w by its velocity
+// over w->dt, horizontally if x is true and vertically otherwise. See
+// util_sweep_x and util_sweep_y. ladders and crossed are only used vertically.
+static enum collision sweep(const struct lily_world *w, struct sprite *s,
+                            const bool x, const double hit, const bool ladders,
+                            bool *crossed) {
+  int r, c;
+  util_nearest(s, &r, &c);
+
+  // the sprite moves along k, from its "grid" location k0, in the lane of
+  // tiles it is on: its row if it moves horizontally, its column otherwise
+  double *pos = x ? &s->x : &s->y;
+  const double v = x ? s->vx : s->vy;
+  const double across = x ? s->y : s->x;
+  const int k0 = x ? c : r;
+  const int lane = x ? r : c;
+  const double to = *pos + fixed_step(v, w->dt);
+
+  // the tiles of the lanes on either side are only tested if the sprite
+  // overlaps them by more than hit pixels
+  const int first = lane - (across + hit < SPRITE_SIZE * lane ? 1 : 0);
+  const int last = lane + (across - hit > SPRITE_SIZE * lane ? 1 : 0);
+
+  int dir;
+  enum solid_type type;
+  enum collision collision;
+  if (to < SPRITE_SIZE * k0 && v <= 0) {
+    // our new left (or top) is past the one of our "grid" location, and we
+    // are not moving right (or down)
+    dir = -1;
+    type = x ? SOLID_RIGHT : SOLID_BOTTOM;
+    collision = x ? COLLISION_LEFT : COLLISION_TOP;
+  } else if (to > SPRITE_SIZE * k0 && v >= 0) {
+    dir = 1;
+    type = x ? SOLID_LEFT : SOLID_TOP;
+    collision = x ? COLLISION_RIGHT : COLLISION_BOTTOM;
+  } else {
+    *pos = to;
+    *crossed = false;
     return COLLISION_NONE;
   }
 
-  // -- is moving right okay? --
-  // if 1) our new right is more right than our old right, and 2) we are
-  // not moving left
-  if (b.r > passive.r && s->vx >= 0) {
-    bool right_solid = util_solid(r, c + 1, SOLID_LEFT);
+  // every tile border crossed on the way is tested in order, so the sprite
+  // stops at the first solid tile however far it moves in a frame
+  *crossed = true;
+  register int k, i;
+  for (k = k0; dir > 0 ? SPRITE_SIZE * k < to : SPRITE_SIZE * k > to;
+       k += dir) {
+    bool solid = ladders && !x && dir > 0 && util_solid_ladder(w, k + 1, lane);
+    for (i = first; i <= last && !solid; i++) {
+      solid = x ? util_solid(w, i, k + dir, type)
+                : util_solid(w, k + dir, i, type);
+    }
 
-    if (right_solid) {
-      s->x = passive.l; // put the player back onto the old "grid" location
-      return COLLISION_RIGHT;
+    if (solid) {
+      *pos = SPRITE_SIZE * k; // put the sprite onto the last "grid" location
+      return collision;
     }
   }
 
+  *pos = to;
   return COLLISION_NONE;
 }
+
+enum collision util_sweep_x(const struct lily_world *w, struct sprite *s,
+                            const double hit) {
+  assert_not_null(3, w, w->level, s);
+  bool crossed;
+  return sweep(w, s, true, hit, false, &crossed);
+}
+
+enum collision util_sweep_y(const struct lily_world *w, struct sprite *s,
+                            const double hit, const bool ladders,
+                            bool *crossed) {
+  assert_not_null(4, w, w->level, s, crossed);
+  return sweep(w, s, false, hit, ladders, crossed);
+}
+
+enum collision util_move_x(const struct lily_world *w, struct sprite *s) {
+  s->vx = util_abs_limit(s->vx, MAX_VELOCITY);
+  // only the tiles of the sprite's own row stop it
+  return util_sweep_x(w, s, SPRITE_SIZE);
+}
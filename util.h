@@ -6,6 +6,9 @@
 
 // This file contains miscellaneous utility functions
 
+// forward declaration, see state.h
+struct lily_world;
+
 struct borders {
   // left, right, top, bottom
   double l, r, t, b;
@@ -16,17 +19,17 @@ struct borders {
 void util_nearest(const struct sprite *s, int *r, int *c);
 
 // util_ladder checks if the passive sprite at row r, and column c, in the
-// current level is of type SPRITE_LADDER
-bool util_ladder(const int r, const int c);
+// current level of the world w is of type SPRITE_LADDER
+bool util_ladder(const struct lily_world *w, const int r, const int c);
 
 // util_door checks if the passive sprite at row r, and column c, in the current
-// level is of type SPRITE_DOOR
-bool util_door(const int r, const int c);
+// level of the world w is of type SPRITE_DOOR
+bool util_door(const struct lily_world *w, const int r, const int c);
 
 // util_solid_ladder checks if the passive sprite at row r, and column c, in the
-// current level is of type SPRITE_LADDER, and also if it makes 2D platformer
-// physics sense for the player to be able to stay on the ladder.
-bool util_solid_ladder(const int r, const int c);
+// current level of the world w is of type SPRITE_LADDER, and also if it makes
+// 2D platformer physics sense for the player to be able to stay on the ladder.
+bool util_solid_ladder(const struct lily_world *w, const int r, const int c);
 
 // util_sprite_hints get information on the sprite's row and column on the
 // level, the borders of the passive sprite in the level the sprite is nearest
@@ -39,17 +42,39 @@ void util_sprite_hints(const struct sprite *s, int *r, int *c,
 // (m, infty) to m.
 double util_abs_limit(const double v, const double m);
 
-// util_solid returns true is the passive sprite at row r and column c is
-// valid (see the valid function in util.c), and if it is of the solid type
-// specified.
-bool util_solid(const int r, const int c, const enum solid_type s);
+// util_solid returns true is the passive sprite at row r and column c in the
+// current level of the world w is valid (see the valid function in util.c), and
+// if it is of the solid type specified.
+bool util_solid(const struct lily_world *w, const int r, const int c,
+                const enum solid_type s);
 
 // util_collide returns true is sprite s1 is colliding with sprite s2. It
 // returns false otherwise.
 bool util_collide(const struct sprite *s1, const struct sprite *s2);
 
-// util_return returns true if s1 can see s2
-bool util_visible(const struct sprite *s1, const struct sprite *s2);
+// util_tiles populates the first (r0, c0) and last (r1, c1) row and column of
+// the tiles of the current level of the world w that the body of the sprite s
+// overlaps, the same way util_collide tests overlaps. The rows and columns are
+// within the level: if the body is outside of it, r0 > r1 or c0 > c1.
+void util_tiles(const struct lily_world *w, const struct sprite *s, int *r0,
+                int *c0, int *r1, int *c1);
+
+// util_touch returns true if the body of the sprite s overlaps a tile of the
+// current level of the world w that has all the tile_flag values in flags
+bool util_touch(const struct lily_world *w, const struct sprite *s,
+                const int flags);
+
+// util_return returns true if s1 can see s2 in the current level of the world w
+bool util_visible(const struct lily_world *w, const struct sprite *s1,
+                  const struct sprite *s2);
+
+// util_level_from_buffer reads a level from the `len` bytes of `buf`, which are
+// in the same format as a level file (see levels/). Returns the length of the
+// level string on success, -1 on failure. User is responsible for freeing
+// returned string. w and h store the width and height of the level which is
+// inferred dynamically from the buffer.
+long util_level_from_buffer(const char *buf, const size_t len, char **str,
+                            size_t *w, size_t *h);
 
 // util_level_from_file reads a level from a file. Returns length on success, -1
 // on failure. User is responsible for freeing returned string. w and h store
@@ -58,21 +83,54 @@ bool util_visible(const struct sprite *s1, const struct sprite *s2);
 long util_level_from_file(const char *filename, char **str, size_t *w,
                           size_t *h);
 
+// util_seed seeds the pseudo-random number generator of the world w. Worlds
+// seeded with the same value make the same random choices.
+void util_seed(struct lily_world *w, const Uint64 seed);
+
+// util_rand returns the next pseudo-random number of the world w
+Uint32 util_rand(struct lily_world *w);
+
+// util_rand_state returns the next pseudo-random number of the generator whose
+// state is *state, e.g the generator of a sprite, which its frame handler may
+// use while other sprites are updated at the same time (see level_iterate)
+Uint32 util_rand_state(Uint64 *state);
+
 // util_fair_coin_flip returns true if 0.5 probability and false with
-// 0.5 probability
-bool util_fair_coin_flip(void);
+// 0.5 probability, using the pseudo-random number generator of the world w
+bool util_fair_coin_flip(struct lily_world *w);
 
 // collision is returned by util operations that process movement, such as
 // util_move_x
 enum collision {
   COLLISION_NONE = 0,
   COLLISION_LEFT = (1 << 0),
-  COLLISION_RIGHT = (1 << 1)
+  COLLISION_RIGHT = (1 << 1),
+  COLLISION_TOP = (1 << 2),
+  COLLISION_BOTTOM = (1 << 3)
 };
 
+// util_sweep_x moves the sprite s horizontally by its velocity over the frame
+// of the world w, and returns the side it collided on, if any. The move is
+// swept: every column border crossed on the way is tested against the tiles of
+// the current level, so the sprite stops on the last tile before the first
+// solid one, however far it moves in a frame, and never tunnels through tiles
+// at large time steps (see MAX_STEP_TIME). The sprite also collides with the
+// tiles of the rows above and below its own if it overlaps them by more than
+// hit pixels.
+enum collision util_sweep_x(const struct lily_world *w, struct sprite *s,
+                            const double hit);
+
+// util_sweep_y works like util_sweep_x, but vertically. If ladders is true, the
+// top of a ladder is solid for a sprite moving down (see util_solid_ladder).
+// crossed is set to true if the sprite moved past the top or bottom of the tile
+// it was on, whether it collided or not.
+enum collision util_sweep_y(const struct lily_world *w, struct sprite *s,
+                            const double hit, const bool ladders,
+                            bool *crossed);
+
 // util_move_x is a generic processor the horizontal movement of a sprite that
-// also handles horizontal collisions. This is used, for example, by enemy
-// handlers
-enum collision util_move_x(struct sprite *s);
+// also handles horizontal collisions in the current level of the world w (see
+// util_sweep_x). This is used, for example, by enemy handlers
+enum collision util_move_x(const struct lily_world *w, struct sprite *s);
 
 #endif // UTIL_H
@@ -1,7 +1,7 @@
 #include "util.h"
 
-#include "fps.h"
 #include "level.h"
+#include "lily.h"
 #include "player.h"
 #include "state.h"
 #include "test.h"
@@ -18,7 +18,7 @@ static const struct token_entry TOKENS[TOKEN_SIZE] = {
     {' ', SPRITE_NONE, NULL}};
 
 static struct level *l = NULL;
-static struct player p;
+static struct lily_world *world = NULL;
 
 // this test expects a 15 row, 20 column level. May need to be changed if the
 // level size changes.
@@ -73,61 +73,140 @@ static void test_util_nearest(void) {
 }
 
 static void test_util_other_sprites(void) {
-  assert(util_door(10, 18));
-  assert(!util_door(10, 17));
-  assert(!util_door(0, 0));
+  assert(util_door(world, 10, 18));
+  assert(!util_door(world, 10, 17));
+  assert(!util_door(world, 0, 0));
 
-  assert(util_ladder(0, 0));
-  assert(!util_ladder(10, 10));
+  assert(util_ladder(world, 0, 0));
+  assert(!util_ladder(world, 10, 10));
 
   // these should be false and *not* a segmentation fault as these are out of
   // the level
-  assert(!util_door(300, 0));
-  assert(!util_door(0, 300));
-  assert(!util_ladder(300, 0));
-  assert(!util_ladder(0, 300));
+  assert(!util_door(world, 300, 0));
+  assert(!util_door(world, 0, 300));
+  assert(!util_ladder(world, 300, 0));
+  assert(!util_ladder(world, 0, 300));
 }
 
 static void test_util_solid(void) {
-  assert(!util_solid(0, 0, SOLID_TOP));
-  assert(util_solid(13, 0, SOLID_TOP));
-  assert(!util_solid(14, 0, SOLID_TOP));
-  assert(util_solid(14, 0, SOLID_LEFT));
+  assert(!util_solid(world, 0, 0, SOLID_TOP));
+  assert(util_solid(world, 13, 0, SOLID_TOP));
+  assert(!util_solid(world, 14, 0, SOLID_TOP));
+  assert(util_solid(world, 14, 0, SOLID_LEFT));
 
   // horizontally out of the screen is considered solid
-  assert(util_solid(0, -1, SOLID_RIGHT));
-  assert(util_solid(0, 20, SOLID_LEFT));
+  assert(util_solid(world, 0, -1, SOLID_RIGHT));
+  assert(util_solid(world, 0, 20, SOLID_LEFT));
 
   // vertically out of the screen is *not* considered solid
-  assert(!util_solid(-1, 0, SOLID_BOTTOM));
-  assert(!util_solid(15, 0, SOLID_TOP));
+  assert(!util_solid(world, -1, 0, SOLID_BOTTOM));
+  assert(!util_solid(world, 15, 0, SOLID_TOP));
 }
 
 static void test_util_move_x(void) {
+  struct player *p = world->player;
+
   // we need some frame time to test this
-  fps_init();
-  SDL_Delay(50); // 50 ms should do the trick
-  fps_iterate();
-
-  p.s->vx = -72;
-  assert(util_move_x(p.s) == COLLISION_LEFT);
-  p.s->vx = 72;
-  assert(util_move_x(p.s) == COLLISION_NONE);
-
-  p.s->vx = 16 - p.s->type->body.w + 1;
-  p.s->x = 7 * SPRITE_SIZE;
-  assert(util_move_x(p.s) == COLLISION_RIGHT);
+  world->dt = 50; // 50 ms should do the trick
+
+  p->s->vx = -72;
+  assert(util_move_x(world, p->s) == COLLISION_LEFT);
+  p->s->vx = 72;
+  assert(util_move_x(world, p->s) == COLLISION_NONE);
+
+  p->s->vx = 16 - p->s->type->body.w + 1;
+  p->s->x = 7 * SPRITE_SIZE;
+  assert(util_move_x(world, p->s) == COLLISION_RIGHT);
+}
+
+// walls one tile thick, which the sprites in test_util_sweep would tunnel
+// through without sweeping their moves
+static const char SWEEP_LEVEL[] = "          *         \n"
+                                  "                    \n"
+                                  "              ===   \n"
+                                  "                    \n"
+                                  "                    \n"
+                                  "  =                 \n"
+                                  "                    \n"
+                                  "                    \n"
+                                  "  P     *           \n"
+                                  "====================\n"
+                                  "********************";
+
+enum { SWEEP_FACTORS = 8, SWEEP_TIME = 3000 };
+
+// step steps the world w for SWEEP_TIME milliseconds, in steps of dt, with
+// `input` held down. Returns the smallest y position of the player meanwhile.
+static double step(struct lily_world *w, const Uint32 input,
+                   const Uint64 dt) {
+  double top = w->player->s->y;
+  register Uint64 t;
+  for (t = 0; t < SWEEP_TIME; t += dt) {
+    assert(lily_world_step(w, input, dt) == 0);
+    top = SDL_min(top, w->player->s->y);
+  }
+
+  return top;
+}
+
+// moving sprites stop at the same tile, whatever the time step of the world,
+// from FRAME_TIME to SWEEP_FACTORS times longer
+static void test_util_sweep(void) {
+  register Uint64 k;
+  for (k = 1; k <= SWEEP_FACTORS; k++) {
+    const Uint64 dt = k * FRAME_TIME;
+    struct lily_world *w = test_world(SWEEP_LEVEL, TOKENS, TOKEN_SIZE);
+    struct sprite *p = w->player->s;
+
+    // launched by a spring (see handlers_spring.c), the player bumps into the
+    // ceiling three tiles above it, then lands back
+    p->vy = -352;
+    assert(step(w, INPUT_NONE, dt) == 10 * SPRITE_SIZE);
+    assert(p->y == 12 * SPRITE_SIZE);
+    assert(!w->player->air);
+
+    // sprinting, the player stops before the wall
+    step(w, INPUT_RIGHT | INPUT_SPRINT, dt);
+    assert(p->x == 7 * SPRITE_SIZE);
+
+    // falling from the top, the player lands on the platform
+    p->x = 15 * SPRITE_SIZE;
+    p->y = 0;
+    step(w, INPUT_NONE, dt);
+    assert(p->y == 5 * SPRITE_SIZE);
+
+    // at the highest velocity, a sprite stops before the wall from either side
+    w->dt = dt;
+    struct sprite s;
+    assert(sprite_init(w, &s, SPRITE_SHOT) == 0);
+    s.y = 4 * SPRITE_SIZE;
+    s.vx = MAX_VELOCITY;
+    enum collision c;
+    while ((c = util_move_x(w, &s)) == COLLISION_NONE) {
+      assert(s.x < LEVEL_WIDTH);
+    }
+    assert(c == COLLISION_RIGHT);
+    assert(s.x == 9 * SPRITE_SIZE);
+
+    s.x = 19 * SPRITE_SIZE;
+    s.vx = -MAX_VELOCITY;
+    while ((c = util_move_x(w, &s)) == COLLISION_NONE) {
+      assert(s.x > 0);
+    }
+    assert(c == COLLISION_LEFT);
+    assert(s.x == 11 * SPRITE_SIZE);
+
+    lily_world_destroy(&w);
+  }
 }
 
 int main(int argc, char *argv[]) {
   SAFE_UNUSED(argc);
   SAFE_UNUSED(argv);
 
-  // load all sprite types prior to testing, otherwise the assert_not_nulls will
-  // fail
-  assert(g_sprite_types_create() == 0);
-  g_game.player = &p; // we don't want to fail because the player is NULL
-  p.s = NULL;
+  // create a world prior to testing, otherwise the assert_not_nulls will fail
+  world = lily_world_create();
+  assert(world != NULL);
 
   char test_level[] = "L                   " // 20 characters
                       "                    "
@@ -148,20 +227,21 @@ int main(int argc, char *argv[]) {
   // reset errno
   errno = 0;
 
-  l = level_load_from_string(test_level, 1, 1, TOKENS, TOKEN_SIZE);
+  l = level_load_from_string(world, test_level, 1, 1, TOKENS, TOKEN_SIZE);
 
   assert(l != NULL);
   assert(errno == 0);
 
-  g_game.level = l;
+  world->level = l;
 
   RUN_TEST(test_util_nearest);
   RUN_TEST(test_util_other_sprites);
   RUN_TEST(test_util_solid);
   RUN_TEST(test_util_move_x);
+  RUN_TEST(test_util_sweep);
 
-  level_free(&l);
-  g_sprite_types_destroy();
+  // the world frees its level
+  lily_world_destroy(&world);
 
   return EXIT_SUCCESS;
 }